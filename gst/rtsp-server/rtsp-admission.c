@@ -0,0 +1,320 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Admission decides if a new connection is handled before anything is made
+ * for it. A connection is refused when the server has too many connections,
+ * when too many connections did not complete their first request yet or when
+ * its source address connects faster than allowed.
+ *
+ * The rate of each source address is limited with a token bucket that holds
+ * up to burst tokens and is refilled with rate tokens per second, a
+ * connection takes a token. IPv6 sources share the bucket of their /64
+ * prefix, which is what a single host usually gets. Buckets that are full
+ * again are removed from time to time.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "rtsp-admission.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtsp_admission_debug);
+#define GST_CAT_DEFAULT rtsp_admission_debug
+
+/* the bytes of a source address used for its bucket */
+#define MAX_KEY_SIZE    8
+
+/* how often full buckets are removed */
+#define SWEEP_INTERVAL  (10 * G_USEC_PER_SEC)
+
+typedef struct
+{
+  guint8 key[MAX_KEY_SIZE];
+  gsize size;
+
+  gdouble tokens;
+  gint64 last;
+} Bucket;
+
+struct _GstRTSPAdmission
+{
+  GMutex lock;
+
+  gint max_connections;
+  gint max_pending;
+  gdouble rate;
+  guint burst;
+
+  GHashTable *buckets;
+  gint64 last_sweep;
+
+  gint connections;
+  gint pending;
+
+  guint64 accepted;
+  guint64 rejected_rate;
+  guint64 rejected_connections;
+  guint64 rejected_pending;
+};
+
+static guint
+bucket_hash (const Bucket * bucket)
+{
+  guint hash = 5381;
+  gsize i;
+
+  for (i = 0; i < bucket->size; i++)
+    hash = hash * 33 + bucket->key[i];
+
+  return hash;
+}
+
+static gboolean
+bucket_equal (const Bucket * a, const Bucket * b)
+{
+  return a->size == b->size && memcmp (a->key, b->key, a->size) == 0;
+}
+
+static void
+bucket_free (Bucket * bucket)
+{
+  g_slice_free (Bucket, bucket);
+}
+
+GstRTSPAdmission *
+gst_rtsp_admission_new (void)
+{
+  static gsize once = 0;
+  GstRTSPAdmission *admission;
+
+  if (g_once_init_enter (&once)) {
+    GST_DEBUG_CATEGORY_INIT (rtsp_admission_debug, "rtspadmission", 0,
+        "GstRTSPAdmission");
+    g_once_init_leave (&once, 1);
+  }
+
+  admission = g_slice_new0 (GstRTSPAdmission);
+  g_mutex_init (&admission->lock);
+  admission->max_connections = -1;
+  admission->max_pending = -1;
+  admission->burst = 1;
+  admission->buckets = g_hash_table_new_full ((GHashFunc) bucket_hash,
+      (GEqualFunc) bucket_equal, (GDestroyNotify) bucket_free, NULL);
+
+  return admission;
+}
+
+void
+gst_rtsp_admission_free (GstRTSPAdmission * admission)
+{
+  g_hash_table_unref (admission->buckets);
+  g_mutex_clear (&admission->lock);
+  g_slice_free (GstRTSPAdmission, admission);
+}
+
+void
+gst_rtsp_admission_set_max_connections (GstRTSPAdmission * admission,
+    gint max_connections)
+{
+  g_mutex_lock (&admission->lock);
+  admission->max_connections = max_connections;
+  g_mutex_unlock (&admission->lock);
+}
+
+gint
+gst_rtsp_admission_get_max_connections (GstRTSPAdmission * admission)
+{
+  gint result;
+
+  g_mutex_lock (&admission->lock);
+  result = admission->max_connections;
+  g_mutex_unlock (&admission->lock);
+
+  return result;
+}
+
+void
+gst_rtsp_admission_set_max_pending (GstRTSPAdmission * admission,
+    gint max_pending)
+{
+  g_mutex_lock (&admission->lock);
+  admission->max_pending = max_pending;
+  g_mutex_unlock (&admission->lock);
+}
+
+gint
+gst_rtsp_admission_get_max_pending (GstRTSPAdmission * admission)
+{
+  gint result;
+
+  g_mutex_lock (&admission->lock);
+  result = admission->max_pending;
+  g_mutex_unlock (&admission->lock);
+
+  return result;
+}
+
+/* a @rate of 0 does not limit the rate */
+void
+gst_rtsp_admission_set_rate (GstRTSPAdmission * admission, gdouble rate,
+    guint burst)
+{
+  g_mutex_lock (&admission->lock);
+  admission->rate = rate;
+  admission->burst = MAX (burst, 1);
+  g_hash_table_remove_all (admission->buckets);
+  g_mutex_unlock (&admission->lock);
+}
+
+void
+gst_rtsp_admission_get_rate (GstRTSPAdmission * admission, gdouble * rate,
+    guint * burst)
+{
+  g_mutex_lock (&admission->lock);
+  if (rate)
+    *rate = admission->rate;
+  if (burst)
+    *burst = admission->burst;
+  g_mutex_unlock (&admission->lock);
+}
+
+static gboolean
+bucket_is_full (Bucket * bucket, gpointer value, GstRTSPAdmission * admission)
+{
+  gint64 now = admission->last_sweep;
+
+  return bucket->tokens + admission->rate * (now - bucket->last) /
+      G_USEC_PER_SEC >= admission->burst;
+}
+
+/* with the lock, take a token from the bucket of @address */
+static gboolean
+take_token (GstRTSPAdmission * admission, const guint8 * address, gsize size)
+{
+  Bucket key, *bucket;
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+
+  if (now - admission->last_sweep >= SWEEP_INTERVAL) {
+    admission->last_sweep = now;
+    g_hash_table_foreach_remove (admission->buckets, (GHRFunc) bucket_is_full,
+        admission);
+  }
+
+  key.size = MIN (size, MAX_KEY_SIZE);
+  memcpy (key.key, address, key.size);
+
+  bucket = g_hash_table_lookup (admission->buckets, &key);
+  if (bucket == NULL) {
+    bucket = g_slice_new (Bucket);
+    *bucket = key;
+    bucket->tokens = admission->burst;
+    bucket->last = now;
+    g_hash_table_add (admission->buckets, bucket);
+  } else {
+    bucket->tokens = MIN (admission->burst, bucket->tokens +
+        admission->rate * (now - bucket->last) / G_USEC_PER_SEC);
+    bucket->last = now;
+  }
+
+  if (bucket->tokens < 1.0)
+    return FALSE;
+
+  bucket->tokens -= 1.0;
+
+  return TRUE;
+}
+
+/* check if a new connection from @address, the bytes of an IPv4 or IPv6
+ * address, can be handled. When it can, the connection is counted as pending
+ * until gst_rtsp_admission_handshake_done() and as a connection until
+ * gst_rtsp_admission_release(). */
+GstRTSPAdmissionResult
+gst_rtsp_admission_check (GstRTSPAdmission * admission,
+    const guint8 * address, gsize size)
+{
+  GstRTSPAdmissionResult result;
+
+  g_mutex_lock (&admission->lock);
+  if (admission->max_connections >= 0 &&
+      admission->connections >= admission->max_connections) {
+    admission->rejected_connections++;
+    result = GST_RTSP_ADMISSION_CONNECTIONS;
+  } else if (admission->max_pending >= 0 &&
+      admission->pending >= admission->max_pending) {
+    admission->rejected_pending++;
+    result = GST_RTSP_ADMISSION_PENDING;
+  } else if (admission->rate > 0.0 && size > 0 &&
+      !take_token (admission, address, size)) {
+    admission->rejected_rate++;
+    result = GST_RTSP_ADMISSION_RATE;
+  } else {
+    admission->connections++;
+    admission->pending++;
+    admission->accepted++;
+    result = GST_RTSP_ADMISSION_OK;
+  }
+  g_mutex_unlock (&admission->lock);
+
+  GST_LOG ("admission result %d", result);
+
+  return result;
+}
+
+/* an admitted connection completed its first request */
+void
+gst_rtsp_admission_handshake_done (GstRTSPAdmission * admission)
+{
+  g_mutex_lock (&admission->lock);
+  admission->pending--;
+  g_mutex_unlock (&admission->lock);
+}
+
+/* an admitted connection is closed, @pending when it did not complete its
+ * first request */
+void
+gst_rtsp_admission_release (GstRTSPAdmission * admission, gboolean pending)
+{
+  g_mutex_lock (&admission->lock);
+  admission->connections--;
+  if (pending)
+    admission->pending--;
+  g_mutex_unlock (&admission->lock);
+}
+
+GstStructure *
+gst_rtsp_admission_get_stats (GstRTSPAdmission * admission)
+{
+  GstStructure *result;
+
+  g_mutex_lock (&admission->lock);
+  result = gst_structure_new ("application/x-rtsp-admission-stats",
+      "connections", G_TYPE_INT, admission->connections,
+      "pending", G_TYPE_INT, admission->pending,
+      "accepted", G_TYPE_UINT64, admission->accepted,
+      "rejected-rate", G_TYPE_UINT64, admission->rejected_rate,
+      "rejected-connections", G_TYPE_UINT64, admission->rejected_connections,
+      "rejected-pending", G_TYPE_UINT64, admission->rejected_pending, NULL);
+  g_mutex_unlock (&admission->lock);
+
+  return result;
+}
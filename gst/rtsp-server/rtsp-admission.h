@@ -0,0 +1,70 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSP_ADMISSION_H__
+#define __GST_RTSP_ADMISSION_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstRTSPAdmission GstRTSPAdmission;
+
+typedef enum
+{
+  GST_RTSP_ADMISSION_OK,
+  GST_RTSP_ADMISSION_RATE,
+  GST_RTSP_ADMISSION_CONNECTIONS,
+  GST_RTSP_ADMISSION_PENDING
+} GstRTSPAdmissionResult;
+
+GstRTSPAdmission *     gst_rtsp_admission_new                 (void);
+
+void                   gst_rtsp_admission_free                (GstRTSPAdmission * admission);
+
+void                   gst_rtsp_admission_set_max_connections (GstRTSPAdmission * admission,
+                                                               gint max_connections);
+
+gint                   gst_rtsp_admission_get_max_connections (GstRTSPAdmission * admission);
+
+void                   gst_rtsp_admission_set_max_pending     (GstRTSPAdmission * admission,
+                                                               gint max_pending);
+
+gint                   gst_rtsp_admission_get_max_pending     (GstRTSPAdmission * admission);
+
+void                   gst_rtsp_admission_set_rate            (GstRTSPAdmission * admission,
+                                                               gdouble rate, guint burst);
+
+void                   gst_rtsp_admission_get_rate            (GstRTSPAdmission * admission,
+                                                               gdouble * rate, guint * burst);
+
+GstRTSPAdmissionResult gst_rtsp_admission_check               (GstRTSPAdmission * admission,
+                                                               const guint8 * address,
+                                                               gsize size);
+
+void                   gst_rtsp_admission_handshake_done      (GstRTSPAdmission * admission);
+
+void                   gst_rtsp_admission_release             (GstRTSPAdmission * admission,
+                                                               gboolean pending);
+
+GstStructure *         gst_rtsp_admission_get_stats           (GstRTSPAdmission * admission);
+
+G_END_DECLS
+
+#endif /* __GST_RTSP_ADMISSION_H__ */
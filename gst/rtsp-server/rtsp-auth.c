@@ -37,12 +37,25 @@
  * The default #GstRTSPAuth object has support for basic authentication. With
  * gst_rtsp_auth_add_basic() you can add a basic authentication string together
  * with the #GstRTSPToken that will become active when successfully
- * authenticated.
+ * authenticated. With gst_rtsp_auth_add_digest() Digest authentication is
+ * added in the same way, its nonces are configured with
+ * gst_rtsp_auth_set_digest_nonces().
+ *
+ * Subclasses that look up credentials elsewhere, for example in an external
+ * directory, implement the authenticate_async vfunc. The request of the client
+ * is suspended during the lookup so that the other clients of the same
+ * #GstRTSPThread are not blocked. The results are cached, see
+ * gst_rtsp_auth_set_lookup_cache().
  *
  * When a TLS certificate has been set with gst_rtsp_auth_set_tls_certificate(),
  * the default auth object will require the client to connect with a TLS
  * connection.
  *
+ * The TLS handshake itself, including session resumption with session
+ * tickets or a session cache, is done by the GIO TLS backend. The auth object
+ * only configures the certificate, database and authentication mode of the
+ * #GTlsConnection and can't change how sessions are resumed.
+ *
  * Last reviewed on 2013-07-16 (1.0.0)
  */
 #ifdef HAVE_CONFIG_H
@@ -53,6 +66,29 @@
 
 #include "rtsp-auth.h"
 
+/* digest nonces are a timestamp and an HMAC of the timestamp and the ip of
+ * the client, they are valid for the nonce timeout for clients that didn't
+ * use them yet */
+#define NONCE_KEY_SIZE          32
+#define NONCE_TIMESTAMP_LEN     16
+#define NONCE_HMAC_SIZE         16
+#define NONCE_LEN               (NONCE_TIMESTAMP_LEN + 2 * NONCE_HMAC_SIZE)
+
+#define DEFAULT_NONCE_TIMEOUT           (60 * GST_SECOND)
+#define DEFAULT_NONCE_REPLAY_SLOTS      4096
+
+#define DEFAULT_LOOKUP_CACHE_SIZE       1024
+#define DEFAULT_LOOKUP_TTL              (60 * GST_SECOND)
+#define DEFAULT_LOOKUP_NEGATIVE_TTL     (5 * GST_SECOND)
+
+/* the client that used a nonce, a weak ref so that a new client at the same
+ * address is not taken for it */
+typedef struct
+{
+  guint64 tag;
+  GWeakRef client;
+} GstRTSPNonceSlot;
+
 struct _GstRTSPAuthPrivate
 {
   GMutex lock;
@@ -62,8 +98,26 @@ struct _GstRTSPAuthPrivate
   GTlsDatabase *database;
   GTlsAuthenticationMode mode;
   GHashTable *basic;            /* protected by lock */
-  GHashTable *digest, *nonces;  /* protected by lock */
-  guint64 last_nonce_check;
+  GHashTable *digest;           /* protected by lock */
+  guint credentials_cookie;     /* protected by lock */
+
+  /* key of the digest nonces and the clients that used the nonces of the
+   * last nonce_timeout, protected by replay_lock. There are no slots when
+   * the nonces are not checked for replays */
+  guint8 nonce_key[NONCE_KEY_SIZE];
+  GMutex replay_lock;
+  gint64 nonce_timeout;
+  GstRTSPNonceSlot *replay;
+  guint n_replay;
+
+  /* results of authenticate_async, most recently used first in lookup_lru,
+   * protected by lock */
+  GHashTable *lookup_cache;
+  GQueue lookup_lru;
+  guint lookup_cache_size;
+  GstClockTime lookup_ttl;
+  GstClockTime lookup_negative_ttl;
+
   GstRTSPToken *default_token;
   GstRTSPMethod methods;
   GstRTSPAuthMethod auth_methods;
@@ -77,13 +131,68 @@ typedef struct
   gchar *md5_pass;
 } GstRTSPDigestEntry;
 
+/* a result of authenticate_async, the token is NULL for rejected
+ * credentials */
 typedef struct
 {
-  gchar *nonce;
-  gchar *ip;
-  guint64 timestamp;
-  gpointer client;
-} GstRTSPDigestNonce;
+  gchar *key;
+  GstRTSPToken *token;
+  gint64 expires;
+  GList link;
+} GstRTSPAuthLookupResult;
+
+/* a running authenticate_async call */
+typedef struct
+{
+  GstRTSPAuth *auth;
+  GstRTSPClient *client;
+  GstRTSPMethod method;
+  gchar *authorization;
+  gchar *key;
+} GstRTSPAuthLookup;
+
+/* the last authentication of a client, kept on the client. Only the results
+ * of authenticate_async can have a NULL token */
+typedef struct
+{
+  GstRTSPAuth *auth;
+  guint credentials_cookie;
+  GstRTSPMethod method;
+  gchar *authorization;
+  GstRTSPToken *token;
+} GstRTSPAuthCache;
+
+static GQuark auth_cache_quark;
+/* the digest nonce a client used */
+static GQuark auth_nonce_quark;
+
+static void
+gst_rtsp_auth_cache_free (GstRTSPAuthCache * cache)
+{
+  g_free (cache->authorization);
+  if (cache->token)
+    gst_rtsp_token_unref (cache->token);
+  g_free (cache);
+}
+
+static void
+gst_rtsp_auth_lookup_result_free (GstRTSPAuthLookupResult * result)
+{
+  g_free (result->key);
+  if (result->token)
+    gst_rtsp_token_unref (result->token);
+  g_free (result);
+}
+
+static void
+gst_rtsp_auth_lookup_free (GstRTSPAuthLookup * lookup)
+{
+  g_object_unref (lookup->auth);
+  g_object_unref (lookup->client);
+  g_free (lookup->authorization);
+  g_free (lookup->key);
+  g_free (lookup);
+}
 
 static void
 gst_rtsp_digest_entry_free (GstRTSPDigestEntry * entry)
@@ -94,12 +203,25 @@ gst_rtsp_digest_entry_free (GstRTSPDigestEntry * entry)
   g_free (entry);
 }
 
+/* with replay_lock, forget the clients that used nonces and keep @n_slots
+ * for the next ones */
 static void
-gst_rtsp_digest_nonce_free (GstRTSPDigestNonce * nonce)
+set_replay_slots (GstRTSPAuthPrivate * priv, guint n_slots)
 {
-  g_free (nonce->nonce);
-  g_free (nonce->ip);
-  g_free (nonce);
+  guint i;
+
+  for (i = 0; i < priv->n_replay; i++)
+    g_weak_ref_clear (&priv->replay[i].client);
+  g_free (priv->replay);
+  priv->replay = NULL;
+
+  priv->n_replay = n_slots;
+  if (n_slots == 0)
+    return;
+
+  priv->replay = g_new0 (GstRTSPNonceSlot, n_slots);
+  for (i = 0; i < n_slots; i++)
+    g_weak_ref_init (&priv->replay[i].client, NULL);
 }
 
 enum
@@ -116,6 +238,16 @@ enum
 
 static guint signals[SIGNAL_LAST] = { 0 };
 
+/* the checks, permissions and token fields of the default check function */
+static GQuark quark_check_connect;
+static GQuark quark_check_url;
+static GQuark quark_check_media_factory_access;
+static GQuark quark_check_media_factory_construct;
+static GQuark quark_check_transport_client_settings;
+static GQuark quark_perm_media_factory_access;
+static GQuark quark_perm_media_factory_construct;
+static GQuark quark_token_transport_client_settings;
+
 GST_DEBUG_CATEGORY_STATIC (rtsp_auth_debug);
 #define GST_CAT_DEFAULT rtsp_auth_debug
 
@@ -151,6 +283,26 @@ gst_rtsp_auth_class_init (GstRTSPAuthClass * klass)
 
   GST_DEBUG_CATEGORY_INIT (rtsp_auth_debug, "rtspauth", 0, "GstRTSPAuth");
 
+  auth_cache_quark = g_quark_from_static_string ("gst-rtsp-auth-cache");
+  auth_nonce_quark = g_quark_from_static_string ("gst-rtsp-auth-nonce");
+
+  quark_check_connect =
+      g_quark_from_static_string (GST_RTSP_AUTH_CHECK_CONNECT);
+  quark_check_url = g_quark_from_static_string (GST_RTSP_AUTH_CHECK_URL);
+  quark_check_media_factory_access =
+      g_quark_from_static_string (GST_RTSP_AUTH_CHECK_MEDIA_FACTORY_ACCESS);
+  quark_check_media_factory_construct =
+      g_quark_from_static_string (GST_RTSP_AUTH_CHECK_MEDIA_FACTORY_CONSTRUCT);
+  quark_check_transport_client_settings =
+      g_quark_from_static_string
+      (GST_RTSP_AUTH_CHECK_TRANSPORT_CLIENT_SETTINGS);
+  quark_perm_media_factory_access =
+      g_quark_from_static_string (GST_RTSP_PERM_MEDIA_FACTORY_ACCESS);
+  quark_perm_media_factory_construct =
+      g_quark_from_static_string (GST_RTSP_PERM_MEDIA_FACTORY_CONSTRUCT);
+  quark_token_transport_client_settings =
+      g_quark_from_static_string (GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS);
+
   /**
    * GstRTSPAuth::accept-certificate:
    * @auth: a #GstRTSPAuth
@@ -181,6 +333,7 @@ static void
 gst_rtsp_auth_init (GstRTSPAuth * auth)
 {
   GstRTSPAuthPrivate *priv;
+  guint i;
 
   auth->priv = priv = gst_rtsp_auth_get_instance_private (auth);
 
@@ -190,8 +343,20 @@ gst_rtsp_auth_init (GstRTSPAuth * auth)
       (GDestroyNotify) gst_rtsp_token_unref);
   priv->digest = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
       (GDestroyNotify) gst_rtsp_digest_entry_free);
-  priv->nonces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-      (GDestroyNotify) gst_rtsp_digest_nonce_free);
+  g_mutex_init (&priv->replay_lock);
+  for (i = 0; i < NONCE_KEY_SIZE; i += 4) {
+    guint32 r = g_random_int ();
+
+    memcpy (priv->nonce_key + i, &r, 4);
+  }
+  priv->nonce_timeout = GST_TIME_AS_USECONDS (DEFAULT_NONCE_TIMEOUT);
+  set_replay_slots (priv, DEFAULT_NONCE_REPLAY_SLOTS);
+  priv->lookup_cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) gst_rtsp_auth_lookup_result_free);
+  g_queue_init (&priv->lookup_lru);
+  priv->lookup_cache_size = DEFAULT_LOOKUP_CACHE_SIZE;
+  priv->lookup_ttl = DEFAULT_LOOKUP_TTL;
+  priv->lookup_negative_ttl = DEFAULT_LOOKUP_NEGATIVE_TTL;
 
   /* bitwise or of all methods that need authentication */
   priv->methods = 0;
@@ -213,7 +378,9 @@ gst_rtsp_auth_finalize (GObject * obj)
     g_object_unref (priv->database);
   g_hash_table_unref (priv->basic);
   g_hash_table_unref (priv->digest);
-  g_hash_table_unref (priv->nonces);
+  g_hash_table_unref (priv->lookup_cache);
+  set_replay_slots (priv, 0);
+  g_mutex_clear (&priv->replay_lock);
   g_mutex_clear (&priv->lock);
   g_free (priv->realm);
 
@@ -508,6 +675,7 @@ gst_rtsp_auth_add_basic (GstRTSPAuth * auth, const gchar * basic,
   g_mutex_lock (&priv->lock);
   g_hash_table_replace (priv->basic, g_strdup (basic),
       gst_rtsp_token_ref (token));
+  priv->credentials_cookie++;
   g_mutex_unlock (&priv->lock);
 }
 
@@ -530,6 +698,7 @@ gst_rtsp_auth_remove_basic (GstRTSPAuth * auth, const gchar * basic)
 
   g_mutex_lock (&priv->lock);
   g_hash_table_remove (priv->basic, basic);
+  priv->credentials_cookie++;
   g_mutex_unlock (&priv->lock);
 }
 
@@ -565,6 +734,7 @@ gst_rtsp_auth_add_digest (GstRTSPAuth * auth, const gchar * user,
 
   g_mutex_lock (&priv->lock);
   g_hash_table_replace (priv->digest, g_strdup (user), entry);
+  priv->credentials_cookie++;
   g_mutex_unlock (&priv->lock);
 }
 
@@ -654,6 +824,7 @@ gst_rtsp_auth_parse_htdigest (GstRTSPAuth * auth, const gchar * path,
   g_mutex_lock (&priv->lock);
   g_hash_table_foreach_steal (new_entries, (GHRFunc) update_digest_cb,
       priv->digest);
+  priv->credentials_cookie++;
   g_mutex_unlock (&priv->lock);
 
 done:
@@ -685,6 +856,7 @@ gst_rtsp_auth_remove_digest (GstRTSPAuth * auth, const gchar * user)
 
   g_mutex_lock (&priv->lock);
   g_hash_table_remove (priv->digest, user);
+  priv->credentials_cookie++;
   g_mutex_unlock (&priv->lock);
 }
 
@@ -739,24 +911,175 @@ gst_rtsp_auth_get_supported_methods (GstRTSPAuth * auth)
   return methods;
 }
 
-typedef struct
+/* make the nonce for @ip at @timestamp */
+static gchar *
+make_nonce (GstRTSPAuth * auth, const gchar * ip, gint64 timestamp)
 {
-  GstRTSPAuth *auth;
-  GstRTSPDigestNonce *nonce;
-} RemoveNonceData;
+  GstRTSPAuthPrivate *priv = auth->priv;
+  GHmac *hmac;
+  guint8 digest[32];
+  gsize digest_len = sizeof (digest);
+  gchar *nonce;
+  guint i;
 
-static void
-remove_nonce (gpointer data, GObject * object)
+  nonce = g_malloc (NONCE_LEN + 1);
+  g_snprintf (nonce, NONCE_TIMESTAMP_LEN + 1, "%016" G_GINT64_MODIFIER "x",
+      timestamp);
+
+  /* the key is never changed, no lock needed */
+  hmac = g_hmac_new (G_CHECKSUM_SHA256, priv->nonce_key, NONCE_KEY_SIZE);
+  g_hmac_update (hmac, (const guchar *) nonce, NONCE_TIMESTAMP_LEN);
+  g_hmac_update (hmac, (const guchar *) ip, strlen (ip));
+  g_hmac_get_digest (hmac, digest, &digest_len);
+  g_hmac_unref (hmac);
+
+  for (i = 0; i < NONCE_HMAC_SIZE; i++)
+    g_snprintf (nonce + NONCE_TIMESTAMP_LEN + 2 * i, 3, "%02x", digest[i]);
+
+  return nonce;
+}
+
+/* with replay_lock, TRUE when the nonce with @tag is not used by a client
+ * other than @client */
+static gboolean
+replay_slot_free (GstRTSPAuthPrivate * priv, guint64 tag,
+    GstRTSPClient * client)
 {
-  RemoveNonceData *remove_nonce_data = data;
+  GstRTSPNonceSlot *slot;
+  GstRTSPClient *used_by;
+  gboolean result;
+
+  if (priv->n_replay == 0)
+    return TRUE;
 
-  g_mutex_lock (&remove_nonce_data->auth->priv->lock);
-  g_hash_table_remove (remove_nonce_data->auth->priv->nonces,
-      remove_nonce_data->nonce->nonce);
-  g_mutex_unlock (&remove_nonce_data->auth->priv->lock);
+  slot = &priv->replay[tag % priv->n_replay];
+  if (slot->tag != tag)
+    return TRUE;
+
+  used_by = g_weak_ref_get (&slot->client);
+  result = used_by == NULL || used_by == client;
+  if (used_by)
+    g_object_unref (used_by);
 
-  g_object_unref (remove_nonce_data->auth);
-  g_free (remove_nonce_data);
+  return result;
+}
+
+/* check if @nonce was made for the client of @ctx. A nonce is valid for the
+ * nonce timeout and after that only for the client that used it. The replay
+ * slots make sure that only one client uses a nonce in that time, with a
+ * fixed amount of memory. Nothing is changed, the nonce is only marked as
+ * used by use_nonce() when the response of the client was checked */
+static gboolean
+check_nonce (GstRTSPAuth * auth, GstRTSPContext * ctx, const gchar * nonce,
+    guint64 * tag)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
+  gchar timestr[NONCE_TIMESTAMP_LEN + 1], *end;
+  gchar *expected;
+  const gchar *used;
+  gint64 timestamp;
+  gboolean expired, replayed;
+  guint i, diff;
+
+  if (strlen (nonce) != NONCE_LEN)
+    return FALSE;
+
+  memcpy (timestr, nonce, NONCE_TIMESTAMP_LEN);
+  timestr[NONCE_TIMESTAMP_LEN] = '\0';
+  timestamp = g_ascii_strtoll (timestr, &end, 16);
+  if (end != timestr + NONCE_TIMESTAMP_LEN)
+    return FALSE;
+
+  /* compare all of the nonce so that the time doesn't tell how much of it
+   * was right */
+  expected = make_nonce (auth, gst_rtsp_connection_get_ip (ctx->conn),
+      timestamp);
+  diff = 0;
+  for (i = 0; i < NONCE_LEN; i++)
+    diff |= nonce[i] ^ expected[i];
+  g_free (expected);
+  if (diff != 0)
+    goto invalid_nonce;
+
+  *tag = g_ascii_strtoull (nonce + NONCE_LEN - 16, NULL, 16);
+
+  /* the nonce the client used before */
+  if (ctx->client) {
+    used = g_object_get_qdata (G_OBJECT (ctx->client), auth_nonce_quark);
+    if (used && strcmp (used, nonce) == 0)
+      return TRUE;
+  }
+
+  g_mutex_lock (&priv->replay_lock);
+  expired = g_get_monotonic_time () - timestamp >= priv->nonce_timeout;
+  replayed = ctx->client && !replay_slot_free (priv, *tag, ctx->client);
+  g_mutex_unlock (&priv->replay_lock);
+
+  if (expired)
+    goto expired_nonce;
+  if (replayed)
+    goto replayed_nonce;
+
+  return TRUE;
+
+  /* ERRORS */
+invalid_nonce:
+  {
+    GST_DEBUG_OBJECT (auth, "invalid nonce %s", nonce);
+    return FALSE;
+  }
+expired_nonce:
+  {
+    GST_DEBUG_OBJECT (auth, "expired nonce %s", nonce);
+    return FALSE;
+  }
+replayed_nonce:
+  {
+    GST_DEBUG_OBJECT (auth, "nonce %s was used by another client", nonce);
+    return FALSE;
+  }
+}
+
+/* mark @nonce, checked with check_nonce(), as used by the client of @ctx.
+ * Fails when another client used it after it was checked */
+static gboolean
+use_nonce (GstRTSPAuth * auth, GstRTSPContext * ctx, const gchar * nonce,
+    guint64 tag)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
+  GstRTSPNonceSlot *slot;
+  const gchar *used;
+
+  if (ctx->client == NULL)
+    return TRUE;
+
+  used = g_object_get_qdata (G_OBJECT (ctx->client), auth_nonce_quark);
+  if (used && strcmp (used, nonce) == 0)
+    return TRUE;
+
+  g_mutex_lock (&priv->replay_lock);
+  if (!replay_slot_free (priv, tag, ctx->client)) {
+    g_mutex_unlock (&priv->replay_lock);
+    goto replayed_nonce;
+  }
+  if (priv->n_replay > 0) {
+    slot = &priv->replay[tag % priv->n_replay];
+    slot->tag = tag;
+    g_weak_ref_set (&slot->client, ctx->client);
+  }
+  g_mutex_unlock (&priv->replay_lock);
+
+  g_object_set_qdata_full (G_OBJECT (ctx->client), auth_nonce_quark,
+      g_strdup (nonce), g_free);
+
+  return TRUE;
+
+  /* ERRORS */
+replayed_nonce:
+  {
+    GST_DEBUG_OBJECT (auth, "nonce %s was used by another client", nonce);
+    return FALSE;
+  }
 }
 
 static gboolean
@@ -765,9 +1088,11 @@ default_digest_auth (GstRTSPAuth * auth, GstRTSPContext * ctx,
 {
   const gchar *realm = NULL, *user = NULL, *nonce = NULL;
   const gchar *response = NULL, *uri = NULL;
-  GstRTSPDigestNonce *nonce_entry = NULL;
   GstRTSPDigestEntry *digest_entry;
+  GstRTSPToken *token;
+  gchar *pass, *md5_pass;
   gchar *expected_response = NULL;
+  guint64 tag = 0;
   gboolean ret = FALSE;
 
   GST_DEBUG_OBJECT (auth, "check Digest auth");
@@ -795,64 +1120,129 @@ default_digest_auth (GstRTSPAuth * auth, GstRTSPContext * ctx,
   if (!realm || !user || !nonce || !response || !uri)
     return FALSE;
 
+  if (!check_nonce (auth, ctx, nonce, &tag))
+    return FALSE;
+
   g_mutex_lock (&auth->priv->lock);
   digest_entry = g_hash_table_lookup (auth->priv->digest, user);
-  if (!digest_entry)
-    goto out;
-  nonce_entry = g_hash_table_lookup (auth->priv->nonces, nonce);
-  if (!nonce_entry)
-    goto out;
-
-  if (strcmp (nonce_entry->ip, gst_rtsp_connection_get_ip (ctx->conn)) != 0)
-    goto out;
-  if (nonce_entry->client && nonce_entry->client != ctx->client)
-    goto out;
-
-  if (digest_entry->md5_pass) {
+  if (!digest_entry) {
+    g_mutex_unlock (&auth->priv->lock);
+    return FALSE;
+  }
+  token = gst_rtsp_token_ref (digest_entry->token);
+  pass = g_strdup (digest_entry->pass);
+  md5_pass = g_strdup (digest_entry->md5_pass);
+  g_mutex_unlock (&auth->priv->lock);
+
+  if (md5_pass) {
     expected_response = gst_rtsp_generate_digest_auth_response_from_md5 (NULL,
-        gst_rtsp_method_as_text (ctx->method), digest_entry->md5_pass,
-        uri, nonce);
+        gst_rtsp_method_as_text (ctx->method), md5_pass, uri, nonce);
   } else {
     expected_response =
         gst_rtsp_generate_digest_auth_response (NULL,
-        gst_rtsp_method_as_text (ctx->method), realm, user,
-        digest_entry->pass, uri, nonce);
+        gst_rtsp_method_as_text (ctx->method), realm, user, pass, uri, nonce);
   }
 
-  if (!expected_response || strcmp (response, expected_response) != 0)
-    goto out;
-
-  ctx->token = digest_entry->token;
-  ret = TRUE;
-
-out:
-  if (nonce_entry && !nonce_entry->client) {
-    RemoveNonceData *remove_nonce_data = g_new (RemoveNonceData, 1);
-
-    nonce_entry->client = ctx->client;
-    remove_nonce_data->nonce = nonce_entry;
-    remove_nonce_data->auth = g_object_ref (auth);
-    g_object_weak_ref (G_OBJECT (ctx->client), remove_nonce, remove_nonce_data);
+  /* the nonce is only used up by a client that knows the password */
+  if (expected_response && strcmp (response, expected_response) == 0 &&
+      use_nonce (auth, ctx, nonce, tag)) {
+    /* the entry keeps a ref to the token */
+    ctx->token = token;
+    ret = TRUE;
   }
-  g_mutex_unlock (&auth->priv->lock);
 
+  gst_rtsp_token_unref (token);
+  g_free (pass);
+  g_free (md5_pass);
   g_free (expected_response);
 
   return ret;
 }
 
+/* get the single Authorization header of the request, requests with more
+ * headers are not cached */
+static const gchar *
+get_authorization (GstRTSPContext * ctx)
+{
+  gchar *value, *other;
+
+  if (ctx->client == NULL || ctx->request == NULL)
+    return NULL;
+
+  if (gst_rtsp_message_get_header (ctx->request, GST_RTSP_HDR_AUTHORIZATION,
+          &value, 0) != GST_RTSP_OK)
+    return NULL;
+  if (gst_rtsp_message_get_header (ctx->request, GST_RTSP_HDR_AUTHORIZATION,
+          &other, 1) == GST_RTSP_OK)
+    return NULL;
+
+  return value;
+}
+
+/* with lock, use the token of the last authentication of the client when the
+ * request has the same Authorization header. Digest responses also depend on
+ * the method */
+static gboolean
+use_auth_cache (GstRTSPAuth * auth, GstRTSPContext * ctx,
+    const gchar * authorization)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
+  GstRTSPAuthCache *cache;
+
+  cache = g_object_get_qdata (G_OBJECT (ctx->client), auth_cache_quark);
+  if (cache == NULL || cache->auth != auth ||
+      cache->credentials_cookie != priv->credentials_cookie ||
+      cache->method != ctx->method ||
+      strcmp (cache->authorization, authorization) != 0)
+    return FALSE;
+
+  GST_LOG_OBJECT (auth, "using cached token %p", cache->token);
+  ctx->token = cache->token;
+
+  return TRUE;
+}
+
+/* with lock, @credentials_cookie is the cookie from before the
+ * authentication so that a change during the authentication is noticed */
+static void
+set_auth_cache (GstRTSPAuth * auth, GstRTSPClient * client,
+    GstRTSPMethod method, const gchar * authorization, GstRTSPToken * token,
+    guint credentials_cookie)
+{
+  GstRTSPAuthCache *cache;
+
+  cache = g_new0 (GstRTSPAuthCache, 1);
+  cache->auth = auth;
+  cache->credentials_cookie = credentials_cookie;
+  cache->method = method;
+  cache->authorization = g_strdup (authorization);
+  cache->token = token ? gst_rtsp_token_ref (token) : NULL;
+
+  g_object_set_qdata_full (G_OBJECT (client), auth_cache_quark, cache,
+      (GDestroyNotify) gst_rtsp_auth_cache_free);
+}
+
 static gboolean
 default_authenticate (GstRTSPAuth * auth, GstRTSPContext * ctx)
 {
   GstRTSPAuthPrivate *priv = auth->priv;
   GstRTSPAuthCredential **credentials, **credential;
+  const gchar *authorization;
+  guint cookie;
 
   GST_DEBUG_OBJECT (auth, "authenticate");
 
+  authorization = get_authorization (ctx);
+
   g_mutex_lock (&priv->lock);
+  if (authorization && use_auth_cache (auth, ctx, authorization)) {
+    g_mutex_unlock (&priv->lock);
+    return TRUE;
+  }
   /* FIXME, need to ref but we have no way to unref when the ctx is
    * popped */
   ctx->token = priv->default_token;
+  cookie = priv->credentials_cookie;
   g_mutex_unlock (&priv->lock);
 
   credentials =
@@ -886,6 +1276,15 @@ default_authenticate (GstRTSPAuth * auth, GstRTSPContext * ctx)
     credential++;
   }
 
+  /* keep the token of a successful authentication for the next requests of
+   * the client */
+  if (*credential && authorization) {
+    g_mutex_lock (&priv->lock);
+    set_auth_cache (auth, ctx->client, ctx->method, authorization, ctx->token,
+        cookie);
+    g_mutex_unlock (&priv->lock);
+  }
+
   gst_rtsp_auth_credentials_free (credentials);
   return TRUE;
 
@@ -908,46 +1307,174 @@ default_generate_authenticate_header (GstRTSPAuth * auth, GstRTSPContext * ctx)
   }
 
   if (auth->priv->auth_methods & GST_RTSP_AUTH_DIGEST) {
-    GstRTSPDigestNonce *nonce;
-    gchar *nonce_value, *auth_header;
+    gchar *nonce, *auth_header;
 
-    nonce_value =
-        g_strdup_printf ("%08x%08x", g_random_int (), g_random_int ());
+    nonce = make_nonce (auth, gst_rtsp_connection_get_ip (ctx->conn),
+        g_get_monotonic_time ());
 
     auth_header =
         g_strdup_printf
-        ("Digest realm=\"%s\", nonce=\"%s\"", auth->priv->realm, nonce_value);
+        ("Digest realm=\"%s\", nonce=\"%s\"", auth->priv->realm, nonce);
     gst_rtsp_message_add_header (ctx->response, GST_RTSP_HDR_WWW_AUTHENTICATE,
         auth_header);
     g_free (auth_header);
+    g_free (nonce);
+  }
+}
 
-    nonce = g_new0 (GstRTSPDigestNonce, 1);
-    nonce->nonce = g_strdup (nonce_value);
-    nonce->timestamp = g_get_monotonic_time ();
-    nonce->ip = g_strdup (gst_rtsp_connection_get_ip (ctx->conn));
-    g_mutex_lock (&auth->priv->lock);
-    g_hash_table_replace (auth->priv->nonces, nonce_value, nonce);
+/* the results of Digest credentials are only valid for the method of the
+ * request */
+static gchar *
+make_lookup_key (GstRTSPContext * ctx, const gchar * authorization)
+{
+  if (g_ascii_strncasecmp (authorization, "Digest ", 7) == 0)
+    return g_strdup_printf ("%s %s", gst_rtsp_method_as_text (ctx->method),
+        authorization);
 
-    if (auth->priv->last_nonce_check == 0)
-      auth->priv->last_nonce_check = nonce->timestamp;
+  return g_strdup (authorization);
+}
 
-    /* 30 second nonce timeout */
-    if (nonce->timestamp - auth->priv->last_nonce_check >= 30 * G_USEC_PER_SEC) {
-      GHashTableIter iter;
-      gpointer key, value;
+/* with lock */
+static void
+remove_lookup_result (GstRTSPAuth * auth, GstRTSPAuthLookupResult * result)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
 
-      g_hash_table_iter_init (&iter, auth->priv->nonces);
-      while (g_hash_table_iter_next (&iter, &key, &value)) {
-        GstRTSPDigestNonce *tmp = value;
+  g_queue_unlink (&priv->lookup_lru, &result->link);
+  g_hash_table_remove (priv->lookup_cache, result->key);
+}
 
-        if (!tmp->client
-            && nonce->timestamp - tmp->timestamp >= 30 * G_USEC_PER_SEC)
-          g_hash_table_iter_remove (&iter);
-      }
-      auth->priv->last_nonce_check = nonce->timestamp;
-    }
+/* with lock, returns FALSE when there is no result for @key */
+static gboolean
+get_lookup_result (GstRTSPAuth * auth, const gchar * key,
+    GstRTSPToken ** token)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
+  GstRTSPAuthLookupResult *result;
 
-    g_mutex_unlock (&auth->priv->lock);
+  if (!(result = g_hash_table_lookup (priv->lookup_cache, key)))
+    return FALSE;
+
+  if (result->expires <= g_get_monotonic_time ()) {
+    remove_lookup_result (auth, result);
+    return FALSE;
+  }
+
+  g_queue_unlink (&priv->lookup_lru, &result->link);
+  g_queue_push_head_link (&priv->lookup_lru, &result->link);
+  *token = result->token;
+
+  return TRUE;
+}
+
+/* with lock */
+static void
+add_lookup_result (GstRTSPAuth * auth, const gchar * key,
+    GstRTSPToken * token)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
+  GstRTSPAuthLookupResult *result;
+  GstClockTime ttl;
+
+  ttl = token ? priv->lookup_ttl : priv->lookup_negative_ttl;
+  if (priv->lookup_cache_size == 0 || ttl == 0)
+    return;
+
+  if ((result = g_hash_table_lookup (priv->lookup_cache, key)))
+    remove_lookup_result (auth, result);
+
+  /* make room by dropping the least recently used results */
+  while (g_hash_table_size (priv->lookup_cache) >= priv->lookup_cache_size)
+    remove_lookup_result (auth, g_queue_peek_tail (&priv->lookup_lru));
+
+  result = g_new0 (GstRTSPAuthLookupResult, 1);
+  result->key = g_strdup (key);
+  result->token = token ? gst_rtsp_token_ref (token) : NULL;
+  result->expires = g_get_monotonic_time () + GST_TIME_AS_USECONDS (ttl);
+  result->link.data = result;
+
+  g_hash_table_insert (priv->lookup_cache, result->key, result);
+  g_queue_push_head_link (&priv->lookup_lru, &result->link);
+}
+
+/* called from any thread when authenticate_async is done */
+static void
+lookup_done (GstRTSPAuth * auth, GstRTSPToken * token,
+    GstRTSPAuthLookup * lookup)
+{
+  GstRTSPAuthPrivate *priv = lookup->auth->priv;
+
+  GST_DEBUG_OBJECT (lookup->auth, "credentials %s, resuming client %p",
+      token ? "accepted" : "rejected", lookup->client);
+
+  /* the resumed request finds the result on the client, also when the result
+   * is not cached */
+  g_mutex_lock (&priv->lock);
+  add_lookup_result (lookup->auth, lookup->key, token);
+  set_auth_cache (lookup->auth, lookup->client, lookup->method,
+      lookup->authorization, token, priv->credentials_cookie);
+  g_mutex_unlock (&priv->lock);
+
+  gst_rtsp_client_resume_request (lookup->client);
+
+  gst_rtsp_auth_lookup_free (lookup);
+}
+
+/* authenticate with authenticate_async, returns FALSE when the request was
+ * suspended to look up the credentials */
+static gboolean
+lookup_credentials (GstRTSPAuth * auth, GstRTSPContext * ctx,
+    const gchar * authorization)
+{
+  GstRTSPAuthPrivate *priv = auth->priv;
+  GstRTSPAuthClass *klass;
+  GstRTSPAuthLookup *lookup;
+  GstRTSPToken *token;
+  gchar *key;
+
+  key = make_lookup_key (ctx, authorization);
+
+  g_mutex_lock (&priv->lock);
+  /* the result of the lookup for a resumed request or the last request of
+   * the client */
+  if (use_auth_cache (auth, ctx, authorization))
+    goto done;
+
+  if (get_lookup_result (auth, key, &token)) {
+    GST_LOG_OBJECT (auth, "using cached lookup result %p", token);
+    /* the client keeps the token alive while the request uses it */
+    set_auth_cache (auth, ctx->client, ctx->method, authorization, token,
+        priv->credentials_cookie);
+    ctx->token = token;
+    goto done;
+  }
+  g_mutex_unlock (&priv->lock);
+
+  GST_DEBUG_OBJECT (auth, "looking up credentials of client %p",
+      ctx->client);
+
+  lookup = g_new0 (GstRTSPAuthLookup, 1);
+  lookup->auth = g_object_ref (auth);
+  lookup->client = g_object_ref (ctx->client);
+  lookup->method = ctx->method;
+  lookup->authorization = g_strdup (authorization);
+  lookup->key = key;
+
+  /* suspend first, the lookup can be done before authenticate_async
+   * returns */
+  gst_rtsp_client_suspend_request (ctx->client, ctx);
+
+  klass = GST_RTSP_AUTH_GET_CLASS (auth);
+  klass->authenticate_async (auth, ctx, (GstRTSPAuthResultFunc) lookup_done,
+      lookup);
+
+  return FALSE;
+
+done:
+  {
+    g_mutex_unlock (&priv->lock);
+    g_free (key);
+    return TRUE;
   }
 }
 
@@ -972,12 +1499,17 @@ static gboolean
 ensure_authenticated (GstRTSPAuth * auth, GstRTSPContext * ctx)
 {
   GstRTSPAuthClass *klass;
+  const gchar *authorization;
 
   klass = GST_RTSP_AUTH_GET_CLASS (auth);
 
   /* we need a token to check */
   if (ctx->token == NULL) {
-    if (klass->authenticate) {
+    if (klass->authenticate_async &&
+        (authorization = get_authorization (ctx))) {
+      if (!lookup_credentials (auth, ctx, authorization))
+        goto suspended;
+    } else if (klass->authenticate) {
       if (!klass->authenticate (auth, ctx))
         goto authenticate_failed;
     }
@@ -988,6 +1520,11 @@ ensure_authenticated (GstRTSPAuth * auth, GstRTSPContext * ctx)
   return TRUE;
 
 /* ERRORS */
+suspended:
+  {
+    GST_DEBUG_OBJECT (auth, "request suspended until credentials are known");
+    return FALSE;
+  }
 authenticate_failed:
   {
     GST_DEBUG_OBJECT (auth, "authenticate failed");
@@ -1060,27 +1597,26 @@ not_authenticated:
 
 /* check access to media factory */
 static gboolean
-check_factory (GstRTSPAuth * auth, GstRTSPContext * ctx, const gchar * check)
+check_factory (GstRTSPAuth * auth, GstRTSPContext * ctx, GQuark check)
 {
-  const gchar *role;
+  GQuark role_id;
   GstRTSPPermissions *perms;
 
   if (!ensure_authenticated (auth, ctx))
     return FALSE;
 
-  if (!(role = gst_rtsp_token_get_string (ctx->token,
-              GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE)))
+  if (!(role_id = gst_rtsp_token_get_role_id (ctx->token)))
     goto no_media_role;
   if (!(perms = gst_rtsp_media_factory_get_permissions (ctx->factory)))
     goto no_permissions;
 
-  if (g_str_equal (check, GST_RTSP_AUTH_CHECK_MEDIA_FACTORY_ACCESS)) {
-    if (!gst_rtsp_permissions_is_allowed (perms, role,
-            GST_RTSP_PERM_MEDIA_FACTORY_ACCESS))
+  if (check == quark_check_media_factory_access) {
+    if (!gst_rtsp_permissions_is_allowed_id (perms, role_id,
+            quark_perm_media_factory_access))
       goto no_access;
-  } else if (g_str_equal (check, GST_RTSP_AUTH_CHECK_MEDIA_FACTORY_CONSTRUCT)) {
-    if (!gst_rtsp_permissions_is_allowed (perms, role,
-            GST_RTSP_PERM_MEDIA_FACTORY_CONSTRUCT))
+  } else if (check == quark_check_media_factory_construct) {
+    if (!gst_rtsp_permissions_is_allowed_id (perms, role_id,
+            quark_perm_media_factory_construct))
       goto no_construct;
   }
 
@@ -1124,24 +1660,31 @@ check_client_settings (GstRTSPAuth * auth, GstRTSPContext * ctx,
   if (!ensure_authenticated (auth, ctx))
     return FALSE;
 
-  return gst_rtsp_token_is_allowed (ctx->token,
-      GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS);
+  return gst_rtsp_token_is_allowed_id (ctx->token,
+      quark_token_transport_client_settings);
 }
 
 static gboolean
 default_check (GstRTSPAuth * auth, GstRTSPContext * ctx, const gchar * check)
 {
   gboolean res = FALSE;
+  GQuark id;
 
-  /* FIXME, use hastable or so */
-  if (g_str_equal (check, GST_RTSP_AUTH_CHECK_CONNECT)) {
-    res = check_connect (auth, ctx, check);
-  } else if (g_str_equal (check, GST_RTSP_AUTH_CHECK_URL)) {
+  /* the checks are interned in class_init, other checks have no quark or a
+   * quark that is not one of ours */
+  id = g_quark_try_string (check);
+
+  if (id == quark_check_url) {
     res = check_url (auth, ctx, check);
-  } else if (g_str_has_prefix (check, "auth.check.media.factory.")) {
-    res = check_factory (auth, ctx, check);
-  } else if (g_str_equal (check, GST_RTSP_AUTH_CHECK_TRANSPORT_CLIENT_SETTINGS)) {
+  } else if (id == quark_check_media_factory_access ||
+      id == quark_check_media_factory_construct) {
+    res = check_factory (auth, ctx, id);
+  } else if (id == quark_check_connect) {
+    res = check_connect (auth, ctx, check);
+  } else if (id == quark_check_transport_client_settings) {
     res = check_client_settings (auth, ctx, check);
+  } else if (g_str_has_prefix (check, "auth.check.media.factory.")) {
+    res = check_factory (auth, ctx, id);
   }
   return res;
 }
@@ -1159,6 +1702,84 @@ no_auth_check (const gchar * check)
   return res;
 }
 
+/**
+ * gst_rtsp_auth_set_lookup_cache:
+ * @auth: a #GstRTSPAuth
+ * @size: the maximum number of results to keep, 0 disables the cache
+ * @ttl: how long accepted credentials are kept
+ * @negative_ttl: how long rejected credentials are kept
+ *
+ * Configure the cache of the results of the authenticate_async vfunc of
+ * @auth. The results are shared between the clients and found with the
+ * Authorization header of a request so that the credentials are not looked
+ * up for every new client. Results that are not used for the longest time are
+ * dropped first when the cache is full.
+ *
+ * The cache keeps 1024 results by default, accepted credentials for 60 seconds
+ * and rejected credentials for 5 seconds. Configuring the cache clears it.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_auth_set_lookup_cache (GstRTSPAuth * auth, guint size,
+    GstClockTime ttl, GstClockTime negative_ttl)
+{
+  GstRTSPAuthPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_AUTH (auth));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (ttl));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (negative_ttl));
+
+  priv = auth->priv;
+
+  g_mutex_lock (&priv->lock);
+  g_hash_table_remove_all (priv->lookup_cache);
+  g_queue_init (&priv->lookup_lru);
+  priv->lookup_cache_size = size;
+  priv->lookup_ttl = ttl;
+  priv->lookup_negative_ttl = negative_ttl;
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gst_rtsp_auth_set_digest_nonces:
+ * @auth: a #GstRTSPAuth
+ * @timeout: how long a nonce can be used by a new client
+ * @replay_slots: the number of nonces of which the client is remembered,
+ *   0 disables the replay check
+ *
+ * Configure the nonces of Digest authentication. The nonces are not stored,
+ * they contain the time they were made and are signed with the ip of the
+ * client. A nonce is accepted for @timeout, after that it is only accepted
+ * from the client that used it.
+ *
+ * When @replay_slots is not 0, the client that used a nonce is remembered in
+ * one of @replay_slots slots and other clients are refused the nonce while
+ * it is remembered. When it is 0, all clients at the ip of the nonce can use
+ * it until it times out.
+ *
+ * Nonces time out after 60 seconds and 4096 replay slots are used by
+ * default. Configuring the nonces forgets the clients that used them.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_auth_set_digest_nonces (GstRTSPAuth * auth, GstClockTime timeout,
+    guint replay_slots)
+{
+  GstRTSPAuthPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_AUTH (auth));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (timeout));
+
+  priv = auth->priv;
+
+  g_mutex_lock (&priv->replay_lock);
+  priv->nonce_timeout = GST_TIME_AS_USECONDS (timeout);
+  set_replay_slots (priv, replay_slots);
+  g_mutex_unlock (&priv->replay_lock);
+}
+
 /**
  * gst_rtsp_auth_check:
  * @check: the item to check
@@ -41,6 +41,21 @@ G_BEGIN_DECLS
 #define GST_RTSP_AUTH_CAST(obj)         ((GstRTSPAuth*)(obj))
 #define GST_RTSP_AUTH_CLASS_CAST(klass) ((GstRTSPAuthClass*)(klass))
 
+/**
+ * GstRTSPAuthResultFunc:
+ * @auth: a #GstRTSPAuth
+ * @token: (allow-none): the #GstRTSPToken of the credentials or %NULL when
+ *   the credentials were rejected
+ * @user_data: user data
+ *
+ * Function called when the credentials that were passed to the
+ * authenticate_async vfunc of @auth are looked up.
+ *
+ * Since: 1.18
+ */
+typedef void (*GstRTSPAuthResultFunc) (GstRTSPAuth *auth, GstRTSPToken *token,
+                                       gpointer user_data);
+
 /**
  * GstRTSPAuth:
  *
@@ -65,6 +80,14 @@ struct _GstRTSPAuth {
  *         should also construct and send an appropriate response message on
  *         error.
  *
+ * @authenticate_async: look up the credentials in the Authorization header of
+ *         the request in @ctx without blocking, for example in an external
+ *         directory. The request is suspended until @func is called, exactly
+ *         once and from any thread, with the token of the credentials or %NULL
+ *         when they are rejected. @ctx is only valid during the call. When
+ *         this is implemented, it is used instead of authenticate for the
+ *         requests with an Authorization header. Since: 1.18
+ *
  * The authentication class.
  */
 struct _GstRTSPAuthClass {
@@ -78,8 +101,11 @@ struct _GstRTSPAuthClass {
                                             GTlsConnection *connection,
                                             GTlsCertificate *peer_cert,
                                             GTlsCertificateFlags errors);
+  void               (*authenticate_async) (GstRTSPAuth *auth, GstRTSPContext *ctx,
+                                            GstRTSPAuthResultFunc func,
+                                            gpointer user_data);
   /*< private >*/
-  gpointer            _gst_reserved[GST_PADDING - 1];
+  gpointer            _gst_reserved[GST_PADDING - 2];
 };
 
 GST_RTSP_SERVER_API
@@ -132,6 +158,15 @@ void                gst_rtsp_auth_set_supported_methods (GstRTSPAuth *auth, GstR
 GST_RTSP_SERVER_API
 GstRTSPAuthMethod   gst_rtsp_auth_get_supported_methods (GstRTSPAuth *auth);
 
+GST_RTSP_SERVER_API
+void                gst_rtsp_auth_set_lookup_cache  (GstRTSPAuth *auth, guint size,
+                                                     GstClockTime ttl,
+                                                     GstClockTime negative_ttl);
+
+GST_RTSP_SERVER_API
+void                gst_rtsp_auth_set_digest_nonces (GstRTSPAuth *auth, GstClockTime timeout,
+                                                     guint replay_slots);
+
 GST_RTSP_SERVER_API
 gboolean            gst_rtsp_auth_check             (const gchar *check);
 
@@ -53,6 +53,8 @@
 #include "rtsp-client.h"
 #include "rtsp-sdp.h"
 #include "rtsp-params.h"
+#include "rtsp-tunnels.h"
+#include "rtsp-server-internal.h"
 
 typedef enum
 {
@@ -62,7 +64,7 @@ typedef enum
 } GstRTSPTunnelState;
 
 /* locking order:
- * send_lock, lock, tunnels_lock
+ * send_lock, lock, the locks of the tunnels
  */
 
 struct _GstRTSPClientPrivate
@@ -73,9 +75,15 @@ struct _GstRTSPClientPrivate
   GstRTSPConnection *connection;
   GstRTSPWatch *watch;
   GMainContext *watch_context;
+  GstRTSPThread *thread;        /* the thread running watch_context or NULL */
   gchar *server_ip;
   gboolean is_ipv6;
 
+  /* the url of the last request, reused when the next request is for the
+   * same uri, like the keep-alive requests of a client */
+  gchar *request_uristr;
+  GstRTSPUrl *request_uri;
+
   /* protected by send_lock */
   GstRTSPClientSendFunc send_func;
   gpointer send_data;
@@ -85,6 +93,7 @@ struct _GstRTSPClientPrivate
   GDestroyNotify send_messages_notify;
   guint close_seq;
   GArray *data_seqs;
+  guint data_backlog;           /* data messages queued in the watch */
 
   GstRTSPSessionPool *session_pool;
   gulong session_removed_id;
@@ -102,6 +111,20 @@ struct _GstRTSPClientPrivate
   guint sessions_cookie;
 
   gboolean drop_backlog;
+  gboolean async_prepare;
+
+  /* the request waiting for its media to be prepared asynchronously or for
+   * gst_rtsp_client_resume_request() and the requests that arrived in the
+   * meantime */
+  GstRTSPMessage *suspended_request;
+  GQueue pending_requests;
+  gboolean resuming;
+  /* the pre-request signal of the current request was emitted, it is not
+   * emitted again when the request is resumed */
+  gboolean pre_request_emitted;
+  /* the context to resume the request from, ref taken when the request was
+   * suspended, protected by lock */
+  GMainContext *resume_context;
 
   guint content_length_limit;
 
@@ -113,22 +136,37 @@ struct _GstRTSPClientPrivate
 
   GHashTable *pipelined_requests;       /* pipelined_request_id -> session_id */
   GstRTSPTunnelState tstate;
+  GstRTSPTunnels *tunnels;      /* the pending tunnels of the server or NULL */
 };
 
 typedef struct
 {
   guint8 channel;
   guint seq;
+  guint n_messages;             /* data messages in the queued message seq */
 } DataSeq;
 
-static GMutex tunnels_lock;
-static GHashTable *tunnels;     /* protected by tunnels_lock */
+/* the pending tunnels of the clients that are not handled by a server */
+static GstRTSPTunnels *default_tunnels;
+
+static inline GstRTSPTunnels *
+get_tunnels (GstRTSPClient * client)
+{
+  GstRTSPTunnels *tunnels = client->priv->tunnels;
+
+  return tunnels ? tunnels : default_tunnels;
+}
 
 #define WATCH_BACKLOG_SIZE              100
 
+/* the requests that are queued while a request is suspended, the ones that
+ * arrive after that are refused */
+#define MAX_PENDING_REQUESTS            16
+
 #define DEFAULT_SESSION_POOL            NULL
 #define DEFAULT_MOUNT_POINTS            NULL
 #define DEFAULT_DROP_BACKLOG            TRUE
+#define DEFAULT_ASYNC_PREPARE           FALSE
 
 #define RTSP_CTRL_CB_INTERVAL           1
 #define RTSP_CTRL_TIMEOUT_VALUE         60
@@ -139,6 +177,7 @@ enum
   PROP_SESSION_POOL,
   PROP_MOUNT_POINTS,
   PROP_DROP_BACKLOG,
+  PROP_ASYNC_PREPARE,
   PROP_LAST
 };
 
@@ -254,6 +293,22 @@ gst_rtsp_client_class_init (GstRTSPClientClass * klass)
           "Drop data when the backlog queue is full",
           DEFAULT_DROP_BACKLOG, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPClient:async-prepare:
+   *
+   * Prepare the media without blocking the main context of the client. The
+   * request that needs the media is suspended until the media is prepared,
+   * requests that arrive in the meantime are handled afterwards, in order.
+   *
+   * This only has an effect when the client is attached to a main context.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_PREPARE,
+      g_param_spec_boolean ("async-prepare", "Async Prepare",
+          "Prepare the media without blocking the client",
+          DEFAULT_ASYNC_PREPARE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_rtsp_client_signals[SIGNAL_CLOSED] =
       g_signal_new ("closed", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST,
       G_STRUCT_OFFSET (GstRTSPClientClass, closed), NULL, NULL,
@@ -585,9 +640,7 @@ gst_rtsp_client_class_init (GstRTSPClientClass * klass)
           check_requirements), NULL, NULL, g_cclosure_marshal_generic,
       G_TYPE_STRING, 2, GST_TYPE_RTSP_CONTEXT, G_TYPE_STRV);
 
-  tunnels =
-      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
-  g_mutex_init (&tunnels_lock);
+  default_tunnels = gst_rtsp_tunnels_new ();
 
   GST_DEBUG_CATEGORY_INIT (rtsp_client_debug, "rtspclient", 0, "GstRTSPClient");
 }
@@ -605,6 +658,8 @@ gst_rtsp_client_init (GstRTSPClient * client)
   priv->close_seq = 0;
   priv->data_seqs = g_array_new (FALSE, FALSE, sizeof (DataSeq));
   priv->drop_backlog = DEFAULT_DROP_BACKLOG;
+  priv->async_prepare = DEFAULT_ASYNC_PREPARE;
+  g_queue_init (&priv->pending_requests);
   priv->transports =
       g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
       g_object_unref);
@@ -747,6 +802,20 @@ clean_cached_media (GstRTSPClient * client, gboolean unprepare)
   }
 }
 
+static void
+clean_suspended_requests (GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+
+  if (priv->suspended_request) {
+    gst_rtsp_message_free (priv->suspended_request);
+    priv->suspended_request = NULL;
+  }
+  g_queue_foreach (&priv->pending_requests, (GFunc) gst_rtsp_message_free,
+      NULL);
+  g_queue_clear (&priv->pending_requests);
+}
+
 /* A client is finalized when the connection is broken */
 static void
 gst_rtsp_client_finalize (GObject * obj)
@@ -766,6 +835,12 @@ gst_rtsp_client_finalize (GObject * obj)
 
   if (priv->watch_context)
     g_main_context_unref (priv->watch_context);
+  if (priv->resume_context)
+    g_main_context_unref (priv->resume_context);
+  if (priv->thread)
+    gst_rtsp_thread_unref (priv->thread);
+  if (priv->tunnels)
+    gst_rtsp_tunnels_unref (priv->tunnels);
 
   /* all sessions should have been removed by now. We keep a ref to
    * the client object for the session removed handler. The ref is
@@ -789,6 +864,7 @@ gst_rtsp_client_finalize (GObject * obj)
   if (priv->thread_pool)
     g_object_unref (priv->thread_pool);
 
+  clean_suspended_requests (client);
   clean_cached_media (client, TRUE);
 
   if (priv->rtsp_ctrl_timeout_id != 0) {
@@ -800,6 +876,9 @@ gst_rtsp_client_finalize (GObject * obj)
   }
 
   g_free (priv->server_ip);
+  g_free (priv->request_uristr);
+  if (priv->request_uri)
+    gst_rtsp_url_free (priv->request_uri);
   g_mutex_clear (&priv->lock);
   g_mutex_clear (&priv->send_lock);
   g_mutex_clear (&priv->watch_lock);
@@ -824,6 +903,9 @@ gst_rtsp_client_get_property (GObject * object, guint propid,
     case PROP_DROP_BACKLOG:
       g_value_set_boolean (value, priv->drop_backlog);
       break;
+    case PROP_ASYNC_PREPARE:
+      g_value_set_boolean (value, priv->async_prepare);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -848,6 +930,11 @@ gst_rtsp_client_set_property (GObject * object, guint propid,
       priv->drop_backlog = g_value_get_boolean (value);
       g_mutex_unlock (&priv->lock);
       break;
+    case PROP_ASYNC_PREPARE:
+      g_mutex_lock (&priv->lock);
+      priv->async_prepare = g_value_get_boolean (value);
+      g_mutex_unlock (&priv->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -959,6 +1046,22 @@ paths_are_equal (const gchar * path1, const gchar * path2, gint len2)
   return TRUE;
 }
 
+static gboolean
+use_async_prepare (GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  gboolean res;
+
+  g_mutex_lock (&priv->lock);
+  res = priv->async_prepare && priv->watch_context != NULL;
+  g_mutex_unlock (&priv->lock);
+
+  return res;
+}
+
+static void media_prepared_cb (GstRTSPMedia * media, gboolean success,
+    GstRTSPClient * client);
+
 /* this function is called to initially find the media for the DESCRIBE request
  * but is cached for when the same client (without breaking the connection) is
  * doing a setup for the exact same url. */
@@ -994,14 +1097,30 @@ find_media (GstRTSPClient * client, GstRTSPContext * ctx, gchar * path,
      * media for uri */
     clean_cached_media (client, TRUE);
 
+    /* the warm pool of the factory prepares its medias in our media threads */
+    if (priv->thread_pool &&
+        gst_rtsp_media_factory_get_warm_pool_size (factory) > 0) {
+      GstRTSPThreadPool *pool;
+
+      if ((pool = gst_rtsp_media_factory_get_thread_pool (factory)))
+        g_object_unref (pool);
+      else
+        gst_rtsp_media_factory_set_thread_pool (factory, priv->thread_pool);
+    }
+
     /* prepare the media and add it to the pipeline */
     if (!(media = gst_rtsp_media_factory_construct (factory, ctx->uri)))
       goto no_media;
 
     ctx->media = media;
 
+    /* media that is not shared and already prepared comes from the warm pool
+     * of the factory and its preparation is handed over to us */
     if (!(gst_rtsp_media_get_transport_mode (media) &
-            GST_RTSP_TRANSPORT_MODE_RECORD)) {
+            GST_RTSP_TRANSPORT_MODE_RECORD) &&
+        (gst_rtsp_media_is_shared (media) ||
+            gst_rtsp_media_get_status (media) !=
+            GST_RTSP_MEDIA_STATUS_PREPARED)) {
       GstRTSPThread *thread;
 
       thread = gst_rtsp_thread_pool_get_thread (priv->thread_pool,
@@ -1010,6 +1129,13 @@ find_media (GstRTSPClient * client, GstRTSPContext * ctx, gchar * path,
         goto no_thread;
 
       /* prepare the media */
+      if (use_async_prepare (client)) {
+        if (!gst_rtsp_media_prepare_async (media, thread, priv->watch_context,
+                (GstRTSPMediaPrepareFunc) media_prepared_cb,
+                g_object_ref (client), g_object_unref))
+          goto no_prepare_async;
+        goto suspend;
+      }
       if (!gst_rtsp_media_prepare (media, thread))
         goto no_prepare;
     }
@@ -1074,6 +1200,11 @@ no_thread:
     ctx->factory = NULL;
     return NULL;
   }
+no_prepare_async:
+  {
+    g_object_unref (client);
+    goto no_prepare;
+  }
 no_prepare:
   {
     GST_ERROR ("client %p: can't prepare media", client);
@@ -1084,6 +1215,20 @@ no_prepare:
     ctx->factory = NULL;
     return NULL;
   }
+suspend:
+  {
+    GST_INFO ("client %p: suspending request until media %p is prepared",
+        client, media);
+    /* keep track of the media, the request is handled again when the media
+     * is prepared and then finds it here */
+    priv->path = g_strndup (path, path_len);
+    priv->media = media;
+    gst_rtsp_message_copy (ctx->request, &priv->suspended_request);
+    ctx->media = NULL;
+    g_object_unref (factory);
+    ctx->factory = NULL;
+    return NULL;
+  }
 }
 
 static inline DataSeq *
@@ -1107,22 +1252,12 @@ static void
 add_data_seq (GstRTSPClient * client, guint8 channel)
 {
   GstRTSPClientPrivate *priv = client->priv;
-  DataSeq data_seq = {.channel = channel,.seq = 0 };
+  DataSeq data_seq = {.channel = channel,.seq = 0,.n_messages = 0 };
 
   if (get_data_seq_element (client, channel) == NULL)
     g_array_append_val (priv->data_seqs, data_seq);
 }
 
-static void
-set_data_seq (GstRTSPClient * client, guint8 channel, guint seq)
-{
-  DataSeq *data_seq;
-
-  data_seq = get_data_seq_element (client, channel);
-  g_assert_nonnull (data_seq);
-  data_seq->seq = seq;
-}
-
 static guint
 get_data_seq (GstRTSPClient * client, guint8 channel)
 {
@@ -1152,6 +1287,34 @@ get_data_channel (GstRTSPClient * client, guint seq, guint8 * channel)
   return FALSE;
 }
 
+/* with send_lock, @n_messages data messages were queued in the watch as
+ * message @seq */
+static void
+queue_data_seq (GstRTSPClient * client, guint8 channel, guint seq,
+    guint n_messages)
+{
+  DataSeq *data_seq;
+
+  data_seq = get_data_seq_element (client, channel);
+  g_assert_nonnull (data_seq);
+  data_seq->seq = seq;
+  data_seq->n_messages = n_messages;
+  client->priv->data_backlog += n_messages;
+}
+
+/* with send_lock, the queued data message of @channel was sent */
+static void
+unqueue_data_seq (GstRTSPClient * client, guint8 channel)
+{
+  DataSeq *data_seq;
+
+  data_seq = get_data_seq_element (client, channel);
+  g_assert_nonnull (data_seq);
+  client->priv->data_backlog -= data_seq->n_messages;
+  data_seq->seq = 0;
+  data_seq->n_messages = 0;
+}
+
 static gboolean
 do_close (gpointer user_data)
 {
@@ -1189,6 +1352,9 @@ do_send_data (GstBuffer * buffer, guint8 channel, GstRTSPClient * client)
 
   gst_rtsp_message_unset (&message);
 
+  if (ret && priv->thread)
+    gst_rtsp_thread_add_bytes_sent (priv->thread, gst_buffer_get_size (buffer));
+
   if (!ret) {
     GSource *idle_src;
 
@@ -1218,8 +1384,8 @@ do_send_data_list (GstBufferList * buffer_list, guint8 channel,
     return FALSE;
   }
 
-  messages = g_newa (GstRTSPMessage, n);
-  memset (messages, 0, sizeof (GstRTSPMessage) * n);
+  /* lists can be long, don't put them on the stack */
+  messages = g_new0 (GstRTSPMessage, n);
   for (i = 0; i < n; i++) {
     GstBuffer *buffer = gst_buffer_list_get (buffer_list, i);
     gst_rtsp_message_init_data (&messages[i], channel);
@@ -1241,6 +1407,11 @@ do_send_data_list (GstBufferList * buffer_list, guint8 channel,
   for (i = 0; i < n; i++) {
     gst_rtsp_message_unset (&messages[i]);
   }
+  g_free (messages);
+
+  if (ret && priv->thread)
+    gst_rtsp_thread_add_bytes_sent (priv->thread,
+        gst_buffer_list_calculate_size (buffer_list));
 
   if (!ret) {
     GSource *idle_src;
@@ -1272,12 +1443,8 @@ gst_rtsp_client_close (GstRTSPClient * client)
   GST_DEBUG ("client %p: closing connection", client);
 
   if (priv->connection) {
-    if ((tunnelid = gst_rtsp_connection_get_tunnelid (priv->connection))) {
-      g_mutex_lock (&tunnels_lock);
-      /* remove from tunnelids */
-      g_hash_table_remove (tunnels, tunnelid);
-      g_mutex_unlock (&tunnels_lock);
-    }
+    if ((tunnelid = gst_rtsp_connection_get_tunnelid (priv->connection)))
+      gst_rtsp_tunnels_remove (get_tunnels (client), tunnelid, client);
     gst_rtsp_connection_close (priv->connection);
   }
 
@@ -1349,6 +1516,23 @@ pre_signal_accumulator (GSignalInvocationHint * ihint, GValue * return_accu,
   return TRUE;
 }
 
+/* emit the pre-request signal @sig of the request in @ctx, only once when
+ * the request is suspended and handled again */
+static GstRTSPStatusCode
+emit_pre_request (GstRTSPClient * client, GstRTSPContext * ctx, guint sig)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPStatusCode sig_result = GST_RTSP_STS_OK;
+
+  if (priv->pre_request_emitted)
+    return GST_RTSP_STS_OK;
+
+  g_signal_emit (client, gst_rtsp_client_signals[sig], 0, ctx, &sig_result);
+  priv->pre_request_emitted = TRUE;
+
+  return sig_result;
+}
+
 static gboolean
 handle_teardown_request (GstRTSPClient * client, GstRTSPContext * ctx)
 {
@@ -1391,8 +1575,7 @@ handle_teardown_request (GstRTSPClient * client, GstRTSPContext * ctx)
   g_object_ref (media);
   gst_rtsp_media_lock (media);
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_TEARDOWN_REQUEST],
-      0, ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_TEARDOWN_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -1491,9 +1674,7 @@ handle_get_param_request (GstRTSPClient * client, GstRTSPContext * ctx)
   guint size;
   GstRTSPStatusCode sig_result;
 
-  g_signal_emit (client,
-      gst_rtsp_client_signals[SIGNAL_PRE_GET_PARAMETER_REQUEST], 0, ctx,
-      &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_GET_PARAMETER_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -1549,9 +1730,7 @@ handle_set_param_request (GstRTSPClient * client, GstRTSPContext * ctx)
   guint size;
   GstRTSPStatusCode sig_result;
 
-  g_signal_emit (client,
-      gst_rtsp_client_signals[SIGNAL_PRE_SET_PARAMETER_REQUEST], 0, ctx,
-      &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_SET_PARAMETER_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -1640,8 +1819,7 @@ handle_pause_request (GstRTSPClient * client, GstRTSPContext * ctx)
 
   ctx->sessmedia = sessmedia;
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_PAUSE_REQUEST], 0,
-      ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_PAUSE_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -1998,8 +2176,7 @@ handle_play_request (GstRTSPClient * client, GstRTSPContext * ctx)
   g_object_ref (media);
   gst_rtsp_media_lock (media);
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_PLAY_REQUEST], 0,
-      ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_PLAY_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -2706,8 +2883,11 @@ handle_setup_request (GstRTSPClient * client, GstRTSPContext * ctx)
     }
   }
   /* no media, not found then */
-  if (media == NULL)
+  if (media == NULL) {
+    if (priv->suspended_request)
+      goto suspended;
     goto media_not_found_no_reply;
+  }
 
   if (path[matched] == '\0') {
     if (gst_rtsp_media_n_streams (media) == 1) {
@@ -2732,8 +2912,7 @@ handle_setup_request (GstRTSPClient * client, GstRTSPContext * ctx)
   ctx->stream = stream;
   ctx->media = media;
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_SETUP_REQUEST], 0,
-      ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_SETUP_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -2948,6 +3127,11 @@ no_pool:
     send_generic_response (client, GST_RTSP_STS_SESSION_NOT_FOUND, ctx);
     goto cleanup_path;
   }
+suspended:
+  {
+    GST_DEBUG ("client %p: setup suspended while preparing media", client);
+    goto cleanup_session;
+  }
 media_not_found_no_reply:
   {
     GST_ERROR ("client %p: media '%s' not found", client, path);
@@ -3062,15 +3246,23 @@ keymgmt_error:
   }
 }
 
+static void
+make_session_id (gchar session_id[21])
+{
+  guint64 session_id_tmp;
+
+  session_id_tmp = (((guint64) g_random_int ()) << 32) | g_random_int ();
+  g_snprintf (session_id, 21, "%" G_GUINT64_FORMAT, session_id_tmp);
+}
+
 static GstSDPMessage *
-create_sdp (GstRTSPClient * client, GstRTSPMedia * media)
+make_sdp (GstRTSPClient * client, GstRTSPMedia * media,
+    const gchar * session_id)
 {
   GstRTSPClientPrivate *priv = client->priv;
   GstSDPMessage *sdp;
   GstSDPInfo info;
   const gchar *proto;
-  guint64 session_id_tmp;
-  gchar session_id[21];
 
   gst_sdp_message_new (&sdp);
 
@@ -3082,10 +3274,6 @@ create_sdp (GstRTSPClient * client, GstRTSPMedia * media)
   else
     proto = "IP4";
 
-  session_id_tmp = (((guint64) g_random_int ()) << 32) | g_random_int ();
-  g_snprintf (session_id, sizeof (session_id), "%" G_GUINT64_FORMAT,
-      session_id_tmp);
-
   gst_sdp_message_set_origin (sdp, "-", session_id, "1", "IN", proto,
       priv->server_ip);
 
@@ -3114,26 +3302,74 @@ no_sdp:
   }
 }
 
+static GstSDPMessage *
+create_sdp (GstRTSPClient * client, GstRTSPMedia * media)
+{
+  gchar session_id[21];
+
+  make_session_id (session_id);
+
+  return make_sdp (client, media, session_id);
+}
+
+/* make the SDP for the describe as text. The SDP of the default create_sdp
+ * only depends on the media and the server ip, it is cached in the media and
+ * only the session id is replaced for each describe */
+static gchar *
+make_sdp_text (GstRTSPClient * client, GstRTSPMedia * media)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPClientClass *klass;
+  GstSDPMessage *sdp;
+  GstSDPInfo info;
+  gchar session_id[21];
+  gchar *str;
+
+  klass = GST_RTSP_CLIENT_GET_CLASS (client);
+
+  if (klass->create_sdp != create_sdp) {
+    if (!(sdp = klass->create_sdp (client, media)))
+      return NULL;
+
+    str = gst_sdp_message_as_text (sdp);
+    gst_sdp_message_free (sdp);
+    return str;
+  }
+
+  info.is_ipv6 = priv->is_ipv6;
+  info.server_ip = priv->server_ip;
+
+  make_session_id (session_id);
+
+  if ((str = gst_rtsp_media_get_cached_sdp (media, &info, session_id)))
+    return str;
+
+  if (!(sdp = make_sdp (client, media, session_id)))
+    return NULL;
+
+  gst_rtsp_media_cache_sdp (media, &info, sdp);
+
+  str = gst_sdp_message_as_text (sdp);
+  gst_sdp_message_free (sdp);
+
+  return str;
+}
+
 /* for the describe we must generate an SDP */
 static gboolean
 handle_describe_request (GstRTSPClient * client, GstRTSPContext * ctx)
 {
   GstRTSPClientPrivate *priv = client->priv;
   GstRTSPResult res;
-  GstSDPMessage *sdp;
   guint i;
-  gchar *path, *str;
+  gchar *path, *str, *sdp;
   GstRTSPMedia *media;
-  GstRTSPClientClass *klass;
   GstRTSPStatusCode sig_result;
 
-  klass = GST_RTSP_CLIENT_GET_CLASS (client);
-
   if (!ctx->uri)
     goto no_uri;
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_DESCRIBE_REQUEST],
-      0, ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_DESCRIBE_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -3160,8 +3396,11 @@ handle_describe_request (GstRTSPClient * client, GstRTSPContext * ctx)
     goto no_path;
 
   /* find the media object for the uri */
-  if (!(media = find_media (client, ctx, path, NULL)))
+  if (!(media = find_media (client, ctx, path, NULL))) {
+    if (priv->suspended_request)
+      goto suspended;
     goto no_media;
+  }
 
   gst_rtsp_media_lock (media);
 
@@ -3170,7 +3409,7 @@ handle_describe_request (GstRTSPClient * client, GstRTSPContext * ctx)
     goto unsupported_mode;
 
   /* create an SDP for the media object on this client */
-  if (!(sdp = klass->create_sdp (client, media)))
+  if (!(sdp = make_sdp_text (client, media)))
     goto no_sdp;
 
   /* we suspend after the describe */
@@ -3190,9 +3429,7 @@ handle_describe_request (GstRTSPClient * client, GstRTSPContext * ctx)
   gst_rtsp_message_take_header (ctx->response, GST_RTSP_HDR_CONTENT_BASE, str);
 
   /* add SDP to the response body */
-  str = gst_sdp_message_as_text (sdp);
-  gst_rtsp_message_take_body (ctx->response, (guint8 *) str, strlen (str));
-  gst_sdp_message_free (sdp);
+  gst_rtsp_message_take_body (ctx->response, (guint8 *) sdp, strlen (sdp));
 
   send_message (client, ctx, ctx->response, FALSE);
 
@@ -3204,6 +3441,13 @@ handle_describe_request (GstRTSPClient * client, GstRTSPContext * ctx)
 
   return TRUE;
 
+  /* OK */
+suspended:
+  {
+    GST_DEBUG ("client %p: describe suspended while preparing media", client);
+    g_free (path);
+    return TRUE;
+  }
   /* ERRORS */
 sig_failed:
   {
@@ -3350,8 +3594,7 @@ handle_announce_request (GstRTSPClient * client, GstRTSPContext * ctx)
   ctx->media = media;
   gst_rtsp_media_lock (media);
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_ANNOUNCE_REQUEST],
-      0, ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_ANNOUNCE_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -3513,8 +3756,7 @@ handle_record_request (GstRTSPClient * client, GstRTSPContext * ctx)
   ctx->sessmedia = sessmedia;
   ctx->media = media = gst_rtsp_session_media_get_media (sessmedia);
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_RECORD_REQUEST], 0,
-      ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_RECORD_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -3617,36 +3859,49 @@ unsuspend_failed:
   }
 }
 
-static gboolean
-handle_options_request (GstRTSPClient * client, GstRTSPContext * ctx,
-    GstRTSPVersion version)
+/* the Public header is the same for all requests of a version, make it
+ * only once */
+static const gchar *
+public_options (GstRTSPVersion version)
 {
-  GstRTSPMethod options;
-  gchar *str;
-  GstRTSPStatusCode sig_result;
+  static gsize options_1_0 = 0, options_2_0 = 0;
+  gsize *options_str;
 
-  options = GST_RTSP_DESCRIBE |
-      GST_RTSP_OPTIONS |
-      GST_RTSP_PAUSE |
-      GST_RTSP_PLAY |
-      GST_RTSP_SETUP |
-      GST_RTSP_GET_PARAMETER | GST_RTSP_SET_PARAMETER | GST_RTSP_TEARDOWN;
+  options_str = version < GST_RTSP_VERSION_2_0 ? &options_1_0 : &options_2_0;
 
-  if (version < GST_RTSP_VERSION_2_0) {
-    options |= GST_RTSP_RECORD;
-    options |= GST_RTSP_ANNOUNCE;
+  if (g_once_init_enter (options_str)) {
+    GstRTSPMethod options;
+
+    options = GST_RTSP_DESCRIBE |
+        GST_RTSP_OPTIONS |
+        GST_RTSP_PAUSE |
+        GST_RTSP_PLAY |
+        GST_RTSP_SETUP |
+        GST_RTSP_GET_PARAMETER | GST_RTSP_SET_PARAMETER | GST_RTSP_TEARDOWN;
+
+    if (version < GST_RTSP_VERSION_2_0) {
+      options |= GST_RTSP_RECORD;
+      options |= GST_RTSP_ANNOUNCE;
+    }
+    g_once_init_leave (options_str,
+        (gsize) gst_rtsp_options_as_text (options));
   }
+  return (const gchar *) *options_str;
+}
 
-  str = gst_rtsp_options_as_text (options);
+static gboolean
+handle_options_request (GstRTSPClient * client, GstRTSPContext * ctx,
+    GstRTSPVersion version)
+{
+  GstRTSPStatusCode sig_result;
 
   gst_rtsp_message_init_response (ctx->response, GST_RTSP_STS_OK,
       gst_rtsp_status_as_text (GST_RTSP_STS_OK), ctx->request);
 
-  gst_rtsp_message_add_header (ctx->response, GST_RTSP_HDR_PUBLIC, str);
-  g_free (str);
+  gst_rtsp_message_add_header (ctx->response, GST_RTSP_HDR_PUBLIC,
+      public_options (version));
 
-  g_signal_emit (client, gst_rtsp_client_signals[SIGNAL_PRE_OPTIONS_REQUEST], 0,
-      ctx, &sig_result);
+  sig_result = emit_pre_request (client, ctx, SIGNAL_PRE_OPTIONS_REQUEST);
   if (sig_result != GST_RTSP_STS_OK) {
     goto sig_failed;
   }
@@ -3779,6 +4034,111 @@ done:
   return result;
 }
 
+/* TRUE when something is called for @signal of @client */
+static gboolean
+has_request_handler (GstRTSPClient * client, guint signal,
+    gpointer class_handler)
+{
+  return class_handler != NULL ||
+      g_signal_has_handler_pending (client, gst_rtsp_client_signals[signal],
+      0, FALSE);
+}
+
+/* Answer keep-alive requests, OPTIONS and GET_PARAMETER or SET_PARAMETER
+ * without body, right after their url was parsed when there is no auth and
+ * nothing is called for the signals of the request. Returns FALSE when the
+ * request needs to be handled by handle_request() */
+static gboolean
+handle_keepalive_request (GstRTSPClient * client, GstRTSPContext * ctx,
+    GstRTSPMethod method, GstRTSPVersion version)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPClientClass *klass = GST_RTSP_CLIENT_GET_CLASS (client);
+  GstRTSPSession *session = NULL;
+  guint8 *data;
+  guint size;
+  gchar *value;
+
+  if (ctx->auth != NULL)
+    return FALSE;
+
+  switch (method) {
+    case GST_RTSP_OPTIONS:
+      if (has_request_handler (client, SIGNAL_PRE_OPTIONS_REQUEST,
+              klass->pre_options_request) ||
+          has_request_handler (client, SIGNAL_OPTIONS_REQUEST,
+              klass->options_request))
+        return FALSE;
+      break;
+    case GST_RTSP_GET_PARAMETER:
+      /* not a keep-alive in 2.0 */
+      if (version >= GST_RTSP_VERSION_2_0 ||
+          has_request_handler (client, SIGNAL_PRE_GET_PARAMETER_REQUEST,
+              klass->pre_get_parameter_request) ||
+          has_request_handler (client, SIGNAL_GET_PARAMETER_REQUEST,
+              klass->get_parameter_request))
+        return FALSE;
+      break;
+    case GST_RTSP_SET_PARAMETER:
+      if (has_request_handler (client, SIGNAL_PRE_SET_PARAMETER_REQUEST,
+              klass->pre_set_parameter_request) ||
+          has_request_handler (client, SIGNAL_SET_PARAMETER_REQUEST,
+              klass->set_parameter_request))
+        return FALSE;
+      break;
+    default:
+      return FALSE;
+  }
+
+  /* parameters are handled by the params functions */
+  if (method != GST_RTSP_OPTIONS) {
+    if (gst_rtsp_message_get_body (ctx->request, &data, &size) != GST_RTSP_OK)
+      return FALSE;
+    if (size != 0 && data && strlen ((char *) data) != 0)
+      return FALSE;
+  }
+
+  if (gst_rtsp_message_get_header (ctx->request, GST_RTSP_HDR_REQUIRE, &value,
+          0) == GST_RTSP_OK ||
+      gst_rtsp_message_get_header (ctx->request,
+          GST_RTSP_HDR_PIPELINED_REQUESTS, &value, 0) == GST_RTSP_OK)
+    return FALSE;
+
+  /* touch the session, errors are handled by handle_request() */
+  if (gst_rtsp_message_get_header (ctx->request, GST_RTSP_HDR_SESSION, &value,
+          0) == GST_RTSP_OK) {
+    if (priv->session_pool == NULL)
+      return FALSE;
+    if (!(session = gst_rtsp_session_pool_find (priv->session_pool, value)))
+      return FALSE;
+
+    client_watch_session (client, session);
+  }
+
+  GST_LOG ("client %p: keep-alive %s", client,
+      gst_rtsp_method_as_text (method));
+
+  ctx->session = session;
+
+  if (method == GST_RTSP_OPTIONS) {
+    priv->version = version;
+
+    gst_rtsp_message_init_response (ctx->response, GST_RTSP_STS_OK,
+        gst_rtsp_status_as_text (GST_RTSP_STS_OK), ctx->request);
+    gst_rtsp_message_add_header (ctx->response, GST_RTSP_HDR_PUBLIC,
+        public_options (version));
+
+    send_message (client, ctx, ctx->response, FALSE);
+  } else {
+    send_generic_response (client, GST_RTSP_STS_OK, ctx);
+  }
+
+  if (session)
+    g_object_unref (session);
+
+  return TRUE;
+}
+
 static void
 handle_request (GstRTSPClient * client, GstRTSPMessage * request)
 {
@@ -3805,6 +4165,10 @@ handle_request (GstRTSPClient * client, GstRTSPMessage * request)
   ctx->request = request;
   ctx->response = &response;
 
+  /* a resumed request keeps the state of when it was suspended */
+  if (!priv->resuming)
+    priv->pre_request_emitted = FALSE;
+
   if (gst_debug_category_get_threshold (rtsp_client_debug) >= GST_LEVEL_LOG) {
     gst_rtsp_message_dump (request);
   }
@@ -3821,8 +4185,20 @@ handle_request (GstRTSPClient * client, GstRTSPMessage * request)
 
   ctx->method = method;
 
-  /* we always try to parse the url first */
-  if (strcmp (uristr, "*") == 0) {
+  /* we always try to parse the url first, unless it is the same as the url
+   * of the previous request. gst_rtsp_client_handle_message() can be called
+   * from any thread, so the url is taken from the client with the lock and
+   * it can't be freed under us by another request */
+  g_mutex_lock (&priv->lock);
+  if (priv->request_uri && g_strcmp0 (priv->request_uristr, uristr) == 0) {
+    uri = priv->request_uri;
+    priv->request_uri = NULL;
+  }
+  g_mutex_unlock (&priv->lock);
+
+  if (uri) {
+    /* reused the url of the previous request */
+  } else if (strcmp (uristr, "*") == 0) {
     /* special case where we have * as uri, keep uri = NULL */
   } else if (gst_rtsp_url_parse (uristr, &uri) != GST_RTSP_OK) {
     /* check if the uristr is an absolute path <=> scheme and host information
@@ -3854,6 +4230,10 @@ handle_request (GstRTSPClient * client, GstRTSPMessage * request)
     }
   }
 
+  /* only requests with a valid url are answered right away */
+  if (handle_keepalive_request (client, ctx, method, version))
+    goto done;
+
   /* get the session if there is any */
   res = gst_rtsp_message_get_header (request, GST_RTSP_HDR_PIPELINED_REQUESTS,
       &pipelined_request_id, 0);
@@ -3945,8 +4325,18 @@ done:
     gst_rtsp_context_pop_current (ctx);
   if (session)
     g_object_unref (session);
-  if (uri)
-    gst_rtsp_url_free (uri);
+  if (uri) {
+    /* keep the url for the next request */
+    g_mutex_lock (&priv->lock);
+    if (priv->request_uri)
+      gst_rtsp_url_free (priv->request_uri);
+    if (g_strcmp0 (priv->request_uristr, uristr) != 0) {
+      g_free (priv->request_uristr);
+      priv->request_uristr = g_strdup (uristr);
+    }
+    priv->request_uri = uri;
+    g_mutex_unlock (&priv->lock);
+  }
   return;
 
   /* ERRORS */
@@ -4440,6 +4830,73 @@ gst_rtsp_client_get_thread_pool (GstRTSPClient * client)
   return result;
 }
 
+/* the server tells us the thread of the context so that we can account the
+ * data we send in its load, must be called before gst_rtsp_client_attach() */
+void
+gst_rtsp_client_set_thread (GstRTSPClient * client, GstRTSPThread * thread)
+{
+  GstRTSPClientPrivate *priv;
+  GstRTSPThread *old;
+
+  g_return_if_fail (GST_IS_RTSP_CLIENT (client));
+
+  priv = client->priv;
+
+  if (thread)
+    gst_rtsp_thread_ref (thread);
+
+  g_mutex_lock (&priv->lock);
+  old = priv->thread;
+  priv->thread = thread;
+  g_mutex_unlock (&priv->lock);
+
+  if (old)
+    gst_rtsp_thread_unref (old);
+}
+
+/* the thread of @client or %NULL, unref after usage */
+GstRTSPThread *
+gst_rtsp_client_get_thread (GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv;
+  GstRTSPThread *result;
+
+  g_return_val_if_fail (GST_IS_RTSP_CLIENT (client), NULL);
+
+  priv = client->priv;
+
+  g_mutex_lock (&priv->lock);
+  if ((result = priv->thread))
+    gst_rtsp_thread_ref (result);
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
+
+/* the server tells us where our HTTP tunnel waits for its other half, must be
+ * called before gst_rtsp_client_attach() */
+void
+gst_rtsp_client_set_tunnels (GstRTSPClient * client, GstRTSPTunnels * tunnels)
+{
+  GstRTSPClientPrivate *priv;
+  GstRTSPTunnels *old;
+
+  g_return_if_fail (GST_IS_RTSP_CLIENT (client));
+
+  priv = client->priv;
+
+  if (tunnels)
+    gst_rtsp_tunnels_ref (tunnels);
+
+  g_mutex_lock (&priv->lock);
+  old = priv->tunnels;
+  priv->tunnels = tunnels;
+  g_mutex_unlock (&priv->lock);
+
+  if (old)
+    gst_rtsp_tunnels_unref (old);
+}
+
 /**
  * gst_rtsp_client_set_connection:
  * @client: a #GstRTSPClient
@@ -4611,6 +5068,186 @@ gst_rtsp_client_set_send_messages_func (GstRTSPClient * client,
     old_notify (old_data);
 }
 
+static void
+send_service_unavailable (GstRTSPClient * client, GstRTSPMessage * request)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPContext sctx = { NULL }, *ctx = &sctx;
+  GstRTSPMessage response = { 0 };
+
+  ctx->auth = priv->auth;
+  ctx->conn = priv->connection;
+  ctx->client = client;
+  ctx->request = request;
+  ctx->response = &response;
+
+  gst_rtsp_context_push_current (ctx);
+  send_generic_response (client, GST_RTSP_STS_SERVICE_UNAVAILABLE, ctx);
+  gst_rtsp_context_pop_current (ctx);
+}
+
+/* handle the requests that arrived while a request was suspended until one of
+ * them is suspended again */
+static void
+handle_pending_requests (GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPMessage *request;
+
+  while (priv->suspended_request == NULL &&
+      (request = g_queue_pop_head (&priv->pending_requests))) {
+    handle_request (client, request);
+    gst_rtsp_message_free (request);
+  }
+}
+
+/* called from the main context of the client when the media of the suspended
+ * request is prepared */
+static void
+media_prepared_cb (GstRTSPMedia * media, gboolean success,
+    GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPMessage *request;
+
+  request = priv->suspended_request;
+  priv->suspended_request = NULL;
+
+  if (priv->watch == NULL || request == NULL || media != priv->media)
+    goto closed;
+
+  if (success) {
+    GST_INFO ("client %p: media %p prepared, resuming request", client,
+        media);
+    /* the media is cached now, handling the request again picks it up */
+    priv->resuming = TRUE;
+    handle_request (client, request);
+    priv->resuming = FALSE;
+  } else {
+    GST_ERROR ("client %p: can't prepare media", client);
+    /* the media was unprepared already */
+    clean_cached_media (client, FALSE);
+    send_service_unavailable (client, request);
+  }
+  gst_rtsp_message_free (request);
+
+  handle_pending_requests (client);
+  return;
+
+  /* ERRORS */
+closed:
+  {
+    GST_DEBUG ("client %p: closed while preparing media %p", client, media);
+    if (request)
+      gst_rtsp_message_free (request);
+    clean_suspended_requests (client);
+    return;
+  }
+}
+
+/**
+ * gst_rtsp_client_suspend_request:
+ * @client: a #GstRTSPClient
+ * @ctx: the #GstRTSPContext of the request being handled
+ *
+ * Suspend the handling of the request in @ctx, for example while the
+ * credentials of the request are looked up. No response is sent for the
+ * request and the requests that arrive after it are queued until
+ * gst_rtsp_client_resume_request() is called. The request is then handled
+ * again from the start. When the pre-request signal of the request was
+ * already emitted before it was suspended, it is not emitted again.
+ * When 16 requests are queued, the requests that arrive after them are
+ * answered with 503 Service Unavailable.
+ *
+ * This function must be called from the handler of the request and the
+ * handler must return without sending a response.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_client_suspend_request (GstRTSPClient * client, GstRTSPContext * ctx)
+{
+  GstRTSPClientPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_CLIENT (client));
+  g_return_if_fail (ctx != NULL && ctx->request != NULL);
+
+  priv = client->priv;
+
+  g_return_if_fail (priv->suspended_request == NULL);
+
+  GST_INFO ("client %p: suspending request", client);
+  gst_rtsp_message_copy (ctx->request, &priv->suspended_request);
+
+  /* resume can be called from any thread, don't look at the watch then */
+  g_mutex_lock (&priv->lock);
+  if (priv->resume_context)
+    g_main_context_unref (priv->resume_context);
+  priv->resume_context =
+      priv->watch_context ? g_main_context_ref (priv->watch_context) : NULL;
+  g_mutex_unlock (&priv->lock);
+}
+
+static gboolean
+resume_request (GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv = client->priv;
+  GstRTSPMessage *request;
+
+  request = priv->suspended_request;
+  priv->suspended_request = NULL;
+
+  /* the request was dropped when the client was closed */
+  if (request == NULL)
+    return G_SOURCE_REMOVE;
+
+  GST_INFO ("client %p: resuming request", client);
+  priv->resuming = TRUE;
+  handle_request (client, request);
+  priv->resuming = FALSE;
+  gst_rtsp_message_free (request);
+
+  handle_pending_requests (client);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_rtsp_client_resume_request:
+ * @client: a #GstRTSPClient
+ *
+ * Handle the request that was suspended with
+ * gst_rtsp_client_suspend_request() again. The request is handled from the
+ * main context of @client, this function can be called from any thread.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_client_resume_request (GstRTSPClient * client)
+{
+  GstRTSPClientPrivate *priv;
+  GMainContext *context;
+  GSource *idle_src;
+
+  g_return_if_fail (GST_IS_RTSP_CLIENT (client));
+
+  priv = client->priv;
+
+  g_mutex_lock (&priv->lock);
+  context = priv->resume_context;
+  priv->resume_context = NULL;
+  g_mutex_unlock (&priv->lock);
+
+  idle_src = g_idle_source_new ();
+  g_source_set_callback (idle_src, (GSourceFunc) resume_request,
+      g_object_ref (client), g_object_unref);
+  g_source_attach (idle_src, context);
+  g_source_unref (idle_src);
+
+  if (context)
+    g_main_context_unref (context);
+}
+
 /**
  * gst_rtsp_client_handle_message:
  * @client: a #GstRTSPClient
@@ -4624,12 +5261,34 @@ GstRTSPResult
 gst_rtsp_client_handle_message (GstRTSPClient * client,
     GstRTSPMessage * message)
 {
+  GstRTSPClientPrivate *priv;
+
   g_return_val_if_fail (GST_IS_RTSP_CLIENT (client), GST_RTSP_EINVAL);
   g_return_val_if_fail (message != NULL, GST_RTSP_EINVAL);
 
+  priv = client->priv;
+
   switch (message->type) {
     case GST_RTSP_MESSAGE_REQUEST:
-      handle_request (client, message);
+      if (priv->suspended_request &&
+          g_queue_get_length (&priv->pending_requests) >=
+          MAX_PENDING_REQUESTS) {
+        /* don't let a client that keeps sending fill up our memory */
+        GST_WARNING ("client %p: too many requests while a request is "
+            "suspended", client);
+        send_service_unavailable (client, message);
+      } else if (priv->suspended_request) {
+        GstRTSPMessage *copy;
+
+        /* keep the order of the requests, handle it when the suspended
+         * request is done */
+        GST_DEBUG ("client %p: queueing request while a request is "
+            "suspended", client);
+        gst_rtsp_message_copy (message, &copy);
+        g_queue_push_tail (&priv->pending_requests, copy);
+      } else {
+        handle_request (client, message);
+      }
       break;
     case GST_RTSP_MESSAGE_RESPONSE:
       handle_response (client, message);
@@ -4715,6 +5374,14 @@ do_send_messages (GstRTSPClient * client, GstRTSPMessage * messages,
   GstRTSPResult ret;
   guint i;
 
+  /* the watch counts a list of messages as one message in its backlog,
+   * count each data message against the backlog here */
+  if (gst_rtsp_message_get_type (messages) == GST_RTSP_MESSAGE_DATA &&
+      priv->data_backlog + n_messages > WATCH_BACKLOG_SIZE) {
+    ret = GST_RTSP_ENOMEM;
+    goto error;
+  }
+
   /* send the message */
   ret = gst_rtsp_watch_send_messages (priv->watch, messages, n_messages, &id);
   if (ret != GST_RTSP_OK)
@@ -4743,7 +5410,7 @@ do_send_messages (GstRTSPClient * client, GstRTSPMessage * messages,
         /* store the seq number so we can wait until it has been sent */
         GST_DEBUG_OBJECT (client, "wait for message %d, channel %d", id,
             channel);
-        set_data_seq (client, channel, id);
+        queue_data_seq (client, channel, id, n_messages);
       } else {
         GstRTSPStreamTransport *trans;
 
@@ -4791,7 +5458,7 @@ message_sent (GstRTSPWatch * watch, guint cseq, gpointer user_data)
 
   if (get_data_channel (client, cseq, &channel)) {
     trans = g_hash_table_lookup (priv->transports, GINT_TO_POINTER (channel));
-    set_data_seq (client, channel, 0);
+    unqueue_data_seq (client, channel);
   }
 
   if (priv->close_seq && priv->close_seq == cseq) {
@@ -4822,12 +5489,8 @@ closed (GstRTSPWatch * watch, gpointer user_data)
 
   GST_INFO ("client %p: connection closed", client);
 
-  if ((tunnelid = gst_rtsp_connection_get_tunnelid (priv->connection))) {
-    g_mutex_lock (&tunnels_lock);
-    /* remove from tunnelids */
-    g_hash_table_remove (tunnels, tunnelid);
-    g_mutex_unlock (&tunnels_lock);
-  }
+  if ((tunnelid = gst_rtsp_connection_get_tunnelid (priv->connection)))
+    gst_rtsp_tunnels_remove (get_tunnels (client), tunnelid, client);
 
   gst_rtsp_watch_set_flushing (watch, TRUE);
   g_mutex_lock (&priv->watch_lock);
@@ -4913,12 +5576,8 @@ remember_tunnel (GstRTSPClient * client)
   GST_INFO ("client %p: inserting tunnel session %s", client, tunnelid);
 
   /* we can't have two clients connecting with the same tunnelid */
-  g_mutex_lock (&tunnels_lock);
-  if (g_hash_table_lookup (tunnels, tunnelid))
-    goto tunnel_existed;
-
-  g_hash_table_insert (tunnels, g_strdup (tunnelid), g_object_ref (client));
-  g_mutex_unlock (&tunnels_lock);
+  if (!gst_rtsp_tunnels_add (get_tunnels (client), tunnelid, client))
+    goto tunnel_not_added;
 
   return TRUE;
 
@@ -4928,11 +5587,10 @@ no_tunnelid:
     GST_ERROR ("client %p: no tunnelid provided", client);
     return FALSE;
   }
-tunnel_existed:
+tunnel_not_added:
   {
-    g_mutex_unlock (&tunnels_lock);
-    GST_ERROR ("client %p: tunnel session %s already existed", client,
-        tunnelid);
+    GST_ERROR ("client %p: tunnel session %s already existed or too many "
+        "tunnels are pending", client, tunnelid);
     return FALSE;
   }
 }
@@ -4964,25 +5622,17 @@ handle_tunnel (GstRTSPClient * client)
   if (tunnelid == NULL)
     goto no_tunnelid;
 
-  /* check for previous tunnel */
-  g_mutex_lock (&tunnels_lock);
-  oclient = g_hash_table_lookup (tunnels, tunnelid);
+  /* check for previous tunnel, the tunnel is remembered when there is none */
+  if (!gst_rtsp_tunnels_pair (get_tunnels (client), tunnelid, client,
+          &oclient))
+    goto too_many_tunnels;
 
   if (oclient == NULL) {
-    /* no previous tunnel, remember tunnel */
-    g_hash_table_insert (tunnels, g_strdup (tunnelid), g_object_ref (client));
-    g_mutex_unlock (&tunnels_lock);
-
     GST_INFO ("client %p: no previous tunnel found, remembering tunnel (%p)",
         client, priv->connection);
   } else {
-    /* merge both tunnels into the first client */
-    /* remove the old client from the table. ref before because removing it will
-     * remove the ref to it. */
-    g_object_ref (oclient);
-    g_hash_table_remove (tunnels, tunnelid);
-    g_mutex_unlock (&tunnels_lock);
-
+    /* merge both tunnels into the first client, it was removed from the
+     * pending tunnels */
     opriv = oclient->priv;
 
     g_mutex_lock (&opriv->watch_lock);
@@ -5015,6 +5665,11 @@ no_tunnelid:
     GST_ERROR ("client %p: no tunnelid provided", client);
     return GST_RTSP_STS_SERVICE_UNAVAILABLE;
   }
+too_many_tunnels:
+  {
+    GST_ERROR ("client %p: too many pending tunnels", client);
+    return GST_RTSP_STS_SERVICE_UNAVAILABLE;
+  }
 tunnel_closed:
   {
     GST_ERROR ("client %p: tunnel session %s was closed", client, tunnelid);
@@ -247,6 +247,13 @@ GST_RTSP_SERVER_API
 GstRTSPResult         gst_rtsp_client_handle_message    (GstRTSPClient *client,
                                                          GstRTSPMessage *message);
 
+GST_RTSP_SERVER_API
+void                  gst_rtsp_client_suspend_request   (GstRTSPClient *client,
+                                                         GstRTSPContext *ctx);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_client_resume_request    (GstRTSPClient *client);
+
 GST_RTSP_SERVER_API
 GstRTSPResult         gst_rtsp_client_send_message      (GstRTSPClient * client,
                                                          GstRTSPSession *session,
@@ -0,0 +1,737 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/*
+ * A launch template is a pre-parsed version of a bin created with
+ * gst_parse_launch(). It keeps the element factories, the properties that
+ * were changed from their defaults and the links between the elements so
+ * that new copies of the bin can be created without parsing the launch
+ * description again.
+ *
+ * The properties are set again in the order of the launch description, as
+ * gst_parse_launch() does.
+ *
+ * Only flat bins with static and request pads can be represented. Bins
+ * that contain other bins, child proxies or elements with sometimes pads
+ * (which are linked lazily by the parser) are rejected and should be parsed
+ * every time.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "rtsp-launch-template.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtsp_launch_template_debug);
+#define GST_CAT_DEFAULT rtsp_launch_template_debug
+
+typedef struct
+{
+  GstElementFactory *factory;
+  gchar *name;
+  GPtrArray *prop_names;
+  GArray *prop_values;
+} TemplateElement;
+
+typedef struct
+{
+  guint src_idx;
+  gchar *src_pad;
+  gboolean src_request;
+  guint sink_idx;
+  gchar *sink_pad;
+  gboolean sink_request;
+} TemplateLink;
+
+struct _GstRTSPLaunchTemplate
+{
+  gint refcount;
+
+  /* the toplevel element, a bin when elements is not empty */
+  TemplateElement top;
+  GArray *elements;             /* of TemplateElement */
+  GArray *links;                /* of TemplateLink */
+};
+
+/* an element of the launch description and the properties that are set on it
+ * in order */
+typedef struct
+{
+  gchar *factory;
+  GPtrArray *props;
+} LaunchElement;
+
+static void
+launch_element_free (LaunchElement * le)
+{
+  g_free (le->factory);
+  g_ptr_array_free (le->props, TRUE);
+  g_slice_free (LaunchElement, le);
+}
+
+/* split @launch in tokens like the parser does. Links, bins and their ends
+ * are separate tokens, quoted strings and the parentheses of caps and values
+ * are kept in their token */
+static GPtrArray *
+tokenize_launch (const gchar * launch)
+{
+  GPtrArray *tokens;
+  const gchar *p = launch;
+
+  tokens = g_ptr_array_new_with_free_func (g_free);
+
+  while (*p) {
+    const gchar *start;
+    gchar quote = 0;
+    gint depth = 0;
+
+    if (g_ascii_isspace (*p)) {
+      p++;
+      continue;
+    }
+    if (*p == '!' || *p == '(' || *p == ')') {
+      g_ptr_array_add (tokens, g_strndup (p, 1));
+      p++;
+      continue;
+    }
+
+    start = p;
+    while (*p) {
+      if (quote) {
+        if (*p == '\\' && p[1])
+          p++;
+        else if (*p == quote)
+          quote = 0;
+      } else if (*p == '"' || *p == '\'') {
+        quote = *p;
+      } else if (*p == '(') {
+        depth++;
+      } else if (*p == ')') {
+        if (depth == 0)
+          break;
+        depth--;
+      } else if (g_ascii_isspace (*p) || *p == '!') {
+        break;
+      }
+      p++;
+    }
+    g_ptr_array_add (tokens, g_strndup (start, p - start));
+  }
+
+  return tokens;
+}
+
+/* the length of the property name when @token sets a property */
+static gsize
+get_assignment (const gchar * token)
+{
+  gsize i;
+
+  if (!g_ascii_isalpha (token[0]) && token[0] != '_')
+    return 0;
+
+  for (i = 1; token[i]; i++) {
+    if (token[i] == '=')
+      return i;
+    if (!g_ascii_isalnum (token[i]) && token[i] != '_' && token[i] != '-' &&
+        token[i] != ':')
+      return 0;
+  }
+  return 0;
+}
+
+static void
+add_launch_prop (GPtrArray * props, const gchar * token, gsize len)
+{
+  gchar *name;
+  guint i;
+
+  name = g_strndup (token, len);
+  g_strdelimit (name, "_", '-');
+
+  /* only the last value that is set matters */
+  for (i = 0; i < props->len; i++) {
+    if (strcmp (g_ptr_array_index (props, i), name) == 0) {
+      g_ptr_array_remove_index (props, i);
+      break;
+    }
+  }
+  g_ptr_array_add (props, name);
+}
+
+/* collect the elements of @launch with the properties that are set on them
+ * in order. The properties of the toplevel bin are added to @bin_props. */
+static GPtrArray *
+parse_launch_order (const gchar * launch, GPtrArray * bin_props)
+{
+  GPtrArray *tokens, *elements;
+  LaunchElement *current = NULL;
+  gboolean in_bin = FALSE;
+  guint i;
+
+  tokens = tokenize_launch (launch);
+  elements = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      launch_element_free);
+
+  for (i = 0; i < tokens->len; i++) {
+    gchar *token = g_ptr_array_index (tokens, i);
+    gsize len;
+
+    /* "prop = value" is the same as "prop=value" */
+    while (i + 1 < tokens->len && (g_str_has_suffix (token, "=") ||
+            *(gchar *) g_ptr_array_index (tokens, i + 1) == '=')) {
+      gchar *joined;
+
+      joined = g_strconcat (token, g_ptr_array_index (tokens, i + 1), NULL);
+      g_ptr_array_remove_index (tokens, i + 1);
+      g_free (tokens->pdata[i]);
+      tokens->pdata[i] = token = joined;
+    }
+
+    if (strcmp (token, "!") == 0 || strcmp (token, ")") == 0) {
+      current = NULL;
+    } else if (strcmp (token, "(") == 0) {
+      current = NULL;
+      in_bin = TRUE;
+    } else if ((len = get_assignment (token))) {
+      if (current)
+        add_launch_prop (current->props, token, len);
+      else if (in_bin && elements->len == 0)
+        add_launch_prop (bin_props, token, len);
+    } else if (strchr (token, '/') || strchr (token, '.')) {
+      /* caps or a reference to an element or pad */
+      current = NULL;
+    } else {
+      current = g_slice_new (LaunchElement);
+      current->factory = g_strdup (token);
+      current->props = g_ptr_array_new_with_free_func (g_free);
+      g_ptr_array_add (elements, current);
+    }
+  }
+  g_ptr_array_free (tokens, TRUE);
+
+  return elements;
+}
+
+static void
+template_element_clear (TemplateElement * te)
+{
+  if (te->factory)
+    gst_object_unref (te->factory);
+  g_free (te->name);
+  if (te->prop_names)
+    g_ptr_array_free (te->prop_names, TRUE);
+  if (te->prop_values)
+    g_array_free (te->prop_values, TRUE);
+}
+
+static void
+template_link_clear (TemplateLink * tl)
+{
+  g_free (tl->src_pad);
+  g_free (tl->sink_pad);
+}
+
+static gboolean
+has_sometimes_pads (GstElementFactory * factory)
+{
+  const GList *walk;
+
+  for (walk = gst_element_factory_get_static_pad_templates (factory); walk;
+      walk = g_list_next (walk)) {
+    GstStaticPadTemplate *templ = walk->data;
+
+    if (templ->presence == GST_PAD_SOMETIMES)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static gboolean
+add_property (TemplateElement * te, GstElement * element, GParamSpec * pspec)
+{
+  GValue value = G_VALUE_INIT;
+  GType type;
+
+  type = G_PARAM_SPEC_VALUE_TYPE (pspec);
+  if (g_type_is_a (type, G_TYPE_OBJECT) || g_type_is_a (type, G_TYPE_POINTER)
+      || G_TYPE_IS_INTERFACE (type)) {
+    /* we can't share objects between the instances */
+    GST_DEBUG ("can't copy property %s of %s", pspec->name, te->name);
+    return FALSE;
+  }
+
+  GST_LOG ("property %s of %s changed", pspec->name, te->name);
+  g_value_init (&value, type);
+  g_object_get_property (G_OBJECT (element), pspec->name, &value);
+  g_ptr_array_add (te->prop_names, g_strdup (pspec->name));
+  /* the array takes ownership of the value */
+  g_array_append_val (te->prop_values, value);
+
+  return TRUE;
+}
+
+static gboolean
+is_copyable (GParamSpec * pspec)
+{
+  if ((pspec->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE)
+    return FALSE;
+  if (pspec->flags & G_PARAM_CONSTRUCT_ONLY)
+    return FALSE;
+  /* the name is handled separately and the parent is set when adding */
+  if (pspec->owner_type == GST_TYPE_OBJECT)
+    return FALSE;
+  return TRUE;
+}
+
+static gboolean
+in_order (GPtrArray * order, const gchar * name)
+{
+  guint i;
+
+  for (i = 0; order && i < order->len; i++)
+    if (strcmp (g_ptr_array_index (order, i), name) == 0)
+      return TRUE;
+  return FALSE;
+}
+
+/* record the properties of @element. The properties that are set in the
+ * launch description are in @order and are recorded in that order, after
+ * the other properties that differ from a freshly created element of the
+ * same factory */
+static gboolean
+template_element_init (TemplateElement * te, GstElement * element,
+    GPtrArray * order)
+{
+  GstElementFactory *factory;
+  GstElement *fresh;
+  GParamSpec **pspecs;
+  guint i, n_pspecs;
+  gboolean res = TRUE;
+
+  factory = gst_element_get_factory (element);
+  if (factory == NULL)
+    goto no_factory;
+
+  fresh = gst_element_factory_create (factory, NULL);
+  if (fresh == NULL)
+    goto no_factory;
+  gst_object_ref_sink (fresh);
+
+  te->factory = gst_object_ref (factory);
+  te->name = gst_element_get_name (element);
+  te->prop_names = g_ptr_array_new_with_free_func (g_free);
+  te->prop_values = g_array_new (FALSE, TRUE, sizeof (GValue));
+  g_array_set_clear_func (te->prop_values, (GDestroyNotify) g_value_unset);
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (element),
+      &n_pspecs);
+  for (i = 0; i < n_pspecs && res; i++) {
+    GParamSpec *pspec = pspecs[i];
+    GValue value = G_VALUE_INIT;
+    GValue def = G_VALUE_INIT;
+    GType type;
+
+    if (!is_copyable (pspec) || in_order (order, pspec->name))
+      continue;
+
+    type = G_PARAM_SPEC_VALUE_TYPE (pspec);
+    g_value_init (&value, type);
+    g_value_init (&def, type);
+    g_object_get_property (G_OBJECT (element), pspec->name, &value);
+    g_object_get_property (G_OBJECT (fresh), pspec->name, &def);
+
+    if (g_param_values_cmp (pspec, &value, &def) != 0)
+      res = add_property (te, element, pspec);
+
+    g_value_unset (&value);
+    g_value_unset (&def);
+  }
+  g_free (pspecs);
+  gst_object_unref (fresh);
+
+  for (i = 0; order && i < order->len && res; i++) {
+    const gchar *name = g_ptr_array_index (order, i);
+    GParamSpec *pspec;
+
+    pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (element), name);
+    if (pspec == NULL) {
+      GST_DEBUG ("%s has no property %s", te->name, name);
+      res = FALSE;
+    } else if (is_copyable (pspec)) {
+      res = add_property (te, element, pspec);
+    }
+  }
+
+  return res;
+
+  /* ERRORS */
+no_factory:
+  {
+    GST_DEBUG ("element %s has no factory", GST_ELEMENT_NAME (element));
+    return FALSE;
+  }
+}
+
+static GstElement *
+template_element_create (TemplateElement * te)
+{
+  GstElement *element;
+  guint i;
+
+  element = gst_element_factory_create (te->factory, te->name);
+  if (element == NULL)
+    return NULL;
+
+  for (i = 0; i < te->prop_names->len; i++)
+    g_object_set_property (G_OBJECT (element),
+        g_ptr_array_index (te->prop_names, i),
+        &g_array_index (te->prop_values, GValue, i));
+
+  return element;
+}
+
+static gint
+find_element (GPtrArray * children, GstElement * element)
+{
+  guint i;
+
+  for (i = 0; i < children->len; i++)
+    if (g_ptr_array_index (children, i) == element)
+      return i;
+  return -1;
+}
+
+static gboolean
+is_request_pad (GstPad * pad)
+{
+  GstPadTemplate *templ = GST_PAD_PAD_TEMPLATE (pad);
+
+  return templ && GST_PAD_TEMPLATE_PRESENCE (templ) == GST_PAD_REQUEST;
+}
+
+static gboolean
+collect_links (GstRTSPLaunchTemplate * tmpl, GPtrArray * children, guint idx)
+{
+  GstElement *element = g_ptr_array_index (children, idx);
+  gboolean res = TRUE;
+  GList *walk;
+
+  GST_OBJECT_LOCK (element);
+  for (walk = element->srcpads; walk && res; walk = g_list_next (walk)) {
+    GstPad *pad = walk->data;
+    GstPad *peer;
+    GstElement *peer_element;
+    TemplateLink link;
+    gint peer_idx;
+
+    if ((peer = gst_pad_get_peer (pad)) == NULL)
+      continue;
+
+    peer_element = gst_pad_get_parent_element (peer);
+    peer_idx = peer_element ? find_element (children, peer_element) : -1;
+    if (peer_idx < 0) {
+      GST_DEBUG ("pad %s:%s is linked outside of the bin",
+          GST_DEBUG_PAD_NAME (pad));
+      res = FALSE;
+    } else {
+      link.src_idx = idx;
+      link.src_pad = gst_pad_get_name (pad);
+      link.src_request = is_request_pad (pad);
+      link.sink_idx = peer_idx;
+      link.sink_pad = gst_pad_get_name (peer);
+      link.sink_request = is_request_pad (peer);
+      g_array_append_val (tmpl->links, link);
+    }
+    if (peer_element)
+      gst_object_unref (peer_element);
+    gst_object_unref (peer);
+  }
+  GST_OBJECT_UNLOCK (element);
+
+  return res;
+}
+
+/* gst_rtsp_launch_template_new:
+ * @element: a freshly parsed element
+ * @launch: the launch description @element was parsed from
+ *
+ * Make a template from @element, which should be the result of
+ * gst_parse_launch() with @launch and not be used yet.
+ *
+ * Returns a new #GstRTSPLaunchTemplate or %NULL when @element can't be
+ * represented as a template.
+ */
+GstRTSPLaunchTemplate *
+gst_rtsp_launch_template_new (GstElement * element, const gchar * launch)
+{
+  static gsize init = 0;
+  GstRTSPLaunchTemplate *tmpl;
+  GPtrArray *children = NULL;
+  GPtrArray *launch_elements, *bin_props, *order;
+  GList *walk;
+  guint i, next;
+
+  g_return_val_if_fail (GST_IS_ELEMENT (element), NULL);
+  g_return_val_if_fail (launch != NULL, NULL);
+
+  if (g_once_init_enter (&init)) {
+    GST_DEBUG_CATEGORY_INIT (rtsp_launch_template_debug, "rtsplaunchtemplate",
+        0, "GstRTSPLaunchTemplate");
+    g_once_init_leave (&init, 1);
+  }
+
+  tmpl = g_slice_new0 (GstRTSPLaunchTemplate);
+  tmpl->refcount = 1;
+  tmpl->elements = g_array_new (FALSE, TRUE, sizeof (TemplateElement));
+  g_array_set_clear_func (tmpl->elements,
+      (GDestroyNotify) template_element_clear);
+  tmpl->links = g_array_new (FALSE, TRUE, sizeof (TemplateLink));
+  g_array_set_clear_func (tmpl->links, (GDestroyNotify) template_link_clear);
+
+  bin_props = g_ptr_array_new_with_free_func (g_free);
+  launch_elements = parse_launch_order (launch, bin_props);
+
+  if (element->numpads > 0 && GST_IS_BIN (element))
+    goto not_supported;
+
+  if (GST_IS_CHILD_PROXY (element) && !GST_IS_BIN (element))
+    goto not_supported;
+
+  if (GST_IS_BIN (element)) {
+    order = bin_props;
+  } else if (launch_elements->len == 1) {
+    order = ((LaunchElement *) g_ptr_array_index (launch_elements, 0))->props;
+  } else {
+    goto not_supported;
+  }
+
+  if (!template_element_init (&tmpl->top, element, order))
+    goto not_supported;
+
+  if (!GST_IS_BIN (element))
+    goto done;
+
+  /* only plain bins made by the parser are expanded, other bins do their own
+   * setup of the children */
+  if (strcmp (GST_OBJECT_NAME (tmpl->top.factory), "bin") != 0)
+    goto not_supported;
+
+  children = g_ptr_array_new_with_free_func (gst_object_unref);
+  GST_OBJECT_LOCK (element);
+  /* children are prepended, walk backwards to keep the original order */
+  for (walk = g_list_last (GST_BIN_CHILDREN (element)); walk;
+      walk = g_list_previous (walk))
+    g_ptr_array_add (children, gst_object_ref (walk->data));
+  GST_OBJECT_UNLOCK (element);
+
+  /* the elements of the launch description are added in order. The parser
+   * adds capsfilters for the caps of links, these are not in the
+   * description */
+  next = 0;
+  for (i = 0; i < children->len; i++) {
+    GstElement *child = g_ptr_array_index (children, i);
+    TemplateElement te = { NULL, };
+    LaunchElement *le = NULL;
+
+    if (GST_IS_CHILD_PROXY (child))
+      goto child_not_supported;
+
+    if (next < launch_elements->len && gst_element_get_factory (child)) {
+      le = g_ptr_array_index (launch_elements, next);
+      if (strcmp (GST_OBJECT_NAME (gst_element_get_factory (child)),
+              le->factory) == 0)
+        next++;
+      else
+        le = NULL;
+    }
+
+    if (!template_element_init (&te, child, le ? le->props : NULL)) {
+      template_element_clear (&te);
+      goto child_not_supported;
+    }
+    g_array_append_val (tmpl->elements, te);
+
+    /* these would be linked when the pad appears, which we can't copy */
+    if (has_sometimes_pads (te.factory))
+      goto child_not_supported;
+  }
+
+  /* all elements of the description must be found to know the order of
+   * their properties */
+  if (next < launch_elements->len)
+    goto child_not_supported;
+
+  for (i = 0; i < children->len; i++) {
+    if (!collect_links (tmpl, children, i))
+      goto child_not_supported;
+  }
+  g_ptr_array_free (children, TRUE);
+
+  GST_DEBUG ("made template with %u elements and %u links",
+      tmpl->elements->len, tmpl->links->len);
+
+done:
+  g_ptr_array_free (launch_elements, TRUE);
+  g_ptr_array_free (bin_props, TRUE);
+
+  return tmpl;
+
+  /* ERRORS */
+child_not_supported:
+  {
+    g_ptr_array_free (children, TRUE);
+    goto not_supported;
+  }
+not_supported:
+  {
+    GST_DEBUG ("element %s can't be used as a template",
+        GST_ELEMENT_NAME (element));
+    g_ptr_array_free (launch_elements, TRUE);
+    g_ptr_array_free (bin_props, TRUE);
+    gst_rtsp_launch_template_unref (tmpl);
+    return NULL;
+  }
+}
+
+/* gst_rtsp_launch_template_ref:
+ * @tmpl: a #GstRTSPLaunchTemplate
+ *
+ * Increase the refcount of @tmpl.
+ *
+ * Returns @tmpl.
+ */
+GstRTSPLaunchTemplate *
+gst_rtsp_launch_template_ref (GstRTSPLaunchTemplate * tmpl)
+{
+  g_return_val_if_fail (tmpl != NULL, NULL);
+
+  g_atomic_int_inc (&tmpl->refcount);
+
+  return tmpl;
+}
+
+/* gst_rtsp_launch_template_unref:
+ * @tmpl: a #GstRTSPLaunchTemplate
+ *
+ * Decrease the refcount of @tmpl and free it when it reaches 0.
+ */
+void
+gst_rtsp_launch_template_unref (GstRTSPLaunchTemplate * tmpl)
+{
+  g_return_if_fail (tmpl != NULL);
+
+  if (!g_atomic_int_dec_and_test (&tmpl->refcount))
+    return;
+
+  template_element_clear (&tmpl->top);
+  g_array_free (tmpl->elements, TRUE);
+  g_array_free (tmpl->links, TRUE);
+  g_slice_free (GstRTSPLaunchTemplate, tmpl);
+}
+
+static GstPad *
+get_pad (GstElement * element, const gchar * name, gboolean request)
+{
+  if (request)
+    return gst_element_get_request_pad (element, name);
+  else
+    return gst_element_get_static_pad (element, name);
+}
+
+/* gst_rtsp_launch_template_instantiate:
+ * @tmpl: a #GstRTSPLaunchTemplate
+ *
+ * Make a new element from @tmpl. This is the same as parsing the launch line
+ * that was used to make @tmpl again.
+ *
+ * Returns a new floating #GstElement or %NULL on error.
+ */
+GstElement *
+gst_rtsp_launch_template_instantiate (GstRTSPLaunchTemplate * tmpl)
+{
+  GstElement *top;
+  GstElement **children;
+  guint i;
+
+  g_return_val_if_fail (tmpl != NULL, NULL);
+
+  top = template_element_create (&tmpl->top);
+  if (top == NULL)
+    goto create_failed;
+
+  if (tmpl->elements->len == 0)
+    return top;
+
+  children = g_newa (GstElement *, tmpl->elements->len);
+  for (i = 0; i < tmpl->elements->len; i++) {
+    children[i] =
+        template_element_create (&g_array_index (tmpl->elements,
+            TemplateElement, i));
+    if (children[i] == NULL)
+      goto create_child_failed;
+    gst_bin_add (GST_BIN_CAST (top), children[i]);
+  }
+
+  for (i = 0; i < tmpl->links->len; i++) {
+    TemplateLink *link = &g_array_index (tmpl->links, TemplateLink, i);
+    GstPad *srcpad, *sinkpad;
+    GstPadLinkReturn ret;
+
+    srcpad = get_pad (children[link->src_idx], link->src_pad,
+        link->src_request);
+    sinkpad = get_pad (children[link->sink_idx], link->sink_pad,
+        link->sink_request);
+
+    /* check the caps like the parser does */
+    if (srcpad && sinkpad)
+      ret = gst_pad_link (srcpad, sinkpad);
+    else
+      ret = GST_PAD_LINK_REFUSED;
+
+    if (srcpad)
+      gst_object_unref (srcpad);
+    if (sinkpad)
+      gst_object_unref (sinkpad);
+
+    if (ret != GST_PAD_LINK_OK)
+      goto link_failed;
+  }
+  return top;
+
+  /* ERRORS */
+create_failed:
+  {
+    GST_WARNING ("could not create element %s", tmpl->top.name);
+    return NULL;
+  }
+create_child_failed:
+  {
+    GST_WARNING ("could not create child element %u", i);
+    gst_object_unref (gst_object_ref_sink (top));
+    return NULL;
+  }
+link_failed:
+  {
+    GST_WARNING ("could not make link %u", i);
+    gst_object_unref (gst_object_ref_sink (top));
+    return NULL;
+  }
+}
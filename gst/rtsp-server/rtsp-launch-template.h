@@ -0,0 +1,40 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSP_LAUNCH_TEMPLATE_H__
+#define __GST_RTSP_LAUNCH_TEMPLATE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstRTSPLaunchTemplate GstRTSPLaunchTemplate;
+
+GstRTSPLaunchTemplate * gst_rtsp_launch_template_new         (GstElement * element,
+                                                              const gchar * launch);
+
+GstRTSPLaunchTemplate * gst_rtsp_launch_template_ref         (GstRTSPLaunchTemplate * tmpl);
+
+void                    gst_rtsp_launch_template_unref       (GstRTSPLaunchTemplate * tmpl);
+
+GstElement *            gst_rtsp_launch_template_instantiate (GstRTSPLaunchTemplate * tmpl);
+
+G_END_DECLS
+
+#endif /* __GST_RTSP_LAUNCH_TEMPLATE_H__ */
@@ -27,6 +27,12 @@
  * It will automatically demux and payload the different streams found in the
  * media at URL.
  *
+ * When a cache directory is configured with
+ * gst_rtsp_media_factory_uri_set_cache_dir(), the RTP packets of local files
+ * are indexed once in the background and stored in that directory. Medias
+ * made after that stream the stored packets instead of demuxing and
+ * payloading the file again.
+ *
  * Last reviewed on 2013-07-11 (1.0.0)
  */
 #ifdef HAVE_CONFIG_H
@@ -35,7 +41,10 @@
 
 #include <string.h>
 
+#include <glib/gstdio.h>
+
 #include "rtsp-media-factory-uri.h"
+#include "rtsp-packet-cache.h"
 
 struct _GstRTSPMediaFactoryURIPrivate
 {
@@ -48,16 +57,32 @@ struct _GstRTSPMediaFactoryURIPrivate
   GList *demuxers;
   GList *payloaders;
   GList *decoders;
+
+  gchar *cache_dir;             /* protected by lock */
+  GstRTSPPacketCache *packet_cache;     /* protected by lock */
+  gchar *packet_cache_path;     /* path of packet_cache, protected by lock */
+  /* the paths being indexed or that failed to index, with the monotonic
+   * time until which they are not indexed again, protected by lock */
+  GHashTable *indexing;
 };
 
 #define DEFAULT_URI         NULL
 #define DEFAULT_USE_GSTPAY  FALSE
+#define DEFAULT_CACHE_DIR   NULL
+
+/* files that are indexed at the same time */
+#define INDEX_MAX_THREADS   2
+/* give up on files that take longer to index */
+#define INDEX_TIMEOUT       (10 * 60 * GST_SECOND)
+/* the time before a file that failed to index is indexed again */
+#define INDEX_RETRY_INTERVAL (5 * G_TIME_SPAN_MINUTE)
 
 enum
 {
   PROP_0,
   PROP_URI,
   PROP_USE_GSTPAY,
+  PROP_CACHE_DIR,
   PROP_LAST
 };
 
@@ -133,6 +158,18 @@ gst_rtsp_media_factory_uri_class_init (GstRTSPMediaFactoryURIClass * klass)
       g_param_spec_boolean ("use-gstpay", "Use gstpay",
           "Use the gstpay payloader to avoid decoding", DEFAULT_USE_GSTPAY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPMediaFactoryURI::cache-dir:
+   *
+   * The directory where the RTP packets of local files are cached.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_DIR,
+      g_param_spec_string ("cache-dir", "Cache directory",
+          "The directory to cache the RTP packets of local files in "
+          "(NULL = no caching)", DEFAULT_CACHE_DIR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   mediafactory_class->create_element = rtsp_media_factory_uri_create_element;
 
@@ -195,6 +232,9 @@ gst_rtsp_media_factory_uri_init (GstRTSPMediaFactoryURI * factory)
 
   priv->uri = g_strdup (DEFAULT_URI);
   priv->use_gstpay = DEFAULT_USE_GSTPAY;
+  priv->cache_dir = g_strdup (DEFAULT_CACHE_DIR);
+  priv->indexing = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
   g_mutex_init (&priv->lock);
 
   /* get the feature list using the filter */
@@ -221,6 +261,11 @@ gst_rtsp_media_factory_uri_finalize (GObject * obj)
   GST_DEBUG_OBJECT (factory, "finalize");
 
   g_free (priv->uri);
+  g_free (priv->cache_dir);
+  if (priv->packet_cache)
+    gst_rtsp_packet_cache_unref (priv->packet_cache);
+  g_free (priv->packet_cache_path);
+  g_hash_table_unref (priv->indexing);
   gst_plugin_feature_list_free (priv->demuxers);
   gst_plugin_feature_list_free (priv->payloaders);
   gst_plugin_feature_list_free (priv->decoders);
@@ -245,6 +290,10 @@ gst_rtsp_media_factory_uri_get_property (GObject * object, guint propid,
     case PROP_USE_GSTPAY:
       g_value_set_boolean (value, priv->use_gstpay);
       break;
+    case PROP_CACHE_DIR:
+      g_value_take_string (value,
+          gst_rtsp_media_factory_uri_get_cache_dir (factory));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -264,6 +313,10 @@ gst_rtsp_media_factory_uri_set_property (GObject * object, guint propid,
     case PROP_USE_GSTPAY:
       priv->use_gstpay = g_value_get_boolean (value);
       break;
+    case PROP_CACHE_DIR:
+      gst_rtsp_media_factory_uri_set_cache_dir (factory,
+          g_value_get_string (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -335,6 +388,70 @@ gst_rtsp_media_factory_uri_get_uri (GstRTSPMediaFactoryURI * factory)
   return result;
 }
 
+/**
+ * gst_rtsp_media_factory_uri_set_cache_dir:
+ * @factory: a #GstRTSPMediaFactoryURI
+ * @cache_dir: (nullable): a directory
+ *
+ * Configure a directory where @factory caches the RTP packets of local
+ * files. The first media of a file is made as usual while the packets of
+ * the file are indexed in the background. The next medias stream the cached
+ * packets from a memory mapping and resolve seeks with the index, without
+ * demuxing and payloading the file again. Seeks in cached medias always
+ * start at a keyframe.
+ *
+ * A cache is made per file, modification time and payloader configuration.
+ * When the file changes, it is indexed again and the caches of its older
+ * versions are removed. A file that failed to index is indexed again after
+ * a few minutes. Cached packets keep the size they were made with, later
+ * changes to the MTU of the stream have no effect.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_factory_uri_set_cache_dir (GstRTSPMediaFactoryURI * factory,
+    const gchar * cache_dir)
+{
+  GstRTSPMediaFactoryURIPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA_FACTORY_URI (factory));
+
+  priv = factory->priv;
+
+  g_mutex_lock (&priv->lock);
+  g_free (priv->cache_dir);
+  priv->cache_dir = g_strdup (cache_dir);
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gst_rtsp_media_factory_uri_get_cache_dir:
+ * @factory: a #GstRTSPMediaFactoryURI
+ *
+ * Get the directory where @factory caches the RTP packets of local files.
+ *
+ * Returns: (transfer full) (nullable): the cache directory. g_free() after
+ * usage.
+ *
+ * Since: 1.18
+ */
+gchar *
+gst_rtsp_media_factory_uri_get_cache_dir (GstRTSPMediaFactoryURI * factory)
+{
+  GstRTSPMediaFactoryURIPrivate *priv;
+  gchar *result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY_URI (factory), NULL);
+
+  priv = factory->priv;
+
+  g_mutex_lock (&priv->lock);
+  result = g_strdup (priv->cache_dir);
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
+
 static GstElementFactory *
 find_payloader (GstRTSPMediaFactoryURI * urifact, GstCaps * caps)
 {
@@ -590,17 +707,11 @@ no_more_pads_cb (GstElement * uribin, GstElement * element)
 }
 
 static GstElement *
-rtsp_media_factory_uri_create_element (GstRTSPMediaFactory * factory,
-    const GstRTSPUrl * url)
+create_uri_element (GstRTSPMediaFactoryURI * urifact, const gchar * uri)
 {
-  GstRTSPMediaFactoryURIPrivate *priv;
   GstElement *topbin, *element, *uribin;
-  GstRTSPMediaFactoryURI *urifact;
   FactoryData *data;
 
-  urifact = GST_RTSP_MEDIA_FACTORY_URI_CAST (factory);
-  priv = urifact->priv;
-
   GST_LOG ("creating element");
 
   topbin = gst_bin_new ("GstRTSPMediaFactoryURI");
@@ -614,7 +725,7 @@ rtsp_media_factory_uri_create_element (GstRTSPMediaFactory * factory,
   if (uribin == NULL)
     goto no_uridecodebin;
 
-  g_object_set (uribin, "uri", priv->uri, NULL);
+  g_object_set (uribin, "uri", uri, NULL);
 
   /* keep factory data around */
   data = g_new0 (FactoryData, 1);
@@ -643,3 +754,443 @@ no_uridecodebin:
     return NULL;
   }
 }
+
+/* the path of the packet cache of @uri, NULL when @uri can't be cached */
+static gchar *
+get_cache_path (GstRTSPMediaFactoryURI * urifact, const gchar * uri)
+{
+  GstRTSPMediaFactoryURIPrivate *priv = urifact->priv;
+  gchar *cache_dir, *filename, *key, *checksum, *name, *path = NULL;
+  GStatBuf st;
+
+  g_mutex_lock (&priv->lock);
+  cache_dir = g_strdup (priv->cache_dir);
+  g_mutex_unlock (&priv->lock);
+
+  if (cache_dir == NULL || uri == NULL)
+    goto done;
+
+  /* only local files, for which we can see when they change */
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (filename && g_stat (filename, &st) == 0) {
+    /* the payloaders are configured the same way for each media, so the
+     * packets only depend on the file and the payloaders we pick. The
+     * caches of the older versions of the file have the same prefix */
+    key = g_strdup_printf ("%s|%d", uri, priv->use_gstpay);
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key, -1);
+    name = g_strdup_printf ("%s-%" G_GINT64_FORMAT "-%" G_GINT64_FORMAT
+        ".rtpcache", checksum, (gint64) st.st_mtime, (gint64) st.st_size);
+    path = g_build_filename (cache_dir, name, NULL);
+    g_free (name);
+    g_free (checksum);
+    g_free (key);
+  }
+  g_free (filename);
+
+done:
+  g_free (cache_dir);
+  return path;
+}
+
+/* get the packet cache at @path, NULL when it is not made yet */
+/* remove the caches of the older versions of the file of the cache at
+ * @path */
+static void
+remove_old_caches (const gchar * path)
+{
+  gchar *dirname, *basename, *prefix;
+  const gchar *name;
+  GDir *dir;
+
+  dirname = g_path_get_dirname (path);
+  basename = g_path_get_basename (path);
+  prefix = g_strndup (basename, strcspn (basename, "-") + 1);
+
+  if ((dir = g_dir_open (dirname, 0, NULL))) {
+    while ((name = g_dir_read_name (dir))) {
+      gchar *old;
+
+      if (!g_str_has_prefix (name, prefix) ||
+          !g_str_has_suffix (name, ".rtpcache") || !strcmp (name, basename))
+        continue;
+
+      old = g_build_filename (dirname, name, NULL);
+      GST_INFO ("removing old packet cache %s", old);
+      if (g_unlink (old) != 0)
+        GST_WARNING ("could not remove %s", old);
+      g_free (old);
+    }
+    g_dir_close (dir);
+  }
+
+  g_free (prefix);
+  g_free (basename);
+  g_free (dirname);
+}
+
+/* called with the lock, whether @path is being indexed or failed to index
+ * recently */
+static gboolean
+is_indexing (GstRTSPMediaFactoryURIPrivate * priv, const gchar * path)
+{
+  gint64 *until;
+
+  until = g_hash_table_lookup (priv->indexing, path);
+
+  return until && *until > g_get_monotonic_time ();
+}
+
+static GstRTSPPacketCache *
+get_packet_cache (GstRTSPMediaFactoryURI * urifact, const gchar * path)
+{
+  GstRTSPMediaFactoryURIPrivate *priv = urifact->priv;
+  GstRTSPPacketCache *cache = NULL;
+
+  g_mutex_lock (&priv->lock);
+  if (priv->packet_cache && !g_strcmp0 (priv->packet_cache_path, path))
+    cache = gst_rtsp_packet_cache_ref (priv->packet_cache);
+  g_mutex_unlock (&priv->lock);
+
+  if (cache)
+    return cache;
+
+  if (!(cache = gst_rtsp_packet_cache_open (path)))
+    return NULL;
+
+  /* keep the last cache around, the medias of a factory share the mapping */
+  g_mutex_lock (&priv->lock);
+  if (priv->packet_cache)
+    gst_rtsp_packet_cache_unref (priv->packet_cache);
+  priv->packet_cache = gst_rtsp_packet_cache_ref (cache);
+  g_free (priv->packet_cache_path);
+  priv->packet_cache_path = g_strdup (path);
+  g_mutex_unlock (&priv->lock);
+
+  return cache;
+}
+
+static GstElement *
+create_cached_element (GstRTSPPacketCache * cache)
+{
+  GstElement *topbin;
+  guint i;
+
+  topbin = gst_bin_new ("GstRTSPMediaFactoryURI");
+
+  /* the replaying elements act as payloaders of static streams */
+  for (i = 0; i < gst_rtsp_packet_cache_n_streams (cache); i++) {
+    gchar *name = g_strdup_printf ("pay%u", i);
+
+    gst_bin_add (GST_BIN_CAST (topbin),
+        gst_rtsp_packet_cache_create_src (cache, i, name));
+    g_free (name);
+  }
+  return topbin;
+}
+
+typedef struct
+{
+  GstRTSPMediaFactoryURI *factory;
+  gchar *uri;
+  gchar *path;
+  GstRTSPPacketCacheWriter *writer;
+} IndexData;
+
+typedef struct
+{
+  GstRTSPPacketCacheWriter *writer;
+  guint stream;
+  gboolean keyframe;            /* the next packet starts a keyframe */
+  GstClockTime dts;             /* of the frame being payloaded */
+  GstSegment segment;           /* of the payloader output */
+} IndexStream;
+
+static GstPadProbeReturn
+index_payloader_input (GstPad * pad, GstPadProbeInfo * info,
+    IndexStream * stream)
+{
+  GstBuffer *buffer;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    buffer = gst_buffer_list_get (GST_PAD_PROBE_INFO_BUFFER_LIST (info), 0);
+  else
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (buffer == NULL)
+    return GST_PAD_PROBE_OK;
+
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    stream->keyframe = TRUE;
+  /* the packets only have the presentation time of their frame */
+  stream->dts = GST_BUFFER_DTS (buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+typedef struct
+{
+  IndexStream *stream;
+  GstCaps *caps;
+} IndexPacket;
+
+static gboolean
+index_packet (GstBuffer ** buffer, guint idx, IndexPacket * packet)
+{
+  IndexStream *stream = packet->stream;
+  GstClockTime pts, dts;
+
+  /* payloaders payload the frames in the segment of their input, the
+   * payloader input and output have the same segment */
+  pts = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (*buffer));
+  dts = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->dts);
+
+  gst_rtsp_packet_cache_writer_add_packet (stream->writer, stream->stream,
+      packet->caps, *buffer, pts, dts, stream->keyframe);
+  stream->keyframe = FALSE;
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+index_payloader_output (GstPad * pad, GstPadProbeInfo * info,
+    IndexStream * stream)
+{
+  IndexPacket packet;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)
+      gst_event_copy_segment (event, &stream->segment);
+    return GST_PAD_PROBE_OK;
+  }
+
+  packet.stream = stream;
+  packet.caps = gst_pad_get_current_caps (pad);
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        (GstBufferListFunc) index_packet, &packet);
+  else
+    index_packet (&GST_PAD_PROBE_INFO_BUFFER (info), 0, &packet);
+
+  if (packet.caps)
+    gst_caps_unref (packet.caps);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+index_pad_added_cb (GstElement * element, GstPad * pad, IndexData * data)
+{
+  IndexStream *stream;
+  GstElement *payloader, *sink, *parent;
+  GstPad *target, *sinkpad;
+  GstEvent *event;
+
+  GST_DEBUG ("indexing pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  stream = g_new0 (IndexStream, 1);
+  stream->writer = data->writer;
+  stream->stream = gst_rtsp_packet_cache_writer_add_stream (data->writer);
+  stream->dts = GST_CLOCK_TIME_NONE;
+  gst_segment_init (&stream->segment, GST_FORMAT_TIME);
+  if ((event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0))) {
+    gst_event_copy_segment (event, &stream->segment);
+    gst_event_unref (event);
+  }
+
+  /* the keyframe flags are on the input of the payloader */
+  target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+  payloader = gst_pad_get_parent_element (target);
+  sinkpad = gst_element_get_static_pad (payloader, "sink");
+  gst_pad_add_probe (sinkpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) index_payloader_input, stream, NULL);
+  gst_object_unref (sinkpad);
+  gst_object_unref (payloader);
+  gst_object_unref (target);
+
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) index_payloader_output, stream, g_free);
+
+  /* run as fast as possible */
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  parent = GST_ELEMENT_CAST (gst_object_get_parent (GST_OBJECT (element)));
+  gst_bin_add (GST_BIN_CAST (parent), sink);
+  gst_element_sync_state_with_parent (sink);
+  gst_object_unref (parent);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static void
+index_file (IndexData * data, gpointer user_data)
+{
+  GstRTSPMediaFactoryURIPrivate *priv = data->factory->priv;
+  GstElement *pipeline, *topbin, *dynpay;
+  GstMessage *msg;
+  GstBus *bus;
+  gint64 duration;
+  gboolean res = FALSE;
+  gchar *dir;
+
+  GST_INFO ("indexing %s to %s", data->uri, data->path);
+
+  dir = g_path_get_dirname (data->path);
+  g_mkdir_with_parents (dir, 0755);
+  g_free (dir);
+
+  data->writer = gst_rtsp_packet_cache_writer_new (data->path);
+  if (data->writer == NULL)
+    goto done;
+
+  if (!(topbin = create_uri_element (data->factory, data->uri)))
+    goto done;
+
+  dynpay = gst_bin_get_by_name (GST_BIN_CAST (topbin), "dynpay0");
+  g_signal_connect (dynpay, "pad-added", (GCallback) index_pad_added_cb,
+      data);
+  gst_object_unref (dynpay);
+
+  pipeline = gst_pipeline_new ("rtsp-index");
+  gst_bin_add (GST_BIN_CAST (pipeline), topbin);
+  bus = gst_element_get_bus (pipeline);
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE) {
+    msg = gst_bus_timed_pop_filtered (bus, INDEX_TIMEOUT,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg == NULL) {
+      GST_WARNING ("timeout indexing %s", data->uri);
+    } else {
+      if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS) {
+        if (!gst_element_query_duration (pipeline, GST_FORMAT_TIME,
+                &duration))
+          duration = GST_CLOCK_TIME_NONE;
+        res = TRUE;
+      }
+      gst_message_unref (msg);
+    }
+  }
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  if (res)
+    res = gst_rtsp_packet_cache_writer_finish (data->writer, duration);
+  if (res)
+    remove_old_caches (data->path);
+
+done:
+  g_mutex_lock (&priv->lock);
+  if (res) {
+    g_hash_table_remove (priv->indexing, data->path);
+  } else {
+    gint64 *until = g_new (gint64, 1);
+
+    /* don't try again for every media, the file might be fixed later */
+    GST_WARNING ("failed to index %s", data->uri);
+    *until = g_get_monotonic_time () + INDEX_RETRY_INTERVAL;
+    g_hash_table_insert (priv->indexing, g_strdup (data->path), until);
+  }
+  g_mutex_unlock (&priv->lock);
+
+  if (data->writer)
+    gst_rtsp_packet_cache_writer_free (data->writer);
+  g_object_unref (data->factory);
+  g_free (data->uri);
+  g_free (data->path);
+  g_free (data);
+}
+
+static GThreadPool *
+get_indexers (void)
+{
+  static gsize indexers = 0;
+
+  if (g_once_init_enter (&indexers)) {
+    GThreadPool *pool;
+
+    pool = g_thread_pool_new ((GFunc) index_file, NULL, INDEX_MAX_THREADS,
+        FALSE, NULL);
+    g_once_init_leave (&indexers, (gsize) pool);
+  }
+  return (GThreadPool *) indexers;
+}
+
+/* index @uri in the background unless it is being indexed already or
+ * failed recently, returns %TRUE when indexing was queued */
+static gboolean
+start_indexing (GstRTSPMediaFactoryURI * urifact, const gchar * uri,
+    const gchar * path)
+{
+  GstRTSPMediaFactoryURIPrivate *priv = urifact->priv;
+  IndexData *data;
+  gint64 *until;
+
+  g_mutex_lock (&priv->lock);
+  if (is_indexing (priv, path)) {
+    g_mutex_unlock (&priv->lock);
+    return FALSE;
+  }
+  until = g_new (gint64, 1);
+  *until = G_MAXINT64;
+  g_hash_table_insert (priv->indexing, g_strdup (path), until);
+  g_mutex_unlock (&priv->lock);
+
+  data = g_new0 (IndexData, 1);
+  data->factory = g_object_ref (urifact);
+  data->uri = g_strdup (uri);
+  data->path = g_strdup (path);
+
+  g_thread_pool_push (get_indexers (), data, NULL);
+
+  return TRUE;
+}
+
+static GstElement *
+rtsp_media_factory_uri_create_element (GstRTSPMediaFactory * factory,
+    const GstRTSPUrl * url)
+{
+  GstRTSPMediaFactoryURIPrivate *priv;
+  GstRTSPMediaFactoryURI *urifact;
+  GstRTSPPacketCache *cache = NULL;
+  GstElement *topbin;
+  gchar *uri, *path;
+  gboolean indexing;
+
+  urifact = GST_RTSP_MEDIA_FACTORY_URI_CAST (factory);
+  priv = urifact->priv;
+
+  uri = gst_rtsp_media_factory_uri_get_uri (urifact);
+
+  if ((path = get_cache_path (urifact, uri))) {
+    g_mutex_lock (&priv->lock);
+    indexing = is_indexing (priv, path);
+    g_mutex_unlock (&priv->lock);
+
+    if (!indexing && !(cache = get_packet_cache (urifact, path)))
+      start_indexing (urifact, uri, path);
+    g_free (path);
+  }
+
+  if (cache) {
+    GST_LOG ("creating element from packet cache");
+    topbin = create_cached_element (cache);
+    gst_rtsp_packet_cache_unref (cache);
+  } else {
+    topbin = create_uri_element (urifact, uri);
+  }
+  g_free (uri);
+
+  return topbin;
+}
@@ -82,6 +82,13 @@ void                  gst_rtsp_media_factory_uri_set_uri  (GstRTSPMediaFactoryUR
 GST_RTSP_SERVER_API
 gchar *               gst_rtsp_media_factory_uri_get_uri  (GstRTSPMediaFactoryURI *factory);
 
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_factory_uri_set_cache_dir (GstRTSPMediaFactoryURI *factory,
+                                                                const gchar *cache_dir);
+
+GST_RTSP_SERVER_API
+gchar *               gst_rtsp_media_factory_uri_get_cache_dir (GstRTSPMediaFactoryURI *factory);
+
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstRTSPMediaFactoryURI, gst_object_unref)
 #endif
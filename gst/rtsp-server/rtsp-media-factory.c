@@ -35,6 +35,12 @@
  * gst_rtsp_media_factory_construct() will return the same #GstRTSPMedia when
  * the url matches.
  *
+ * To reduce the time it takes to answer a DESCRIBE request for media that
+ * is not shared, a warm pool of already prepared #GstRTSPMedia objects can
+ * be kept with gst_rtsp_media_factory_set_warm_pool_size(). The pool is
+ * filled in the background for the last requested url and medias are taken
+ * from it by gst_rtsp_media_factory_construct().
+ *
  * Last reviewed on 2013-07-11 (1.0.0)
  */
 #ifdef HAVE_CONFIG_H
@@ -42,6 +48,7 @@
 #endif
 
 #include "rtsp-media-factory.h"
+#include "rtsp-launch-template.h"
 
 #define GST_RTSP_MEDIA_FACTORY_GET_LOCK(f)       (&(GST_RTSP_MEDIA_FACTORY_CAST(f)->priv->lock))
 #define GST_RTSP_MEDIA_FACTORY_LOCK(f)           (g_mutex_lock(GST_RTSP_MEDIA_FACTORY_GET_LOCK(f)))
@@ -52,6 +59,8 @@ struct _GstRTSPMediaFactoryPrivate
   GMutex lock;                  /* protects everything but medias */
   GstRTSPPermissions *permissions;
   gchar *launch;
+  GstRTSPLaunchTemplate *launch_template;
+  gboolean launch_template_failed;
   gboolean shared;
   GstRTSPSuspendMode suspend_mode;
   gboolean eos_shutdown;
@@ -64,13 +73,33 @@ struct _GstRTSPMediaFactoryPrivate
   gchar *multicast_iface;
   guint max_mcast_ttl;
   gboolean bind_mcast_address;
+  GstClockTime key_unit_interval;
+  gboolean gop_cache;
 
   GstClockTime rtx_time;
   guint latency;
   gboolean do_retransmission;
+  GstClockTime linger_time;
 
   GMutex medias_lock;
   GHashTable *medias;           /* protected by medias_lock */
+  GHashTable *constructing;     /* keys being constructed, protected by medias_lock */
+  GCond constructing_cond;      /* signaled when a construction finishes */
+
+  /* warm pool of prepared medias, protected by medias_lock */
+  guint warm_pool_size;
+  GQueue warm_pool;
+  gchar *warm_pool_key;         /* key of the medias in the pool */
+  GstRTSPUrl *warm_pool_url;    /* url used to fill the pool */
+  guint warm_pool_filling;      /* medias being prepared for the pool */
+  gboolean warm_pool_blocked;   /* the medias of the key can't be pooled */
+  GstRTSPThreadPool *thread_pool;       /* prepares the medias of the pool */
+  guint64 warm_pool_hits;
+  guint64 warm_pool_misses;
+
+  /* linger statistics, protected by medias_lock */
+  guint64 linger_reused;
+  guint64 linger_expired;
 
   GType media_gtype;
 
@@ -93,6 +122,10 @@ struct _GstRTSPMediaFactoryPrivate
 #define DEFAULT_TRANSPORT_MODE  GST_RTSP_TRANSPORT_MODE_PLAY
 #define DEFAULT_STOP_ON_DISCONNECT TRUE
 #define DEFAULT_DO_RETRANSMISSION FALSE
+#define DEFAULT_WARM_POOL_SIZE  0
+#define DEFAULT_LINGER_TIME     0
+#define DEFAULT_KEY_UNIT_INTERVAL 0
+#define DEFAULT_GOP_CACHE       FALSE
 
 enum
 {
@@ -110,6 +143,10 @@ enum
   PROP_CLOCK,
   PROP_MAX_MCAST_TTL,
   PROP_BIND_MCAST_ADDRESS,
+  PROP_WARM_POOL_SIZE,
+  PROP_LINGER_TIME,
+  PROP_KEY_UNIT_INTERVAL,
+  PROP_GOP_CACHE,
   PROP_LAST
 };
 
@@ -141,6 +178,8 @@ static void default_configure (GstRTSPMediaFactory * factory,
     GstRTSPMedia * media);
 static GstElement *default_create_pipeline (GstRTSPMediaFactory * factory,
     GstRTSPMedia * media);
+static void warm_pool_release (GList * medias);
+static void warm_pool_fill (gpointer data, gpointer user_data);
 
 G_DEFINE_TYPE_WITH_PRIVATE (GstRTSPMediaFactory, gst_rtsp_media_factory,
     G_TYPE_OBJECT);
@@ -244,6 +283,63 @@ gst_rtsp_media_factory_class_init (GstRTSPMediaFactoryClass * klass)
           DEFAULT_BIND_MCAST_ADDRESS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPMediaFactory:warm-pool-size:
+   *
+   * The number of prepared medias to keep ready for the next requests of
+   * the last url that was requested. Only medias that are not shared are
+   * kept in the pool.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_WARM_POOL_SIZE,
+      g_param_spec_uint ("warm-pool-size", "Warm Pool Size",
+          "The number of prepared medias to keep ready (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_WARM_POOL_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPMediaFactory:linger-time:
+   *
+   * The time a shared media stays prepared after its last client left.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_LINGER_TIME,
+      g_param_spec_uint64 ("linger-time", "Linger Time",
+          "Time in nanoseconds a shared media stays prepared without clients "
+          "(0 = unprepare immediately)", 0, G_MAXUINT64, DEFAULT_LINGER_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPMediaFactory:key-unit-interval:
+   *
+   * The minimum time between the keyframe requests of the streams of the
+   * medias when clients join them, see gst_rtsp_media_set_key_unit_interval().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_KEY_UNIT_INTERVAL,
+      g_param_spec_uint64 ("key-unit-interval", "Key Unit Interval",
+          "Minimum time in nanoseconds between keyframe requests when clients "
+          "join a stream (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_KEY_UNIT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPMediaFactory:gop-cache:
+   *
+   * Whether the streams of the medias keep their last GOP and send it to
+   * clients that join them, see gst_rtsp_media_set_gop_cache().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_GOP_CACHE,
+      g_param_spec_boolean ("gop-cache", "GOP Cache",
+          "Send the packets since the last keyframe to clients that join a "
+          "stream", DEFAULT_GOP_CACHE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_rtsp_media_factory_signals[SIGNAL_MEDIA_CONSTRUCTED] =
       g_signal_new ("media-constructed", G_TYPE_FROM_CLASS (klass),
       G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstRTSPMediaFactoryClass,
@@ -287,11 +383,19 @@ gst_rtsp_media_factory_init (GstRTSPMediaFactory * factory)
   priv->do_retransmission = DEFAULT_DO_RETRANSMISSION;
   priv->max_mcast_ttl = DEFAULT_MAX_MCAST_TTL;
   priv->bind_mcast_address = DEFAULT_BIND_MCAST_ADDRESS;
+  priv->linger_time = DEFAULT_LINGER_TIME;
+  priv->key_unit_interval = DEFAULT_KEY_UNIT_INTERVAL;
+  priv->gop_cache = DEFAULT_GOP_CACHE;
 
   g_mutex_init (&priv->lock);
   g_mutex_init (&priv->medias_lock);
   priv->medias = g_hash_table_new_full (g_str_hash, g_str_equal,
       g_free, g_object_unref);
+  priv->constructing = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, NULL);
+  g_cond_init (&priv->constructing_cond);
+  priv->warm_pool_size = DEFAULT_WARM_POOL_SIZE;
+  g_queue_init (&priv->warm_pool);
   priv->media_gtype = GST_TYPE_RTSP_MEDIA;
 }
 
@@ -301,13 +405,25 @@ gst_rtsp_media_factory_finalize (GObject * obj)
   GstRTSPMediaFactory *factory = GST_RTSP_MEDIA_FACTORY (obj);
   GstRTSPMediaFactoryPrivate *priv = factory->priv;
 
+  warm_pool_release (priv->warm_pool.head);
+  g_queue_init (&priv->warm_pool);
+  g_free (priv->warm_pool_key);
+  if (priv->warm_pool_url)
+    gst_rtsp_url_free (priv->warm_pool_url);
+  if (priv->thread_pool)
+    g_object_unref (priv->thread_pool);
+
   if (priv->clock)
     gst_object_unref (priv->clock);
   if (priv->permissions)
     gst_rtsp_permissions_unref (priv->permissions);
   g_hash_table_unref (priv->medias);
+  g_hash_table_unref (priv->constructing);
+  g_cond_clear (&priv->constructing_cond);
   g_mutex_clear (&priv->medias_lock);
   g_free (priv->launch);
+  if (priv->launch_template)
+    gst_rtsp_launch_template_unref (priv->launch_template);
   g_mutex_clear (&priv->lock);
   if (priv->pool)
     g_object_unref (priv->pool);
@@ -369,6 +485,22 @@ gst_rtsp_media_factory_get_property (GObject * object, guint propid,
       g_value_set_boolean (value,
           gst_rtsp_media_factory_is_bind_mcast_address (factory));
       break;
+    case PROP_WARM_POOL_SIZE:
+      g_value_set_uint (value,
+          gst_rtsp_media_factory_get_warm_pool_size (factory));
+      break;
+    case PROP_LINGER_TIME:
+      g_value_set_uint64 (value,
+          gst_rtsp_media_factory_get_linger_time (factory));
+      break;
+    case PROP_KEY_UNIT_INTERVAL:
+      g_value_set_uint64 (value,
+          gst_rtsp_media_factory_get_key_unit_interval (factory));
+      break;
+    case PROP_GOP_CACHE:
+      g_value_set_boolean (value,
+          gst_rtsp_media_factory_get_gop_cache (factory));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -427,6 +559,22 @@ gst_rtsp_media_factory_set_property (GObject * object, guint propid,
       gst_rtsp_media_factory_set_bind_mcast_address (factory,
           g_value_get_boolean (value));
       break;
+    case PROP_WARM_POOL_SIZE:
+      gst_rtsp_media_factory_set_warm_pool_size (factory,
+          g_value_get_uint (value));
+      break;
+    case PROP_LINGER_TIME:
+      gst_rtsp_media_factory_set_linger_time (factory,
+          g_value_get_uint64 (value));
+      break;
+    case PROP_KEY_UNIT_INTERVAL:
+      gst_rtsp_media_factory_set_key_unit_interval (factory,
+          g_value_get_uint64 (value));
+      break;
+    case PROP_GOP_CACHE:
+      gst_rtsp_media_factory_set_gop_cache (factory,
+          g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -592,6 +740,11 @@ gst_rtsp_media_factory_set_launch (GstRTSPMediaFactory * factory,
   GST_RTSP_MEDIA_FACTORY_LOCK (factory);
   g_free (priv->launch);
   priv->launch = g_strdup (launch);
+  /* the template is made again from the new launch line */
+  if (priv->launch_template)
+    gst_rtsp_launch_template_unref (priv->launch_template);
+  priv->launch_template = NULL;
+  priv->launch_template_failed = FALSE;
   GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
 }
 
@@ -1248,6 +1401,36 @@ media_unprepared (GstRTSPMedia * media, GWeakRef * ref)
   g_object_unref (factory);
 }
 
+static void
+media_linger_reused (GstRTSPMedia * media, GWeakRef * ref)
+{
+  GstRTSPMediaFactory *factory = g_weak_ref_get (ref);
+
+  if (!factory)
+    return;
+
+  g_mutex_lock (&factory->priv->medias_lock);
+  factory->priv->linger_reused++;
+  g_mutex_unlock (&factory->priv->medias_lock);
+
+  g_object_unref (factory);
+}
+
+static void
+media_linger_expired (GstRTSPMedia * media, GWeakRef * ref)
+{
+  GstRTSPMediaFactory *factory = g_weak_ref_get (ref);
+
+  if (!factory)
+    return;
+
+  g_mutex_lock (&factory->priv->medias_lock);
+  factory->priv->linger_expired++;
+  g_mutex_unlock (&factory->priv->medias_lock);
+
+  g_object_unref (factory);
+}
+
 static GWeakRef *
 weak_ref_new (gpointer obj)
 {
@@ -1264,6 +1447,233 @@ weak_ref_free (GWeakRef * ref)
   g_slice_free (GWeakRef, ref);
 }
 
+/* construct and configure a new media for @url, called without the
+ * medias_lock */
+static GstRTSPMedia *
+construct_media (GstRTSPMediaFactory * factory, const GstRTSPUrl * url)
+{
+  GstRTSPMediaFactoryClass *klass = GST_RTSP_MEDIA_FACTORY_GET_CLASS (factory);
+  GstRTSPMedia *media;
+
+  if (klass->construct == NULL)
+    return NULL;
+
+  media = klass->construct (factory, url);
+  if (media == NULL)
+    return NULL;
+
+  g_signal_emit (factory,
+      gst_rtsp_media_factory_signals[SIGNAL_MEDIA_CONSTRUCTED], 0, media, NULL);
+
+  /* configure the media */
+  if (klass->configure)
+    klass->configure (factory, media);
+
+  g_signal_emit (factory,
+      gst_rtsp_media_factory_signals[SIGNAL_MEDIA_CONFIGURE], 0, media, NULL);
+
+  if (!gst_rtsp_media_is_reusable (media)) {
+    /* when not reusable, connect to the unprepare signal to remove the item
+     * from our cache when it gets unprepared */
+    g_signal_connect_data (media, "unprepared",
+        (GCallback) media_unprepared, weak_ref_new (factory),
+        (GClosureNotify) weak_ref_free, 0);
+  }
+
+  /* the linger time can still be changed on the media */
+  g_signal_connect_data (media, "linger-reused",
+      (GCallback) media_linger_reused, weak_ref_new (factory),
+      (GClosureNotify) weak_ref_free, 0);
+  g_signal_connect_data (media, "linger-expired",
+      (GCallback) media_linger_expired, weak_ref_new (factory),
+      (GClosureNotify) weak_ref_free, 0);
+
+  return media;
+}
+
+typedef struct
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPUrl *url;
+  gchar *key;
+} WarmPoolFill;
+
+/* unprepare and unref all medias in @medias, must be called without the
+ * medias_lock because unpreparing can call media_unprepared() */
+static void
+warm_pool_release (GList * medias)
+{
+  GList *walk;
+
+  for (walk = medias; walk; walk = g_list_next (walk)) {
+    GstRTSPMedia *media = walk->data;
+
+    GST_DEBUG ("releasing media %p from warm pool", media);
+    gst_rtsp_media_unprepare (media);
+    g_object_unref (media);
+  }
+  g_list_free (medias);
+}
+
+static GThreadPool *
+warm_pool_get_fillers (void)
+{
+  static gsize fillers = 0;
+
+  if (g_once_init_enter (&fillers)) {
+    GThreadPool *pool;
+
+    /* constructing a media is CPU bound, don't make more than one at a
+     * time per CPU */
+    pool = g_thread_pool_new (warm_pool_fill, NULL, g_get_num_processors (),
+        FALSE, NULL);
+    g_once_init_leave (&fillers, (gsize) pool);
+  }
+  return (GThreadPool *) fillers;
+}
+
+/* start preparing medias until the pool has warm_pool_size medias, called
+ * with medias_lock */
+static void
+warm_pool_schedule_unlocked (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv = factory->priv;
+
+  /* the medias are prepared in the media threads of the server */
+  if (priv->warm_pool_url == NULL || priv->thread_pool == NULL ||
+      priv->warm_pool_blocked)
+    return;
+
+  while (priv->warm_pool.length + priv->warm_pool_filling <
+      priv->warm_pool_size) {
+    WarmPoolFill *fill;
+
+    fill = g_slice_new (WarmPoolFill);
+    fill->factory = g_object_ref (factory);
+    fill->url = gst_rtsp_url_copy (priv->warm_pool_url);
+    fill->key = g_strdup (priv->warm_pool_key);
+
+    priv->warm_pool_filling++;
+    g_thread_pool_push (warm_pool_get_fillers (), fill, NULL);
+  }
+}
+
+/* take a prepared media for @key from the pool, medias that need to be
+ * released are added to @release. Called with medias_lock */
+static GstRTSPMedia *
+warm_pool_take_unlocked (GstRTSPMediaFactory * factory,
+    const GstRTSPUrl * url, const gchar * key, GList ** release)
+{
+  GstRTSPMediaFactoryPrivate *priv = factory->priv;
+  GstRTSPMedia *media;
+
+  if (priv->warm_pool_size == 0)
+    return NULL;
+
+  if (g_strcmp0 (priv->warm_pool_key, key) != 0) {
+    /* the pool has medias for another url, fill it for this one now */
+    GST_DEBUG_OBJECT (factory, "warm pool switches to key %s", key);
+    while ((media = g_queue_pop_head (&priv->warm_pool)))
+      *release = g_list_prepend (*release, media);
+    g_free (priv->warm_pool_key);
+    priv->warm_pool_key = g_strdup (key);
+    if (priv->warm_pool_url)
+      gst_rtsp_url_free (priv->warm_pool_url);
+    priv->warm_pool_url = gst_rtsp_url_copy (url);
+    priv->warm_pool_blocked = FALSE;
+  }
+
+  while ((media = g_queue_pop_head (&priv->warm_pool))) {
+    /* the pipeline could have errored while in the pool */
+    if (gst_rtsp_media_get_status (media) == GST_RTSP_MEDIA_STATUS_PREPARED)
+      break;
+    GST_WARNING_OBJECT (factory, "media %p in warm pool is not prepared",
+        media);
+    *release = g_list_prepend (*release, media);
+  }
+
+  if (media)
+    priv->warm_pool_hits++;
+  else
+    priv->warm_pool_misses++;
+
+  GST_DEBUG_OBJECT (factory, "warm pool %s for key %s, %u left",
+      media ? "hit" : "miss", key, priv->warm_pool.length);
+
+  warm_pool_schedule_unlocked (factory);
+
+  return media;
+}
+
+static void
+warm_pool_fill (gpointer data, gpointer user_data)
+{
+  WarmPoolFill *fill = data;
+  GstRTSPMediaFactory *factory = fill->factory;
+  GstRTSPMediaFactoryPrivate *priv = factory->priv;
+  GstRTSPMedia *media;
+  GList *release = NULL;
+  gboolean blocked = FALSE;
+
+  media = construct_media (factory, fill->url);
+  if (media == NULL)
+    goto done;
+
+  if (gst_rtsp_media_is_shared (media) ||
+      (gst_rtsp_media_get_transport_mode (media) &
+          GST_RTSP_TRANSPORT_MODE_RECORD)) {
+    /* these medias are never taken from the pool, a configure step made it
+     * so. Stop filling the pool for this key */
+    GST_DEBUG_OBJECT (factory, "media %p can't be kept in warm pool", media);
+    g_object_unref (media);
+    media = NULL;
+    blocked = TRUE;
+  } else {
+    GstRTSPThreadPool *pool;
+    GstRTSPThread *thread = NULL;
+
+    g_mutex_lock (&priv->medias_lock);
+    pool = priv->thread_pool ? g_object_ref (priv->thread_pool) : NULL;
+    g_mutex_unlock (&priv->medias_lock);
+
+    if (pool) {
+      thread = gst_rtsp_thread_pool_get_thread (pool,
+          GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+      g_object_unref (pool);
+    }
+    if (thread == NULL || !gst_rtsp_media_prepare (media, thread)) {
+      GST_WARNING_OBJECT (factory, "could not prepare media for warm pool");
+      g_object_unref (media);
+      media = NULL;
+    }
+  }
+
+done:
+  g_mutex_lock (&priv->medias_lock);
+  priv->warm_pool_filling--;
+  if (blocked && g_strcmp0 (priv->warm_pool_key, fill->key) == 0)
+    priv->warm_pool_blocked = TRUE;
+  if (media) {
+    if (priv->warm_pool.length < priv->warm_pool_size &&
+        g_strcmp0 (priv->warm_pool_key, fill->key) == 0) {
+      GST_DEBUG_OBJECT (factory, "add media %p to warm pool", media);
+      g_queue_push_tail (&priv->warm_pool, media);
+    } else {
+      release = g_list_prepend (release, media);
+    }
+    /* don't retry when we failed to make a media */
+    warm_pool_schedule_unlocked (factory);
+  }
+  g_mutex_unlock (&priv->medias_lock);
+
+  warm_pool_release (release);
+
+  g_object_unref (fill->factory);
+  gst_rtsp_url_free (fill->url);
+  g_free (fill->key);
+  g_slice_free (WarmPoolFill, fill);
+}
+
 /**
  * gst_rtsp_media_factory_construct:
  * @factory: a #GstRTSPMediaFactory
@@ -1279,6 +1689,17 @@ weak_ref_free (GWeakRef * ref)
  * After the media is constructed, it can be configured and then prepared
  * with gst_rtsp_media_prepare ().
  *
+ * When the medias of @factory can be shared, concurrent calls for the same
+ * url wait for the first construction to finish and reuse its media. This is
+ * the case when @factory is shared or when the configure step, like a
+ * #GstRTSPMediaFactory::media-configure handler, can make the media shared.
+ * Other medias are constructed in parallel.
+ *
+ * When the warm pool of @factory is enabled, the returned media can already
+ * be prepared. The preparation is then handed over to the caller, who should
+ * not call gst_rtsp_media_prepare() again but gst_rtsp_media_unprepare()
+ * when done with it.
+ *
  * Returns: (transfer full): a new #GstRTSPMedia if the media could be prepared.
  */
 GstRTSPMedia *
@@ -1289,6 +1710,8 @@ gst_rtsp_media_factory_construct (GstRTSPMediaFactory * factory,
   gchar *key;
   GstRTSPMedia *media;
   GstRTSPMediaFactoryClass *klass;
+  GList *release = NULL;
+  gboolean shared, poolable;
 
   g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), NULL);
   g_return_val_if_fail (url != NULL, NULL);
@@ -1296,6 +1719,16 @@ gst_rtsp_media_factory_construct (GstRTSPMediaFactory * factory,
   priv = factory->priv;
   klass = GST_RTSP_MEDIA_FACTORY_GET_CLASS (factory);
 
+  /* only shared medias are reused, medias that are not shared are
+   * constructed independently. The media is shared like the factory unless
+   * the configure step can change it */
+  shared = gst_rtsp_media_factory_is_shared (factory);
+  poolable = !shared && !(gst_rtsp_media_factory_get_transport_mode (factory)
+      & GST_RTSP_TRANSPORT_MODE_RECORD);
+  shared = shared || klass->configure != default_configure ||
+      g_signal_has_handler_pending (factory,
+      gst_rtsp_media_factory_signals[SIGNAL_MEDIA_CONFIGURE], 0, FALSE);
+
   /* convert the url to a key for the hashtable. NULL return or a NULL function
    * will not cache anything for this factory. */
   if (klass->gen_key)
@@ -1305,33 +1738,41 @@ gst_rtsp_media_factory_construct (GstRTSPMediaFactory * factory,
 
   g_mutex_lock (&priv->medias_lock);
   if (key) {
+    /* if another thread is constructing a shared media for the same key,
+     * wait for it to finish so that we can pick up its result from the
+     * cache */
+    while (shared && g_hash_table_contains (priv->constructing, key))
+      g_cond_wait (&priv->constructing_cond, &priv->medias_lock);
+
     /* we have a key, see if we find a cached media */
     media = g_hash_table_lookup (priv->medias, key);
     if (media)
       g_object_ref (media);
+    else if (poolable) {
+      /* the medias of shared and RECORD factories are never pooled */
+      media = warm_pool_take_unlocked (factory, url, key, &release);
+    }
+
+    if (media == NULL && shared)
+      g_hash_table_add (priv->constructing, g_strdup (key));
   } else
     media = NULL;
+  g_mutex_unlock (&priv->medias_lock);
 
-  if (media == NULL) {
-    /* nothing cached found, try to create one */
-    if (klass->construct) {
-      media = klass->construct (factory, url);
-      if (media)
-        g_signal_emit (factory,
-            gst_rtsp_media_factory_signals[SIGNAL_MEDIA_CONSTRUCTED], 0, media,
-            NULL);
-    } else
-      media = NULL;
+  warm_pool_release (release);
 
+  if (media == NULL) {
+    /* nothing cached found, try to create one. This is done without the
+     * medias_lock so that medias for other keys can be constructed in
+     * parallel */
+    media = construct_media (factory, url);
+
+    g_mutex_lock (&priv->medias_lock);
+    if (key && shared) {
+      g_hash_table_remove (priv->constructing, key);
+      g_cond_broadcast (&priv->constructing_cond);
+    }
     if (media) {
-      /* configure the media */
-      if (klass->configure)
-        klass->configure (factory, media);
-
-      g_signal_emit (factory,
-          gst_rtsp_media_factory_signals[SIGNAL_MEDIA_CONFIGURE], 0, media,
-          NULL);
-
       /* check if we can cache this media */
       if (gst_rtsp_media_is_shared (media) && key) {
         /* insert in the hashtable, takes ownership of the key */
@@ -1339,16 +1780,9 @@ gst_rtsp_media_factory_construct (GstRTSPMediaFactory * factory,
         g_hash_table_insert (priv->medias, key, media);
         key = NULL;
       }
-      if (!gst_rtsp_media_is_reusable (media)) {
-        /* when not reusable, connect to the unprepare signal to remove the item
-         * from our cache when it gets unprepared */
-        g_signal_connect_data (media, "unprepared",
-            (GCallback) media_unprepared, weak_ref_new (factory),
-            (GClosureNotify) weak_ref_free, 0);
-      }
     }
+    g_mutex_unlock (&priv->medias_lock);
   }
-  g_mutex_unlock (&priv->medias_lock);
 
   if (key)
     g_free (key);
@@ -1358,6 +1792,193 @@ gst_rtsp_media_factory_construct (GstRTSPMediaFactory * factory,
   return media;
 }
 
+/**
+ * gst_rtsp_media_factory_set_warm_pool_size:
+ * @factory: a #GstRTSPMediaFactory
+ * @size: the number of medias to keep prepared
+ *
+ * Configure the number of prepared medias that @factory keeps ready for the
+ * next requests. The pool is filled in the background for the last url that
+ * was passed to gst_rtsp_media_factory_construct() and refilled after a
+ * media is taken from it. Only medias that are not shared and not used for
+ * RECORD are kept in the pool, the pool is not filled for a shared or RECORD
+ * factory and stops filling for a url when a configured media of it turns
+ * out to be shared or used for RECORD.
+ *
+ * The medias of the pool are constructed and configured in a background
+ * thread, the #GstRTSPMediaFactory::media-constructed and
+ * #GstRTSPMediaFactory::media-configure signals are emitted from that thread
+ * for them. They are prepared in a media thread of the pool set with
+ * gst_rtsp_media_factory_set_thread_pool(), the pool is not filled as long
+ * as no thread pool is set.
+ *
+ * A @size of 0 disables the pool and releases the medias in it.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_factory_set_warm_pool_size (GstRTSPMediaFactory * factory,
+    guint size)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  GstRTSPMedia *media;
+  GList *release = NULL;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory));
+
+  priv = factory->priv;
+
+  GST_DEBUG_OBJECT (factory, "warm pool size %u", size);
+
+  g_mutex_lock (&priv->medias_lock);
+  priv->warm_pool_size = size;
+  priv->warm_pool_blocked = FALSE;
+  while (priv->warm_pool.length > size) {
+    media = g_queue_pop_tail (&priv->warm_pool);
+    release = g_list_prepend (release, media);
+  }
+  warm_pool_schedule_unlocked (factory);
+  g_mutex_unlock (&priv->medias_lock);
+
+  warm_pool_release (release);
+}
+
+/**
+ * gst_rtsp_media_factory_get_warm_pool_size:
+ * @factory: a #GstRTSPMediaFactory
+ *
+ * Get the number of prepared medias that @factory keeps ready.
+ *
+ * Returns: the size of the warm pool.
+ *
+ * Since: 1.18
+ */
+guint
+gst_rtsp_media_factory_get_warm_pool_size (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  guint result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), 0);
+
+  priv = factory->priv;
+
+  g_mutex_lock (&priv->medias_lock);
+  result = priv->warm_pool_size;
+  g_mutex_unlock (&priv->medias_lock);
+
+  return result;
+}
+
+/**
+ * gst_rtsp_media_factory_set_thread_pool:
+ * @factory: a #GstRTSPMediaFactory
+ * @pool: (transfer none) (nullable): a #GstRTSPThreadPool
+ *
+ * Configure @pool as the thread pool that provides the media threads for the
+ * medias of the warm pool of @factory. #GstRTSPClient sets the thread pool
+ * of the server on factories that don't have one when it constructs a media.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_factory_set_thread_pool (GstRTSPMediaFactory * factory,
+    GstRTSPThreadPool * pool)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  GstRTSPThreadPool *old;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory));
+  g_return_if_fail (pool == NULL || GST_IS_RTSP_THREAD_POOL (pool));
+
+  priv = factory->priv;
+
+  if (pool)
+    g_object_ref (pool);
+
+  g_mutex_lock (&priv->medias_lock);
+  old = priv->thread_pool;
+  priv->thread_pool = pool;
+  warm_pool_schedule_unlocked (factory);
+  g_mutex_unlock (&priv->medias_lock);
+
+  if (old)
+    g_object_unref (old);
+}
+
+/**
+ * gst_rtsp_media_factory_get_thread_pool:
+ * @factory: a #GstRTSPMediaFactory
+ *
+ * Get the #GstRTSPThreadPool used for the warm pool of @factory.
+ *
+ * Returns: (transfer full) (nullable): the #GstRTSPThreadPool of @factory.
+ *     g_object_unref() after usage.
+ *
+ * Since: 1.18
+ */
+GstRTSPThreadPool *
+gst_rtsp_media_factory_get_thread_pool (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  GstRTSPThreadPool *result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), NULL);
+
+  priv = factory->priv;
+
+  g_mutex_lock (&priv->medias_lock);
+  if ((result = priv->thread_pool))
+    g_object_ref (result);
+  g_mutex_unlock (&priv->medias_lock);
+
+  return result;
+}
+
+/**
+ * gst_rtsp_media_factory_get_stats:
+ * @factory: a #GstRTSPMediaFactory
+ *
+ * Get statistics about the medias made by @factory. The structure contains:
+ *
+ *  * "warm-pool-level" G_TYPE_UINT: the number of prepared medias in the warm
+ *    pool
+ *  * "warm-pool-hits" G_TYPE_UINT64: the number of medias that were taken
+ *    from the warm pool
+ *  * "warm-pool-misses" G_TYPE_UINT64: the number of medias that had to be
+ *    constructed because the warm pool was empty
+ *  * "linger-reused" G_TYPE_UINT64: the number of times a lingering shared
+ *    media was prepared again
+ *  * "linger-expired" G_TYPE_UINT64: the number of times a lingering shared
+ *    media was unprepared because its linger time expired
+ *
+ * Returns: (transfer full): a #GstStructure with the statistics, free with
+ *     gst_structure_free() after usage.
+ *
+ * Since: 1.18
+ */
+GstStructure *
+gst_rtsp_media_factory_get_stats (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  GstStructure *result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), NULL);
+
+  priv = factory->priv;
+
+  g_mutex_lock (&priv->medias_lock);
+  result = gst_structure_new ("application/x-rtsp-media-factory-stats",
+      "warm-pool-level", G_TYPE_UINT, priv->warm_pool.length,
+      "warm-pool-hits", G_TYPE_UINT64, priv->warm_pool_hits,
+      "warm-pool-misses", G_TYPE_UINT64, priv->warm_pool_misses,
+      "linger-reused", G_TYPE_UINT64, priv->linger_reused,
+      "linger-expired", G_TYPE_UINT64, priv->linger_expired, NULL);
+  g_mutex_unlock (&priv->medias_lock);
+
+  return result;
+}
+
 /**
  * gst_rtsp_media_factory_set_media_gtype:
  * @factory: a #GstRTSPMediaFactory
@@ -1615,6 +2236,166 @@ gst_rtsp_media_factory_is_bind_mcast_address (GstRTSPMediaFactory * factory)
   return result;
 }
 
+/**
+ * gst_rtsp_media_factory_set_linger_time:
+ * @factory: a #GstRTSPMediaFactory
+ * @linger_time: the linger time in nanoseconds
+ *
+ * Configure the time the shared medias of @factory stay prepared after
+ * their last client left. See gst_rtsp_media_set_linger_time().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_factory_set_linger_time (GstRTSPMediaFactory * factory,
+    GstClockTime linger_time)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory));
+
+  priv = factory->priv;
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+  priv->linger_time = linger_time;
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+}
+
+/**
+ * gst_rtsp_media_factory_get_linger_time:
+ * @factory: a #GstRTSPMediaFactory
+ *
+ * Get the time the shared medias of @factory stay prepared after their last
+ * client left.
+ *
+ * Returns: the linger time in nanoseconds.
+ *
+ * Since: 1.18
+ */
+GstClockTime
+gst_rtsp_media_factory_get_linger_time (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  GstClockTime result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), 0);
+
+  priv = factory->priv;
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+  result = priv->linger_time;
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+
+  return result;
+}
+
+/**
+ * gst_rtsp_media_factory_set_key_unit_interval:
+ * @factory: a #GstRTSPMediaFactory
+ * @interval: the minimum time between keyframe requests, or 0
+ *
+ * Configure the medias of @factory to request a keyframe upstream when a
+ * client joins a stream that is sent to other clients. See
+ * gst_rtsp_media_set_key_unit_interval().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_factory_set_key_unit_interval (GstRTSPMediaFactory * factory,
+    GstClockTime interval)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory));
+
+  priv = factory->priv;
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+  priv->key_unit_interval = interval;
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+}
+
+/**
+ * gst_rtsp_media_factory_get_key_unit_interval:
+ * @factory: a #GstRTSPMediaFactory
+ *
+ * Get the minimum time between the keyframe requests of the medias of
+ * @factory.
+ *
+ * Returns: the interval in nanoseconds, 0 when no keyframes are requested.
+ *
+ * Since: 1.18
+ */
+GstClockTime
+gst_rtsp_media_factory_get_key_unit_interval (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  GstClockTime result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), 0);
+
+  priv = factory->priv;
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+  result = priv->key_unit_interval;
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+
+  return result;
+}
+
+/**
+ * gst_rtsp_media_factory_set_gop_cache:
+ * @factory: a #GstRTSPMediaFactory
+ * @enabled: whether to cache the GOP
+ *
+ * Configure the streams of the medias of @factory to keep the packets since
+ * their last keyframe and to send them to clients that join the stream. See
+ * gst_rtsp_media_set_gop_cache().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_factory_set_gop_cache (GstRTSPMediaFactory * factory,
+    gboolean enabled)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory));
+
+  priv = factory->priv;
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+  priv->gop_cache = enabled;
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+}
+
+/**
+ * gst_rtsp_media_factory_get_gop_cache:
+ * @factory: a #GstRTSPMediaFactory
+ *
+ * Check if the streams of the medias of @factory cache their last GOP.
+ *
+ * Returns: %TRUE if the GOP is cached.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_media_factory_get_gop_cache (GstRTSPMediaFactory * factory)
+{
+  GstRTSPMediaFactoryPrivate *priv;
+  gboolean result;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA_FACTORY (factory), FALSE);
+
+  priv = factory->priv;
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+  result = priv->gop_cache;
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+
+  return result;
+}
+
 static gchar *
 default_gen_key (GstRTSPMediaFactory * factory, const GstRTSPUrl * url)
 {
@@ -1637,6 +2418,7 @@ static GstElement *
 default_create_element (GstRTSPMediaFactory * factory, const GstRTSPUrl * url)
 {
   GstRTSPMediaFactoryPrivate *priv = factory->priv;
+  GstRTSPLaunchTemplate *template;
   GstElement *element;
   GError *error = NULL;
 
@@ -1645,6 +2427,31 @@ default_create_element (GstRTSPMediaFactory * factory, const GstRTSPUrl * url)
   if (priv->launch == NULL)
     goto no_launch;
 
+  if ((template = priv->launch_template))
+    gst_rtsp_launch_template_ref (template);
+  GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+
+  if (template) {
+    /* make the element from the already parsed launch line */
+    element = gst_rtsp_launch_template_instantiate (template);
+    if (element) {
+      gst_rtsp_launch_template_unref (template);
+      return element;
+    }
+
+    /* don't try the template again, parse the launch line from now on */
+    GST_WARNING ("could not use launch template, parsing launch line");
+    GST_RTSP_MEDIA_FACTORY_LOCK (factory);
+    if (priv->launch_template == template) {
+      gst_rtsp_launch_template_unref (priv->launch_template);
+      priv->launch_template = NULL;
+      priv->launch_template_failed = TRUE;
+    }
+    GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
+    gst_rtsp_launch_template_unref (template);
+  }
+
+  GST_RTSP_MEDIA_FACTORY_LOCK (factory);
   /* parse the user provided launch line */
   element =
       gst_parse_launch_full (priv->launch, NULL, GST_PARSE_FLAG_PLACE_IN_BIN,
@@ -1652,6 +2459,15 @@ default_create_element (GstRTSPMediaFactory * factory, const GstRTSPUrl * url)
   if (element == NULL)
     goto parse_error;
 
+  /* make a template so that we don't need to parse the launch line for the
+   * next media */
+  if (priv->launch_template == NULL && !priv->launch_template_failed
+      && error == NULL) {
+    priv->launch_template = gst_rtsp_launch_template_new (element,
+        priv->launch);
+    if (priv->launch_template == NULL)
+      priv->launch_template_failed = TRUE;
+  }
   GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
 
   if (error != NULL) {
@@ -1767,6 +2583,9 @@ default_configure (GstRTSPMediaFactory * factory, GstRTSPMedia * media)
   GstRTSPPublishClockMode publish_clock_mode;
   guint ttl;
   gboolean bind_mcast;
+  GstClockTime linger_time;
+  GstClockTime key_unit_interval;
+  gboolean gop_cache;
 
   /* configure the sharedness */
   GST_RTSP_MEDIA_FACTORY_LOCK (factory);
@@ -1784,6 +2603,9 @@ default_configure (GstRTSPMediaFactory * factory, GstRTSPMedia * media)
   publish_clock_mode = priv->publish_clock_mode;
   ttl = priv->max_mcast_ttl;
   bind_mcast = priv->bind_mcast_address;
+  linger_time = priv->linger_time;
+  key_unit_interval = priv->key_unit_interval;
+  gop_cache = priv->gop_cache;
   GST_RTSP_MEDIA_FACTORY_UNLOCK (factory);
 
   gst_rtsp_media_set_suspend_mode (media, suspend_mode);
@@ -1800,6 +2622,9 @@ default_configure (GstRTSPMediaFactory * factory, GstRTSPMedia * media)
   gst_rtsp_media_set_publish_clock_mode (media, publish_clock_mode);
   gst_rtsp_media_set_max_mcast_ttl (media, ttl);
   gst_rtsp_media_set_bind_mcast_address (media, bind_mcast);
+  gst_rtsp_media_set_linger_time (media, linger_time);
+  gst_rtsp_media_set_key_unit_interval (media, key_unit_interval);
+  gst_rtsp_media_set_gop_cache (media, gop_cache);
 
   if (clock) {
     gst_rtsp_media_set_clock (media, clock);
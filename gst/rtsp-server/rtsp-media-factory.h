@@ -252,6 +252,44 @@ void                  gst_rtsp_media_factory_set_bind_mcast_address (GstRTSPMedi
 GST_RTSP_SERVER_API
 gboolean              gst_rtsp_media_factory_is_bind_mcast_address (GstRTSPMediaFactory * factory);
 
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_factory_set_linger_time (GstRTSPMediaFactory * factory,
+                                                              GstClockTime linger_time);
+
+GST_RTSP_SERVER_API
+GstClockTime          gst_rtsp_media_factory_get_linger_time (GstRTSPMediaFactory * factory);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_factory_set_key_unit_interval (GstRTSPMediaFactory * factory,
+                                                                    GstClockTime interval);
+
+GST_RTSP_SERVER_API
+GstClockTime          gst_rtsp_media_factory_get_key_unit_interval (GstRTSPMediaFactory * factory);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_factory_set_gop_cache (GstRTSPMediaFactory * factory,
+                                                            gboolean enabled);
+
+GST_RTSP_SERVER_API
+gboolean              gst_rtsp_media_factory_get_gop_cache (GstRTSPMediaFactory * factory);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_factory_set_warm_pool_size (GstRTSPMediaFactory * factory,
+                                                                 guint size);
+
+GST_RTSP_SERVER_API
+guint                 gst_rtsp_media_factory_get_warm_pool_size (GstRTSPMediaFactory * factory);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_factory_set_thread_pool  (GstRTSPMediaFactory * factory,
+                                                               GstRTSPThreadPool * pool);
+
+GST_RTSP_SERVER_API
+GstRTSPThreadPool *   gst_rtsp_media_factory_get_thread_pool  (GstRTSPMediaFactory * factory);
+
+GST_RTSP_SERVER_API
+GstStructure *        gst_rtsp_media_factory_get_stats        (GstRTSPMediaFactory * factory);
+
 /* creating the media from the factory and a url */
 
 GST_RTSP_SERVER_API
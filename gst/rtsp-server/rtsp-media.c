@@ -113,6 +113,9 @@ struct _GstRTSPMediaPrivate
   gboolean blocked;
   GstRTSPTransportMode transport_mode;
   gboolean stop_on_disconnect;
+  GstClockTime linger_time;
+  GstClockTime key_unit_interval;
+  gboolean gop_cache;
 
   GstElement *element;
   GRecMutex state_lock;         /* locking order: state lock, lock */
@@ -123,6 +126,8 @@ struct _GstRTSPMediaPrivate
   gint n_active;
   gboolean complete;
   gboolean finishing_unprepare;
+  GSource *linger_source;       /* protected by state_lock */
+  GList *prepare_waiters;       /* protected by lock */
 
   /* the pipeline for the media */
   GstElement *pipeline;
@@ -155,6 +160,11 @@ struct _GstRTSPMediaPrivate
   gboolean do_rate_control;     /* protected by lock */
   GstRTSPPublishClockMode publish_clock_mode;
 
+  /* serialised SDP of live media, per server ip, and the caps of the streams
+   * it was made with, protected by lock */
+  GHashTable *sdp_cache;
+  GPtrArray *sdp_caps;
+
   /* Dynamic element handling */
   guint nb_dynamic_elements;
   guint no_more_pads_pending;
@@ -176,6 +186,9 @@ struct _GstRTSPMediaPrivate
 #define DEFAULT_MAX_MCAST_TTL   255
 #define DEFAULT_BIND_MCAST_ADDRESS FALSE
 #define DEFAULT_DO_RATE_CONTROL TRUE
+#define DEFAULT_LINGER_TIME     0
+#define DEFAULT_KEY_UNIT_INTERVAL 0
+#define DEFAULT_GOP_CACHE       FALSE
 
 #define DEFAULT_DO_RETRANSMISSION FALSE
 
@@ -200,6 +213,9 @@ enum
   PROP_CLOCK,
   PROP_MAX_MCAST_TTL,
   PROP_BIND_MCAST_ADDRESS,
+  PROP_LINGER_TIME,
+  PROP_KEY_UNIT_INTERVAL,
+  PROP_GOP_CACHE,
   PROP_LAST
 };
 
@@ -211,6 +227,8 @@ enum
   SIGNAL_UNPREPARED,
   SIGNAL_TARGET_STATE,
   SIGNAL_NEW_STATE,
+  SIGNAL_LINGER_REUSED,
+  SIGNAL_LINGER_EXPIRED,
   SIGNAL_LAST
 };
 
@@ -226,6 +244,9 @@ static void gst_rtsp_media_finalize (GObject * obj);
 static gboolean default_handle_message (GstRTSPMedia * media,
     GstMessage * message);
 static void finish_unprepare (GstRTSPMedia * media);
+static void clear_sdp_cache (GstRTSPMedia * media);
+static void stop_linger (GstRTSPMedia * media);
+static void dispatch_prepare_waiter (gpointer data);
 static gboolean default_prepare (GstRTSPMedia * media, GstRTSPThread * thread);
 static gboolean default_unprepare (GstRTSPMedia * media);
 static gboolean default_suspend (GstRTSPMedia * media);
@@ -410,6 +431,50 @@ gst_rtsp_media_class_init (GstRTSPMediaClass * klass)
           DEFAULT_BIND_MCAST_ADDRESS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPMedia:linger-time:
+   *
+   * The time a shared media stays prepared after the last client
+   * unprepared it. When it is prepared again within this time, the pipeline
+   * is reused instead of being constructed and prerolled again.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_LINGER_TIME,
+      g_param_spec_uint64 ("linger-time", "Linger Time",
+          "Time in nanoseconds a shared media stays prepared without clients "
+          "(0 = unprepare immediately)", 0, G_MAXUINT64, DEFAULT_LINGER_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPMedia:key-unit-interval:
+   *
+   * The minimum time between the keyframe requests of the streams when
+   * clients join them, see gst_rtsp_stream_set_key_unit_interval().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_KEY_UNIT_INTERVAL,
+      g_param_spec_uint64 ("key-unit-interval", "Key Unit Interval",
+          "Minimum time in nanoseconds between keyframe requests when clients "
+          "join a stream (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_KEY_UNIT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPMedia:gop-cache:
+   *
+   * Whether the streams keep their last GOP and send it to clients that join
+   * them, see gst_rtsp_stream_set_gop_cache().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_GOP_CACHE,
+      g_param_spec_boolean ("gop-cache", "GOP Cache",
+          "Send the packets since the last keyframe to clients that join a "
+          "stream", DEFAULT_GOP_CACHE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_rtsp_media_signals[SIGNAL_NEW_STREAM] =
       g_signal_new ("new-stream", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST,
       G_STRUCT_OFFSET (GstRTSPMediaClass, new_stream), NULL, NULL,
@@ -441,6 +506,33 @@ gst_rtsp_media_class_init (GstRTSPMediaClass * klass)
       G_STRUCT_OFFSET (GstRTSPMediaClass, new_state), NULL, NULL,
       g_cclosure_marshal_generic, G_TYPE_NONE, 1, G_TYPE_INT);
 
+  /**
+   * GstRTSPMedia::linger-reused:
+   * @media: a #GstRTSPMedia
+   *
+   * Emitted when @media is prepared again while it was lingering.
+   *
+   * Since: 1.18
+   */
+  gst_rtsp_media_signals[SIGNAL_LINGER_REUSED] =
+      g_signal_new ("linger-reused", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 0, G_TYPE_NONE);
+
+  /**
+   * GstRTSPMedia::linger-expired:
+   * @media: a #GstRTSPMedia
+   *
+   * Emitted when @media was unprepared because its linger time expired
+   * without being prepared again.
+   *
+   * Since: 1.18
+   */
+  gst_rtsp_media_signals[SIGNAL_LINGER_EXPIRED] =
+      g_signal_new ("linger-expired", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 0, G_TYPE_NONE);
+
   GST_DEBUG_CATEGORY_INIT (rtsp_media_debug, "rtspmedia", 0, "GstRTSPMedia");
 
   klass->handle_message = default_handle_message;
@@ -484,6 +576,9 @@ gst_rtsp_media_init (GstRTSPMedia * media)
   priv->max_mcast_ttl = DEFAULT_MAX_MCAST_TTL;
   priv->bind_mcast_address = DEFAULT_BIND_MCAST_ADDRESS;
   priv->do_rate_control = DEFAULT_DO_RATE_CONTROL;
+  priv->linger_time = DEFAULT_LINGER_TIME;
+  priv->key_unit_interval = DEFAULT_KEY_UNIT_INTERVAL;
+  priv->gop_cache = DEFAULT_GOP_CACHE;
   priv->expected_async_done = FALSE;
 }
 
@@ -518,6 +613,10 @@ gst_rtsp_media_finalize (GObject * obj)
   if (priv->clock)
     gst_object_unref (priv->clock);
   g_free (priv->multicast_iface);
+  if (priv->sdp_cache)
+    g_hash_table_unref (priv->sdp_cache);
+  if (priv->sdp_caps)
+    g_ptr_array_unref (priv->sdp_caps);
   g_mutex_clear (&priv->lock);
   g_mutex_clear (&priv->global_lock);
   g_cond_clear (&priv->cond);
@@ -578,6 +677,15 @@ gst_rtsp_media_get_property (GObject * object, guint propid,
     case PROP_BIND_MCAST_ADDRESS:
       g_value_set_boolean (value, gst_rtsp_media_is_bind_mcast_address (media));
       break;
+    case PROP_LINGER_TIME:
+      g_value_set_uint64 (value, gst_rtsp_media_get_linger_time (media));
+      break;
+    case PROP_KEY_UNIT_INTERVAL:
+      g_value_set_uint64 (value, gst_rtsp_media_get_key_unit_interval (media));
+      break;
+    case PROP_GOP_CACHE:
+      g_value_set_boolean (value, gst_rtsp_media_get_gop_cache (media));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -638,6 +746,15 @@ gst_rtsp_media_set_property (GObject * object, guint propid,
       gst_rtsp_media_set_bind_mcast_address (media,
           g_value_get_boolean (value));
       break;
+    case PROP_LINGER_TIME:
+      gst_rtsp_media_set_linger_time (media, g_value_get_uint64 (value));
+      break;
+    case PROP_KEY_UNIT_INTERVAL:
+      gst_rtsp_media_set_key_unit_interval (media, g_value_get_uint64 (value));
+      break;
+    case PROP_GOP_CACHE:
+      gst_rtsp_media_set_gop_cache (media, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -2007,6 +2124,178 @@ gst_rtsp_media_is_bind_mcast_address (GstRTSPMedia * media)
   return result;
 }
 
+/**
+ * gst_rtsp_media_set_linger_time:
+ * @media: a #GstRTSPMedia
+ * @linger_time: the linger time in nanoseconds
+ *
+ * Set the time @media stays prepared after the last client unprepared it.
+ * This only has an effect on shared media. When @media is prepared again
+ * within @linger_time, the pipeline is reused. When @media has a suspend
+ * mode, it is suspended while it lingers.
+ *
+ * A @linger_time of 0 unprepares the media immediately.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_set_linger_time (GstRTSPMedia * media, GstClockTime linger_time)
+{
+  GstRTSPMediaPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA (media));
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  priv->linger_time = linger_time;
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gst_rtsp_media_get_linger_time:
+ * @media: a #GstRTSPMedia
+ *
+ * Get the time @media stays prepared after the last client unprepared it.
+ *
+ * Returns: the linger time in nanoseconds.
+ *
+ * Since: 1.18
+ */
+GstClockTime
+gst_rtsp_media_get_linger_time (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv;
+  GstClockTime res;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), 0);
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  res = priv->linger_time;
+  g_mutex_unlock (&priv->lock);
+
+  return res;
+}
+
+/**
+ * gst_rtsp_media_set_key_unit_interval:
+ * @media: a #GstRTSPMedia
+ * @interval: the minimum time between keyframe requests, or 0
+ *
+ * Configure the streams of @media to request a keyframe upstream when a
+ * client joins them while they are sent to other clients. Clients that join
+ * within @interval share one request. See
+ * gst_rtsp_stream_set_key_unit_interval().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_set_key_unit_interval (GstRTSPMedia * media,
+    GstClockTime interval)
+{
+  GstRTSPMediaPrivate *priv;
+  guint i;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA (media));
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  priv->key_unit_interval = interval;
+  for (i = 0; i < priv->streams->len; i++) {
+    GstRTSPStream *stream = g_ptr_array_index (priv->streams, i);
+    gst_rtsp_stream_set_key_unit_interval (stream, interval);
+  }
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gst_rtsp_media_get_key_unit_interval:
+ * @media: a #GstRTSPMedia
+ *
+ * Get the minimum time between the keyframe requests of the streams of
+ * @media.
+ *
+ * Returns: the interval in nanoseconds, 0 when no keyframes are requested.
+ *
+ * Since: 1.18
+ */
+GstClockTime
+gst_rtsp_media_get_key_unit_interval (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv;
+  GstClockTime res;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), 0);
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  res = priv->key_unit_interval;
+  g_mutex_unlock (&priv->lock);
+
+  return res;
+}
+
+/**
+ * gst_rtsp_media_set_gop_cache:
+ * @media: a #GstRTSPMedia
+ * @enabled: whether to cache the GOP
+ *
+ * Configure the streams of @media to keep the packets since their last
+ * keyframe and to send them to clients that join them. See
+ * gst_rtsp_stream_set_gop_cache().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_set_gop_cache (GstRTSPMedia * media, gboolean enabled)
+{
+  GstRTSPMediaPrivate *priv;
+  guint i;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA (media));
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  priv->gop_cache = enabled;
+  for (i = 0; i < priv->streams->len; i++) {
+    GstRTSPStream *stream = g_ptr_array_index (priv->streams, i);
+    gst_rtsp_stream_set_gop_cache (stream, enabled);
+  }
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gst_rtsp_media_get_gop_cache:
+ * @media: a #GstRTSPMedia
+ *
+ * Check if the streams of @media cache their last GOP.
+ *
+ * Returns: %TRUE if the GOP is cached.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_media_get_gop_cache (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv;
+  gboolean res;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), FALSE);
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  res = priv->gop_cache;
+  g_mutex_unlock (&priv->lock);
+
+  return res;
+}
+
 static GList *
 _find_payload_types (GstRTSPMedia * media)
 {
@@ -2334,6 +2623,8 @@ gst_rtsp_media_create_stream (GstRTSPMedia * media, GstElement * payloader,
   gst_rtsp_stream_set_buffer_size (stream, priv->buffer_size);
   gst_rtsp_stream_set_publish_clock_mode (stream, priv->publish_clock_mode);
   gst_rtsp_stream_set_rate_control (stream, priv->do_rate_control);
+  gst_rtsp_stream_set_key_unit_interval (stream, priv->key_unit_interval);
+  gst_rtsp_stream_set_gop_cache (stream, priv->gop_cache);
 
   g_ptr_array_add (priv->streams, stream);
 
@@ -2685,12 +2976,20 @@ static void
 gst_rtsp_media_set_status (GstRTSPMedia * media, GstRTSPMediaStatus status)
 {
   GstRTSPMediaPrivate *priv = media->priv;
+  GList *waiters = NULL;
 
   g_mutex_lock (&priv->lock);
   priv->status = status;
   GST_DEBUG ("setting new status to %d", status);
   g_cond_broadcast (&priv->cond);
+  /* preparation completed, wake up the asynchronous waiters */
+  if (status != GST_RTSP_MEDIA_STATUS_PREPARING) {
+    waiters = priv->prepare_waiters;
+    priv->prepare_waiters = NULL;
+  }
   g_mutex_unlock (&priv->lock);
+
+  g_list_free_full (waiters, dispatch_prepare_waiter);
 }
 
 /**
@@ -3704,34 +4003,24 @@ no_rtpbin:
   }
 }
 
-/**
- * gst_rtsp_media_prepare:
- * @media: a #GstRTSPMedia
- * @thread: (transfer full) (allow-none): a #GstRTSPThread to run the
- *   bus handler or %NULL
- *
- * Prepare @media for streaming. This function will create the objects
- * to manage the streaming. A pipeline must have been set on @media with
- * gst_rtsp_media_take_pipeline().
- *
- * It will preroll the pipeline and collect vital information about the streams
- * such as the duration.
- *
- * Returns: %TRUE on success.
- */
-gboolean
-gst_rtsp_media_prepare (GstRTSPMedia * media, GstRTSPThread * thread)
+/* start preparing @media, @wait is set to %TRUE when the caller has to wait
+ * for the preparation to complete */
+static gboolean
+begin_prepare (GstRTSPMedia * media, GstRTSPThread * thread, gboolean * wait)
 {
-  GstRTSPMediaPrivate *priv;
+  GstRTSPMediaPrivate *priv = media->priv;
   GstRTSPMediaClass *klass;
 
-  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), FALSE);
-
-  priv = media->priv;
-
   g_rec_mutex_lock (&priv->state_lock);
   priv->prepare_count++;
 
+  if (priv->linger_source) {
+    GST_INFO ("reusing lingering media %p", media);
+    stop_linger (media);
+    g_signal_emit (media, gst_rtsp_media_signals[SIGNAL_LINGER_REUSED], 0,
+        NULL);
+  }
+
   if (priv->status == GST_RTSP_MEDIA_STATUS_PREPARED ||
       priv->status == GST_RTSP_MEDIA_STATUS_SUSPENDED)
     goto was_prepared;
@@ -3764,15 +4053,7 @@ gst_rtsp_media_prepare (GstRTSPMedia * media, GstRTSPThread * thread)
 
 wait_status:
   g_rec_mutex_unlock (&priv->state_lock);
-
-  /* now wait for all pads to be prerolled, FIXME, we should somehow be
-   * able to do this async so that we don't block the server thread. */
-  if (!wait_preroll (media))
-    goto preroll_failed;
-
-  g_signal_emit (media, gst_rtsp_media_signals[SIGNAL_PREPARED], 0, NULL);
-
-  GST_INFO ("object %p is prerolled", media);
+  *wait = TRUE;
 
   return TRUE;
 
@@ -3791,6 +4072,7 @@ was_prepared:
     if (thread)
       gst_rtsp_thread_stop (thread);
     g_rec_mutex_unlock (&priv->state_lock);
+    *wait = FALSE;
     return TRUE;
   }
   /* ERRORS */
@@ -3824,6 +4106,48 @@ prepare_failed:
     GST_ERROR ("failed to prepare media");
     return FALSE;
   }
+}
+
+/**
+ * gst_rtsp_media_prepare:
+ * @media: a #GstRTSPMedia
+ * @thread: (transfer full) (allow-none): a #GstRTSPThread to run the
+ *   bus handler or %NULL
+ *
+ * Prepare @media for streaming. This function will create the objects
+ * to manage the streaming. A pipeline must have been set on @media with
+ * gst_rtsp_media_take_pipeline().
+ *
+ * It will preroll the pipeline and collect vital information about the streams
+ * such as the duration.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+gst_rtsp_media_prepare (GstRTSPMedia * media, GstRTSPThread * thread)
+{
+  gboolean wait;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), FALSE);
+
+  if (!begin_prepare (media, thread, &wait))
+    return FALSE;
+
+  if (!wait)
+    return TRUE;
+
+  /* now wait for all pads to be prerolled, use gst_rtsp_media_prepare_async()
+   * to avoid blocking the calling thread */
+  if (!wait_preroll (media))
+    goto preroll_failed;
+
+  g_signal_emit (media, gst_rtsp_media_signals[SIGNAL_PREPARED], 0, NULL);
+
+  GST_INFO ("object %p is prerolled", media);
+
+  return TRUE;
+
+  /* ERRORS */
 preroll_failed:
   {
     GST_WARNING ("failed to preroll pipeline");
@@ -3832,6 +4156,166 @@ preroll_failed:
   }
 }
 
+typedef struct
+{
+  GstRTSPMedia *media;
+  GMainContext *context;
+  GSource *timeout;
+  gboolean emit_prepared;
+  GstRTSPMediaPrepareFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} PrepareWaiter;
+
+static void
+prepare_waiter_free (PrepareWaiter * waiter)
+{
+  if (waiter->notify)
+    waiter->notify (waiter->user_data);
+  if (waiter->timeout) {
+    g_source_destroy (waiter->timeout);
+    g_source_unref (waiter->timeout);
+  }
+  if (waiter->context)
+    g_main_context_unref (waiter->context);
+  g_object_unref (waiter->media);
+  g_slice_free (PrepareWaiter, waiter);
+}
+
+static gboolean
+prepare_waiter_done (PrepareWaiter * waiter)
+{
+  GstRTSPMedia *media = waiter->media;
+  GstRTSPMediaPrivate *priv = media->priv;
+  GstRTSPMediaStatus status;
+  gboolean success;
+
+  g_mutex_lock (&priv->lock);
+  status = priv->status;
+  g_mutex_unlock (&priv->lock);
+
+  if (status == GST_RTSP_MEDIA_STATUS_PREPARED) {
+    if (waiter->emit_prepared) {
+      g_signal_emit (media, gst_rtsp_media_signals[SIGNAL_PREPARED], 0, NULL);
+      GST_INFO ("object %p is prerolled", media);
+    }
+    success = TRUE;
+  } else if (status == GST_RTSP_MEDIA_STATUS_ERROR) {
+    GST_WARNING ("failed to preroll pipeline");
+    gst_rtsp_media_unprepare (media);
+    success = FALSE;
+  } else {
+    /* unprepared before it was prerolled */
+    GST_WARNING ("media %p was unprepared while preparing", media);
+    success = FALSE;
+  }
+
+  waiter->func (media, success, waiter->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* called without the lock, calls the waiter from its main context */
+static void
+dispatch_prepare_waiter (gpointer data)
+{
+  PrepareWaiter *waiter = data;
+  GSource *source;
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (source, (GSourceFunc) prepare_waiter_done, waiter,
+      (GDestroyNotify) prepare_waiter_free);
+  g_source_attach (source, waiter->context);
+  g_source_unref (source);
+}
+
+static gboolean
+prepare_timeout (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+  gboolean preparing;
+
+  g_mutex_lock (&priv->lock);
+  preparing = priv->status == GST_RTSP_MEDIA_STATUS_PREPARING;
+  g_mutex_unlock (&priv->lock);
+
+  if (preparing) {
+    GST_DEBUG ("timeout, assuming error status");
+    gst_rtsp_media_set_status (media, GST_RTSP_MEDIA_STATUS_ERROR);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_rtsp_media_prepare_async:
+ * @media: a #GstRTSPMedia
+ * @thread: (transfer full) (allow-none): a #GstRTSPThread to run the
+ *   bus handler or %NULL
+ * @context: (allow-none): a #GMainContext to call @func from or %NULL for
+ *   the default main context
+ * @func: (scope notified): a #GstRTSPMediaPrepareFunc
+ * @user_data: (closure): user data passed to @func
+ * @notify: (allow-none): called when @user_data is no longer in use
+ *
+ * Prepare @media for streaming like gst_rtsp_media_prepare() but without
+ * waiting for the pipeline to preroll. @func is called from @context when
+ * the preparation completed. Only a prepared @media is a success, @func is
+ * called with a %FALSE success when the pipeline failed to preroll, @media
+ * was then already unprepared again, or when @media was unprepared before it
+ * prerolled.
+ *
+ * Returns: %TRUE when the preparation was started, @func will then be called
+ * exactly once. %FALSE when the preparation could not be started.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_media_prepare_async (GstRTSPMedia * media, GstRTSPThread * thread,
+    GMainContext * context, GstRTSPMediaPrepareFunc func, gpointer user_data,
+    GDestroyNotify notify)
+{
+  GstRTSPMediaPrivate *priv;
+  PrepareWaiter *waiter;
+  gboolean wait;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  priv = media->priv;
+
+  if (!begin_prepare (media, thread, &wait))
+    return FALSE;
+
+  waiter = g_slice_new0 (PrepareWaiter);
+  waiter->media = g_object_ref (media);
+  waiter->context = context ? g_main_context_ref (context) : NULL;
+  waiter->emit_prepared = wait;
+  waiter->func = func;
+  waiter->user_data = user_data;
+  waiter->notify = notify;
+
+  g_mutex_lock (&priv->lock);
+  if (priv->status == GST_RTSP_MEDIA_STATUS_PREPARING) {
+    GST_DEBUG ("media %p waiting for preroll asynchronously", media);
+    /* same timeout as gst_rtsp_media_get_status() */
+    waiter->timeout = g_timeout_source_new_seconds (20);
+    g_source_set_callback (waiter->timeout, (GSourceFunc) prepare_timeout,
+        g_object_ref (media), g_object_unref);
+    g_source_attach (waiter->timeout, context);
+    priv->prepare_waiters = g_list_prepend (priv->prepare_waiters, waiter);
+    waiter = NULL;
+  }
+  g_mutex_unlock (&priv->lock);
+
+  /* already prepared or failed, complete right away */
+  if (waiter)
+    dispatch_prepare_waiter (waiter);
+
+  return TRUE;
+}
+
 /* must be called with state-lock */
 static void
 finish_unprepare (GstRTSPMedia * media)
@@ -3889,6 +4373,10 @@ finish_unprepare (GstRTSPMedia * media)
     gst_object_unref (priv->nettime);
   priv->nettime = NULL;
 
+  g_mutex_lock (&priv->lock);
+  clear_sdp_cache (media);
+  g_mutex_unlock (&priv->lock);
+
   priv->reused = TRUE;
   gst_rtsp_media_set_status (media, GST_RTSP_MEDIA_STATUS_UNPREPARED);
 
@@ -3931,6 +4419,105 @@ default_unprepare (GstRTSPMedia * media)
   return TRUE;
 }
 
+/* must be called with state-lock */
+static gboolean
+do_unprepare (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+  gboolean success = TRUE;
+
+  GST_INFO ("unprepare media %p", media);
+  set_target_state (media, GST_STATE_NULL, FALSE);
+
+  if (priv->status == GST_RTSP_MEDIA_STATUS_PREPARED) {
+    GstRTSPMediaClass *klass;
+
+    klass = GST_RTSP_MEDIA_GET_CLASS (media);
+    if (klass->unprepare)
+      success = klass->unprepare (media);
+  } else {
+    gst_rtsp_media_set_status (media, GST_RTSP_MEDIA_STATUS_UNPREPARING);
+    finish_unprepare (media);
+  }
+  return success;
+}
+
+/* must be called with state-lock */
+static void
+stop_linger (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+
+  g_source_destroy (priv->linger_source);
+  g_source_unref (priv->linger_source);
+  priv->linger_source = NULL;
+}
+
+static gboolean
+linger_timeout (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+  gboolean expired = FALSE;
+
+  g_rec_mutex_lock (&priv->state_lock);
+  /* we could have been reused right before taking the lock */
+  if (priv->linger_source == g_main_current_source ()) {
+    GST_INFO ("linger time of media %p expired", media);
+    g_source_unref (priv->linger_source);
+    priv->linger_source = NULL;
+    do_unprepare (media);
+    expired = TRUE;
+  }
+  g_rec_mutex_unlock (&priv->state_lock);
+
+  if (expired)
+    g_signal_emit (media, gst_rtsp_media_signals[SIGNAL_LINGER_EXPIRED], 0,
+        NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* must be called with state-lock, returns %TRUE when the media lingers */
+static gboolean
+start_linger (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+  GstClockTime linger_time;
+  GstRTSPSuspendMode suspend_mode;
+
+  if (!priv->shared)
+    return FALSE;
+
+  if (priv->status != GST_RTSP_MEDIA_STATUS_PREPARED &&
+      priv->status != GST_RTSP_MEDIA_STATUS_SUSPENDED)
+    return FALSE;
+
+  g_mutex_lock (&priv->lock);
+  linger_time = priv->linger_time;
+  suspend_mode = priv->suspend_mode;
+  g_mutex_unlock (&priv->lock);
+
+  if (linger_time == 0)
+    return FALSE;
+
+  GST_INFO ("media %p lingers for %" GST_TIME_FORMAT, media,
+      GST_TIME_ARGS (linger_time));
+
+  /* don't keep the pipeline running without clients when we can suspend */
+  if (suspend_mode != GST_RTSP_SUSPEND_MODE_NONE &&
+      priv->status == GST_RTSP_MEDIA_STATUS_PREPARED)
+    gst_rtsp_media_suspend (media);
+
+  priv->linger_source =
+      g_timeout_source_new (GST_TIME_AS_MSECONDS (linger_time));
+  g_source_set_callback (priv->linger_source, (GSourceFunc) linger_timeout,
+      g_object_ref (media), (GDestroyNotify) g_object_unref);
+  g_source_attach (priv->linger_source,
+      priv->thread ? priv->thread->context : NULL);
+
+  return TRUE;
+}
+
 /**
  * gst_rtsp_media_unprepare:
  * @media: a #GstRTSPMedia
@@ -3939,6 +4526,11 @@ default_unprepare (GstRTSPMedia * media)
  * it can be used again. If the media is set to be non-reusable, a new instance
  * must be created.
  *
+ * When @media is shared and has a #GstRTSPMedia:linger-time, the last
+ * unprepare keeps the media prepared until the linger time expires. Calling
+ * this function on a lingering media stops lingering and unprepares it
+ * immediately.
+ *
  * Returns: %TRUE on success.
  */
 gboolean
@@ -3955,24 +4547,22 @@ gst_rtsp_media_unprepare (GstRTSPMedia * media)
   if (priv->status == GST_RTSP_MEDIA_STATUS_UNPREPARED)
     goto was_unprepared;
 
+  if (priv->linger_source) {
+    /* nobody uses a lingering media, unprepare it now */
+    GST_INFO ("stop lingering of media %p", media);
+    stop_linger (media);
+    goto unprepare;
+  }
+
   priv->prepare_count--;
   if (priv->prepare_count > 0)
     goto is_busy;
 
-  GST_INFO ("unprepare media %p", media);
-  set_target_state (media, GST_STATE_NULL, FALSE);
-  success = TRUE;
+  if (start_linger (media))
+    goto is_lingering;
 
-  if (priv->status == GST_RTSP_MEDIA_STATUS_PREPARED) {
-    GstRTSPMediaClass *klass;
-
-    klass = GST_RTSP_MEDIA_GET_CLASS (media);
-    if (klass->unprepare)
-      success = klass->unprepare (media);
-  } else {
-    gst_rtsp_media_set_status (media, GST_RTSP_MEDIA_STATUS_UNPREPARING);
-    finish_unprepare (media);
-  }
+unprepare:
+  success = do_unprepare (media);
   g_rec_mutex_unlock (&priv->state_lock);
 
   return success;
@@ -3989,6 +4579,12 @@ is_busy:
     g_rec_mutex_unlock (&priv->state_lock);
     return TRUE;
   }
+is_lingering:
+  {
+    GST_INFO ("media %p is lingering", media);
+    g_rec_mutex_unlock (&priv->state_lock);
+    return TRUE;
+  }
 }
 
 /* should be called with state-lock */
@@ -4212,6 +4808,247 @@ no_setup_sdp:
   }
 }
 
+typedef struct
+{
+  gboolean is_ipv6;
+  gchar *text;
+  gsize len;
+  /* position of the session id in the origin line */
+  gsize id_offset;
+  gsize id_len;
+} SDPCacheEntry;
+
+static void
+sdp_cache_entry_free (SDPCacheEntry * entry)
+{
+  g_free (entry->text);
+  g_slice_free (SDPCacheEntry, entry);
+}
+
+/* must be called with the lock */
+static void
+clear_sdp_cache (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+
+  if (priv->sdp_cache)
+    g_hash_table_remove_all (priv->sdp_cache);
+  if (priv->sdp_caps) {
+    g_ptr_array_unref (priv->sdp_caps);
+    priv->sdp_caps = NULL;
+  }
+}
+
+/* must be called with the lock. Returns %TRUE when the streams still have the
+ * caps in @caps. The caps are compared by pointer, the caps of a stream are
+ * replaced by a new object on each caps change */
+static gboolean
+sdp_caps_unchanged (GstRTSPMedia * media, GPtrArray * caps)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+  guint i;
+
+  if (caps == NULL || caps->len != priv->streams->len)
+    return FALSE;
+
+  for (i = 0; i < priv->streams->len; i++) {
+    GstRTSPStream *stream = g_ptr_array_index (priv->streams, i);
+    GstCaps *current;
+    gboolean same;
+
+    current = gst_rtsp_stream_get_caps (stream);
+    same = current == g_ptr_array_index (caps, i);
+    if (current)
+      gst_caps_unref (current);
+
+    if (!same)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* must be called with the lock */
+static GPtrArray *
+get_sdp_caps (GstRTSPMedia * media)
+{
+  GstRTSPMediaPrivate *priv = media->priv;
+  GPtrArray *caps;
+  guint i;
+
+  caps = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_caps_unref);
+  for (i = 0; i < priv->streams->len; i++) {
+    GstRTSPStream *stream = g_ptr_array_index (priv->streams, i);
+    GstCaps *current;
+
+    if (!(current = gst_rtsp_stream_get_caps (stream))) {
+      g_ptr_array_unref (caps);
+      return NULL;
+    }
+    g_ptr_array_add (caps, current);
+  }
+  return caps;
+}
+
+/**
+ * gst_rtsp_media_get_cached_sdp:
+ * @media: a #GstRTSPMedia
+ * @info: (transfer none): a #GstSDPInfo
+ * @session_id: the session id for the origin of the SDP
+ *
+ * Get the SDP that was cached for @info with gst_rtsp_media_cache_sdp(),
+ * with @session_id as the session id of the origin.
+ *
+ * The cache is emptied when the caps of one of the streams change or when
+ * @media is unprepared.
+ *
+ * Returns: (transfer full) (nullable): the SDP as text or %NULL when there is
+ * no SDP cached for @info. g_free() after usage.
+ *
+ * Since: 1.18
+ */
+gchar *
+gst_rtsp_media_get_cached_sdp (GstRTSPMedia * media, GstSDPInfo * info,
+    const gchar * session_id)
+{
+  GstRTSPMediaPrivate *priv;
+  SDPCacheEntry *entry = NULL;
+  gchar *result;
+  gsize len;
+
+  g_return_val_if_fail (GST_IS_RTSP_MEDIA (media), NULL);
+  g_return_val_if_fail (info != NULL, NULL);
+  g_return_val_if_fail (session_id != NULL, NULL);
+
+  priv = media->priv;
+
+  g_mutex_lock (&priv->lock);
+  if (!sdp_caps_unchanged (media, priv->sdp_caps)) {
+    /* start a new cache for the current caps */
+    clear_sdp_cache (media);
+    priv->sdp_caps = get_sdp_caps (media);
+    goto no_entry;
+  }
+
+  if (priv->sdp_cache && info->server_ip)
+    entry = g_hash_table_lookup (priv->sdp_cache, info->server_ip);
+  if (entry == NULL || entry->is_ipv6 != info->is_ipv6)
+    goto no_entry;
+
+  len = strlen (session_id);
+  result = g_malloc (entry->len - entry->id_len + len + 1);
+  memcpy (result, entry->text, entry->id_offset);
+  memcpy (result + entry->id_offset, session_id, len);
+  memcpy (result + entry->id_offset + len,
+      entry->text + entry->id_offset + entry->id_len,
+      entry->len - entry->id_offset - entry->id_len + 1);
+  g_mutex_unlock (&priv->lock);
+
+  GST_LOG ("media %p: using cached SDP for %s", media, info->server_ip);
+
+  return result;
+
+no_entry:
+  {
+    g_mutex_unlock (&priv->lock);
+    return NULL;
+  }
+}
+
+/**
+ * gst_rtsp_media_cache_sdp:
+ * @media: a #GstRTSPMedia
+ * @info: (transfer none): a #GstSDPInfo
+ * @sdp: (transfer none): the #GstSDPMessage made for @info
+ *
+ * Keep the text of @sdp so that the next request for an SDP with @info can
+ * get it with gst_rtsp_media_get_cached_sdp() instead of making it again.
+ * Only the session id of the origin of @sdp is replaced then.
+ *
+ * The SDP is only cached for prepared live media without a time provider, for
+ * other media it changes with the position or the clock. It is also not
+ * cached when the caps of a stream changed since the last
+ * gst_rtsp_media_get_cached_sdp().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_media_cache_sdp (GstRTSPMedia * media, GstSDPInfo * info,
+    const GstSDPMessage * sdp)
+{
+  GstRTSPMediaPrivate *priv;
+  const GstSDPOrigin *origin;
+  SDPCacheEntry *entry;
+  gchar *text, *line, *id;
+
+  g_return_if_fail (GST_IS_RTSP_MEDIA (media));
+  g_return_if_fail (info != NULL);
+  g_return_if_fail (sdp != NULL);
+
+  priv = media->priv;
+
+  origin = gst_sdp_message_get_origin (sdp);
+  if (info->server_ip == NULL || origin->username == NULL ||
+      origin->sess_id == NULL)
+    return;
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->is_live || priv->time_provider ||
+      (priv->status != GST_RTSP_MEDIA_STATUS_PREPARED &&
+          priv->status != GST_RTSP_MEDIA_STATUS_SUSPENDED))
+    goto not_cacheable;
+  g_mutex_unlock (&priv->lock);
+
+  text = gst_sdp_message_as_text (sdp);
+
+  /* find the session id in the origin line */
+  if (!(line = strstr (text, "\r\no=")))
+    goto no_origin;
+  id = line + 4 + strlen (origin->username) + 1;
+  if (!g_str_has_prefix (id, origin->sess_id))
+    goto no_origin;
+
+  entry = g_slice_new (SDPCacheEntry);
+  entry->is_ipv6 = info->is_ipv6;
+  entry->text = text;
+  entry->len = strlen (text);
+  entry->id_offset = id - text;
+  entry->id_len = strlen (origin->sess_id);
+
+  g_mutex_lock (&priv->lock);
+  /* the caps changed while the SDP was made */
+  if (!sdp_caps_unchanged (media, priv->sdp_caps))
+    goto caps_changed;
+
+  if (priv->sdp_cache == NULL)
+    priv->sdp_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) sdp_cache_entry_free);
+  g_hash_table_insert (priv->sdp_cache, g_strdup (info->server_ip), entry);
+  g_mutex_unlock (&priv->lock);
+
+  GST_DEBUG ("media %p: cached SDP for %s", media, info->server_ip);
+
+  return;
+
+not_cacheable:
+  {
+    g_mutex_unlock (&priv->lock);
+    return;
+  }
+no_origin:
+  {
+    GST_WARNING ("media %p: no origin found in SDP", media);
+    g_free (text);
+    return;
+  }
+caps_changed:
+  {
+    g_mutex_unlock (&priv->lock);
+    GST_DEBUG ("media %p: caps changed, not caching SDP", media);
+    sdp_cache_entry_free (entry);
+    return;
+  }
+}
+
 static gboolean
 default_handle_sdp (GstRTSPMedia * media, GstSDPMessage * sdp)
 {
@@ -122,6 +122,20 @@ GType gst_rtsp_publish_clock_mode_get_type (void);
 #include "rtsp-address-pool.h"
 #include "rtsp-sdp.h"
 
+/**
+ * GstRTSPMediaPrepareFunc:
+ * @media: a #GstRTSPMedia
+ * @success: %TRUE when @media was prepared
+ * @user_data: user data
+ *
+ * Function called when the preparation of @media, started with
+ * gst_rtsp_media_prepare_async(), completed.
+ *
+ * Since: 1.18
+ */
+typedef void (*GstRTSPMediaPrepareFunc) (GstRTSPMedia *media, gboolean success,
+                                         gpointer user_data);
+
 /**
  * GstRTSPMedia:
  *
@@ -325,11 +339,36 @@ void                  gst_rtsp_media_set_bind_mcast_address  (GstRTSPMedia *medi
 GST_RTSP_SERVER_API
 gboolean              gst_rtsp_media_is_bind_mcast_address  (GstRTSPMedia *media);
 
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_set_linger_time  (GstRTSPMedia *media, GstClockTime linger_time);
+
+GST_RTSP_SERVER_API
+GstClockTime          gst_rtsp_media_get_linger_time  (GstRTSPMedia *media);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_set_key_unit_interval  (GstRTSPMedia *media, GstClockTime interval);
+
+GST_RTSP_SERVER_API
+GstClockTime          gst_rtsp_media_get_key_unit_interval  (GstRTSPMedia *media);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_set_gop_cache  (GstRTSPMedia *media, gboolean enabled);
+
+GST_RTSP_SERVER_API
+gboolean              gst_rtsp_media_get_gop_cache  (GstRTSPMedia *media);
+
 /* prepare the media for playback */
 
 GST_RTSP_SERVER_API
 gboolean              gst_rtsp_media_prepare          (GstRTSPMedia *media, GstRTSPThread *thread);
 
+GST_RTSP_SERVER_API
+gboolean              gst_rtsp_media_prepare_async    (GstRTSPMedia *media, GstRTSPThread *thread,
+                                                       GMainContext *context,
+                                                       GstRTSPMediaPrepareFunc func,
+                                                       gpointer user_data,
+                                                       GDestroyNotify notify);
+
 GST_RTSP_SERVER_API
 gboolean              gst_rtsp_media_unprepare        (GstRTSPMedia *media);
 
@@ -352,6 +391,14 @@ gboolean              gst_rtsp_media_setup_sdp        (GstRTSPMedia * media, Gst
 GST_RTSP_SERVER_API
 gboolean              gst_rtsp_media_handle_sdp (GstRTSPMedia * media, GstSDPMessage * sdp);
 
+GST_RTSP_SERVER_API
+gchar *               gst_rtsp_media_get_cached_sdp   (GstRTSPMedia * media, GstSDPInfo * info,
+                                                       const gchar * session_id);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_media_cache_sdp        (GstRTSPMedia * media, GstSDPInfo * info,
+                                                       const GstSDPMessage * sdp);
+
 /* creating streams */
 
 GST_RTSP_SERVER_API
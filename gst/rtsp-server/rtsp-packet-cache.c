@@ -0,0 +1,1051 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A packet cache holds the RTP packets that the payloaders of a file
+ * produced, together with an index of packet boundaries, timestamps and
+ * keyframes. Medias made from a cache stream the packets from a memory
+ * mapping of the cache file and resolve seeks with an index lookup instead
+ * of running the demuxer, parser and payloader again.
+ *
+ * The file is written once and only read afterwards. All integers are
+ * stored in little endian byte order:
+ *
+ *   the packets, as they left the payloaders
+ *   for each stream, aligned to 8 bytes:
+ *     guint32 length of the caps string, the caps string
+ *     guint64 number of packets, the PacketEntry of each packet
+ *   a CacheFooter
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gst/base/gstpushsrc.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "rtsp-packet-cache.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtsp_packet_cache_debug);
+#define GST_CAT_DEFAULT rtsp_packet_cache_debug
+
+#define CACHE_MAGIC     0x43505452      /* "RTPC" */
+#define CACHE_VERSION   3
+#define MAX_STREAMS     64
+
+#define ENTRY_FLAG_KEYFRAME  (1 << 0)
+
+/* the fields of a PacketEntry in the mapping of the cache */
+#define ENTRY_OFFSET(e)      GUINT64_FROM_LE ((e)->offset)
+#define ENTRY_PTS(e)         GUINT64_FROM_LE ((e)->pts)
+#define ENTRY_DTS(e)         GUINT64_FROM_LE ((e)->dts)
+#define ENTRY_RTPTIME(e)     GUINT32_FROM_LE ((e)->rtptime)
+#define ENTRY_FLAGS(e)       GUINT32_FROM_LE ((e)->flags)
+#define ENTRY_SIZE(e)        GUINT32_FROM_LE ((e)->size)
+#define ENTRY_HDRLEN(e)      GUINT32_FROM_LE ((e)->hdrlen)
+
+/* the times are running times of the pipeline that made the cache. @dts
+ * never decreases within a stream so that seeks can search on it, @pts does
+ * when frames are reordered */
+typedef struct
+{
+  guint64 offset;
+  guint64 pts;
+  guint64 dts;
+  guint32 rtptime;
+  guint32 flags;
+  guint32 size;
+  guint32 hdrlen;
+} PacketEntry;
+
+typedef struct
+{
+  guint64 index_offset;
+  guint64 duration;
+  guint32 n_streams;
+  guint32 version;
+  guint32 magic;
+  guint32 padding;
+} CacheFooter;
+
+typedef struct
+{
+  GstCaps *caps;
+  const PacketEntry *entries;
+  guint64 n_entries;
+} CacheStream;
+
+struct _GstRTSPPacketCache
+{
+  gint refcount;
+
+  GMappedFile *file;
+  const guint8 *data;
+  GstClockTime duration;
+
+  guint n_streams;
+  CacheStream *streams;
+};
+
+typedef struct
+{
+  GstCaps *caps;
+  GArray *entries;
+  GstClockTime last_pts;
+  GstClockTime last_dts;
+  GstClockTime max_pts;
+} WriterStream;
+
+struct _GstRTSPPacketCacheWriter
+{
+  GMutex lock;
+  gchar *path;
+  gchar *tmp_path;
+  FILE *file;
+  guint64 offset;
+  GPtrArray *streams;
+  gboolean failed;
+  gboolean finished;
+};
+
+static void
+init_debug (void)
+{
+  static gsize init = 0;
+
+  if (g_once_init_enter (&init)) {
+    GST_DEBUG_CATEGORY_INIT (rtsp_packet_cache_debug, "rtsppacketcache", 0,
+        "GstRTSPPacketCache");
+    g_once_init_leave (&init, 1);
+  }
+}
+
+static void
+writer_stream_free (WriterStream * ws)
+{
+  if (ws->caps)
+    gst_caps_unref (ws->caps);
+  g_array_free (ws->entries, TRUE);
+  g_slice_free (WriterStream, ws);
+}
+
+/* Start writing a cache to @path. The cache is written to a temporary file
+ * that only replaces @path when gst_rtsp_packet_cache_writer_finish()
+ * succeeds. */
+GstRTSPPacketCacheWriter *
+gst_rtsp_packet_cache_writer_new (const gchar * path)
+{
+  GstRTSPPacketCacheWriter *writer;
+  gint fd;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  init_debug ();
+
+  writer = g_slice_new0 (GstRTSPPacketCacheWriter);
+  g_mutex_init (&writer->lock);
+  writer->path = g_strdup (path);
+  writer->tmp_path = g_strconcat (path, ".XXXXXX", NULL);
+  writer->streams = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      writer_stream_free);
+
+  fd = g_mkstemp (writer->tmp_path);
+  if (fd == -1)
+    goto no_file;
+
+  writer->file = fdopen (fd, "wb");
+  if (writer->file == NULL) {
+    g_close (fd, NULL);
+    g_unlink (writer->tmp_path);
+    goto no_file;
+  }
+
+  return writer;
+
+  /* ERRORS */
+no_file:
+  {
+    GST_WARNING ("could not create %s: %s", writer->tmp_path,
+        g_strerror (errno));
+    writer->finished = TRUE;
+    gst_rtsp_packet_cache_writer_free (writer);
+    return NULL;
+  }
+}
+
+/* Free @writer, the cache is discarded when it was not finished. */
+void
+gst_rtsp_packet_cache_writer_free (GstRTSPPacketCacheWriter * writer)
+{
+  g_return_if_fail (writer != NULL);
+
+  if (writer->file)
+    fclose (writer->file);
+  if (!writer->finished)
+    g_unlink (writer->tmp_path);
+
+  g_ptr_array_unref (writer->streams);
+  g_free (writer->tmp_path);
+  g_free (writer->path);
+  g_mutex_clear (&writer->lock);
+  g_slice_free (GstRTSPPacketCacheWriter, writer);
+}
+
+/* Add a stream to @writer, returns the index of the new stream. Streams are
+ * replayed in the order they were added. */
+guint
+gst_rtsp_packet_cache_writer_add_stream (GstRTSPPacketCacheWriter * writer)
+{
+  WriterStream *ws;
+  guint idx;
+
+  g_return_val_if_fail (writer != NULL, 0);
+
+  ws = g_slice_new0 (WriterStream);
+  ws->entries = g_array_new (FALSE, FALSE, sizeof (PacketEntry));
+  ws->last_pts = 0;
+  ws->last_dts = 0;
+  ws->max_pts = 0;
+
+  g_mutex_lock (&writer->lock);
+  idx = writer->streams->len;
+  g_ptr_array_add (writer->streams, ws);
+  g_mutex_unlock (&writer->lock);
+
+  return idx;
+}
+
+/* called with the writer lock */
+static gboolean
+write_data (GstRTSPPacketCacheWriter * writer, gconstpointer data, gsize size)
+{
+  if (writer->failed)
+    return FALSE;
+
+  if (size > 0 && fwrite (data, size, 1, writer->file) != 1)
+    goto write_failed;
+
+  writer->offset += size;
+
+  return TRUE;
+
+  /* ERRORS */
+write_failed:
+  {
+    GST_WARNING ("failed to write %s: %s", writer->tmp_path,
+        g_strerror (errno));
+    writer->failed = TRUE;
+    return FALSE;
+  }
+}
+
+/* called with the writer lock */
+static gboolean
+write_padding (GstRTSPPacketCacheWriter * writer)
+{
+  static const guint8 zeros[8] = { 0, };
+
+  return write_data (writer, zeros,
+      GST_ROUND_UP_8 (writer->offset) - writer->offset);
+}
+
+/* remove the fields that every media picks for itself */
+static GstCaps *
+strip_caps (GstCaps * caps)
+{
+  GstStructure *s;
+
+  caps = gst_caps_copy (caps);
+  s = gst_caps_get_structure (caps, 0);
+  gst_structure_remove_fields (s, "ssrc", "timestamp-offset", "seqnum-offset",
+      NULL);
+
+  return caps;
+}
+
+/* Add the RTP packet in @buffer to @stream. @caps are the caps of the
+ * payloader, @pts and @dts the running times of the packet, either can be
+ * GST_CLOCK_TIME_NONE. @keyframe marks the first packet of a keyframe, where
+ * seeks can start. */
+void
+gst_rtsp_packet_cache_writer_add_packet (GstRTSPPacketCacheWriter * writer,
+    guint stream, GstCaps * caps, GstBuffer * buffer, GstClockTime pts,
+    GstClockTime dts, gboolean keyframe)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  WriterStream *ws;
+  PacketEntry entry;
+  GstMapInfo map;
+
+  g_return_if_fail (writer != NULL);
+  g_return_if_fail (GST_IS_BUFFER (buffer));
+
+  g_mutex_lock (&writer->lock);
+  if (writer->failed || stream >= writer->streams->len)
+    goto done;
+
+  ws = g_ptr_array_index (writer->streams, stream);
+
+  if (ws->caps == NULL && caps != NULL)
+    ws->caps = strip_caps (caps);
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp))
+    goto not_rtp;
+
+  entry.hdrlen = GUINT32_TO_LE (gst_rtp_buffer_get_header_len (&rtp));
+  entry.rtptime = GUINT32_TO_LE (gst_rtp_buffer_get_timestamp (&rtp));
+  gst_rtp_buffer_unmap (&rtp);
+
+  /* packets without timestamp belong to the previous one */
+  if (GST_CLOCK_TIME_IS_VALID (pts)) {
+    ws->last_pts = pts;
+    ws->max_pts = MAX (ws->max_pts, pts);
+  }
+  /* without a decode time the packets are decoded in presentation order */
+  if (!GST_CLOCK_TIME_IS_VALID (dts))
+    dts = pts;
+  if (GST_CLOCK_TIME_IS_VALID (dts))
+    ws->last_dts = MAX (ws->last_dts, dts);
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    goto not_rtp;
+
+  entry.offset = GUINT64_TO_LE (writer->offset);
+  entry.pts = GUINT64_TO_LE (ws->last_pts);
+  entry.dts = GUINT64_TO_LE (ws->last_dts);
+  entry.flags = GUINT32_TO_LE (keyframe ? ENTRY_FLAG_KEYFRAME : 0);
+  entry.size = GUINT32_TO_LE (map.size);
+
+  if (write_data (writer, map.data, map.size))
+    g_array_append_val (ws->entries, entry);
+
+  gst_buffer_unmap (buffer, &map);
+
+done:
+  g_mutex_unlock (&writer->lock);
+  return;
+
+  /* ERRORS */
+not_rtp:
+  {
+    GST_WARNING ("stream %u produced a buffer that is not RTP", stream);
+    writer->failed = TRUE;
+    g_mutex_unlock (&writer->lock);
+    return;
+  }
+}
+
+/* Write the index and move the cache to its final path. @duration can be
+ * GST_CLOCK_TIME_NONE, the timestamp of the last packet is used then. */
+gboolean
+gst_rtsp_packet_cache_writer_finish (GstRTSPPacketCacheWriter * writer,
+    GstClockTime duration)
+{
+  CacheFooter footer = { 0, };
+  GstClockTime max_pts = 0;
+  gboolean res;
+  guint i;
+
+  g_return_val_if_fail (writer != NULL, FALSE);
+
+  g_mutex_lock (&writer->lock);
+  if (writer->streams->len == 0 || writer->streams->len > MAX_STREAMS)
+    writer->failed = TRUE;
+
+  write_padding (writer);
+  footer.index_offset = writer->offset;
+
+  for (i = 0; i < writer->streams->len && !writer->failed; i++) {
+    WriterStream *ws = g_ptr_array_index (writer->streams, i);
+    gchar *caps_str;
+    guint32 caps_len, caps_len_le;
+    guint64 n_entries, n_entries_le;
+
+    if (ws->caps == NULL || ws->entries->len == 0)
+      goto empty_stream;
+
+    caps_str = gst_caps_to_string (ws->caps);
+    caps_len = strlen (caps_str);
+    caps_len_le = GUINT32_TO_LE (caps_len);
+    n_entries = ws->entries->len;
+    n_entries_le = GUINT64_TO_LE (n_entries);
+
+    write_data (writer, &caps_len_le, sizeof (caps_len_le));
+    write_data (writer, caps_str, caps_len);
+    write_padding (writer);
+    write_data (writer, &n_entries_le, sizeof (n_entries_le));
+    write_data (writer, ws->entries->data, n_entries * sizeof (PacketEntry));
+    g_free (caps_str);
+
+    max_pts = MAX (max_pts, ws->max_pts);
+  }
+
+  footer.index_offset = GUINT64_TO_LE (footer.index_offset);
+  footer.duration = GUINT64_TO_LE (GST_CLOCK_TIME_IS_VALID (duration) ?
+      duration : max_pts);
+  footer.n_streams = GUINT32_TO_LE (writer->streams->len);
+  footer.version = GUINT32_TO_LE (CACHE_VERSION);
+  footer.magic = GUINT32_TO_LE (CACHE_MAGIC);
+  write_data (writer, &footer, sizeof (footer));
+
+  if (fclose (writer->file) != 0)
+    writer->failed = TRUE;
+  writer->file = NULL;
+
+  if (!writer->failed && g_rename (writer->tmp_path, writer->path) != 0) {
+    GST_WARNING ("could not rename %s: %s", writer->tmp_path,
+        g_strerror (errno));
+    writer->failed = TRUE;
+  }
+  res = !writer->failed;
+  writer->finished = res;
+  g_mutex_unlock (&writer->lock);
+
+  if (res)
+    GST_INFO ("wrote packet cache %s", writer->path);
+
+  return res;
+
+  /* ERRORS */
+empty_stream:
+  {
+    GST_WARNING ("stream %u has no packets", i);
+    writer->failed = TRUE;
+    g_mutex_unlock (&writer->lock);
+    return FALSE;
+  }
+}
+
+static void
+packet_cache_free (GstRTSPPacketCache * cache)
+{
+  guint i;
+
+  for (i = 0; i < cache->n_streams; i++) {
+    if (cache->streams[i].caps)
+      gst_caps_unref (cache->streams[i].caps);
+  }
+  g_free (cache->streams);
+  g_mapped_file_unref (cache->file);
+  g_slice_free (GstRTSPPacketCache, cache);
+}
+
+/* Open the cache at @path, returns NULL when there is no valid cache. */
+GstRTSPPacketCache *
+gst_rtsp_packet_cache_open (const gchar * path)
+{
+  GstRTSPPacketCache *cache;
+  GMappedFile *file;
+  GError *error = NULL;
+  CacheFooter footer;
+  gsize size, pos, end;
+  guint i;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  init_debug ();
+
+  file = g_mapped_file_new (path, FALSE, &error);
+  if (file == NULL)
+    goto no_file;
+
+  cache = g_slice_new0 (GstRTSPPacketCache);
+  cache->refcount = 1;
+  cache->file = file;
+  cache->data = (const guint8 *) g_mapped_file_get_contents (file);
+  size = g_mapped_file_get_length (file);
+
+  if (size < sizeof (footer))
+    goto invalid;
+
+  end = size - sizeof (footer);
+  memcpy (&footer, cache->data + end, sizeof (footer));
+  footer.index_offset = GUINT64_FROM_LE (footer.index_offset);
+  footer.duration = GUINT64_FROM_LE (footer.duration);
+  footer.n_streams = GUINT32_FROM_LE (footer.n_streams);
+  footer.version = GUINT32_FROM_LE (footer.version);
+  footer.magic = GUINT32_FROM_LE (footer.magic);
+
+  if (footer.magic != CACHE_MAGIC || footer.version != CACHE_VERSION)
+    goto invalid;
+  if (footer.index_offset > end || footer.index_offset % 8 != 0)
+    goto invalid;
+  if (footer.n_streams == 0 || footer.n_streams > MAX_STREAMS)
+    goto invalid;
+
+  cache->duration = footer.duration;
+  cache->n_streams = footer.n_streams;
+  cache->streams = g_new0 (CacheStream, cache->n_streams);
+
+  pos = footer.index_offset;
+  for (i = 0; i < cache->n_streams; i++) {
+    CacheStream *cs = &cache->streams[i];
+    guint32 caps_len;
+    gchar *caps_str;
+    guint64 j;
+
+    if (end - pos < sizeof (caps_len))
+      goto invalid;
+    caps_len = GST_READ_UINT32_LE (cache->data + pos);
+    pos += sizeof (caps_len);
+
+    if (end - pos < caps_len)
+      goto invalid;
+    caps_str = g_strndup ((const gchar *) cache->data + pos, caps_len);
+    cs->caps = gst_caps_from_string (caps_str);
+    g_free (caps_str);
+    if (cs->caps == NULL || !gst_caps_is_fixed (cs->caps))
+      goto invalid;
+    pos = GST_ROUND_UP_8 (pos + caps_len);
+
+    if (pos > end || end - pos < sizeof (cs->n_entries))
+      goto invalid;
+    cs->n_entries = GST_READ_UINT64_LE (cache->data + pos);
+    pos += sizeof (cs->n_entries);
+
+    if (cs->n_entries == 0 || cs->n_entries > (end - pos) / sizeof (PacketEntry))
+      goto invalid;
+    cs->entries = (const PacketEntry *) (cache->data + pos);
+    pos += cs->n_entries * sizeof (PacketEntry);
+
+    for (j = 0; j < cs->n_entries; j++) {
+      const PacketEntry *entry = &cs->entries[j];
+
+      if (ENTRY_OFFSET (entry) > footer.index_offset ||
+          ENTRY_SIZE (entry) > footer.index_offset - ENTRY_OFFSET (entry) ||
+          ENTRY_HDRLEN (entry) < 12 ||
+          ENTRY_HDRLEN (entry) > ENTRY_SIZE (entry))
+        goto invalid;
+      /* seeks do a binary search on the decode times */
+      if (j > 0 && ENTRY_DTS (entry) < ENTRY_DTS (&cs->entries[j - 1]))
+        goto invalid;
+    }
+  }
+  if (pos != end)
+    goto invalid;
+
+  GST_INFO ("opened packet cache %s with %u streams", path, cache->n_streams);
+
+  return cache;
+
+  /* ERRORS */
+no_file:
+  {
+    GST_DEBUG ("no packet cache: %s", error->message);
+    g_clear_error (&error);
+    return NULL;
+  }
+invalid:
+  {
+    GST_WARNING ("invalid packet cache %s", path);
+    packet_cache_free (cache);
+    return NULL;
+  }
+}
+
+GstRTSPPacketCache *
+gst_rtsp_packet_cache_ref (GstRTSPPacketCache * cache)
+{
+  g_return_val_if_fail (cache != NULL, NULL);
+
+  g_atomic_int_inc (&cache->refcount);
+
+  return cache;
+}
+
+void
+gst_rtsp_packet_cache_unref (GstRTSPPacketCache * cache)
+{
+  g_return_if_fail (cache != NULL);
+
+  if (g_atomic_int_dec_and_test (&cache->refcount))
+    packet_cache_free (cache);
+}
+
+guint
+gst_rtsp_packet_cache_n_streams (GstRTSPPacketCache * cache)
+{
+  g_return_val_if_fail (cache != NULL, 0);
+
+  return cache->n_streams;
+}
+
+/* the element that replays a stream of a cache, it has the properties of a
+ * payloader so that it can be used as one by GstRTSPStream */
+#define GST_TYPE_RTSP_PACKET_CACHE_SRC (gst_rtsp_packet_cache_src_get_type ())
+#define GST_RTSP_PACKET_CACHE_SRC(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+    GST_TYPE_RTSP_PACKET_CACHE_SRC, GstRTSPPacketCacheSrc))
+
+typedef struct
+{
+  GstPushSrc parent;
+
+  GstRTSPPacketCache *cache;
+  guint stream;
+
+  /* protected by the object lock */
+  guint pt;
+  guint mtu;
+  guint ssrc;
+  guint ts_offset;
+  gint seqnum_offset;
+
+  guint32 current_ssrc;
+  guint32 ts_base;
+  guint16 seqnum;               /* of the next packet */
+  guint32 timestamp;            /* of the last packet */
+  guint64 index;                /* of the next packet */
+  gboolean discont;
+} GstRTSPPacketCacheSrc;
+
+typedef struct
+{
+  GstPushSrcClass parent_class;
+} GstRTSPPacketCacheSrcClass;
+
+GType gst_rtsp_packet_cache_src_get_type (void);
+
+#define DEFAULT_PT              96
+#define DEFAULT_MTU             1400
+#define DEFAULT_SSRC            G_MAXUINT32
+#define DEFAULT_TIMESTAMP_OFFSET G_MAXUINT32
+#define DEFAULT_SEQNUM_OFFSET   -1
+
+enum
+{
+  PROP_0,
+  PROP_PT,
+  PROP_MTU,
+  PROP_SSRC,
+  PROP_TIMESTAMP_OFFSET,
+  PROP_SEQNUM_OFFSET,
+  PROP_SEQNUM,
+  PROP_TIMESTAMP,
+  PROP_STATS,
+};
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static void gst_rtsp_packet_cache_src_get_property (GObject * object,
+    guint propid, GValue * value, GParamSpec * pspec);
+static void gst_rtsp_packet_cache_src_set_property (GObject * object,
+    guint propid, const GValue * value, GParamSpec * pspec);
+static void gst_rtsp_packet_cache_src_finalize (GObject * obj);
+static GstCaps *gst_rtsp_packet_cache_src_get_caps (GstBaseSrc * bsrc,
+    GstCaps * filter);
+static gboolean gst_rtsp_packet_cache_src_is_seekable (GstBaseSrc * bsrc);
+static gboolean gst_rtsp_packet_cache_src_do_seek (GstBaseSrc * bsrc,
+    GstSegment * segment);
+static gboolean gst_rtsp_packet_cache_src_query (GstBaseSrc * bsrc,
+    GstQuery * query);
+static GstFlowReturn gst_rtsp_packet_cache_src_create (GstPushSrc * psrc,
+    GstBuffer ** buffer);
+
+G_DEFINE_TYPE (GstRTSPPacketCacheSrc, gst_rtsp_packet_cache_src,
+    GST_TYPE_PUSH_SRC);
+
+static void
+gst_rtsp_packet_cache_src_class_init (GstRTSPPacketCacheSrcClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSrcClass *basesrc_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *pushsrc_class = GST_PUSH_SRC_CLASS (klass);
+
+  gobject_class->get_property = gst_rtsp_packet_cache_src_get_property;
+  gobject_class->set_property = gst_rtsp_packet_cache_src_set_property;
+  gobject_class->finalize = gst_rtsp_packet_cache_src_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_PT,
+      g_param_spec_uint ("pt", "Payload type", "The payload type of the packets",
+          0, 0x7f, DEFAULT_PT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /* the packets are cut already, the mtu is only kept for the API */
+  g_object_class_install_property (gobject_class, PROP_MTU,
+      g_param_spec_uint ("mtu", "MTU",
+          "Maximum size of one packet (ignored, the packets are cached)",
+          28, G_MAXUINT, DEFAULT_MTU,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SSRC,
+      g_param_spec_uint ("ssrc", "SSRC",
+          "The SSRC of the packets (default == random)", 0, G_MAXUINT32,
+          DEFAULT_SSRC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMP_OFFSET,
+      g_param_spec_uint ("timestamp-offset", "Timestamp Offset",
+          "Offset to add to all outgoing timestamps (default = random)", 0,
+          G_MAXUINT32, DEFAULT_TIMESTAMP_OFFSET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SEQNUM_OFFSET,
+      g_param_spec_int ("seqnum-offset", "Sequence number Offset",
+          "Offset to add to all outgoing seqnum (-1 = random)", -1, G_MAXUINT16,
+          DEFAULT_SEQNUM_OFFSET, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SEQNUM,
+      g_param_spec_uint ("seqnum", "Sequence number",
+          "The RTP sequence number of the last processed packet",
+          0, G_MAXUINT16, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMP,
+      g_param_spec_uint ("timestamp", "Timestamp",
+          "The RTP timestamp of the last processed packet",
+          0, G_MAXUINT32, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Various statistics",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &srctemplate);
+  gst_element_class_set_static_metadata (element_class,
+      "RTSP packet cache source", "Codec/Payloader/Network/RTP",
+      "Replays RTP packets from a packet cache",
+      "The GStreamer developers");
+
+  basesrc_class->get_caps = gst_rtsp_packet_cache_src_get_caps;
+  basesrc_class->is_seekable = gst_rtsp_packet_cache_src_is_seekable;
+  basesrc_class->do_seek = gst_rtsp_packet_cache_src_do_seek;
+  basesrc_class->query = gst_rtsp_packet_cache_src_query;
+  pushsrc_class->create = gst_rtsp_packet_cache_src_create;
+}
+
+static void
+gst_rtsp_packet_cache_src_init (GstRTSPPacketCacheSrc * src)
+{
+  src->pt = DEFAULT_PT;
+  src->mtu = DEFAULT_MTU;
+  src->ssrc = DEFAULT_SSRC;
+  src->ts_offset = DEFAULT_TIMESTAMP_OFFSET;
+  src->seqnum_offset = DEFAULT_SEQNUM_OFFSET;
+
+  src->current_ssrc = g_random_int ();
+  src->ts_base = g_random_int ();
+  src->seqnum = g_random_int_range (0, G_MAXUINT16);
+  src->discont = TRUE;
+
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+}
+
+static void
+gst_rtsp_packet_cache_src_finalize (GObject * obj)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (obj);
+
+  if (src->cache)
+    gst_rtsp_packet_cache_unref (src->cache);
+
+  G_OBJECT_CLASS (gst_rtsp_packet_cache_src_parent_class)->finalize (obj);
+}
+
+/* called with the object lock, the values for the next packet. The RTP-Info
+ * of a stream starts at the seqnum-offset and needs the timestamp and the
+ * running-time of that same packet */
+static GstStructure *
+create_stats (GstRTSPPacketCacheSrc * src)
+{
+  CacheStream *cs = &src->cache->streams[src->stream];
+  GstSegment *segment = &GST_BASE_SRC (src)->segment;
+  const PacketEntry *entry;
+  GstClockTime running_time;
+  guint32 timestamp;
+  gint clock_rate = 0;
+
+  entry = &cs->entries[MIN (src->index, cs->n_entries - 1)];
+  timestamp = src->ts_base + (ENTRY_RTPTIME (entry) -
+      ENTRY_RTPTIME (&cs->entries[0]));
+  running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+      ENTRY_PTS (entry));
+  gst_structure_get_int (gst_caps_get_structure (cs->caps, 0), "clock-rate",
+      &clock_rate);
+
+  return gst_structure_new ("application/x-rtp-payload-stats",
+      "clock-rate", G_TYPE_UINT, (guint) clock_rate,
+      "running-time", G_TYPE_UINT64, running_time,
+      "seqnum", G_TYPE_UINT, (guint) (guint16) (src->seqnum - 1),
+      "timestamp", G_TYPE_UINT, timestamp,
+      "ssrc", G_TYPE_UINT, src->current_ssrc,
+      "pt", G_TYPE_UINT, src->pt,
+      "seqnum-offset", G_TYPE_UINT, (guint) src->seqnum,
+      "timestamp-offset", G_TYPE_UINT, src->ts_base, NULL);
+}
+
+static void
+gst_rtsp_packet_cache_src_get_property (GObject * object, guint propid,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (object);
+
+  GST_OBJECT_LOCK (src);
+  switch (propid) {
+    case PROP_PT:
+      g_value_set_uint (value, src->pt);
+      break;
+    case PROP_MTU:
+      g_value_set_uint (value, src->mtu);
+      break;
+    case PROP_SSRC:
+      g_value_set_uint (value, src->ssrc);
+      break;
+    case PROP_TIMESTAMP_OFFSET:
+      g_value_set_uint (value, src->ts_offset);
+      break;
+    case PROP_SEQNUM_OFFSET:
+      g_value_set_int (value, src->seqnum_offset);
+      break;
+    case PROP_SEQNUM:
+      g_value_set_uint (value, (guint16) (src->seqnum - 1));
+      break;
+    case PROP_TIMESTAMP:
+      g_value_set_uint (value, src->timestamp);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, create_stats (src));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
+  }
+  GST_OBJECT_UNLOCK (src);
+}
+
+static void
+gst_rtsp_packet_cache_src_set_property (GObject * object, guint propid,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (object);
+
+  GST_OBJECT_LOCK (src);
+  switch (propid) {
+    case PROP_PT:
+      src->pt = g_value_get_uint (value);
+      break;
+    case PROP_MTU:
+      src->mtu = g_value_get_uint (value);
+      break;
+    case PROP_SSRC:
+      src->ssrc = g_value_get_uint (value);
+      if (src->ssrc != DEFAULT_SSRC)
+        src->current_ssrc = src->ssrc;
+      break;
+    case PROP_TIMESTAMP_OFFSET:
+      src->ts_offset = g_value_get_uint (value);
+      if (src->ts_offset != DEFAULT_TIMESTAMP_OFFSET)
+        src->ts_base = src->ts_offset;
+      break;
+    case PROP_SEQNUM_OFFSET:
+      src->seqnum_offset = g_value_get_int (value);
+      if (src->seqnum_offset != DEFAULT_SEQNUM_OFFSET)
+        src->seqnum = src->seqnum_offset;
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
+  }
+  GST_OBJECT_UNLOCK (src);
+}
+
+static GstCaps *
+gst_rtsp_packet_cache_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (bsrc);
+  GstCaps *caps, *result;
+
+  caps = gst_caps_copy (src->cache->streams[src->stream].caps);
+
+  GST_OBJECT_LOCK (src);
+  gst_caps_set_simple (caps,
+      "payload", G_TYPE_INT, src->pt,
+      "ssrc", G_TYPE_UINT, src->current_ssrc,
+      "timestamp-offset", G_TYPE_UINT, src->ts_base,
+      "seqnum-offset", G_TYPE_UINT, (guint) src->seqnum, NULL);
+  GST_OBJECT_UNLOCK (src);
+
+  if (filter) {
+    result = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+  } else {
+    result = caps;
+  }
+  return result;
+}
+
+static gboolean
+gst_rtsp_packet_cache_src_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_rtsp_packet_cache_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (bsrc);
+  CacheStream *cs = &src->cache->streams[src->stream];
+  guint64 lo, hi, idx;
+
+  if (segment->format != GST_FORMAT_TIME || segment->rate < 0.0)
+    return FALSE;
+
+  /* find the last packet decoded before the start, then the keyframe it
+   * belongs to. The presentation times are not ordered when frames are
+   * reordered, the decode times are */
+  lo = 0;
+  hi = cs->n_entries;
+  while (hi - lo > 1) {
+    guint64 mid = lo + (hi - lo) / 2;
+
+    if (ENTRY_DTS (&cs->entries[mid]) <= segment->start)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  idx = lo;
+  while (idx > 0 && !(ENTRY_FLAGS (&cs->entries[idx]) & ENTRY_FLAG_KEYFRAME))
+    idx--;
+
+  GST_DEBUG_OBJECT (src, "seek to %" GST_TIME_FORMAT " starts at packet %"
+      G_GUINT64_FORMAT, GST_TIME_ARGS (segment->start), idx);
+
+  /* we can only start at a keyframe, move the segment there so that the
+   * sinks don't drop the packets before the requested position */
+  if (ENTRY_PTS (&cs->entries[idx]) < segment->start) {
+    segment->start = ENTRY_PTS (&cs->entries[idx]);
+    segment->time = segment->start;
+    segment->position = segment->start;
+  }
+
+  GST_OBJECT_LOCK (src);
+  src->index = idx;
+  src->discont = TRUE;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtsp_packet_cache_src_query (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (bsrc);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_DURATION) {
+    GstFormat format;
+
+    gst_query_parse_duration (query, &format, NULL);
+    if (format == GST_FORMAT_TIME) {
+      gst_query_set_duration (query, format, src->cache->duration);
+      return TRUE;
+    }
+  }
+  return GST_BASE_SRC_CLASS (gst_rtsp_packet_cache_src_parent_class)->query
+      (bsrc, query);
+}
+
+static GstFlowReturn
+gst_rtsp_packet_cache_src_create (GstPushSrc * psrc, GstBuffer ** buffer)
+{
+  GstRTSPPacketCacheSrc *src = GST_RTSP_PACKET_CACHE_SRC (psrc);
+  CacheStream *cs = &src->cache->streams[src->stream];
+  GstSegment *segment = &GST_BASE_SRC (psrc)->segment;
+  const PacketEntry *entry;
+  const guint8 *data;
+  guint32 hdrlen, size;
+  GstMemory *header;
+  GstMapInfo map;
+  GstBuffer *buf;
+
+  GST_OBJECT_LOCK (src);
+  if (src->index >= cs->n_entries)
+    goto eos;
+
+  entry = &cs->entries[src->index];
+  if (GST_CLOCK_TIME_IS_VALID (segment->stop) &&
+      ENTRY_DTS (entry) >= segment->stop)
+    goto eos;
+
+  data = src->cache->data + ENTRY_OFFSET (entry);
+  hdrlen = ENTRY_HDRLEN (entry);
+  size = ENTRY_SIZE (entry);
+  buf = gst_buffer_new ();
+
+  /* the header is copied so that we can give it our own ssrc, seqnum and
+   * timestamp, the payload is shared with the mapping of the cache */
+  header = gst_allocator_alloc (NULL, hdrlen, NULL);
+  gst_memory_map (header, &map, GST_MAP_WRITE);
+  memcpy (map.data, data, hdrlen);
+  map.data[1] = (map.data[1] & 0x80) | (src->pt & 0x7f);
+  src->timestamp = src->ts_base + (ENTRY_RTPTIME (entry) -
+      ENTRY_RTPTIME (&cs->entries[0]));
+  GST_WRITE_UINT16_BE (map.data + 2, src->seqnum);
+  GST_WRITE_UINT32_BE (map.data + 4, src->timestamp);
+  GST_WRITE_UINT32_BE (map.data + 8, src->current_ssrc);
+  gst_memory_unmap (header, &map);
+  gst_buffer_append_memory (buf, header);
+
+  if (size > hdrlen) {
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) (data + hdrlen), size - hdrlen, 0, size - hdrlen,
+            g_mapped_file_ref (src->cache->file),
+            (GDestroyNotify) g_mapped_file_unref));
+  }
+
+  GST_BUFFER_PTS (buf) = ENTRY_PTS (entry);
+  if (!(ENTRY_FLAGS (entry) & ENTRY_FLAG_KEYFRAME))
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  if (src->discont) {
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    src->discont = FALSE;
+  }
+
+  src->seqnum++;
+  src->index++;
+  GST_OBJECT_UNLOCK (src);
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+eos:
+  {
+    GST_OBJECT_UNLOCK (src);
+    GST_DEBUG_OBJECT (src, "end of stream");
+    return GST_FLOW_EOS;
+  }
+}
+
+/* Make an element that replays @stream of @cache and behaves as its
+ * payloader. */
+GstElement *
+gst_rtsp_packet_cache_create_src (GstRTSPPacketCache * cache, guint stream,
+    const gchar * name)
+{
+  GstRTSPPacketCacheSrc *src;
+  gint pt;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (stream < cache->n_streams, NULL);
+
+  src = g_object_new (GST_TYPE_RTSP_PACKET_CACHE_SRC, "name", name, NULL);
+  src->cache = gst_rtsp_packet_cache_ref (cache);
+  src->stream = stream;
+
+  if (gst_structure_get_int (gst_caps_get_structure (cache->streams[stream].
+              caps, 0), "payload", &pt))
+    src->pt = pt;
+
+  return GST_ELEMENT_CAST (src);
+}
@@ -0,0 +1,61 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSP_PACKET_CACHE_H__
+#define __GST_RTSP_PACKET_CACHE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstRTSPPacketCache GstRTSPPacketCache;
+typedef struct _GstRTSPPacketCacheWriter GstRTSPPacketCacheWriter;
+
+/* writing a cache */
+GstRTSPPacketCacheWriter * gst_rtsp_packet_cache_writer_new    (const gchar * path);
+
+void                       gst_rtsp_packet_cache_writer_free   (GstRTSPPacketCacheWriter * writer);
+
+guint                      gst_rtsp_packet_cache_writer_add_stream (GstRTSPPacketCacheWriter * writer);
+
+void                       gst_rtsp_packet_cache_writer_add_packet (GstRTSPPacketCacheWriter * writer,
+                                                                    guint stream, GstCaps * caps,
+                                                                    GstBuffer * buffer,
+                                                                    GstClockTime pts,
+                                                                    GstClockTime dts,
+                                                                    gboolean keyframe);
+
+gboolean                   gst_rtsp_packet_cache_writer_finish (GstRTSPPacketCacheWriter * writer,
+                                                                GstClockTime duration);
+
+/* reading a cache */
+GstRTSPPacketCache *       gst_rtsp_packet_cache_open          (const gchar * path);
+
+GstRTSPPacketCache *       gst_rtsp_packet_cache_ref           (GstRTSPPacketCache * cache);
+
+void                       gst_rtsp_packet_cache_unref         (GstRTSPPacketCache * cache);
+
+guint                      gst_rtsp_packet_cache_n_streams     (GstRTSPPacketCache * cache);
+
+GstElement *               gst_rtsp_packet_cache_create_src    (GstRTSPPacketCache * cache,
+                                                                guint stream, const gchar * name);
+
+G_END_DECLS
+
+#endif /* __GST_RTSP_PACKET_CACHE_H__ */
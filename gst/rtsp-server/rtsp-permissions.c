@@ -44,14 +44,36 @@
 
 #include "rtsp-permissions.h"
 
+/* the maximum number of different permissions that can be compiled */
+#define MAX_COMPILED_PERMISSIONS 64
+
+typedef struct
+{
+  GQuark role;
+  guint64 allowed;              /* bit n is set when perms[n] is allowed */
+} CompiledRole;
+
 typedef struct _GstRTSPPermissionsImpl
 {
   GstRTSPPermissions permissions;
 
   /* Roles, array of GstStructure */
   GPtrArray *roles;
+
+  /* the roles compiled to bitmasks of allowed permissions, made again after
+   * each change of the roles. Not compiled when there are too many different
+   * permissions */
+  gboolean compiled;
+  GArray *compiled_roles;       /* array of CompiledRole */
+  GArray *perms;                /* array of GQuark, the permission of each bit */
 } GstRTSPPermissionsImpl;
 
+typedef struct
+{
+  GArray *perms;
+  CompiledRole role;
+} CompileData;
+
 static void
 free_structure (GstStructure * structure)
 {
@@ -64,6 +86,68 @@ free_structure (GstStructure * structure)
 
 GST_DEFINE_MINI_OBJECT_TYPE (GstRTSPPermissions, gst_rtsp_permissions);
 
+static gint
+permission_bit (GArray * perms, GQuark permission)
+{
+  guint i;
+
+  for (i = 0; i < perms->len; i++) {
+    if (g_array_index (perms, GQuark, i) == permission)
+      return i;
+  }
+  return -1;
+}
+
+static gboolean
+compile_permission (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  CompileData *data = user_data;
+  gint bit;
+
+  /* only booleans that are TRUE allow something */
+  if (!G_VALUE_HOLDS_BOOLEAN (value) || !g_value_get_boolean (value))
+    return TRUE;
+
+  if ((bit = permission_bit (data->perms, field_id)) < 0) {
+    if (data->perms->len == MAX_COMPILED_PERMISSIONS)
+      return FALSE;
+
+    bit = data->perms->len;
+    g_array_append_val (data->perms, field_id);
+  }
+  data->role.allowed |= G_GUINT64_CONSTANT (1) << bit;
+
+  return TRUE;
+}
+
+/* make the bitmasks of the roles again, must be called after each change of
+ * the roles */
+static void
+compile_roles (GstRTSPPermissionsImpl * impl)
+{
+  CompileData data;
+  guint i;
+
+  g_array_set_size (impl->compiled_roles, 0);
+  g_array_set_size (impl->perms, 0);
+  impl->compiled = TRUE;
+
+  data.perms = impl->perms;
+  for (i = 0; i < impl->roles->len; i++) {
+    GstStructure *entry = g_ptr_array_index (impl->roles, i);
+
+    data.role.role = gst_structure_get_name_id (entry);
+    data.role.allowed = 0;
+
+    if (!gst_structure_foreach (entry, compile_permission, &data)) {
+      /* too many permissions, use the structures */
+      impl->compiled = FALSE;
+      return;
+    }
+    g_array_append_val (impl->compiled_roles, data.role);
+  }
+}
+
 static void gst_rtsp_permissions_init (GstRTSPPermissionsImpl * permissions);
 
 static void
@@ -72,6 +156,8 @@ _gst_rtsp_permissions_free (GstRTSPPermissions * permissions)
   GstRTSPPermissionsImpl *impl = (GstRTSPPermissionsImpl *) permissions;
 
   g_ptr_array_free (impl->roles, TRUE);
+  g_array_free (impl->compiled_roles, TRUE);
+  g_array_free (impl->perms, TRUE);
 
   g_slice_free1 (sizeof (GstRTSPPermissionsImpl), permissions);
 }
@@ -92,6 +178,7 @@ _gst_rtsp_permissions_copy (GstRTSPPermissionsImpl * permissions)
         &copy->permissions.mini_object.refcount);
     g_ptr_array_add (copy->roles, entry_copy);
   }
+  compile_roles (copy);
 
   return GST_RTSP_PERMISSIONS (copy);
 }
@@ -106,6 +193,9 @@ gst_rtsp_permissions_init (GstRTSPPermissionsImpl * permissions)
 
   permissions->roles =
       g_ptr_array_new_with_free_func ((GDestroyNotify) free_structure);
+  permissions->compiled = TRUE;
+  permissions->compiled_roles = g_array_new (FALSE, FALSE, sizeof (CompiledRole));
+  permissions->perms = g_array_new (FALSE, FALSE, sizeof (GQuark));
 }
 
 static void
@@ -128,6 +218,8 @@ add_role_from_structure (GstRTSPPermissionsImpl * impl,
   gst_structure_set_parent_refcount (structure,
       &impl->permissions.mini_object.refcount);
   g_ptr_array_add (impl->roles, structure);
+
+  compile_roles (impl);
 }
 
 /**
@@ -177,6 +269,7 @@ gst_rtsp_permissions_add_permission_for_role (GstRTSPPermissions * permissions,
 
     if (gst_structure_has_name (entry, role)) {
       gst_structure_set (entry, permission, G_TYPE_BOOLEAN, allowed, NULL);
+      compile_roles (impl);
       return;
     }
   }
@@ -302,6 +395,7 @@ gst_rtsp_permissions_remove_role (GstRTSPPermissions * permissions,
 
     if (gst_structure_has_name (entry, role)) {
       g_ptr_array_remove_index_fast (impl->roles, i);
+      compile_roles (impl);
       break;
     }
   }
@@ -351,19 +445,67 @@ gboolean
 gst_rtsp_permissions_is_allowed (GstRTSPPermissions * permissions,
     const gchar * role, const gchar * permission)
 {
-  const GstStructure *str;
-  gboolean result;
-
   g_return_val_if_fail (GST_IS_RTSP_PERMISSIONS (permissions), FALSE);
   g_return_val_if_fail (role != NULL, FALSE);
   g_return_val_if_fail (permission != NULL, FALSE);
 
-  str = gst_rtsp_permissions_get_role (permissions, role);
+  /* roles and permissions are quarks in the structures, when there is no
+   * quark for them they are not in @permissions */
+  return gst_rtsp_permissions_is_allowed_id (permissions,
+      g_quark_try_string (role), g_quark_try_string (permission));
+}
+
+/**
+ * gst_rtsp_permissions_is_allowed_id:
+ * @permissions: a #GstRTSPPermissions
+ * @role: the quark of a role
+ * @permission: the quark of a permission
+ *
+ * Check if @role in @permissions is given permission for @permission, like
+ * gst_rtsp_permissions_is_allowed() but with quarks for @role and
+ * @permission.
+ *
+ * Returns: %TRUE if @role is allowed @permission.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_permissions_is_allowed_id (GstRTSPPermissions * permissions,
+    GQuark role, GQuark permission)
+{
+  GstRTSPPermissionsImpl *impl = (GstRTSPPermissionsImpl *) permissions;
+  const GstStructure *str;
+  const GValue *value;
+  gint bit;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_RTSP_PERMISSIONS (permissions), FALSE);
+
+  if (role == 0 || permission == 0)
+    return FALSE;
+
+  if (impl->compiled) {
+    /* not allowed for any role */
+    if ((bit = permission_bit (impl->perms, permission)) < 0)
+      return FALSE;
+
+    for (i = 0; i < impl->compiled_roles->len; i++) {
+      CompiledRole *entry = &g_array_index (impl->compiled_roles,
+          CompiledRole, i);
+
+      if (entry->role == role)
+        return (entry->allowed & (G_GUINT64_CONSTANT (1) << bit)) != 0;
+    }
+    return FALSE;
+  }
+
+  str = gst_rtsp_permissions_get_role (permissions, g_quark_to_string (role));
   if (str == NULL)
     return FALSE;
 
-  if (!gst_structure_get_boolean (str, permission, &result))
-    result = FALSE;
+  value = gst_structure_id_get_value (str, permission);
+  if (value == NULL || !G_VALUE_HOLDS_BOOLEAN (value))
+    return FALSE;
 
-  return result;
+  return g_value_get_boolean (value);
 }
@@ -113,6 +113,10 @@ GST_RTSP_SERVER_API
 gboolean              gst_rtsp_permissions_is_allowed      (GstRTSPPermissions *permissions,
                                                             const gchar *role, const gchar *permission);
 
+GST_RTSP_SERVER_API
+gboolean              gst_rtsp_permissions_is_allowed_id   (GstRTSPPermissions *permissions,
+                                                            GQuark role, GQuark permission);
+
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstRTSPPermissions, gst_rtsp_permissions_unref)
 #endif
@@ -0,0 +1,59 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSP_SERVER_INTERNAL_H__
+#define __GST_RTSP_SERVER_INTERNAL_H__
+
+#include <glib.h>
+
+#include "rtsp-client.h"
+#include "rtsp-stream-transport.h"
+#include "rtsp-thread-pool.h"
+#include "rtsp-tunnels.h"
+
+G_BEGIN_DECLS
+
+/* the thread that runs the main context of the client, set by the server
+ * before the client is attached */
+void                   gst_rtsp_client_set_thread             (GstRTSPClient * client,
+                                                               GstRTSPThread * thread);
+
+GstRTSPThread *        gst_rtsp_client_get_thread             (GstRTSPClient * client);
+
+/* the pending HTTP tunnels the tunnels of the client are paired in, set by
+ * the server before the client is attached */
+void                   gst_rtsp_client_set_tunnels            (GstRTSPClient * client,
+                                                               GstRTSPTunnels * tunnels);
+
+/* the RTP-Info of the cached GOP that is sent to @trans first when it is
+ * added to @stream. The GOP is kept on @trans until then */
+gboolean               gst_rtsp_stream_get_burst_rtpinfo      (GstRTSPStream * stream,
+                                                               GstRTSPStreamTransport * trans,
+                                                               guint * rtptime,
+                                                               guint * seq,
+                                                               GstClockTime * running_time);
+
+void                   gst_rtsp_stream_transport_set_burst    (GstRTSPStreamTransport * trans,
+                                                               GstBufferList * burst);
+
+GstBufferList *        gst_rtsp_stream_transport_take_burst   (GstRTSPStreamTransport * trans);
+
+G_END_DECLS
+
+#endif /* __GST_RTSP_SERVER_INTERNAL_H__ */
@@ -120,6 +120,54 @@ gint                  gst_rtsp_server_get_backlog          (GstRTSPServer *serve
 GST_RTSP_SERVER_API
 int                   gst_rtsp_server_get_bound_port       (GstRTSPServer *server);
 
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_n_acceptors      (GstRTSPServer *server, guint n_acceptors);
+
+GST_RTSP_SERVER_API
+guint                 gst_rtsp_server_get_n_acceptors      (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_cpu_steering     (GstRTSPServer *server, gboolean steering);
+
+GST_RTSP_SERVER_API
+gboolean              gst_rtsp_server_get_cpu_steering     (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_max_connections  (GstRTSPServer *server, gint max_connections);
+
+GST_RTSP_SERVER_API
+gint                  gst_rtsp_server_get_max_connections  (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_max_pending_connections (GstRTSPServer *server, gint max_pending);
+
+GST_RTSP_SERVER_API
+gint                  gst_rtsp_server_get_max_pending_connections (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_connection_rate  (GstRTSPServer *server, gdouble rate, guint burst);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_get_connection_rate  (GstRTSPServer *server, gdouble *rate, guint *burst);
+
+GST_RTSP_SERVER_API
+GstStructure *        gst_rtsp_server_get_admission_stats  (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_max_pending_tunnels (GstRTSPServer *server, gint max_pending);
+
+GST_RTSP_SERVER_API
+gint                  gst_rtsp_server_get_max_pending_tunnels (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+void                  gst_rtsp_server_set_tunnel_timeout   (GstRTSPServer *server, GstClockTime timeout);
+
+GST_RTSP_SERVER_API
+GstClockTime          gst_rtsp_server_get_tunnel_timeout   (GstRTSPServer *server);
+
+GST_RTSP_SERVER_API
+GstStructure *        gst_rtsp_server_get_tunnel_stats     (GstRTSPServer *server);
+
 GST_RTSP_SERVER_API
 void                  gst_rtsp_server_set_session_pool     (GstRTSPServer *server, GstRTSPSessionPool *pool);
 
@@ -41,6 +41,26 @@
  * gst_rtsp_server_transfer_connection() can be used to transfer an existing
  * socket to the RTSP server, for example from an HTTP server.
  *
+ * With gst_rtsp_server_set_n_acceptors() the server listens on the port with
+ * multiple sockets, using SO_REUSEPORT where available. The additional
+ * sockets accept connections on threads of the #GstRTSPThreadPool and the
+ * clients they accept are handled on that same thread.
+ *
+ * New connections are checked before a client is made for them. With
+ * gst_rtsp_server_set_max_connections(),
+ * gst_rtsp_server_set_max_pending_connections() and
+ * gst_rtsp_server_set_connection_rate() the server refuses connections when
+ * it has too many clients, when too many clients did not complete their first
+ * request yet or when a source address connects too fast. The refused
+ * connections are closed right away and counted in the stats returned by
+ * gst_rtsp_server_get_admission_stats().
+ *
+ * RTSP-over-HTTP clients open a GET and a POST connection with the same
+ * tunnelid, the first one waits for the other in the tunnels of the server.
+ * gst_rtsp_server_set_max_pending_tunnels() and
+ * gst_rtsp_server_set_tunnel_timeout() limit the waiting tunnels, see
+ * gst_rtsp_server_get_tunnel_stats().
+ *
  * Once the server socket is attached to a mainloop, it will start accepting
  * connections. When a new connection is received, a new #GstRTSPClient object
  * is created to handle the connection. The new client will be configured with
@@ -56,11 +76,20 @@
 #include "config.h"
 #endif
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <gio/gnetworking.h>
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+#include "rtsp-admission.h"
+#include "rtsp-tunnels.h"
 #include "rtsp-context.h"
 #include "rtsp-server-object.h"
+#include "rtsp-server-internal.h"
 #include "rtsp-client.h"
 
 #define GST_RTSP_SERVER_GET_LOCK(server)  (&(GST_RTSP_SERVER_CAST(server)->priv->lock))
@@ -78,6 +107,17 @@ struct _GstRTSPServerPrivate
 
   GSocket *socket;
 
+  /* additional listening sockets, the GSource of each */
+  guint n_acceptors;
+  gboolean cpu_steering;
+
+  /* checks new connections */
+  GstRTSPAdmission *admission;
+  GList *acceptors;
+
+  /* the HTTP tunnels of the clients that wait for their other half */
+  GstRTSPTunnels *tunnels;
+
   /* sessions on this server */
   GstRTSPSessionPool *session_pool;
 
@@ -103,6 +143,12 @@ struct _GstRTSPServerPrivate
 /* #define DEFAULT_ADDRESS         "::0" */
 #define DEFAULT_SERVICE         "8554"
 #define DEFAULT_BACKLOG         5
+#define DEFAULT_N_ACCEPTORS     1
+#define DEFAULT_CPU_STEERING    FALSE
+#define DEFAULT_MAX_CONNECTIONS -1
+#define DEFAULT_MAX_PENDING_CONNECTIONS -1
+#define DEFAULT_CONNECTION_RATE 0.0
+#define DEFAULT_CONNECTION_BURST 1
 
 /* Define to use the SO_LINGER option so that the server sockets can be resused
  * sooner. Disabled for now because it is not very well implemented by various
@@ -116,6 +162,12 @@ enum
   PROP_SERVICE,
   PROP_BOUND_PORT,
   PROP_BACKLOG,
+  PROP_N_ACCEPTORS,
+  PROP_CPU_STEERING,
+  PROP_MAX_CONNECTIONS,
+  PROP_MAX_PENDING_CONNECTIONS,
+  PROP_CONNECTION_RATE,
+  PROP_CONNECTION_BURST,
 
   PROP_SESSION_POOL,
   PROP_MOUNT_POINTS,
@@ -203,6 +255,80 @@ gst_rtsp_server_class_init (GstRTSPServerClass * klass)
           "The maximum length to which the queue "
           "of pending connections may grow", 0, G_MAXINT, DEFAULT_BACKLOG,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPServer::n-acceptors:
+   *
+   * The number of sockets listening on the port of the server. See
+   * gst_rtsp_server_set_n_acceptors().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_N_ACCEPTORS,
+      g_param_spec_uint ("n-acceptors", "Acceptors",
+          "The number of sockets listening on the port", 1, G_MAXUINT16,
+          DEFAULT_N_ACCEPTORS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPServer::cpu-steering:
+   *
+   * Steer new connections to the acceptor that matches the CPU that
+   * received them. See gst_rtsp_server_set_cpu_steering().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_CPU_STEERING,
+      g_param_spec_boolean ("cpu-steering", "CPU Steering",
+          "Steer new connections to an acceptor by the receiving CPU",
+          DEFAULT_CPU_STEERING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPServer::max-connections:
+   *
+   * The maximum number of connections, -1 for no maximum. See
+   * gst_rtsp_server_set_max_connections().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_CONNECTIONS,
+      g_param_spec_int ("max-connections", "Max Connections",
+          "The maximum number of connections (-1 = unlimited)", -1, G_MAXINT,
+          DEFAULT_MAX_CONNECTIONS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPServer::max-pending-connections:
+   *
+   * The maximum number of connections without a completed request, -1 for no
+   * maximum. See gst_rtsp_server_set_max_pending_connections().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_PENDING_CONNECTIONS,
+      g_param_spec_int ("max-pending-connections", "Max Pending Connections",
+          "The maximum number of connections without a completed request "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_MAX_PENDING_CONNECTIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPServer::connection-rate:
+   *
+   * The number of connections per second allowed from a source address, 0 for
+   * no limit. See gst_rtsp_server_set_connection_rate().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_CONNECTION_RATE,
+      g_param_spec_double ("connection-rate", "Connection Rate",
+          "The connections per second allowed from a source address "
+          "(0 = unlimited)", 0.0, G_MAXDOUBLE, DEFAULT_CONNECTION_RATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRTSPServer::connection-burst:
+   *
+   * The number of connections a source address can make at once. See
+   * gst_rtsp_server_set_connection_rate().
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_CONNECTION_BURST,
+      g_param_spec_uint ("connection-burst", "Connection Burst",
+          "The connections a source address can make at once", 1, G_MAXUINT,
+          DEFAULT_CONNECTION_BURST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   /**
    * GstRTSPServer::session-pool:
    *
@@ -263,6 +389,16 @@ gst_rtsp_server_init (GstRTSPServer * server)
   priv->service = g_strdup (DEFAULT_SERVICE);
   priv->socket = NULL;
   priv->backlog = DEFAULT_BACKLOG;
+  priv->n_acceptors = DEFAULT_N_ACCEPTORS;
+  priv->cpu_steering = DEFAULT_CPU_STEERING;
+  priv->admission = gst_rtsp_admission_new ();
+  gst_rtsp_admission_set_max_connections (priv->admission,
+      DEFAULT_MAX_CONNECTIONS);
+  gst_rtsp_admission_set_max_pending (priv->admission,
+      DEFAULT_MAX_PENDING_CONNECTIONS);
+  gst_rtsp_admission_set_rate (priv->admission, DEFAULT_CONNECTION_RATE,
+      DEFAULT_CONNECTION_BURST);
+  priv->tunnels = gst_rtsp_tunnels_new ();
   priv->session_pool = gst_rtsp_session_pool_new ();
   priv->mount_points = gst_rtsp_mount_points_new ();
   priv->content_length_limit = G_MAXUINT;
@@ -293,6 +429,9 @@ gst_rtsp_server_finalize (GObject * object)
   if (priv->auth)
     g_object_unref (priv->auth);
 
+  gst_rtsp_admission_free (priv->admission);
+  gst_rtsp_tunnels_unref (priv->tunnels);
+
   g_mutex_clear (&priv->lock);
 
   G_OBJECT_CLASS (gst_rtsp_server_parent_class)->finalize (object);
@@ -503,6 +642,366 @@ gst_rtsp_server_get_backlog (GstRTSPServer * server)
   return result;
 }
 
+/**
+ * gst_rtsp_server_set_n_acceptors:
+ * @server: a #GstRTSPServer
+ * @n_acceptors: the number of acceptors
+ *
+ * Configure @server to listen on its port with @n_acceptors sockets. The
+ * sockets share the port with SO_REUSEPORT and the kernel distributes the
+ * new connections over them.
+ *
+ * The first socket is the one of the #GSource made by
+ * gst_rtsp_server_create_source(). The others are attached to threads of the
+ * #GstRTSPThreadPool of @server, which should allow at least
+ * @n_acceptors - 1 threads, and the clients they accept are handled on the
+ * thread that accepted them.
+ *
+ * This function must be called before the server is bound.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_n_acceptors (GstRTSPServer * server, guint n_acceptors)
+{
+  GstRTSPServerPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+  g_return_if_fail (n_acceptors > 0);
+
+  priv = server->priv;
+
+  GST_RTSP_SERVER_LOCK (server);
+  priv->n_acceptors = n_acceptors;
+  GST_RTSP_SERVER_UNLOCK (server);
+}
+
+/**
+ * gst_rtsp_server_get_n_acceptors:
+ * @server: a #GstRTSPServer
+ *
+ * Get the number of sockets listening on the port of @server.
+ *
+ * Returns: the number of acceptors.
+ *
+ * Since: 1.18
+ */
+guint
+gst_rtsp_server_get_n_acceptors (GstRTSPServer * server)
+{
+  GstRTSPServerPrivate *priv;
+  guint result;
+
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), 0);
+
+  priv = server->priv;
+
+  GST_RTSP_SERVER_LOCK (server);
+  result = priv->n_acceptors;
+  GST_RTSP_SERVER_UNLOCK (server);
+
+  return result;
+}
+
+/**
+ * gst_rtsp_server_set_cpu_steering:
+ * @server: a #GstRTSPServer
+ * @steering: if new connections should be steered by CPU
+ *
+ * When @steering is %TRUE and @server has more than one acceptor, a new
+ * connection is accepted by the acceptor with the index of the CPU that
+ * received it, modulo the number of acceptors, instead of by the hash of
+ * the connection. This is only supported on Linux and is most effective when
+ * the threads of the acceptors run on the matching CPUs.
+ *
+ * This function must be called before the server is bound.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_cpu_steering (GstRTSPServer * server, gboolean steering)
+{
+  GstRTSPServerPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+
+  priv = server->priv;
+
+  GST_RTSP_SERVER_LOCK (server);
+  priv->cpu_steering = steering;
+  GST_RTSP_SERVER_UNLOCK (server);
+}
+
+/**
+ * gst_rtsp_server_get_cpu_steering:
+ * @server: a #GstRTSPServer
+ *
+ * Check if @server steers new connections to its acceptors by CPU.
+ *
+ * Returns: %TRUE when new connections are steered by CPU.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_server_get_cpu_steering (GstRTSPServer * server)
+{
+  GstRTSPServerPrivate *priv;
+  gboolean result;
+
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), FALSE);
+
+  priv = server->priv;
+
+  GST_RTSP_SERVER_LOCK (server);
+  result = priv->cpu_steering;
+  GST_RTSP_SERVER_UNLOCK (server);
+
+  return result;
+}
+
+/**
+ * gst_rtsp_server_set_max_connections:
+ * @server: a #GstRTSPServer
+ * @max_connections: the maximum number of connections
+ *
+ * Configure @server to refuse new connections while it handles
+ * @max_connections connections. A value of -1 doesn't limit the connections.
+ * The connections given to gst_rtsp_server_transfer_connection() are not
+ * counted.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_max_connections (GstRTSPServer * server,
+    gint max_connections)
+{
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+
+  gst_rtsp_admission_set_max_connections (server->priv->admission,
+      max_connections);
+}
+
+/**
+ * gst_rtsp_server_get_max_connections:
+ * @server: a #GstRTSPServer
+ *
+ * Get the maximum number of connections of @server.
+ *
+ * Returns: the maximum number of connections.
+ *
+ * Since: 1.18
+ */
+gint
+gst_rtsp_server_get_max_connections (GstRTSPServer * server)
+{
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), -1);
+
+  return gst_rtsp_admission_get_max_connections (server->priv->admission);
+}
+
+/**
+ * gst_rtsp_server_set_max_pending_connections:
+ * @server: a #GstRTSPServer
+ * @max_pending: the maximum number of pending connections
+ *
+ * Configure @server to refuse new connections while @max_pending
+ * connections did not complete their first request. A value of -1 doesn't
+ * limit the pending connections.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_max_pending_connections (GstRTSPServer * server,
+    gint max_pending)
+{
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+
+  gst_rtsp_admission_set_max_pending (server->priv->admission, max_pending);
+}
+
+/**
+ * gst_rtsp_server_get_max_pending_connections:
+ * @server: a #GstRTSPServer
+ *
+ * Get the maximum number of pending connections of @server.
+ *
+ * Returns: the maximum number of pending connections.
+ *
+ * Since: 1.18
+ */
+gint
+gst_rtsp_server_get_max_pending_connections (GstRTSPServer * server)
+{
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), -1);
+
+  return gst_rtsp_admission_get_max_pending (server->priv->admission);
+}
+
+/**
+ * gst_rtsp_server_set_connection_rate:
+ * @server: a #GstRTSPServer
+ * @rate: the connections per second
+ * @burst: the connections at once
+ *
+ * Limit the connections from a source address to @rate connections per
+ * second, with bursts of up to @burst connections. Connections over the limit
+ * are refused. IPv6 addresses are limited by their /64 prefix. A @rate of 0
+ * doesn't limit the connections.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_connection_rate (GstRTSPServer * server, gdouble rate,
+    guint burst)
+{
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+  g_return_if_fail (rate >= 0.0);
+
+  gst_rtsp_admission_set_rate (server->priv->admission, rate, burst);
+}
+
+/**
+ * gst_rtsp_server_get_connection_rate:
+ * @server: a #GstRTSPServer
+ * @rate: (out) (optional): the connections per second
+ * @burst: (out) (optional): the connections at once
+ *
+ * Get the connection rate limit of a source address of @server.
+ * See gst_rtsp_server_set_connection_rate().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_get_connection_rate (GstRTSPServer * server, gdouble * rate,
+    guint * burst)
+{
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+
+  gst_rtsp_admission_get_rate (server->priv->admission, rate, burst);
+}
+
+/**
+ * gst_rtsp_server_get_admission_stats:
+ * @server: a #GstRTSPServer
+ *
+ * Get the counters of the admission of new connections of @server. The
+ * result has the "connections" and "pending" fields for the current number
+ * of connections and connections without a completed request, the
+ * "accepted" field for the accepted connections and the "rejected-rate",
+ * "rejected-connections" and "rejected-pending" fields for the connections
+ * refused for each reason.
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
+ *
+ * Since: 1.18
+ */
+GstStructure *
+gst_rtsp_server_get_admission_stats (GstRTSPServer * server)
+{
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), NULL);
+
+  return gst_rtsp_admission_get_stats (server->priv->admission);
+}
+
+/**
+ * gst_rtsp_server_set_max_pending_tunnels:
+ * @server: a #GstRTSPServer
+ * @max_pending: the maximum number of pending tunnels
+ *
+ * Configure @server to refuse new RTSP-over-HTTP tunnels while
+ * @max_pending tunnels wait for their other half. The default is 1024, a
+ * value of -1 doesn't limit the pending tunnels.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_max_pending_tunnels (GstRTSPServer * server,
+    gint max_pending)
+{
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+
+  gst_rtsp_tunnels_set_max_pending (server->priv->tunnels, max_pending);
+}
+
+/**
+ * gst_rtsp_server_get_max_pending_tunnels:
+ * @server: a #GstRTSPServer
+ *
+ * Get the maximum number of pending tunnels of @server.
+ *
+ * Returns: the maximum number of pending tunnels.
+ *
+ * Since: 1.18
+ */
+gint
+gst_rtsp_server_get_max_pending_tunnels (GstRTSPServer * server)
+{
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), -1);
+
+  return gst_rtsp_tunnels_get_max_pending (server->priv->tunnels);
+}
+
+/**
+ * gst_rtsp_server_set_tunnel_timeout:
+ * @server: a #GstRTSPServer
+ * @timeout: the timeout of pending tunnels
+ *
+ * Configure how long an RTSP-over-HTTP tunnel of @server waits for its other
+ * half. Tunnels that wait longer are forgotten and their client is closed
+ * when the next tunnel is added, their other half is refused. The default is
+ * 2 minutes, #GST_CLOCK_TIME_NONE doesn't forget pending tunnels.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_server_set_tunnel_timeout (GstRTSPServer * server,
+    GstClockTime timeout)
+{
+  g_return_if_fail (GST_IS_RTSP_SERVER (server));
+
+  gst_rtsp_tunnels_set_timeout (server->priv->tunnels, timeout);
+}
+
+/**
+ * gst_rtsp_server_get_tunnel_timeout:
+ * @server: a #GstRTSPServer
+ *
+ * Get the timeout of the pending tunnels of @server.
+ *
+ * Returns: the timeout of pending tunnels.
+ *
+ * Since: 1.18
+ */
+GstClockTime
+gst_rtsp_server_get_tunnel_timeout (GstRTSPServer * server)
+{
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), GST_CLOCK_TIME_NONE);
+
+  return gst_rtsp_tunnels_get_timeout (server->priv->tunnels);
+}
+
+/**
+ * gst_rtsp_server_get_tunnel_stats:
+ * @server: a #GstRTSPServer
+ *
+ * Get the counters of the RTSP-over-HTTP tunnels of @server. The result has
+ * the "pending" field for the tunnels that wait for their other half, the
+ * "merged" field for the tunnels that were completed, the "expired" field for
+ * the tunnels that waited too long and the "rejected" field for the tunnels
+ * refused because of a duplicate tunnelid or too many pending tunnels.
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
+ *
+ * Since: 1.18
+ */
+GstStructure *
+gst_rtsp_server_get_tunnel_stats (GstRTSPServer * server)
+{
+  g_return_val_if_fail (GST_IS_RTSP_SERVER (server), NULL);
+
+  return gst_rtsp_tunnels_get_stats (server->priv->tunnels);
+}
+
 /**
  * gst_rtsp_server_set_session_pool:
  * @server: a #GstRTSPServer
@@ -788,6 +1287,8 @@ gst_rtsp_server_get_property (GObject * object, guint propid,
     GValue * value, GParamSpec * pspec)
 {
   GstRTSPServer *server = GST_RTSP_SERVER (object);
+  gdouble rate;
+  guint burst;
 
   switch (propid) {
     case PROP_ADDRESS:
@@ -802,6 +1303,27 @@ gst_rtsp_server_get_property (GObject * object, guint propid,
     case PROP_BACKLOG:
       g_value_set_int (value, gst_rtsp_server_get_backlog (server));
       break;
+    case PROP_N_ACCEPTORS:
+      g_value_set_uint (value, gst_rtsp_server_get_n_acceptors (server));
+      break;
+    case PROP_CPU_STEERING:
+      g_value_set_boolean (value, gst_rtsp_server_get_cpu_steering (server));
+      break;
+    case PROP_MAX_CONNECTIONS:
+      g_value_set_int (value, gst_rtsp_server_get_max_connections (server));
+      break;
+    case PROP_MAX_PENDING_CONNECTIONS:
+      g_value_set_int (value,
+          gst_rtsp_server_get_max_pending_connections (server));
+      break;
+    case PROP_CONNECTION_RATE:
+      gst_rtsp_server_get_connection_rate (server, &rate, NULL);
+      g_value_set_double (value, rate);
+      break;
+    case PROP_CONNECTION_BURST:
+      gst_rtsp_server_get_connection_rate (server, NULL, &burst);
+      g_value_set_uint (value, burst);
+      break;
     case PROP_SESSION_POOL:
       g_value_take_object (value, gst_rtsp_server_get_session_pool (server));
       break;
@@ -822,6 +1344,8 @@ gst_rtsp_server_set_property (GObject * object, guint propid,
     const GValue * value, GParamSpec * pspec)
 {
   GstRTSPServer *server = GST_RTSP_SERVER (object);
+  gdouble rate;
+  guint burst;
 
   switch (propid) {
     case PROP_ADDRESS:
@@ -833,6 +1357,29 @@ gst_rtsp_server_set_property (GObject * object, guint propid,
     case PROP_BACKLOG:
       gst_rtsp_server_set_backlog (server, g_value_get_int (value));
       break;
+    case PROP_N_ACCEPTORS:
+      gst_rtsp_server_set_n_acceptors (server, g_value_get_uint (value));
+      break;
+    case PROP_CPU_STEERING:
+      gst_rtsp_server_set_cpu_steering (server, g_value_get_boolean (value));
+      break;
+    case PROP_MAX_CONNECTIONS:
+      gst_rtsp_server_set_max_connections (server, g_value_get_int (value));
+      break;
+    case PROP_MAX_PENDING_CONNECTIONS:
+      gst_rtsp_server_set_max_pending_connections (server,
+          g_value_get_int (value));
+      break;
+    case PROP_CONNECTION_RATE:
+      gst_rtsp_server_get_connection_rate (server, NULL, &burst);
+      gst_rtsp_server_set_connection_rate (server, g_value_get_double (value),
+          burst);
+      break;
+    case PROP_CONNECTION_BURST:
+      gst_rtsp_server_get_connection_rate (server, &rate, NULL);
+      gst_rtsp_server_set_connection_rate (server, rate,
+          g_value_get_uint (value));
+      break;
     case PROP_SESSION_POOL:
       gst_rtsp_server_set_session_pool (server, g_value_get_object (value));
       break;
@@ -922,6 +1469,20 @@ gst_rtsp_server_create_socket (GstRTSPServer * server,
       continue;
     }
 
+#ifdef SO_REUSEPORT
+    /* the acceptors all listen on the same port */
+    if (priv->n_acceptors > 1) {
+      GError *opt_error = NULL;
+
+      if (!g_socket_set_option (socket, SOL_SOCKET, SO_REUSEPORT, 1,
+              &opt_error)) {
+        GST_WARNING_OBJECT (server, "failed to set SO_REUSEPORT: %s",
+            opt_error->message);
+        g_clear_error (&opt_error);
+      }
+    }
+#endif
+
     if (g_socket_bind (socket, sockaddr, TRUE, bind_error ? NULL : &bind_error)) {
       /* ask what port the socket has been bound to */
       if (port == 0 || !strcmp (priv->service, "0")) {
@@ -1048,6 +1609,11 @@ struct _ClientContext
   GstRTSPServer *server;
   GstRTSPThread *thread;
   GstRTSPClient *client;
+
+  /* counted by the admission */
+  gboolean admitted;
+  gint pending;
+  gulong handshake_id;
 };
 
 static gboolean
@@ -1075,6 +1641,16 @@ unmanage_client (GstRTSPClient * client, ClientContext * ctx)
 
   GST_DEBUG_OBJECT (server, "unmanage client %p", client);
 
+  if (ctx->admitted) {
+    gboolean pending;
+
+    /* the handler is still connected while the handshake is pending */
+    pending = g_atomic_int_compare_and_exchange (&ctx->pending, TRUE, FALSE);
+    if (pending)
+      g_signal_handler_disconnect (client, ctx->handshake_id);
+    gst_rtsp_admission_release (priv->admission, pending);
+  }
+
   GST_RTSP_SERVER_LOCK (server);
   priv->clients = g_list_remove (priv->clients, ctx);
   priv->clients_cookie++;
@@ -1092,15 +1668,30 @@ unmanage_client (GstRTSPClient * client, ClientContext * ctx)
   }
 }
 
+/* the first message sent to an admitted client completes its handshake,
+ * the handler is not needed after that */
+static void
+client_handshake_done (GstRTSPClient * client, GstRTSPContext * ctx,
+    GstRTSPMessage * message, ClientContext * cctx)
+{
+  if (g_atomic_int_compare_and_exchange (&cctx->pending, TRUE, FALSE)) {
+    g_signal_handler_disconnect (client, cctx->handshake_id);
+    gst_rtsp_admission_handshake_done (cctx->server->priv->admission);
+  }
+}
+
 /* add the client context to the active list of clients, takes ownership
- * of client */
+ * of client. When @thread is not %NULL, the client is handled on @thread.
+ * @admitted when the connection of the client is counted by the admission */
 static void
-manage_client (GstRTSPServer * server, GstRTSPClient * client)
+manage_client (GstRTSPServer * server, GstRTSPClient * client,
+    GstRTSPThread * thread, gboolean admitted)
 {
   ClientContext *cctx;
   GstRTSPServerPrivate *priv = server->priv;
   GMainContext *mainctx = NULL;
   GstRTSPContext ctx = { NULL };
+  gchar *cpus;
 
   GST_DEBUG_OBJECT (server, "manage client %p", client);
 
@@ -1110,23 +1701,43 @@ manage_client (GstRTSPServer * server, GstRTSPClient * client)
   cctx = g_slice_new0 (ClientContext);
   cctx->server = g_object_ref (server);
   cctx->client = client;
+  if (admitted) {
+    cctx->admitted = TRUE;
+    cctx->pending = TRUE;
+    cctx->handshake_id = g_signal_connect (client, "send-message",
+        (GCallback) client_handshake_done, cctx);
+  }
 
   GST_RTSP_SERVER_LOCK (server);
 
   ctx.server = server;
   ctx.client = client;
 
-  cctx->thread = gst_rtsp_thread_pool_get_thread (priv->thread_pool,
-      GST_RTSP_THREAD_TYPE_CLIENT, &ctx);
-  if (cctx->thread)
+  /* a pool that pins its threads hands out the thread of the CPU that
+   * received the connection */
+  cpus = gst_rtsp_thread_pool_get_cpus (priv->thread_pool);
+  if (thread && cpus == NULL && gst_rtsp_thread_reuse (thread))
+    cctx->thread = thread;
+  else
+    cctx->thread = gst_rtsp_thread_pool_get_thread (priv->thread_pool,
+        GST_RTSP_THREAD_TYPE_CLIENT, &ctx);
+  g_free (cpus);
+
+  if (cctx->thread) {
     mainctx = cctx->thread->context;
-  else {
+    /* the client accounts its load in the thread */
+    gst_rtsp_client_set_thread (client, cctx->thread);
+  } else {
     GSource *source;
     /* find the context to add the watch */
     if ((source = g_main_current_source ()))
       mainctx = g_source_get_context (source);
   }
 
+  /* the HTTP tunnels of the client are paired with the ones of the other
+   * clients of this server */
+  gst_rtsp_client_set_tunnels (client, priv->tunnels);
+
   g_signal_connect (client, "closed", (GCallback) unmanage_client, cctx);
   priv->clients = g_list_prepend (priv->clients, cctx);
   priv->clients_cookie++;
@@ -1201,7 +1812,7 @@ gst_rtsp_server_transfer_connection (GstRTSPServer * server, GSocket * socket,
   gst_rtsp_client_set_connection (client, conn);
 
   /* manage the client connection */
-  manage_client (server, client);
+  manage_client (server, client, NULL, FALSE);
 
   return TRUE;
 
@@ -1222,20 +1833,106 @@ no_connection:
   }
 }
 
-/**
- * gst_rtsp_server_io_func:
- * @socket: a #GSocket
- * @condition: the condition on @source
- * @server: (transfer none): a #GstRTSPServer
- *
- * A default #GSocketSourceFunc that creates a new #GstRTSPClient to accept and handle a
- * new connection on @socket or @server.
- *
- * Returns: TRUE if the source could be connected, FALSE if an error occurred.
- */
-gboolean
-gst_rtsp_server_io_func (GSocket * socket, GIOCondition condition,
-    GstRTSPServer * server)
+/* accept a connection on @socket and check its admission before anything is
+ * made for it. A refused connection is closed right away and @conn is set to
+ * %NULL */
+static GstRTSPResult
+admit_connection (GstRTSPServer * server, GSocket * socket,
+    GstRTSPConnection ** conn)
+{
+  GstRTSPServerPrivate *priv = server->priv;
+  struct sockaddr_storage native;
+  socklen_t native_len = sizeof (native);
+  GstRTSPAdmissionResult result;
+  GInetSocketAddress *addr;
+  GSocket *client_sock;
+  const guint8 *bytes = NULL;
+  gsize size = 0;
+  GstRTSPResult res;
+  gchar *ip;
+  gint port;
+
+  *conn = NULL;
+
+  client_sock = g_socket_accept (socket, NULL, NULL);
+  if (client_sock == NULL)
+    return GST_RTSP_ESYS;
+
+  /* get the source address without making objects */
+  if (getpeername (g_socket_get_fd (client_sock),
+          (struct sockaddr *) &native, &native_len) < 0)
+    goto no_address;
+
+  if (native.ss_family == AF_INET) {
+    bytes = (const guint8 *) &((struct sockaddr_in *) &native)->sin_addr;
+    size = 4;
+  } else if (native.ss_family == AF_INET6) {
+    struct in6_addr *in6 = &((struct sockaddr_in6 *) &native)->sin6_addr;
+
+    bytes = (const guint8 *) in6;
+    size = 16;
+    /* an IPv4 client on an IPv6 socket */
+    if (IN6_IS_ADDR_V4MAPPED (in6)) {
+      bytes += 12;
+      size = 4;
+    }
+  }
+
+  result = gst_rtsp_admission_check (priv->admission, bytes, size);
+  if (result != GST_RTSP_ADMISSION_OK)
+    goto refused;
+
+  addr = (GInetSocketAddress *) g_socket_address_new_from_native (&native,
+      native_len);
+  if (addr == NULL)
+    goto no_inet_address;
+  if (!G_IS_INET_SOCKET_ADDRESS (addr)) {
+    g_object_unref (addr);
+    goto no_inet_address;
+  }
+
+  ip = g_inet_address_to_string (g_inet_socket_address_get_address (addr));
+  port = g_inet_socket_address_get_port (addr);
+  g_object_unref (addr);
+
+  res = gst_rtsp_connection_create_from_socket (client_sock, ip, port, NULL,
+      conn);
+  g_free (ip);
+  g_object_unref (client_sock);
+
+  if (res != GST_RTSP_OK)
+    gst_rtsp_admission_release (priv->admission, TRUE);
+
+  return res;
+
+  /* ERRORS */
+no_address:
+  {
+    GST_WARNING_OBJECT (server, "could not get address: %s",
+        g_strerror (errno));
+    g_object_unref (client_sock);
+    return GST_RTSP_ESYS;
+  }
+refused:
+  {
+    GST_INFO_OBJECT (server, "connection refused by admission (%d)", result);
+    g_object_unref (client_sock);
+    return GST_RTSP_OK;
+  }
+no_inet_address:
+  {
+    GST_WARNING_OBJECT (server, "connection has no internet address");
+    gst_rtsp_admission_release (priv->admission, TRUE);
+    g_object_unref (client_sock);
+    return GST_RTSP_EINVAL;
+  }
+}
+
+/* accept a new connection on @socket, the client is handled on @thread when
+ * not %NULL */
+static gboolean
+accept_connection (GstRTSPServer * server, GSocket * socket,
+    GIOCondition condition, GstRTSPThread * thread)
 {
   GstRTSPServerPrivate *priv = server->priv;
   GstRTSPClient *client = NULL;
@@ -1246,8 +1943,10 @@ gst_rtsp_server_io_func (GSocket * socket, GIOCondition condition,
 
   if (condition & G_IO_IN) {
     /* a new client connected. */
-    GST_RTSP_CHECK (gst_rtsp_connection_accept (socket, &conn, NULL),
-        accept_failed);
+    GST_RTSP_CHECK (admit_connection (server, socket, &conn), accept_failed);
+    if (conn == NULL)
+      /* refused by the admission */
+      goto exit_no_ctx;
 
     ctx.server = server;
     ctx.conn = conn;
@@ -1268,7 +1967,7 @@ gst_rtsp_server_io_func (GSocket * socket, GIOCondition condition,
     gst_rtsp_client_set_connection (client, conn);
 
     /* manage the client connection */
-    manage_client (server, client);
+    manage_client (server, client, thread, TRUE);
   } else {
     GST_WARNING_OBJECT (server, "received unknown event %08x", condition);
     goto exit_no_ctx;
@@ -1292,24 +1991,198 @@ accept_failed:
 connection_refused:
   {
     GST_ERROR_OBJECT (server, "connection refused");
+    gst_rtsp_admission_release (priv->admission, TRUE);
     gst_rtsp_connection_free (conn);
     goto exit;
   }
 client_failed:
   {
     GST_ERROR_OBJECT (server, "failed to create a client");
+    gst_rtsp_admission_release (priv->admission, TRUE);
     gst_rtsp_connection_free (conn);
     goto exit;
   }
 }
 
+/**
+ * gst_rtsp_server_io_func:
+ * @socket: a #GSocket
+ * @condition: the condition on @source
+ * @server: (transfer none): a #GstRTSPServer
+ *
+ * A default #GSocketSourceFunc that creates a new #GstRTSPClient to accept and handle a
+ * new connection on @socket or @server.
+ *
+ * Returns: TRUE if the source could be connected, FALSE if an error occurred.
+ */
+gboolean
+gst_rtsp_server_io_func (GSocket * socket, GIOCondition condition,
+    GstRTSPServer * server)
+{
+  return accept_connection (server, socket, condition, NULL);
+}
+
+#ifdef SO_REUSEPORT
+typedef struct
+{
+  GstRTSPServer *server;
+  GstRTSPThread *thread;
+} Acceptor;
+
+static void
+free_acceptor (Acceptor * acceptor)
+{
+  gst_rtsp_thread_stop (acceptor->thread);
+  g_object_unref (acceptor->server);
+  g_slice_free (Acceptor, acceptor);
+}
+
+static gboolean
+acceptor_io_func (GSocket * socket, GIOCondition condition,
+    Acceptor * acceptor)
+{
+  return accept_connection (acceptor->server, socket, condition,
+      acceptor->thread);
+}
+
+#if defined (SO_ATTACH_REUSEPORT_CBPF) && defined (SKF_AD_CPU)
+/* select the socket in the reuseport group of @socket by the CPU that
+ * received the connection, the sockets are in the order they started
+ * listening */
+static gboolean
+attach_cpu_steering (GSocket * socket, guint n_acceptors)
+{
+  struct sock_filter code[] = {
+    /* A = current CPU */
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU},
+    /* A = A % n_acceptors */
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, n_acceptors},
+    /* return A, the index of the socket */
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = { G_N_ELEMENTS (code), code };
+
+  return setsockopt (g_socket_get_fd (socket), SOL_SOCKET,
+      SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof (prog)) == 0;
+}
+#endif
+
+/* start an additional acceptor on a thread of the thread pool */
+static gboolean
+start_acceptor (GstRTSPServer * server, guint index)
+{
+  GstRTSPServerPrivate *priv = server->priv;
+  GstRTSPContext ctx = { NULL };
+  Acceptor *acceptor;
+  GstRTSPThread *thread;
+  GSocket *socket;
+  GSource *source;
+  GError *error = NULL;
+
+  ctx.server = server;
+
+  thread = gst_rtsp_thread_pool_get_thread (priv->thread_pool,
+      GST_RTSP_THREAD_TYPE_CLIENT, &ctx);
+  if (thread == NULL)
+    goto no_thread;
+
+  socket = gst_rtsp_server_create_socket (server, NULL, &error);
+  if (socket == NULL)
+    goto no_socket;
+
+  acceptor = g_slice_new0 (Acceptor);
+  acceptor->server = g_object_ref (server);
+  acceptor->thread = thread;
+
+  source = g_socket_create_source (socket, G_IO_IN |
+      G_IO_ERR | G_IO_HUP | G_IO_NVAL, NULL);
+  g_object_unref (socket);
+  g_source_set_callback (source, (GSourceFunc) acceptor_io_func, acceptor,
+      (GDestroyNotify) free_acceptor);
+  g_source_attach (source, thread->context);
+
+  GST_DEBUG_OBJECT (server, "started acceptor %u on thread %p", index, thread);
+
+  GST_RTSP_SERVER_LOCK (server);
+  priv->acceptors = g_list_prepend (priv->acceptors, source);
+  GST_RTSP_SERVER_UNLOCK (server);
+
+  return TRUE;
+
+  /* ERRORS */
+no_thread:
+  {
+    GST_WARNING_OBJECT (server, "no thread for acceptor %u", index);
+    return FALSE;
+  }
+no_socket:
+  {
+    GST_WARNING_OBJECT (server, "failed to create socket for acceptor %u: %s",
+        index, error->message);
+    g_clear_error (&error);
+    gst_rtsp_thread_stop (thread);
+    return FALSE;
+  }
+}
+
+#endif /* SO_REUSEPORT */
+
+/* start the acceptors other than the one of @socket */
+static void
+start_acceptors (GstRTSPServer * server, GSocket * socket)
+{
+  GstRTSPServerPrivate *priv = server->priv;
+  guint i, n_acceptors;
+  gboolean cpu_steering;
+
+  GST_RTSP_SERVER_LOCK (server);
+  n_acceptors = priv->n_acceptors;
+  cpu_steering = priv->cpu_steering;
+  GST_RTSP_SERVER_UNLOCK (server);
+
+  for (i = 1; i < n_acceptors; i++) {
+#ifdef SO_REUSEPORT
+    if (!start_acceptor (server, i))
+      break;
+#else
+    GST_WARNING_OBJECT (server, "SO_REUSEPORT is not supported");
+    break;
+#endif
+  }
+
+  if (cpu_steering && i > 1) {
+#if defined (SO_ATTACH_REUSEPORT_CBPF) && defined (SKF_AD_CPU)
+    if (!attach_cpu_steering (socket, i))
+      GST_WARNING_OBJECT (server, "failed to attach CPU steering program: %s",
+          g_strerror (errno));
+#else
+    GST_WARNING_OBJECT (server, "CPU steering is not supported");
+#endif
+  }
+}
+
+static void
+stop_acceptor (GSource * source)
+{
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
 static void
 watch_destroyed (GstRTSPServer * server)
 {
   GstRTSPServerPrivate *priv = server->priv;
+  GList *acceptors;
 
   GST_DEBUG_OBJECT (server, "source destroyed");
 
+  GST_RTSP_SERVER_LOCK (server);
+  acceptors = priv->acceptors;
+  priv->acceptors = NULL;
+  GST_RTSP_SERVER_UNLOCK (server);
+
+  g_list_free_full (acceptors, (GDestroyNotify) stop_acceptor);
+
   g_object_unref (priv->socket);
   priv->socket = NULL;
   g_object_unref (server);
@@ -1331,6 +2204,10 @@ watch_destroyed (GstRTSPServer * server)
  *
  * This takes a reference on @server until @source is destroyed.
  *
+ * When @server has more than one acceptor, the additional acceptors start
+ * accepting connections on their threads right away and they are stopped
+ * when @source is destroyed.
+ *
  * Returns: (transfer full): the #GSource for @server or %NULL when an error
  * occurred. Free with g_source_unref ()
  */
@@ -1358,6 +2235,9 @@ gst_rtsp_server_create_source (GstRTSPServer * server,
   if (old)
     g_object_unref (old);
 
+  /* the other sockets listening on the same port */
+  start_acceptors (server, socket);
+
   /* create a watch for reads (new connections) and possible errors */
   source = g_socket_create_source (socket, G_IO_IN |
       G_IO_ERR | G_IO_HUP | G_IO_NVAL, cancellable);
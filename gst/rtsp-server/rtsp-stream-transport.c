@@ -48,6 +48,7 @@
 #include <stdlib.h>
 
 #include "rtsp-stream-transport.h"
+#include "rtsp-server-internal.h"
 
 struct _GstRTSPStreamTransportPrivate
 {
@@ -76,6 +77,9 @@ struct _GstRTSPStreamTransportPrivate
   GstRTSPTransport *transport;
   GstRTSPUrl *url;
 
+  /* the cached GOP its RTP-Info was made for, sent first when added */
+  GstBufferList *burst;
+
   GObject *rtpsource;
 };
 
@@ -135,6 +139,9 @@ gst_rtsp_stream_transport_finalize (GObject * obj)
   if (priv->url)
     gst_rtsp_url_free (priv->url);
 
+  if (priv->burst)
+    gst_buffer_list_unref (priv->burst);
+
   G_OBJECT_CLASS (gst_rtsp_stream_transport_parent_class)->finalize (obj);
 }
 
@@ -381,6 +388,30 @@ gst_rtsp_stream_transport_get_url (GstRTSPStreamTransport * trans)
   return trans->priv->url;
 }
 
+/* takes ownership of @burst */
+void
+gst_rtsp_stream_transport_set_burst (GstRTSPStreamTransport * trans,
+    GstBufferList * burst)
+{
+  GstRTSPStreamTransportPrivate *priv = trans->priv;
+
+  if (priv->burst)
+    gst_buffer_list_unref (priv->burst);
+  priv->burst = burst;
+}
+
+GstBufferList *
+gst_rtsp_stream_transport_take_burst (GstRTSPStreamTransport * trans)
+{
+  GstRTSPStreamTransportPrivate *priv = trans->priv;
+  GstBufferList *burst;
+
+  burst = priv->burst;
+  priv->burst = NULL;
+
+  return burst;
+}
+
  /**
  * gst_rtsp_stream_transport_get_rtpinfo:
  * @trans: a #GstRTSPStreamTransport
@@ -388,6 +419,10 @@ gst_rtsp_stream_transport_get_url (GstRTSPStreamTransport * trans)
  *
  * Get the RTP-Info string for @trans and @start_time.
  *
+ * When @trans is not active yet and the GOP cache of its stream is enabled,
+ * the RTP-Info starts from the first cached packet. These packets are sent
+ * to @trans first when it is activated, see gst_rtsp_stream_set_gop_cache().
+ *
  * Returns: (transfer full) (nullable): the RTPInfo string for @trans
  * and @start_time or %NULL when the RTP-Info could not be
  * determined. g_free() after usage.
@@ -412,6 +447,12 @@ gst_rtsp_stream_transport_get_rtpinfo (GstRTSPStreamTransport * trans,
           &running_time))
     return NULL;
 
+  /* a transport that is not streaming yet is sent the cached GOP first,
+   * start from its first packet */
+  if (!priv->active)
+    gst_rtsp_stream_get_burst_rtpinfo (priv->stream, trans, &rtptime, &seq,
+        &running_time);
+
   GST_DEBUG ("RTP time %u, seq %u, rate %u, running-time %" GST_TIME_FORMAT,
       rtptime, seq, clock_rate, GST_TIME_ARGS (running_time));
 
@@ -61,6 +61,7 @@
 #include <gst/rtp/gstrtpbuffer.h>
 
 #include "rtsp-stream.h"
+#include "rtsp-server-internal.h"
 
 struct _GstRTSPStreamPrivate
 {
@@ -183,6 +184,34 @@ struct _GstRTSPStreamPrivate
 
   GstRTSPPublishClockMode publish_clock_mode;
   GThreadPool *send_pool;
+
+  /* GOP cache, the RTP packets since the last keyframe. Every packet is
+   * added from the streaming thread, the cache has its own lock so that this
+   * does not contend with the sending of the packets */
+  gboolean gop_cache;
+  gulong gop_probe_id;
+  GMutex gop_lock;
+  GPtrArray *gop;
+  GstClockTime gop_pts;
+  GstClockTime gop_running_time;
+  gboolean gop_delta;
+  /* the transports being sent the cached GOP before they are added */
+  GList *gop_bursts;
+  /* the transports that were sent the cached GOP and don't get the live
+   * packets that were in the GOP yet, protected by gop_lock */
+  GList *gop_joins;
+  guint n_gop_tcp_joins;        /* protected by lock */
+  gint gop_udp_joins;           /* atomic */
+  gulong gop_join_probe_id;
+
+  /* keyframe requests when a transport joins */
+  GstClockTime key_unit_interval;
+  GstClockTime key_unit_time;
+  gulong key_unit_probe_id;
+  guint key_units_requested;
+  guint key_units_coalesced;
+  gint key_units_honoured;      /* atomic */
+  gint key_unit_pending;        /* atomic */
 };
 
 #define DEFAULT_CONTROL         NULL
@@ -192,6 +221,30 @@ struct _GstRTSPStreamPrivate
 #define DEFAULT_MAX_MCAST_TTL   255
 #define DEFAULT_BIND_MCAST_ADDRESS FALSE
 #define DEFAULT_DO_RATE_CONTROL TRUE
+#define DEFAULT_GOP_CACHE       FALSE
+#define DEFAULT_KEY_UNIT_INTERVAL 0
+
+/* the number of samples that can queue up in the appsinks of the TCP
+ * transports while a message is being sent. They are sent together in the
+ * next message */
+#define TCP_BATCH_SIZE          16
+
+/* the maximum number of packets in the GOP cache. When a GOP has more packets
+ * it is not cached */
+#define GOP_CACHE_MAX_PACKETS   8192
+
+/* the cached GOP is sent to a new transport in chunks of this many packets
+ * from a pool of GOP_BURST_MAX_THREADS threads. A transport that did not
+ * catch up with the GOP cache after GOP_BURST_MAX_CHUNKS chunks is added
+ * anyway */
+#define GOP_BURST_CHUNK_SIZE    32
+#define GOP_BURST_MAX_THREADS   2
+#define GOP_BURST_MAX_CHUNKS (2 * GOP_CACHE_MAX_PACKETS / GOP_BURST_CHUNK_SIZE)
+
+/* the time between the chunks of the cached GOP sent over UDP, this limits
+ * a burst to 6400 packets per second so that it does not overflow the
+ * socket buffers on the way */
+#define GOP_BURST_UDP_INTERVAL  (5 * G_TIME_SPAN_MILLISECOND)
 
 enum
 {
@@ -294,8 +347,14 @@ gst_rtsp_stream_init (GstRTSPStream * stream)
   priv->max_mcast_ttl = DEFAULT_MAX_MCAST_TTL;
   priv->bind_mcast_address = DEFAULT_BIND_MCAST_ADDRESS;
   priv->do_rate_control = DEFAULT_DO_RATE_CONTROL;
+  priv->gop_cache = DEFAULT_GOP_CACHE;
+  priv->key_unit_interval = DEFAULT_KEY_UNIT_INTERVAL;
+  priv->key_unit_time = GST_CLOCK_TIME_NONE;
 
   g_mutex_init (&priv->lock);
+  g_mutex_init (&priv->gop_lock);
+  priv->gop =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
 
   priv->keys = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) gst_caps_unref);
@@ -379,6 +438,8 @@ gst_rtsp_stream_finalize (GObject * obj)
     gst_object_unref (priv->sinkpad);
   g_free (priv->control);
   g_mutex_clear (&priv->lock);
+  g_mutex_clear (&priv->gop_lock);
+  g_ptr_array_unref (priv->gop);
 
   g_hash_table_unref (priv->keys);
   g_hash_table_destroy (priv->ptmap);
@@ -2450,6 +2511,158 @@ clear_tr_cache (GstRTSPStreamPrivate * priv)
   priv->tr_cache = NULL;
 }
 
+/* a transport that was sent the cached GOP up to @seqnum. The live packets
+ * up to @seqnum can still be on their way to the sinks when the transport
+ * is added, they are not sent to it again. A UDP transport is only added to
+ * the RTP udpsink by gop_join_probe() once a newer packet arrives there, a
+ * TCP transport is skipped by send_tcp_message() until then */
+typedef struct
+{
+  GstRTSPStreamTransport *trans;
+  guint16 seqnum;
+  gboolean udp;
+} GopJoin;
+
+static void
+gop_join_free (GopJoin * join)
+{
+  g_object_unref (join->trans);
+  g_slice_free (GopJoin, join);
+}
+
+/* must be called with gop_lock */
+static GList *
+find_gop_join (GstRTSPStreamPrivate * priv, GstRTSPStreamTransport * trans)
+{
+  GList *walk;
+
+  for (walk = priv->gop_joins; walk; walk = walk->next) {
+    GopJoin *join = walk->data;
+
+    if (join->trans == trans)
+      return walk;
+  }
+  return NULL;
+}
+
+/* packets that can't be parsed are treated as newer */
+static gboolean
+is_newer_packet (GstBuffer * buffer, guint16 seqnum)
+{
+  GstRTPBuffer rtp_buffer = GST_RTP_BUFFER_INIT;
+  guint16 seq;
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp_buffer))
+    return TRUE;
+  seq = gst_rtp_buffer_get_seq (&rtp_buffer);
+  gst_rtp_buffer_unmap (&rtp_buffer);
+
+  return gst_rtp_buffer_compare_seqnum (seqnum, seq) > 0;
+}
+
+/* must be called with lock and gop_lock. Returns the packets of @buffer or
+ * @buffer_list newer than the GOP @join was sent, and their number in
+ * @n_newer */
+static GstBufferList *
+get_join_packets (GopJoin * join, GstBuffer * buffer,
+    GstBufferList * buffer_list, guint * n_newer, guint * n_packets)
+{
+  GstBufferList *newer;
+  guint i, n;
+
+  n = buffer_list ? gst_buffer_list_length (buffer_list) : 0;
+  newer = gst_buffer_list_new_sized (n + 1);
+  if (buffer && is_newer_packet (buffer, join->seqnum))
+    gst_buffer_list_add (newer, gst_buffer_ref (buffer));
+  for (i = 0; i < n; i++) {
+    GstBuffer *packet = gst_buffer_list_get (buffer_list, i);
+
+    if (is_newer_packet (packet, join->seqnum))
+      gst_buffer_list_add (newer, gst_buffer_ref (packet));
+  }
+  *n_newer = gst_buffer_list_length (newer);
+  *n_packets = n + (buffer ? 1 : 0);
+
+  return newer;
+}
+
+typedef struct
+{
+  GstRTSPStreamTransport *trans;
+  GstBufferList *packets;
+} JoinPackets;
+
+/* must be called with lock. Returns the packets that are sent instead of
+ * the message to the TCP transports that join, a %NULL list when the
+ * transport is not sent the message. The transports that get the live
+ * packets now are joined */
+static GArray *
+filter_gop_joins (GstRTSPStreamPrivate * priv, GstBuffer * buffer,
+    GstBufferList * buffer_list, guint n_messages)
+{
+  GArray *filtered = NULL;
+  GList *walk, *next;
+
+  g_mutex_lock (&priv->gop_lock);
+  for (walk = priv->gop_joins; walk; walk = next) {
+    GopJoin *join = walk->data;
+    JoinPackets packets;
+    guint n_newer, n_packets;
+
+    next = walk->next;
+    if (join->udp)
+      continue;
+
+    packets.trans = join->trans;
+    packets.packets = get_join_packets (join, buffer, buffer_list, &n_newer,
+        &n_packets);
+    if (n_newer == 0) {
+      /* the transport is not sent a message */
+      gst_buffer_list_unref (packets.packets);
+      packets.packets = NULL;
+      priv->n_outstanding -= n_messages;
+    } else if (n_newer == n_packets) {
+      gst_buffer_list_unref (packets.packets);
+      packets.packets = NULL;
+    } else {
+      /* the transport is sent one message with the newer packets */
+      priv->n_outstanding -= n_messages - 1;
+    }
+
+    if (n_newer > 0) {
+      GST_DEBUG ("transport %p gets the live packets now", join->trans);
+      priv->gop_joins = g_list_delete_link (priv->gop_joins, walk);
+      priv->n_gop_tcp_joins--;
+      gop_join_free (join);
+    }
+    if (n_newer < n_packets) {
+      if (filtered == NULL)
+        filtered = g_array_new (FALSE, FALSE, sizeof (JoinPackets));
+      g_array_append_val (filtered, packets);
+    }
+  }
+  g_mutex_unlock (&priv->gop_lock);
+
+  return filtered;
+}
+
+static void
+add_sample_to_list (GstBufferList * list, GstSample * sample)
+{
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  GstBufferList *buffer_list = gst_sample_get_buffer_list (sample);
+  guint i, n;
+
+  if (buffer)
+    gst_buffer_list_add (list, gst_buffer_ref (buffer));
+  if (buffer_list) {
+    n = gst_buffer_list_length (buffer_list);
+    for (i = 0; i < n; i++)
+      gst_buffer_list_add (list,
+          gst_buffer_ref (gst_buffer_list_get (buffer_list, i)));
+  }
+}
+
 /* Must be called with priv->lock */
 static void
 send_tcp_message (GstRTSPStream * stream, gint idx)
@@ -2457,12 +2670,14 @@ send_tcp_message (GstRTSPStream * stream, gint idx)
   GstRTSPStreamPrivate *priv = stream->priv;
   GstAppSink *sink;
   GList *walk;
-  GstSample *sample;
+  GstSample *sample, *next;
   GstBuffer *buffer;
-  GstBufferList *buffer_list;
+  GstBufferList *buffer_list, *batch = NULL;
+  guint n_samples = 1;
   guint n_messages = 0;
   gboolean is_rtp;
   GPtrArray *transports;
+  GArray *joins = NULL;
 
   if (priv->n_outstanding > 0 || !priv->have_buffer[idx]) {
     return;
@@ -2475,8 +2690,10 @@ send_tcp_message (GstRTSPStream * stream, gint idx)
     return;
   }
 
+  /* samples that queued up after a previous have_buffer was handled might
+   * have been sent with that message already, don't block */
   sink = GST_APP_SINK (priv->appsink[idx]);
-  sample = gst_app_sink_pull_sample (sink);
+  sample = gst_app_sink_try_pull_sample (sink, 0);
   if (!sample) {
     return;
   }
@@ -2484,6 +2701,23 @@ send_tcp_message (GstRTSPStream * stream, gint idx)
   buffer = gst_sample_get_buffer (sample);
   buffer_list = gst_sample_get_buffer_list (sample);
 
+  /* send the samples that queued up while the previous message was being
+   * sent in the same message, so that the client writes them together */
+  while (n_samples < TCP_BATCH_SIZE &&
+      (next = gst_app_sink_try_pull_sample (sink, 0))) {
+    if (batch == NULL) {
+      batch = gst_buffer_list_new ();
+      add_sample_to_list (batch, sample);
+    }
+    add_sample_to_list (batch, next);
+    gst_sample_unref (next);
+    n_samples++;
+  }
+  if (batch) {
+    buffer = NULL;
+    buffer_list = batch;
+  }
+
   /* We will get one message-sent notification per buffer or
    * complete buffer-list. We handle each buffer-list as a unit */
   if (buffer)
@@ -2514,6 +2748,10 @@ send_tcp_message (GstRTSPStream * stream, gint idx)
   g_ptr_array_ref (transports);
   priv->n_outstanding += n_messages * priv->n_tcp_transports;
 
+  /* don't send the packets that were in the cached GOP again */
+  if (is_rtp && priv->n_gop_tcp_joins > 0)
+    joins = filter_gop_joins (priv, buffer, buffer_list, n_messages);
+
   g_mutex_unlock (&priv->lock);
 
   if (transports) {
@@ -2521,6 +2759,33 @@ send_tcp_message (GstRTSPStream * stream, gint idx)
       GstRTSPStreamTransport *tr =
           (GstRTSPStreamTransport *) g_ptr_array_index (transports, index);
       gboolean send_ret = TRUE;
+      gboolean joining = FALSE;
+      guint n_sent = n_messages;
+
+      for (guint i = 0; joins && i < joins->len; i++) {
+        JoinPackets *packets = &g_array_index (joins, JoinPackets, i);
+
+        if (packets->trans != tr)
+          continue;
+
+        joining = TRUE;
+        if (packets->packets) {
+          n_sent = 1;
+          send_ret = gst_rtsp_stream_transport_send_rtp_list (tr,
+              packets->packets);
+        }
+        break;
+      }
+
+      if (joining) {
+        if (!send_ret) {
+          g_mutex_lock (&priv->lock);
+          priv->n_outstanding -= n_sent;
+          update_transport (stream, tr, FALSE);
+          g_mutex_unlock (&priv->lock);
+        }
+        continue;
+      }
 
       if (is_rtp) {
         if (buffer)
@@ -2544,7 +2809,18 @@ send_tcp_message (GstRTSPStream * stream, gint idx)
     }
     g_ptr_array_unref (transports);
   }
+  if (joins) {
+    for (guint i = 0; i < joins->len; i++) {
+      JoinPackets *packets = &g_array_index (joins, JoinPackets, i);
+
+      if (packets->packets)
+        gst_buffer_list_unref (packets->packets);
+    }
+    g_array_free (joins, TRUE);
+  }
   gst_sample_unref (sample);
+  if (batch)
+    gst_buffer_list_unref (batch);
 
   g_mutex_lock (&priv->lock);
 }
@@ -2617,6 +2893,425 @@ static GstAppSinkCallbacks sink_cb = {
   handle_new_sample,
 };
 
+/* must be called with gop_lock */
+static void
+add_to_gop_cache (GstRTSPStreamPrivate * priv, GstPad * pad,
+    GstBuffer * buffer)
+{
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    /* all packets of a keyframe have its timestamp, the first packet of the
+     * next keyframe starts a new GOP */
+    if (priv->gop_delta || priv->gop->len == 0 ||
+        GST_BUFFER_PTS (buffer) != priv->gop_pts) {
+      GstEvent *event;
+
+      g_ptr_array_set_size (priv->gop, 0);
+      priv->gop_pts = GST_BUFFER_PTS (buffer);
+      priv->gop_running_time = GST_CLOCK_TIME_NONE;
+
+      event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+      if (event) {
+        const GstSegment *segment;
+
+        gst_event_parse_segment (event, &segment);
+        priv->gop_running_time = gst_segment_to_running_time (segment,
+            GST_FORMAT_TIME, priv->gop_pts);
+        gst_event_unref (event);
+      }
+    }
+    priv->gop_delta = FALSE;
+  } else {
+    priv->gop_delta = TRUE;
+    /* nothing to decode without the keyframe */
+    if (priv->gop->len == 0)
+      return;
+  }
+
+  if (priv->gop->len >= GOP_CACHE_MAX_PACKETS) {
+    GST_DEBUG ("GOP has more than %d packets, not caching it",
+        GOP_CACHE_MAX_PACKETS);
+    g_ptr_array_set_size (priv->gop, 0);
+    return;
+  }
+
+  g_ptr_array_add (priv->gop, gst_buffer_ref (buffer));
+}
+
+static GstPadProbeReturn
+gop_cache_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstRTSPStream *stream = user_data;
+  GstRTSPStreamPrivate *priv = stream->priv;
+
+  g_mutex_lock (&priv->gop_lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    add_to_gop_cache (priv, pad, GST_PAD_PROBE_INFO_BUFFER (info));
+  } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, n;
+
+    n = gst_buffer_list_length (list);
+    for (i = 0; i < n; i++)
+      add_to_gop_cache (priv, pad, gst_buffer_list_get (list, i));
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_FLUSH_STOP) {
+    /* the cached packets are from before the seek */
+    g_ptr_array_set_size (priv->gop, 0);
+  }
+  g_mutex_unlock (&priv->gop_lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* must be called with lock */
+static void
+add_gop_probe (GstRTSPStream * stream)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstPad *pad;
+
+  if (priv->tee[0] == NULL || priv->gop_probe_id != 0)
+    return;
+
+  GST_DEBUG_OBJECT (stream, "caching GOP");
+
+  pad = gst_element_get_static_pad (priv->tee[0], "sink");
+  priv->gop_probe_id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, gop_cache_probe, stream, NULL);
+  gst_object_unref (pad);
+}
+
+/* must be called with lock */
+static void
+remove_gop_probe (GstRTSPStream * stream)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstPad *pad;
+
+  if (priv->gop_probe_id != 0) {
+    pad = gst_element_get_static_pad (priv->tee[0], "sink");
+    gst_pad_remove_probe (pad, priv->gop_probe_id);
+    gst_object_unref (pad);
+    priv->gop_probe_id = 0;
+  }
+
+  g_mutex_lock (&priv->gop_lock);
+  g_ptr_array_set_size (priv->gop, 0);
+  g_mutex_unlock (&priv->gop_lock);
+}
+
+/* adds the UDP transports that were sent the cached GOP to the RTP udpsink
+ * once the first packet that was not in the GOP gets there. This runs in the
+ * streaming thread and must not take the stream lock */
+static GstPadProbeReturn
+gop_join_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstRTSPStream *stream = user_data;
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstBuffer *buffer;
+  GList *walk, *next, *joined = NULL;
+
+  if (g_atomic_int_get (&priv->gop_udp_joins) == 0)
+    return GST_PAD_PROBE_OK;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint len = gst_buffer_list_length (list);
+
+    if (len == 0)
+      return GST_PAD_PROBE_OK;
+    buffer = gst_buffer_list_get (list, len - 1);
+  } else {
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  }
+
+  g_mutex_lock (&priv->gop_lock);
+  for (walk = priv->gop_joins; walk; walk = next) {
+    GopJoin *join = walk->data;
+    const GstRTSPTransport *tr;
+
+    next = walk->next;
+    if (!join->udp || !is_newer_packet (buffer, join->seqnum))
+      continue;
+
+    tr = gst_rtsp_stream_transport_get_transport (join->trans);
+    GST_INFO ("adding %s:%d", tr->destination, tr->client_port.min);
+    g_signal_emit_by_name (GST_PAD_PARENT (pad), "add", tr->destination,
+        tr->client_port.min, NULL);
+    g_atomic_int_add (&priv->gop_udp_joins, -1);
+
+    priv->gop_joins = g_list_remove_link (priv->gop_joins, walk);
+    joined = g_list_concat (walk, joined);
+  }
+  g_mutex_unlock (&priv->gop_lock);
+
+  g_list_free_full (joined, (GDestroyNotify) gop_join_free);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* must be called with lock */
+static void
+remove_gop_join_probe (GstRTSPStream * stream)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstPad *pad;
+
+  if (priv->gop_join_probe_id != 0) {
+    pad = gst_element_get_static_pad (priv->udpsink[0], "sink");
+    gst_pad_remove_probe (pad, priv->gop_join_probe_id);
+    gst_object_unref (pad);
+    priv->gop_join_probe_id = 0;
+  }
+}
+
+static GstPadProbeReturn
+key_unit_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstRTSPStream *stream = user_data;
+  GstRTSPStreamPrivate *priv = stream->priv;
+  gboolean keyframe = FALSE;
+
+  /* only a request that was sent upstream is pending */
+  if (!g_atomic_int_get (&priv->key_unit_pending))
+    return GST_PAD_PROBE_OK;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    keyframe = !GST_BUFFER_FLAG_IS_SET (GST_PAD_PROBE_INFO_BUFFER (info),
+        GST_BUFFER_FLAG_DELTA_UNIT);
+  } else {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, n;
+
+    n = gst_buffer_list_length (list);
+    for (i = 0; i < n && !keyframe; i++)
+      keyframe = !GST_BUFFER_FLAG_IS_SET (gst_buffer_list_get (list, i),
+          GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+
+  if (!keyframe)
+    return GST_PAD_PROBE_OK;
+
+  if (g_atomic_int_compare_and_exchange (&priv->key_unit_pending, TRUE,
+          FALSE)) {
+    GST_DEBUG_OBJECT (stream, "keyframe after key unit request");
+    g_atomic_int_inc (&priv->key_units_honoured);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* must be called with lock */
+static void
+add_key_unit_probe (GstRTSPStream * stream)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstPad *pad;
+
+  if (priv->tee[0] == NULL || priv->key_unit_probe_id != 0)
+    return;
+
+  pad = gst_element_get_static_pad (priv->tee[0], "sink");
+  priv->key_unit_probe_id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      key_unit_probe, stream, NULL);
+  gst_object_unref (pad);
+}
+
+/* must be called with lock */
+static void
+remove_key_unit_probe (GstRTSPStream * stream)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstPad *pad;
+
+  if (priv->key_unit_probe_id != 0) {
+    pad = gst_element_get_static_pad (priv->tee[0], "sink");
+    gst_pad_remove_probe (pad, priv->key_unit_probe_id);
+    gst_object_unref (pad);
+    priv->key_unit_probe_id = 0;
+  }
+  g_atomic_int_set (&priv->key_unit_pending, FALSE);
+}
+
+/* must be called with lock. Every packet of an audio stream is a keyframe,
+ * only video has keyframes to request. Without caps the media is not known
+ * yet */
+static gboolean
+has_key_units (GstRTSPStreamPrivate * priv)
+{
+  const gchar *media;
+
+  if (priv->caps == NULL)
+    return TRUE;
+
+  media = gst_structure_get_string (gst_caps_get_structure (priv->caps, 0),
+      "media");
+
+  return g_strcmp0 (media, "video") == 0;
+}
+
+/* must be called with lock. Returns the pad to send a keyframe request to
+ * when @trans joins the stream that is already sent to other transports, or
+ * %NULL. Joins within the key unit interval share one request. */
+static GstPad *
+get_key_unit_pad (GstRTSPStream * stream, GstRTSPStreamTransport * trans)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstClockTime now;
+
+  if (priv->key_unit_interval == 0 || priv->client_side ||
+      priv->srcpad == NULL || !has_key_units (priv))
+    return NULL;
+
+  /* the first transport gets the keyframe the stream starts with */
+  if (priv->transports == NULL || (priv->transports->data == trans &&
+          priv->transports->next == NULL))
+    return NULL;
+
+  now = g_get_monotonic_time () * GST_USECOND;
+  if (GST_CLOCK_TIME_IS_VALID (priv->key_unit_time) &&
+      now - priv->key_unit_time < priv->key_unit_interval) {
+    GST_DEBUG_OBJECT (stream, "coalescing key unit request");
+    priv->key_units_coalesced++;
+    return NULL;
+  }
+
+  priv->key_unit_time = now;
+  priv->key_units_requested++;
+  g_atomic_int_set (&priv->key_unit_pending, TRUE);
+
+  return gst_object_ref (priv->srcpad);
+}
+
+static void
+request_key_unit (GstRTSPStream * stream, GstPad * pad)
+{
+  GstEvent *event;
+
+  GST_DEBUG_OBJECT (stream, "requesting key unit");
+
+  /* the event of gst_video_event_new_upstream_force_key_unit() */
+  event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+      gst_structure_new ("GstForceKeyUnit",
+          "running-time", GST_TYPE_CLOCK_TIME, GST_CLOCK_TIME_NONE,
+          "all-headers", G_TYPE_BOOLEAN, TRUE,
+          "count", G_TYPE_UINT, 0, NULL));
+
+  if (!gst_pad_send_event (pad, event)) {
+    GST_DEBUG_OBJECT (stream, "key unit request not handled upstream");
+    /* the next keyframe is not an answer to the request */
+    g_atomic_int_set (&stream->priv->key_unit_pending, FALSE);
+  }
+}
+
+/* must be called with lock. Returns a copy of the cached GOP to send to
+ * @trans before the packets of the tee, or %NULL */
+static GstBufferList *
+get_gop_burst (GstRTSPStream * stream, GstRTSPStreamTransport * trans,
+    GstClockTime * running_time)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  const GstRTSPTransport *tr;
+  GstBufferList *burst = NULL;
+  guint i;
+
+  if (!priv->gop_cache || priv->client_side)
+    return NULL;
+
+  /* a multicast group already receives the stream, a burst would be sent to
+   * all its members */
+  tr = gst_rtsp_stream_transport_get_transport (trans);
+  if (tr->lower_transport == GST_RTSP_LOWER_TRANS_UDP_MCAST)
+    return NULL;
+
+  g_mutex_lock (&priv->gop_lock);
+  if (priv->gop->len > 0) {
+    burst = gst_buffer_list_new_sized (priv->gop->len);
+    for (i = 0; i < priv->gop->len; i++)
+      gst_buffer_list_add (burst,
+          gst_buffer_ref (g_ptr_array_index (priv->gop, i)));
+  }
+  if (running_time)
+    *running_time = priv->gop_running_time;
+  g_mutex_unlock (&priv->gop_lock);
+
+  return burst;
+}
+
+static void
+send_udp_burst (GstRTSPStream * stream, const GstRTSPTransport * tr,
+    GstBufferList * burst)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GSocketAddress *addr;
+  GSocket *socket;
+  GError *error = NULL;
+  guint i, n;
+
+  addr = g_inet_socket_address_new_from_string (tr->destination,
+      tr->client_port.min);
+  if (addr == NULL)
+    goto invalid_address;
+
+  g_mutex_lock (&priv->lock);
+  if (g_socket_address_get_family (addr) == G_SOCKET_FAMILY_IPV6)
+    socket = priv->socket_v6[0];
+  else
+    socket = priv->socket_v4[0];
+  if (socket)
+    g_object_ref (socket);
+  g_mutex_unlock (&priv->lock);
+
+  if (socket == NULL)
+    goto no_socket;
+
+  n = gst_buffer_list_length (burst);
+  for (i = 0; i < n; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (burst, i);
+    GstMapInfo map;
+    gssize res;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      continue;
+    res = g_socket_send_to (socket, addr, (const gchar *) map.data, map.size,
+        NULL, &error);
+    gst_buffer_unmap (buffer, &map);
+
+    if (res < 0)
+      goto send_failed;
+  }
+
+  g_object_unref (socket);
+  g_object_unref (addr);
+
+  return;
+
+  /* ERRORS */
+invalid_address:
+  {
+    GST_WARNING_OBJECT (stream, "invalid destination %s", tr->destination);
+    return;
+  }
+no_socket:
+  {
+    GST_WARNING_OBJECT (stream, "no socket to send the GOP to %s",
+        tr->destination);
+    g_object_unref (addr);
+    return;
+  }
+send_failed:
+  {
+    GST_WARNING_OBJECT (stream, "failed to send the GOP to %s: %s",
+        tr->destination, error->message);
+    g_clear_error (&error);
+    g_object_unref (socket);
+    g_object_unref (addr);
+    return;
+  }
+}
+
 static GstElement *
 get_rtp_encoder (GstRTSPStream * stream, guint session)
 {
@@ -3413,7 +4108,7 @@ create_sender_part (GstRTSPStream * stream, const GstRTSPTransport * transport)
       /* make appsink */
       priv->appsink[i] = gst_element_factory_make ("appsink", NULL);
       g_object_set (priv->appsink[i], "emit-signals", FALSE, "buffer-list",
-          TRUE, "max-buffers", 1, NULL);
+          TRUE, "max-buffers", TCP_BATCH_SIZE, NULL);
 
       if (i == 0)
         g_object_set (priv->appsink[i], "sync", priv->do_rate_control, NULL);
@@ -3434,6 +4129,11 @@ create_sender_part (GstRTSPStream * stream, const GstRTSPTransport * transport)
       pad = gst_element_get_static_pad (priv->tee[i], "sink");
       gst_pad_link (priv->send_src[i], pad);
       gst_object_unref (pad);
+
+      if (i == 0 && priv->gop_cache)
+        add_gop_probe (stream);
+      if (i == 0 && priv->key_unit_interval > 0)
+        add_key_unit_probe (stream);
     }
   }
 
@@ -3825,7 +4525,7 @@ gst_rtsp_stream_leave_bin (GstRTSPStream * stream, GstBin * bin,
   priv->joined_bin = NULL;
 
   /* all transports must be removed by now */
-  if (priv->transports != NULL)
+  if (priv->transports != NULL || priv->gop_bursts != NULL)
     goto transports_not_removed;
 
   if (priv->send_pool) {
@@ -3839,6 +4539,9 @@ gst_rtsp_stream_leave_bin (GstRTSPStream * stream, GstBin * bin,
   }
 
   clear_tr_cache (priv);
+  remove_gop_probe (stream);
+  remove_gop_join_probe (stream);
+  remove_key_unit_probe (stream);
 
   GST_INFO ("stream %p leaving bin", stream);
 
@@ -3961,6 +4664,49 @@ gst_rtsp_stream_get_joined_bin (GstRTSPStream * stream)
   return bin;
 }
 
+/* Makes the copy of the cached GOP that is sent to @trans first when it is
+ * added and gets the RTP-Info of its first packet. Returns %FALSE when @trans
+ * is not sent a GOP */
+gboolean
+gst_rtsp_stream_get_burst_rtpinfo (GstRTSPStream * stream,
+    GstRTSPStreamTransport * trans, guint * rtptime, guint * seq,
+    GstClockTime * running_time)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstRTPBuffer rtp_buffer = GST_RTP_BUFFER_INIT;
+  GstBufferList *burst;
+  GstClockTime gop_running_time = GST_CLOCK_TIME_NONE;
+
+  g_mutex_lock (&priv->lock);
+  burst = get_gop_burst (stream, trans, &gop_running_time);
+  g_mutex_unlock (&priv->lock);
+
+  if (burst == NULL)
+    goto no_burst;
+
+  if (!gst_rtp_buffer_map (gst_buffer_list_get (burst, 0), GST_MAP_READ,
+          &rtp_buffer))
+    goto no_burst;
+
+  *seq = gst_rtp_buffer_get_seq (&rtp_buffer);
+  *rtptime = gst_rtp_buffer_get_timestamp (&rtp_buffer);
+  *running_time = gop_running_time;
+  gst_rtp_buffer_unmap (&rtp_buffer);
+
+  gst_rtsp_stream_transport_set_burst (trans, burst);
+
+  return TRUE;
+
+  /* ERRORS */
+no_burst:
+  {
+    if (burst)
+      gst_buffer_list_unref (burst);
+    gst_rtsp_stream_transport_set_burst (trans, NULL);
+    return FALSE;
+  }
+}
+
 /**
  * gst_rtsp_stream_get_rtpinfo:
  * @stream: a #GstRTSPStream
@@ -4367,6 +5113,7 @@ update_transport (GstRTSPStream * stream, GstRTSPStreamTransport * trans,
   const GstRTSPTransport *tr;
   gchar *dest;
   gint min, max;
+  GList *join;
 
   tr = gst_rtsp_stream_transport_get_transport (trans);
   dest = tr->destination;
@@ -4417,15 +5164,29 @@ update_transport (GstRTSPStream * stream, GstRTSPStreamTransport * trans,
         max = tr->client_port.max;
       }
 
+      /* a transport that was sent the cached GOP is added to the RTP
+       * udpsink by gop_join_probe() */
+      g_mutex_lock (&priv->gop_lock);
+      join = find_gop_join (priv, trans);
+      if (join && !add) {
+        priv->gop_joins = g_list_remove_link (priv->gop_joins, join);
+        g_atomic_int_add (&priv->gop_udp_joins, -1);
+      }
+      g_mutex_unlock (&priv->gop_lock);
+
       if (add) {
         GST_INFO ("adding %s:%d-%d", dest, min, max);
-        add_client (priv->udpsink[0], priv->udpsink[1], dest, min, max);
+        add_client (join ? NULL : priv->udpsink[0], priv->udpsink[1], dest,
+            min, max);
         priv->transports = g_list_prepend (priv->transports, trans);
       } else {
         GST_INFO ("removing %s:%d-%d", dest, min, max);
-        remove_client (priv->udpsink[0], priv->udpsink[1], dest, min, max);
+        remove_client (join ? NULL : priv->udpsink[0], priv->udpsink[1], dest,
+            min, max);
         priv->transports = g_list_remove (priv->transports, trans);
       }
+      if (join && !add)
+        g_list_free_full (join, (GDestroyNotify) gop_join_free);
       priv->transports_cookie++;
       break;
     }
@@ -4438,6 +5199,15 @@ update_transport (GstRTSPStream * stream, GstRTSPStreamTransport * trans,
         GST_INFO ("removing TCP %s", tr->destination);
         priv->transports = g_list_remove (priv->transports, trans);
         priv->n_tcp_transports--;
+
+        g_mutex_lock (&priv->gop_lock);
+        join = find_gop_join (priv, trans);
+        if (join) {
+          priv->gop_joins = g_list_remove_link (priv->gop_joins, join);
+          priv->n_gop_tcp_joins--;
+        }
+        g_mutex_unlock (&priv->gop_lock);
+        g_list_free_full (join, (GDestroyNotify) gop_join_free);
       }
       priv->transports_cookie++;
       break;
@@ -4510,6 +5280,297 @@ no_outstanding:
   }
 }
 
+/* the cached GOP being sent to a transport that joins @stream. The
+ * transport is added to @stream once it caught up with the GOP cache, so
+ * the other transports never wait for the burst */
+typedef struct
+{
+  gint refcount;
+  GstRTSPStream *stream;
+  GstRTSPStreamTransport *trans;
+  GstBufferList *packets;
+  guint sent;
+  guint n_chunks;
+  gboolean sending;
+} GopBurst;
+
+static void gop_burst_step (GopBurst * burst, gpointer unused);
+
+static GopBurst *
+gop_burst_ref (GopBurst * burst)
+{
+  g_atomic_int_inc (&burst->refcount);
+  return burst;
+}
+
+static void
+gop_burst_unref (GopBurst * burst)
+{
+  if (!g_atomic_int_dec_and_test (&burst->refcount))
+    return;
+
+  gst_buffer_list_unref (burst->packets);
+  g_object_unref (burst->trans);
+  g_object_unref (burst->stream);
+  g_free (burst);
+}
+
+static GThreadPool *
+get_gop_bursters (void)
+{
+  static gsize bursters = 0;
+
+  if (g_once_init_enter (&bursters)) {
+    GThreadPool *pool;
+
+    pool = g_thread_pool_new ((GFunc) gop_burst_step, NULL,
+        GOP_BURST_MAX_THREADS, FALSE, NULL);
+    g_once_init_leave (&bursters, (gsize) pool);
+  }
+  return (GThreadPool *) bursters;
+}
+
+/* must be called with lock */
+static GopBurst *
+find_gop_burst (GstRTSPStreamPrivate * priv, GstRTSPStreamTransport * trans)
+{
+  GList *walk;
+
+  for (walk = priv->gop_bursts; walk; walk = walk->next) {
+    GopBurst *burst = walk->data;
+
+    if (burst->trans == trans)
+      return burst;
+  }
+  return NULL;
+}
+
+/* the message_sent callback of a TCP transport while it is sent the GOP, the
+ * next chunk is sent when the previous one was written */
+static void
+on_gop_burst_sent (gpointer user_data)
+{
+  GstRTSPStreamTransport *trans = user_data;
+  GstRTSPStream *stream = gst_rtsp_stream_transport_get_stream (trans);
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GopBurst *burst;
+
+  g_mutex_lock (&priv->lock);
+  burst = find_gop_burst (priv, trans);
+  if (burst && burst->sending) {
+    burst->sending = FALSE;
+    g_thread_pool_push (get_gop_bursters (), gop_burst_ref (burst), NULL);
+  }
+  g_mutex_unlock (&priv->lock);
+}
+
+/* must be called with gop_lock. Adds the packets that were cached since
+ * @burst was copied, returns %TRUE when all cached packets were sent */
+static gboolean
+catch_up_gop (GstRTSPStreamPrivate * priv, GopBurst * burst)
+{
+  guint i, len;
+
+  len = gst_buffer_list_length (burst->packets);
+  if (burst->sent < len)
+    return FALSE;
+
+  /* the cache was cleared, there is nothing to catch up with */
+  if (priv->gop->len == 0)
+    return TRUE;
+
+  if (g_ptr_array_index (priv->gop, 0) !=
+      gst_buffer_list_get (burst->packets, 0)) {
+    /* a new GOP started, send it from its keyframe */
+    gst_buffer_list_unref (burst->packets);
+    burst->packets = gst_buffer_list_new_sized (priv->gop->len);
+    burst->sent = 0;
+    len = 0;
+  } else if (priv->gop->len == len) {
+    return TRUE;
+  }
+
+  for (i = len; i < priv->gop->len; i++)
+    gst_buffer_list_add (burst->packets,
+        gst_buffer_ref (g_ptr_array_index (priv->gop, i)));
+
+  return FALSE;
+}
+
+/* must be called with lock and gop_lock. Keeps the live packets up to the
+ * last one of @burst from the transport of @burst */
+static void
+add_gop_join (GstRTSPStream * stream, GopBurst * burst, gboolean udp)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  GstRTPBuffer rtp_buffer = GST_RTP_BUFFER_INIT;
+  GstBuffer *last;
+  GopJoin *join;
+  guint len;
+  GstPad *pad;
+
+  len = gst_buffer_list_length (burst->packets);
+  if (len == 0)
+    return;
+  if (udp && priv->udpsink[0] == NULL)
+    return;
+
+  last = gst_buffer_list_get (burst->packets, len - 1);
+  if (!gst_rtp_buffer_map (last, GST_MAP_READ, &rtp_buffer))
+    return;
+
+  join = g_slice_new (GopJoin);
+  join->trans = g_object_ref (burst->trans);
+  join->seqnum = gst_rtp_buffer_get_seq (&rtp_buffer);
+  join->udp = udp;
+  gst_rtp_buffer_unmap (&rtp_buffer);
+
+  priv->gop_joins = g_list_prepend (priv->gop_joins, join);
+
+  if (!udp) {
+    priv->n_gop_tcp_joins++;
+  } else {
+    g_atomic_int_inc (&priv->gop_udp_joins);
+    if (priv->gop_join_probe_id == 0) {
+      pad = gst_element_get_static_pad (priv->udpsink[0], "sink");
+      priv->gop_join_probe_id = gst_pad_add_probe (pad,
+          GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+          gop_join_probe, stream, NULL);
+      gst_object_unref (pad);
+    }
+  }
+}
+
+/* sends the next chunk of @burst, or adds its transport to the stream when
+ * all cached packets were sent. Runs in the pool of get_gop_bursters() */
+static void
+gop_burst_step (GopBurst * burst, gpointer unused)
+{
+  GstRTSPStream *stream = burst->stream;
+  GstRTSPStreamPrivate *priv = stream->priv;
+  const GstRTSPTransport *tr;
+  GstBufferList *chunk;
+  guint i, n;
+
+  tr = gst_rtsp_stream_transport_get_transport (burst->trans);
+
+  g_mutex_lock (&priv->lock);
+  /* removed while it was sent the GOP */
+  if (!g_list_find (priv->gop_bursts, burst))
+    goto done;
+
+  /* no packet can be cached between the last chunk and the registering of
+   * the join, the packets after that are sent by the sinks */
+  g_mutex_lock (&priv->gop_lock);
+  if (catch_up_gop (priv, burst) || burst->n_chunks == GOP_BURST_MAX_CHUNKS)
+    goto caught_up;
+  g_mutex_unlock (&priv->gop_lock);
+
+  n = MIN (gst_buffer_list_length (burst->packets) - burst->sent,
+      GOP_BURST_CHUNK_SIZE);
+  chunk = gst_buffer_list_new_sized (n);
+  for (i = 0; i < n; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (burst->packets, burst->sent + i);
+
+    gst_buffer_list_add (chunk, gst_buffer_ref (buffer));
+  }
+  burst->sent += n;
+  burst->n_chunks++;
+  burst->sending = TRUE;
+  g_mutex_unlock (&priv->lock);
+
+  GST_LOG_OBJECT (stream, "sending %u cached packets to %s", n,
+      tr->destination);
+
+  if (tr->lower_transport == GST_RTSP_LOWER_TRANS_TCP) {
+    /* the next chunk is sent from on_gop_burst_sent() */
+    if (!gst_rtsp_stream_transport_send_rtp_list (burst->trans, chunk))
+      goto send_failed;
+  } else {
+    send_udp_burst (stream, tr, chunk);
+    /* nothing tells when the packets left, don't send them faster than the
+     * receiver and the network on the way can take them */
+    g_usleep (GOP_BURST_UDP_INTERVAL);
+    g_thread_pool_push (get_gop_bursters (), gop_burst_ref (burst), NULL);
+  }
+  gst_buffer_list_unref (chunk);
+  gop_burst_unref (burst);
+
+  return;
+
+caught_up:
+  {
+    GST_DEBUG_OBJECT (stream, "sent %u chunks of cached packets to %s",
+        burst->n_chunks, tr->destination);
+
+    priv->gop_bursts = g_list_remove (priv->gop_bursts, burst);
+    add_gop_join (stream, burst,
+        tr->lower_transport != GST_RTSP_LOWER_TRANS_TCP);
+    g_mutex_unlock (&priv->gop_lock);
+
+    if (tr->lower_transport == GST_RTSP_LOWER_TRANS_TCP)
+      gst_rtsp_stream_transport_set_message_sent (burst->trans,
+          on_message_sent, stream, NULL);
+    update_transport (stream, burst->trans, TRUE);
+    g_mutex_unlock (&priv->lock);
+    /* the references of the list and of this step */
+    gop_burst_unref (burst);
+    gop_burst_unref (burst);
+    return;
+  }
+done:
+  {
+    g_mutex_unlock (&priv->lock);
+    gop_burst_unref (burst);
+    return;
+  }
+
+  /* ERRORS */
+send_failed:
+  {
+    GST_WARNING_OBJECT (stream, "failed to send the GOP to %s",
+        tr->destination);
+    gst_buffer_list_unref (chunk);
+
+    g_mutex_lock (&priv->lock);
+    if (g_list_find (priv->gop_bursts, burst)) {
+      priv->gop_bursts = g_list_remove (priv->gop_bursts, burst);
+      gop_burst_unref (burst);
+    }
+    g_mutex_unlock (&priv->lock);
+    gop_burst_unref (burst);
+    return;
+  }
+}
+
+/* must be called with lock. Sends @packets to @trans before it is added */
+static void
+start_gop_burst (GstRTSPStream * stream, GstRTSPStreamTransport * trans,
+    GstBufferList * packets)
+{
+  GstRTSPStreamPrivate *priv = stream->priv;
+  const GstRTSPTransport *tr;
+  GopBurst *burst;
+
+  tr = gst_rtsp_stream_transport_get_transport (trans);
+
+  GST_DEBUG_OBJECT (stream, "sending %u cached packets to %s first",
+      gst_buffer_list_length (packets), tr->destination);
+
+  burst = g_new0 (GopBurst, 1);
+  burst->refcount = 1;
+  burst->stream = g_object_ref (stream);
+  burst->trans = g_object_ref (trans);
+  burst->packets = packets;
+
+  if (tr->lower_transport == GST_RTSP_LOWER_TRANS_TCP)
+    gst_rtsp_stream_transport_set_message_sent (trans, on_gop_burst_sent,
+        trans, NULL);
+
+  priv->gop_bursts = g_list_prepend (priv->gop_bursts, burst);
+  g_thread_pool_push (get_gop_bursters (), gop_burst_ref (burst), NULL);
+}
+
 /**
  * gst_rtsp_stream_add_transport:
  * @stream: a #GstRTSPStream
@@ -4522,6 +5583,12 @@ no_outstanding:
  *
  * @trans must contain a valid #GstRTSPTransport.
  *
+ * When the GOP cache of @stream is enabled, the cached packets are sent to
+ * @trans first in the background and @trans only receives the packets of
+ * @stream after that, see gst_rtsp_stream_set_gop_cache(). Otherwise a
+ * keyframe can be requested upstream, see
+ * gst_rtsp_stream_set_key_unit_interval().
+ *
  * Returns: %TRUE if @trans was added
  */
 gboolean
@@ -4529,6 +5596,8 @@ gst_rtsp_stream_add_transport (GstRTSPStream * stream,
     GstRTSPStreamTransport * trans)
 {
   GstRTSPStreamPrivate *priv;
+  GstBufferList *burst = NULL;
+  GstPad *key_unit_pad = NULL;
   gboolean res;
 
   g_return_val_if_fail (GST_IS_RTSP_STREAM (stream), FALSE);
@@ -4536,13 +5605,32 @@ gst_rtsp_stream_add_transport (GstRTSPStream * stream,
   g_return_val_if_fail (GST_IS_RTSP_STREAM_TRANSPORT (trans), FALSE);
   g_return_val_if_fail (priv->joined_bin != NULL, FALSE);
 
+  /* the GOP the RTP-Info of @trans was made for */
+  burst = gst_rtsp_stream_transport_take_burst (trans);
+
   g_mutex_lock (&priv->lock);
-  res = update_transport (stream, trans, TRUE);
-  if (res)
-    gst_rtsp_stream_transport_set_message_sent (trans, on_message_sent, stream,
-        NULL);
+  if (burst == NULL)
+    burst = get_gop_burst (stream, trans, NULL);
+
+  if (burst) {
+    /* @trans is added when it was sent the GOP */
+    start_gop_burst (stream, trans, burst);
+    res = TRUE;
+  } else {
+    res = update_transport (stream, trans, TRUE);
+    if (res) {
+      gst_rtsp_stream_transport_set_message_sent (trans, on_message_sent,
+          stream, NULL);
+      key_unit_pad = get_key_unit_pad (stream, trans);
+    }
+  }
   g_mutex_unlock (&priv->lock);
 
+  if (key_unit_pad) {
+    request_key_unit (stream, key_unit_pad);
+    gst_object_unref (key_unit_pad);
+  }
+
   return res;
 }
 
@@ -4565,6 +5653,7 @@ gst_rtsp_stream_remove_transport (GstRTSPStream * stream,
     GstRTSPStreamTransport * trans)
 {
   GstRTSPStreamPrivate *priv;
+  GopBurst *burst;
   gboolean res;
 
   g_return_val_if_fail (GST_IS_RTSP_STREAM (stream), FALSE);
@@ -4573,9 +5662,19 @@ gst_rtsp_stream_remove_transport (GstRTSPStream * stream,
   g_return_val_if_fail (priv->joined_bin != NULL, FALSE);
 
   g_mutex_lock (&priv->lock);
-  res = update_transport (stream, trans, FALSE);
+  burst = find_gop_burst (priv, trans);
+  if (burst) {
+    /* still being sent the GOP, it was not added yet */
+    priv->gop_bursts = g_list_remove (priv->gop_bursts, burst);
+    res = TRUE;
+  } else {
+    res = update_transport (stream, trans, FALSE);
+  }
   g_mutex_unlock (&priv->lock);
 
+  if (burst)
+    gop_burst_unref (burst);
+
   return res;
 }
 
@@ -5958,3 +7057,151 @@ gst_rtsp_stream_get_rate_control (GstRTSPStream * stream)
 
   return ret;
 }
+
+/**
+ * gst_rtsp_stream_set_gop_cache:
+ * @stream: a #GstRTSPStream
+ * @enabled: whether to cache the GOP
+ *
+ * Define whether @stream keeps the RTP packets since the last keyframe, as
+ * marked by the absence of the %GST_BUFFER_FLAG_DELTA_UNIT flag. A transport
+ * added with gst_rtsp_stream_add_transport() is sent the cached packets first
+ * so that a client joining a shared stream can start decoding without
+ * waiting for the next keyframe. The RTP-Info of such a transport, see
+ * gst_rtsp_stream_transport_get_rtpinfo(), starts from the first cached
+ * packet.
+ *
+ * The cached packets are sent in chunks, paced over UDP. The live packets
+ * that were already sent with the cached ones are not sent to the transport
+ * again. The cached packets are not sent to multicast transports.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_stream_set_gop_cache (GstRTSPStream * stream, gboolean enabled)
+{
+  g_return_if_fail (GST_IS_RTSP_STREAM (stream));
+
+  GST_DEBUG_OBJECT (stream, "%s GOP cache", enabled ? "Enabling" : "Disabling");
+
+  g_mutex_lock (&stream->priv->lock);
+  stream->priv->gop_cache = enabled;
+  if (enabled)
+    add_gop_probe (stream);
+  else
+    remove_gop_probe (stream);
+  g_mutex_unlock (&stream->priv->lock);
+}
+
+/**
+ * gst_rtsp_stream_get_gop_cache:
+ * @stream: a #GstRTSPStream
+ *
+ * Returns: whether @stream caches the packets since the last keyframe.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_stream_get_gop_cache (GstRTSPStream * stream)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_RTSP_STREAM (stream), FALSE);
+
+  g_mutex_lock (&stream->priv->lock);
+  ret = stream->priv->gop_cache;
+  g_mutex_unlock (&stream->priv->lock);
+
+  return ret;
+}
+
+/**
+ * gst_rtsp_stream_set_key_unit_interval:
+ * @stream: a #GstRTSPStream
+ * @interval: the minimum time between keyframe requests, or 0
+ *
+ * Define whether @stream requests a keyframe upstream with a
+ * "GstForceKeyUnit" event when a transport is added while @stream is already
+ * sent to other transports, so that the new client can start decoding without
+ * waiting for the next keyframe. Transports added within @interval of a
+ * request share this request. An @interval of 0 disables the requests.
+ *
+ * Only streams with "media=video" caps request keyframes, the packets of
+ * other media do not depend on earlier packets.
+ *
+ * No keyframe is requested when the transport is sent the cached GOP, see
+ * gst_rtsp_stream_set_gop_cache().
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_stream_set_key_unit_interval (GstRTSPStream * stream,
+    GstClockTime interval)
+{
+  g_return_if_fail (GST_IS_RTSP_STREAM (stream));
+
+  g_mutex_lock (&stream->priv->lock);
+  stream->priv->key_unit_interval = interval;
+  if (interval > 0)
+    add_key_unit_probe (stream);
+  else
+    remove_key_unit_probe (stream);
+  g_mutex_unlock (&stream->priv->lock);
+}
+
+/**
+ * gst_rtsp_stream_get_key_unit_interval:
+ * @stream: a #GstRTSPStream
+ *
+ * Returns: the minimum time between the keyframe requests of @stream, 0 when
+ * @stream does not request keyframes.
+ *
+ * Since: 1.18
+ */
+GstClockTime
+gst_rtsp_stream_get_key_unit_interval (GstRTSPStream * stream)
+{
+  GstClockTime ret;
+
+  g_return_val_if_fail (GST_IS_RTSP_STREAM (stream), 0);
+
+  g_mutex_lock (&stream->priv->lock);
+  ret = stream->priv->key_unit_interval;
+  g_mutex_unlock (&stream->priv->lock);
+
+  return ret;
+}
+
+/**
+ * gst_rtsp_stream_get_key_unit_stats:
+ * @stream: a #GstRTSPStream
+ *
+ * Get the counters of the keyframe requests of @stream. The result has the
+ * "requested" field for the requests sent upstream, the "coalesced" field for
+ * the transports that shared an earlier request and the "honoured" field for
+ * the requests that upstream handled and that were followed by a keyframe.
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
+ *
+ * Since: 1.18
+ */
+GstStructure *
+gst_rtsp_stream_get_key_unit_stats (GstRTSPStream * stream)
+{
+  GstRTSPStreamPrivate *priv;
+  GstStructure *result;
+
+  g_return_val_if_fail (GST_IS_RTSP_STREAM (stream), NULL);
+
+  priv = stream->priv;
+
+  g_mutex_lock (&priv->lock);
+  result = gst_structure_new ("application/x-rtsp-key-unit-stats",
+      "requested", G_TYPE_UINT, priv->key_units_requested,
+      "coalesced", G_TYPE_UINT, priv->key_units_coalesced,
+      "honoured", G_TYPE_UINT,
+      (guint) g_atomic_int_get (&priv->key_units_honoured), NULL);
+  g_mutex_unlock (&priv->lock);
+
+  return result;
+}
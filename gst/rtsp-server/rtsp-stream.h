@@ -365,6 +365,21 @@ void               gst_rtsp_stream_set_rate_control (GstRTSPStream * stream, gbo
 GST_RTSP_SERVER_API
 gboolean           gst_rtsp_stream_get_rate_control (GstRTSPStream * stream);
 
+GST_RTSP_SERVER_API
+void               gst_rtsp_stream_set_gop_cache (GstRTSPStream * stream, gboolean enabled);
+
+GST_RTSP_SERVER_API
+gboolean           gst_rtsp_stream_get_gop_cache (GstRTSPStream * stream);
+
+GST_RTSP_SERVER_API
+void               gst_rtsp_stream_set_key_unit_interval (GstRTSPStream * stream, GstClockTime interval);
+
+GST_RTSP_SERVER_API
+GstClockTime       gst_rtsp_stream_get_key_unit_interval (GstRTSPStream * stream);
+
+GST_RTSP_SERVER_API
+GstStructure *     gst_rtsp_stream_get_key_unit_stats (GstRTSPStream * stream);
+
 /**
  * GstRTSPStreamTransportFilterFunc:
  * @stream: a #GstRTSPStream object
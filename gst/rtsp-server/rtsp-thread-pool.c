@@ -30,12 +30,27 @@
  * same thread for multiple clients.
  *
  * Threads of type #GST_RTSP_THREAD_TYPE_MEDIA will be used to perform the state
- * changes of the media pipelines and handle its bus messages.
+ * changes of the media pipelines and handle its bus messages. By default each
+ * media gets its own thread. With gst_rtsp_thread_pool_set_max_media_threads()
+ * a maximum number of media threads can be set after which a new media is
+ * handled by the media thread with the fewest medias.
  *
  * gst_rtsp_thread_pool_get_thread() can be used to create a #GstRTSPThread
  * object of the right type. The thread object contains a mainloop and context
  * that run in a seperate thread and can be used to attached sources to.
  *
+ * When the maximum number of client threads is reached, a new client is handled
+ * by the least loaded thread. The load of a thread is made of the number of
+ * users of the thread, the time its mainloop spends dispatching and the bytes
+ * sent by the clients on the thread, see gst_rtsp_thread_add_bytes_sent(). The
+ * load of the threads can be retrieved with gst_rtsp_thread_pool_get_stats().
+ *
+ * With gst_rtsp_thread_pool_set_cpus() the threads can be pinned to a set of
+ * CPUs. Each CPU of the set then gets its own client thread and a new client
+ * is handled by the thread of the CPU that received its connection. Media
+ * threads are pinned to the CPUs of the set that are on the NUMA node of the
+ * client thread that made the media.
+ *
  * gst_rtsp_thread_reuse() can be used to reuse a thread for multiple purposes.
  * If all gst_rtsp_thread_reuse() calls are matched with a
  * gst_rtsp_thread_stop() call, the mainloop will be quit and the thread will
@@ -50,9 +65,18 @@
 #include "config.h"
 #endif
 
+#ifdef HAVE_SCHED_SETAFFINITY
+#define _GNU_SOURCE
+#include <sched.h>
+#include <errno.h>
+#endif
+
 #include <string.h>
 
+#include <gio/gnetworking.h>
+
 #include "rtsp-thread-pool.h"
+#include "rtsp-server-internal.h"
 
 typedef struct _GstRTSPThreadImpl
 {
@@ -62,8 +86,32 @@ typedef struct _GstRTSPThreadImpl
   GSource *source;
   /* FIXME, the source has to be part of GstRTSPThreadImpl, due to a bug in GLib:
    * https://bugzilla.gnome.org/show_bug.cgi?id=720186 */
+
+  /* load measurement, only used from the thread itself */
+  gint64 poll_exit;
+  gint64 window_start;
+  gint64 window_busy;
+  volatile gsize bytes_sent;    /* atomic */
+
+  GMutex load_lock;
+  gdouble busy;                 /* protected by load_lock */
+  guint64 bytes_per_second;     /* protected by load_lock */
+
+  /* CPU of a pinned client thread or -1 */
+  gint cpu;
+  /* CPUs to run the thread on or NULL */
+  GArray *affinity;
 } GstRTSPThreadImpl;
 
+/* the highest CPU number we accept in a CPU list */
+#define MAX_CPU       4095
+
+/* the interval over which the load of a thread is measured */
+#define LOAD_WINDOW   G_USEC_PER_SEC
+
+/* the thread running the current mainloop, for load_poll() */
+static GPrivate current_thread;
+
 GST_DEFINE_MINI_OBJECT_TYPE (GstRTSPThread, gst_rtsp_thread);
 
 static void gst_rtsp_thread_init (GstRTSPThreadImpl * impl);
@@ -74,6 +122,9 @@ _gst_rtsp_thread_free (GstRTSPThreadImpl * impl)
   GST_DEBUG ("free thread %p", impl);
 
   g_source_unref (impl->source);
+  g_mutex_clear (&impl->load_lock);
+  if (impl->affinity)
+    g_array_unref (impl->affinity);
   g_main_loop_unref (impl->thread.loop);
   g_main_context_unref (impl->thread.context);
   g_slice_free1 (sizeof (GstRTSPThreadImpl), impl);
@@ -103,6 +154,8 @@ gst_rtsp_thread_init (GstRTSPThreadImpl * impl)
       (GstMiniObjectFreeFunction) _gst_rtsp_thread_free);
 
   g_atomic_int_set (&impl->reused, 1);
+  g_mutex_init (&impl->load_lock);
+  impl->cpu = -1;
 }
 
 /**
@@ -187,21 +240,234 @@ gst_rtsp_thread_stop (GstRTSPThread * thread)
     gst_rtsp_thread_unref (thread);
 }
 
+/**
+ * gst_rtsp_thread_add_bytes_sent:
+ * @thread: a #GstRTSPThread
+ * @bytes: the number of bytes
+ *
+ * Account @bytes sent by a user of @thread in the load of @thread. This
+ * function can be called from any thread.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_thread_add_bytes_sent (GstRTSPThread * thread, gsize bytes)
+{
+  GstRTSPThreadImpl *impl = (GstRTSPThreadImpl *) thread;
+
+  g_return_if_fail (GST_IS_RTSP_THREAD (thread));
+
+  g_atomic_pointer_add (&impl->bytes_sent, bytes);
+}
+
+/* called from the thread, publish the load of the last window */
+static void
+update_load (GstRTSPThreadImpl * impl, gint64 now)
+{
+  gint64 elapsed = now - impl->window_start;
+  gsize bytes;
+
+  if (elapsed < LOAD_WINDOW)
+    return;
+
+  bytes = g_atomic_pointer_and (&impl->bytes_sent, 0);
+
+  g_mutex_lock (&impl->load_lock);
+  impl->busy = (gdouble) impl->window_busy / elapsed;
+  impl->bytes_per_second =
+      gst_util_uint64_scale (bytes, G_USEC_PER_SEC, elapsed);
+  g_mutex_unlock (&impl->load_lock);
+
+  impl->window_start = now;
+  impl->window_busy = 0;
+}
+
+/* poll function of the client threads, the time between two polls is the
+ * time spent dispatching */
+static gint
+load_poll (GPollFD * ufds, guint nfds, gint timeout)
+{
+  GstRTSPThreadImpl *impl = g_private_get (&current_thread);
+  gint64 now;
+  gint res;
+
+  if (impl == NULL)
+    return g_poll (ufds, nfds, timeout);
+
+  now = g_get_monotonic_time ();
+  impl->window_busy += now - impl->poll_exit;
+  update_load (impl, now);
+
+  /* wake up once per window so that the load of an idle thread decays */
+  if (timeout < 0 || timeout > LOAD_WINDOW / 1000)
+    timeout = LOAD_WINDOW / 1000;
+
+  res = g_poll (ufds, nfds, timeout);
+  impl->poll_exit = g_get_monotonic_time ();
+
+  return res;
+}
+
+/* parse a list of CPUs like "0-3,8,10-11", as used by sysfs */
+static GArray *
+parse_cpu_list (const gchar * str)
+{
+  GArray *cpus;
+  gchar **ranges;
+  guint i;
+
+  cpus = g_array_new (FALSE, FALSE, sizeof (gint));
+  ranges = g_strsplit (str, ",", -1);
+
+  for (i = 0; ranges[i]; i++) {
+    gchar *range = g_strstrip (ranges[i]), *end;
+    guint64 first, last;
+    gint cpu;
+
+    first = last = g_ascii_strtoull (range, &end, 10);
+    if (end == range)
+      goto invalid;
+    if (*end == '-') {
+      range = end + 1;
+      last = g_ascii_strtoull (range, &end, 10);
+      if (end == range)
+        goto invalid;
+    }
+    if (*end != '\0' || first > last || last > MAX_CPU)
+      goto invalid;
+
+    for (cpu = first; cpu <= last; cpu++)
+      g_array_append_val (cpus, cpu);
+  }
+  g_strfreev (ranges);
+
+  if (cpus->len == 0)
+    goto empty;
+
+  return cpus;
+
+  /* ERRORS */
+invalid:
+  {
+    GST_WARNING ("invalid CPU list '%s'", str);
+    g_strfreev (ranges);
+    g_array_unref (cpus);
+    return NULL;
+  }
+empty:
+  {
+    GST_WARNING ("empty CPU list '%s'", str);
+    g_array_unref (cpus);
+    return NULL;
+  }
+}
+
+static gboolean
+has_cpu (GArray * cpus, gint cpu)
+{
+  guint i;
+
+  for (i = 0; i < cpus->len; i++) {
+    if (g_array_index (cpus, gint, i) == cpu)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* the CPUs of the NUMA node of @cpu, only @cpu when the node is unknown */
+static GArray *
+node_cpus (gint cpu)
+{
+  GArray *result = NULL;
+  const gchar *name;
+  gchar *path;
+  GDir *dir;
+
+  path = g_strdup_printf ("/sys/devices/system/cpu/cpu%d", cpu);
+  dir = g_dir_open (path, 0, NULL);
+  g_free (path);
+
+  if (dir) {
+    while ((name = g_dir_read_name (dir))) {
+      gchar *contents;
+
+      if (!g_str_has_prefix (name, "node") || !g_ascii_isdigit (name[4]))
+        continue;
+
+      path = g_strdup_printf ("/sys/devices/system/node/%s/cpulist", name);
+      if (g_file_get_contents (path, &contents, NULL, NULL)) {
+        result = parse_cpu_list (contents);
+        g_free (contents);
+      }
+      g_free (path);
+      break;
+    }
+    g_dir_close (dir);
+  }
+
+  if (result == NULL) {
+    result = g_array_new (FALSE, FALSE, sizeof (gint));
+    g_array_append_val (result, cpu);
+  }
+  return result;
+}
+
+#ifdef HAVE_SCHED_SETAFFINITY
+/* called from the thread, restrict it to @cpus and keep the old CPUs of the
+ * thread in @saved */
+static gboolean
+set_affinity (GArray * cpus, cpu_set_t * saved)
+{
+  cpu_set_t set;
+  guint i;
+
+  if (sched_getaffinity (0, sizeof (cpu_set_t), saved) < 0)
+    goto failed;
+
+  CPU_ZERO (&set);
+  for (i = 0; i < cpus->len; i++) {
+    gint cpu = g_array_index (cpus, gint, i);
+
+    if (cpu < CPU_SETSIZE)
+      CPU_SET (cpu, &set);
+  }
+  if (sched_setaffinity (0, sizeof (cpu_set_t), &set) < 0)
+    goto failed;
+
+  return TRUE;
+
+  /* ERRORS */
+failed:
+  {
+    GST_WARNING ("failed to set CPU affinity: %s", g_strerror (errno));
+    return FALSE;
+  }
+}
+#endif
+
 struct _GstRTSPThreadPoolPrivate
 {
   GMutex lock;
 
   gint max_threads;
+  gint max_media_threads;
+  /* CPUs to pin the threads to or NULL */
+  gchar *cpus_str;
+  GArray *cpus;
   /* currently used mainloops */
   GQueue threads;
+  GQueue media_threads;
 };
 
 #define DEFAULT_MAX_THREADS 1
+#define DEFAULT_MAX_MEDIA_THREADS -1
 
 enum
 {
   PROP_0,
   PROP_MAX_THREADS,
+  PROP_MAX_MEDIA_THREADS,
+  PROP_CPUS,
   PROP_LAST
 };
 
@@ -247,6 +513,35 @@ gst_rtsp_thread_pool_class_init (GstRTSPThreadPoolClass * klass)
           "(0 = only mainloop, -1 = unlimited)", -1, G_MAXINT,
           DEFAULT_MAX_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPThreadPool::max-media-threads:
+   *
+   * The maximum amount of threads to use for medias. A value of 0 or -1 means
+   * to use a thread for each media.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_MEDIA_THREADS,
+      g_param_spec_int ("max-media-threads", "Max Media Threads",
+          "The maximum amount of threads to use for medias "
+          "(0 or -1 = a thread for each media)", -1, G_MAXINT,
+          DEFAULT_MAX_MEDIA_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPThreadPool::cpus:
+   *
+   * The CPUs to pin the threads to, as a list like "0-3,8" or %NULL to not
+   * pin the threads.
+   *
+   * Since: 1.18
+   */
+  g_object_class_install_property (gobject_class, PROP_CPUS,
+      g_param_spec_string ("cpus", "CPUs",
+          "The CPUs to pin the threads to, as a list like \"0-3,8\" "
+          "(NULL = don't pin)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   klass->get_thread = default_get_thread;
 
   GST_DEBUG_CATEGORY_INIT (rtsp_thread_pool_debug, "rtspthreadpool", 0,
@@ -264,7 +559,9 @@ gst_rtsp_thread_pool_init (GstRTSPThreadPool * pool)
 
   g_mutex_init (&priv->lock);
   priv->max_threads = DEFAULT_MAX_THREADS;
+  priv->max_media_threads = DEFAULT_MAX_MEDIA_THREADS;
   g_queue_init (&priv->threads);
+  g_queue_init (&priv->media_threads);
 }
 
 static void
@@ -276,6 +573,10 @@ gst_rtsp_thread_pool_finalize (GObject * obj)
   GST_INFO ("finalize pool %p", pool);
 
   g_queue_clear (&priv->threads);
+  g_queue_clear (&priv->media_threads);
+  g_free (priv->cpus_str);
+  if (priv->cpus)
+    g_array_unref (priv->cpus);
   g_mutex_clear (&priv->lock);
 
   G_OBJECT_CLASS (gst_rtsp_thread_pool_parent_class)->finalize (obj);
@@ -291,6 +592,13 @@ gst_rtsp_thread_pool_get_property (GObject * object, guint propid,
     case PROP_MAX_THREADS:
       g_value_set_int (value, gst_rtsp_thread_pool_get_max_threads (pool));
       break;
+    case PROP_MAX_MEDIA_THREADS:
+      g_value_set_int (value,
+          gst_rtsp_thread_pool_get_max_media_threads (pool));
+      break;
+    case PROP_CPUS:
+      g_value_take_string (value, gst_rtsp_thread_pool_get_cpus (pool));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -306,6 +614,13 @@ gst_rtsp_thread_pool_set_property (GObject * object, guint propid,
     case PROP_MAX_THREADS:
       gst_rtsp_thread_pool_set_max_threads (pool, g_value_get_int (value));
       break;
+    case PROP_MAX_MEDIA_THREADS:
+      gst_rtsp_thread_pool_set_max_media_threads (pool,
+          g_value_get_int (value));
+      break;
+    case PROP_CPUS:
+      gst_rtsp_thread_pool_set_cpus (pool, g_value_get_string (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, propid, pspec);
   }
@@ -314,27 +629,54 @@ gst_rtsp_thread_pool_set_property (GObject * object, guint propid,
 static gpointer
 do_loop (GstRTSPThread * thread)
 {
+  GstRTSPThreadImpl *impl = (GstRTSPThreadImpl *) thread;
   GstRTSPThreadPoolPrivate *priv;
   GstRTSPThreadPoolClass *klass;
   GstRTSPThreadPool *pool;
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t saved;
+  gboolean pinned = FALSE;
+#endif
 
   pool = gst_mini_object_get_qdata (GST_MINI_OBJECT (thread), thread_pool);
   priv = pool->priv;
 
   klass = GST_RTSP_THREAD_POOL_GET_CLASS (pool);
 
+#ifdef HAVE_SCHED_SETAFFINITY
+  if (impl->affinity)
+    pinned = set_affinity (impl->affinity, &saved);
+#endif
+
   if (klass->thread_enter)
     klass->thread_enter (pool, thread);
 
+  if (thread->type == GST_RTSP_THREAD_TYPE_CLIENT) {
+    impl->poll_exit = impl->window_start = g_get_monotonic_time ();
+    g_private_set (&current_thread, impl);
+    g_main_context_set_poll_func (thread->context, load_poll);
+  }
+
   GST_INFO ("enter mainloop of thread %p", thread);
   g_main_loop_run (thread->loop);
   GST_INFO ("exit mainloop of thread %p", thread);
 
+  g_private_set (&current_thread, NULL);
+
   if (klass->thread_leave)
     klass->thread_leave (pool, thread);
 
+#ifdef HAVE_SCHED_SETAFFINITY
+  /* the thread goes back to the GThreadPool, let it run anywhere again */
+  if (pinned)
+    sched_setaffinity (0, sizeof (cpu_set_t), &saved);
+#endif
+
   g_mutex_lock (&priv->lock);
-  g_queue_remove (&priv->threads, thread);
+  if (thread->type == GST_RTSP_THREAD_TYPE_CLIENT)
+    g_queue_remove (&priv->threads, thread);
+  else
+    g_queue_remove (&priv->media_threads, thread);
   g_mutex_unlock (&priv->lock);
 
   gst_rtsp_thread_unref (thread);
@@ -409,6 +751,132 @@ gst_rtsp_thread_pool_get_max_threads (GstRTSPThreadPool * pool)
   return res;
 }
 
+/**
+ * gst_rtsp_thread_pool_set_max_media_threads:
+ * @pool: a #GstRTSPThreadPool
+ * @max_media_threads: maximum media threads
+ *
+ * Set the maximum threads used by the pool to handle the bus messages and
+ * state changes of medias. When the maximum is reached, the media thread with
+ * the fewest medias is shared by the new media. A value of 0 or -1 will use a
+ * thread for each media.
+ *
+ * Since: 1.18
+ */
+void
+gst_rtsp_thread_pool_set_max_media_threads (GstRTSPThreadPool * pool,
+    gint max_media_threads)
+{
+  GstRTSPThreadPoolPrivate *priv;
+
+  g_return_if_fail (GST_IS_RTSP_THREAD_POOL (pool));
+
+  priv = pool->priv;
+
+  g_mutex_lock (&priv->lock);
+  priv->max_media_threads = max_media_threads;
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * gst_rtsp_thread_pool_get_max_media_threads:
+ * @pool: a #GstRTSPThreadPool
+ *
+ * Get the maximum number of threads used for medias.
+ * See gst_rtsp_thread_pool_set_max_media_threads().
+ *
+ * Returns: the maximum number of media threads.
+ *
+ * Since: 1.18
+ */
+gint
+gst_rtsp_thread_pool_get_max_media_threads (GstRTSPThreadPool * pool)
+{
+  GstRTSPThreadPoolPrivate *priv;
+  gint res;
+
+  g_return_val_if_fail (GST_IS_RTSP_THREAD_POOL (pool), -1);
+
+  priv = pool->priv;
+
+  g_mutex_lock (&priv->lock);
+  res = priv->max_media_threads;
+  g_mutex_unlock (&priv->lock);
+
+  return res;
+}
+
+/**
+ * gst_rtsp_thread_pool_set_cpus:
+ * @pool: a #GstRTSPThreadPool
+ * @cpus: (nullable): a list of CPUs like "0-3,8"
+ *
+ * Pin the threads made by @pool to @cpus. Each CPU gets one client thread and
+ * a client is handled by the thread of the CPU that received its connection,
+ * when the system tells. Media threads run on the CPUs of @cpus on the NUMA
+ * node of the client thread that made the media.
+ *
+ * A %NULL @cpus will not pin the threads. The CPUs are used for the threads
+ * made after this call.
+ *
+ * Returns: %TRUE if @cpus could be parsed
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_thread_pool_set_cpus (GstRTSPThreadPool * pool, const gchar * cpus)
+{
+  GstRTSPThreadPoolPrivate *priv;
+  GArray *list = NULL, *old;
+
+  g_return_val_if_fail (GST_IS_RTSP_THREAD_POOL (pool), FALSE);
+
+  priv = pool->priv;
+
+  if (cpus && !(list = parse_cpu_list (cpus)))
+    return FALSE;
+
+  g_mutex_lock (&priv->lock);
+  g_free (priv->cpus_str);
+  priv->cpus_str = g_strdup (cpus);
+  old = priv->cpus;
+  priv->cpus = list;
+  g_mutex_unlock (&priv->lock);
+
+  if (old)
+    g_array_unref (old);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtsp_thread_pool_get_cpus:
+ * @pool: a #GstRTSPThreadPool
+ *
+ * Get the CPUs the threads of @pool are pinned to.
+ * See gst_rtsp_thread_pool_set_cpus().
+ *
+ * Returns: (transfer full) (nullable): the list of CPUs, g_free() after usage.
+ *
+ * Since: 1.18
+ */
+gchar *
+gst_rtsp_thread_pool_get_cpus (GstRTSPThreadPool * pool)
+{
+  GstRTSPThreadPoolPrivate *priv;
+  gchar *res;
+
+  g_return_val_if_fail (GST_IS_RTSP_THREAD_POOL (pool), NULL);
+
+  priv = pool->priv;
+
+  g_mutex_lock (&priv->lock);
+  res = g_strdup (priv->cpus_str);
+  g_mutex_unlock (&priv->lock);
+
+  return res;
+}
+
 static GstRTSPThread *
 make_thread (GstRTSPThreadPool * pool, GstRTSPThreadType type,
     GstRTSPContext * ctx)
@@ -430,6 +898,207 @@ make_thread (GstRTSPThreadPool * pool, GstRTSPThreadType type,
   return thread;
 }
 
+typedef struct
+{
+  gint clients;
+  gdouble busy;
+  guint64 bytes_per_second;
+} ThreadLoad;
+
+static void
+get_load (GstRTSPThread * thread, ThreadLoad * load)
+{
+  GstRTSPThreadImpl *impl = (GstRTSPThreadImpl *) thread;
+
+  load->clients = g_atomic_int_get (&impl->reused);
+  g_mutex_lock (&impl->load_lock);
+  load->busy = impl->busy;
+  load->bytes_per_second = impl->bytes_per_second;
+  g_mutex_unlock (&impl->load_lock);
+}
+
+static gdouble
+load_share (gdouble value, gdouble total)
+{
+  return total > 0.0 ? value / total : 0.0;
+}
+
+/* with the pool lock, the score of a thread is the sum of its share in the
+ * clients, the dispatch time and the bytes sent of all threads */
+static GstRTSPThread *
+least_loaded_thread (GstRTSPThreadPool * pool)
+{
+  GstRTSPThreadPoolPrivate *priv = pool->priv;
+  GstRTSPThread *result = NULL;
+  ThreadLoad load, total = { 0, };
+  gdouble score, best = G_MAXDOUBLE;
+  GList *walk;
+
+  for (walk = priv->threads.head; walk; walk = walk->next) {
+    get_load (walk->data, &load);
+    total.clients += load.clients;
+    total.busy += load.busy;
+    total.bytes_per_second += load.bytes_per_second;
+  }
+
+  for (walk = priv->threads.head; walk; walk = walk->next) {
+    get_load (walk->data, &load);
+    score = load_share (load.clients, total.clients) +
+        load_share (load.busy, total.busy) +
+        load_share (load.bytes_per_second, total.bytes_per_second);
+    if (score < best) {
+      best = score;
+      result = walk->data;
+    }
+  }
+
+  return result;
+}
+
+/* the CPU that received the connection of the client in @ctx or -1 */
+static gint
+incoming_cpu (GstRTSPContext * ctx)
+{
+  gint cpu = -1;
+#ifdef SO_INCOMING_CPU
+  GstRTSPConnection *conn;
+
+  if (ctx == NULL || ctx->client == NULL)
+    return -1;
+
+  conn = gst_rtsp_client_get_connection (ctx->client);
+  if (conn == NULL)
+    return -1;
+
+  if (!g_socket_get_option (gst_rtsp_connection_get_read_socket (conn),
+          SOL_SOCKET, SO_INCOMING_CPU, &cpu, NULL))
+    cpu = -1;
+#endif
+  return cpu;
+}
+
+/* with the pool lock, the client thread pinned to @cpu */
+static GstRTSPThread *
+find_pinned_thread (GstRTSPThreadPool * pool, gint cpu)
+{
+  GList *walk;
+
+  for (walk = pool->priv->threads.head; walk; walk = walk->next) {
+    GstRTSPThreadImpl *impl = walk->data;
+
+    if (impl->cpu == cpu)
+      return walk->data;
+  }
+  return NULL;
+}
+
+/* with the pool lock, the CPU of the thread for the client in @ctx. This is
+ * the CPU that received the connection when it is one of the CPUs of the
+ * pool, else a CPU without a thread. Returns -1 when the threads are not
+ * pinned or when all CPUs have a thread */
+static gint
+client_cpu (GstRTSPThreadPool * pool, GstRTSPContext * ctx)
+{
+  GstRTSPThreadPoolPrivate *priv = pool->priv;
+  gint cpu;
+  guint i;
+
+  if (priv->cpus == NULL)
+    return -1;
+
+  cpu = incoming_cpu (ctx);
+  if (cpu >= 0 && has_cpu (priv->cpus, cpu))
+    return cpu;
+
+  for (i = 0; i < priv->cpus->len; i++) {
+    cpu = g_array_index (priv->cpus, gint, i);
+    if (find_pinned_thread (pool, cpu) == NULL)
+      return cpu;
+  }
+  return -1;
+}
+
+static void
+pin_client_thread (GstRTSPThread * thread, gint cpu)
+{
+  GstRTSPThreadImpl *impl = (GstRTSPThreadImpl *) thread;
+
+  impl->cpu = cpu;
+  impl->affinity = g_array_new (FALSE, FALSE, sizeof (gint));
+  g_array_append_val (impl->affinity, cpu);
+}
+
+/* the CPU of the thread of the client in @ctx or -1 */
+static gint
+client_thread_cpu (GstRTSPContext * ctx)
+{
+  GstRTSPThreadImpl *client_thread = NULL;
+  gint cpu = -1;
+
+  if (ctx && ctx->client)
+    client_thread = (GstRTSPThreadImpl *)
+        gst_rtsp_client_get_thread (ctx->client);
+
+  if (client_thread) {
+    cpu = client_thread->cpu;
+    gst_rtsp_thread_unref (GST_RTSP_THREAD_CAST (client_thread));
+  }
+  return cpu;
+}
+
+/* with the pool lock, the CPUs for a media thread: the CPUs of the pool on
+ * @node, the CPUs of the NUMA node of the client thread */
+static GArray *
+media_affinity (GstRTSPThreadPool * pool, GArray * node)
+{
+  GstRTSPThreadPoolPrivate *priv = pool->priv;
+  GArray *result = NULL;
+  guint i;
+
+  if (priv->cpus) {
+    if (node) {
+      result = g_array_new (FALSE, FALSE, sizeof (gint));
+      for (i = 0; i < node->len; i++) {
+        gint cpu = g_array_index (node, gint, i);
+
+        if (has_cpu (priv->cpus, cpu))
+          g_array_append_val (result, cpu);
+      }
+      if (result->len == 0) {
+        g_array_unref (result);
+        result = NULL;
+      }
+    }
+    if (result == NULL)
+      result = g_array_ref (priv->cpus);
+  }
+  return result;
+}
+
+/* with the pool lock, the media thread with the fewest medias, preferring the
+ * threads that run on @cpu */
+static GstRTSPThread *
+least_used_media_thread (GstRTSPThreadPool * pool, gint cpu)
+{
+  GstRTSPThread *result = NULL;
+  gint users, best = G_MAXINT;
+  GList *walk;
+
+  for (walk = pool->priv->media_threads.head; walk; walk = walk->next) {
+    GstRTSPThreadImpl *impl = walk->data;
+
+    users = g_atomic_int_get (&impl->reused);
+    if (cpu >= 0 && (impl->affinity == NULL || !has_cpu (impl->affinity, cpu)))
+      users += G_MAXINT / 2;
+
+    if (users < best) {
+      best = users;
+      result = walk->data;
+    }
+  }
+  return result;
+}
+
 static GstRTSPThread *
 default_get_thread (GstRTSPThreadPool * pool,
     GstRTSPThreadType type, GstRTSPContext * ctx)
@@ -437,7 +1106,9 @@ default_get_thread (GstRTSPThreadPool * pool,
   GstRTSPThreadPoolPrivate *priv = pool->priv;
   GstRTSPThreadPoolClass *klass;
   GstRTSPThread *thread;
+  GArray *node = NULL, *affinity;
   GError *error = NULL;
+  gint cpu;
 
   klass = GST_RTSP_THREAD_POOL_GET_CLASS (pool);
 
@@ -450,40 +1121,84 @@ default_get_thread (GstRTSPThreadPool * pool,
       } else {
         g_mutex_lock (&priv->lock);
       retry:
-        if (priv->max_threads > 0 &&
+        cpu = client_cpu (pool, ctx);
+        if (cpu >= 0)
+          thread = find_pinned_thread (pool, cpu);
+        else if (priv->cpus != NULL)
+          /* all CPUs have their thread */
+          thread = least_loaded_thread (pool);
+        else
+          thread = NULL;
+
+        if (thread == NULL && priv->max_threads > 0 &&
             g_queue_get_length (&priv->threads) >= priv->max_threads) {
-          /* max threads reached, recycle from queue */
-          thread = g_queue_pop_head (&priv->threads);
+          /* max threads reached, recycle the least loaded thread */
+          thread = least_loaded_thread (pool);
+        }
+
+        if (thread) {
           GST_DEBUG_OBJECT (pool, "recycle client thread %p", thread);
           if (!gst_rtsp_thread_reuse (thread)) {
             GST_DEBUG_OBJECT (pool, "thread %p stopping, retry", thread);
             /* this can happen if we just decremented the reuse counter of the
-             * thread and signaled the mainloop that it should stop. We leave
-             * the thread out of the queue now, there is no point to add it
-             * again, it will be removed from the mainloop otherwise after it
+             * thread and signaled the mainloop that it should stop. We take
+             * the thread out of the queue now, there is no point to keep it,
+             * it will be removed from the mainloop otherwise after it
              * stops. */
+            g_queue_remove (&priv->threads, thread);
             goto retry;
           }
         } else {
           /* make more threads */
-          GST_DEBUG_OBJECT (pool, "make new client thread");
+          GST_DEBUG_OBJECT (pool, "make new client thread on CPU %d", cpu);
           thread = make_thread (pool, type, ctx);
+          if (cpu >= 0)
+            pin_client_thread (thread, cpu);
 
           if (!g_thread_pool_push (klass->pool, gst_rtsp_thread_ref (thread),
                   &error))
             goto thread_error;
+          g_queue_push_tail (&priv->threads, thread);
         }
-        g_queue_push_tail (&priv->threads, thread);
         g_mutex_unlock (&priv->lock);
       }
       break;
     case GST_RTSP_THREAD_TYPE_MEDIA:
-      GST_DEBUG_OBJECT (pool, "make new media thread");
-      thread = make_thread (pool, type, ctx);
+      /* place the media near the client */
+      cpu = client_thread_cpu (ctx);
+      node = cpu >= 0 ? node_cpus (cpu) : NULL;
+
+      g_mutex_lock (&priv->lock);
+      affinity = media_affinity (pool, node);
+    retry_media:
+      if (priv->max_media_threads > 0 &&
+          g_queue_get_length (&priv->media_threads) >=
+          priv->max_media_threads) {
+        /* max media threads reached, share the least used thread */
+        thread = least_used_media_thread (pool, cpu);
+        GST_DEBUG_OBJECT (pool, "recycle media thread %p", thread);
+        if (!gst_rtsp_thread_reuse (thread)) {
+          GST_DEBUG_OBJECT (pool, "thread %p stopping, retry", thread);
+          g_queue_remove (&priv->media_threads, thread);
+          goto retry_media;
+        }
+      } else {
+        GST_DEBUG_OBJECT (pool, "make new media thread");
+        thread = make_thread (pool, type, ctx);
+        ((GstRTSPThreadImpl *) thread)->affinity = affinity;
+        affinity = NULL;
+
+        if (!g_thread_pool_push (klass->pool, gst_rtsp_thread_ref (thread),
+                &error))
+          goto thread_error;
+        g_queue_push_tail (&priv->media_threads, thread);
+      }
+      g_mutex_unlock (&priv->lock);
 
-      if (!g_thread_pool_push (klass->pool, gst_rtsp_thread_ref (thread),
-              &error))
-        goto thread_error;
+      if (affinity)
+        g_array_unref (affinity);
+      if (node)
+        g_array_unref (node);
       break;
     default:
       thread = NULL;
@@ -494,7 +1209,10 @@ default_get_thread (GstRTSPThreadPool * pool,
   /* ERRORS */
 thread_error:
   {
+    g_mutex_unlock (&priv->lock);
     GST_ERROR_OBJECT (pool, "failed to push thread %s", error->message);
+    if (node)
+      g_array_unref (node);
     gst_rtsp_thread_unref (thread);
     /* drop also the ref dedicated for the pool */
     gst_rtsp_thread_unref (thread);
@@ -541,6 +1259,76 @@ gst_rtsp_thread_pool_get_thread (GstRTSPThreadPool * pool,
   return result;
 }
 
+/**
+ * gst_rtsp_thread_pool_get_stats:
+ * @pool: a #GstRTSPThreadPool
+ *
+ * Get the load of the threads of @pool. The "threads" field of the
+ * result is an array with a structure for each thread, with the "clients"
+ * field for the number of users of the thread, the "busy" field for the
+ * fraction of time the mainloop of the thread was dispatching and the
+ * "bytes-per-second" field for the bytes sent by the clients of the thread,
+ * measured over the last second and the "cpu" field for the CPU the thread is
+ * pinned to or -1, see gst_rtsp_thread_pool_set_cpus(). The "media-threads"
+ * field is an array with a structure for each media thread, with the "medias"
+ * field for the number of medias handled by the thread.
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
+ *
+ * Since: 1.18
+ */
+GstStructure *
+gst_rtsp_thread_pool_get_stats (GstRTSPThreadPool * pool)
+{
+  GstRTSPThreadPoolPrivate *priv;
+  GValue threads = G_VALUE_INIT;
+  GValue media_threads = G_VALUE_INIT;
+  GstStructure *result;
+  GList *walk;
+
+  g_return_val_if_fail (GST_IS_RTSP_THREAD_POOL (pool), NULL);
+
+  priv = pool->priv;
+
+  g_value_init (&threads, GST_TYPE_ARRAY);
+  g_value_init (&media_threads, GST_TYPE_ARRAY);
+
+  g_mutex_lock (&priv->lock);
+  for (walk = priv->threads.head; walk; walk = walk->next) {
+    GValue value = G_VALUE_INIT;
+    GstRTSPThreadImpl *impl = walk->data;
+    ThreadLoad load;
+
+    get_load (walk->data, &load);
+
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    gst_value_take_structure (&value,
+        gst_structure_new ("application/x-rtsp-thread-load",
+            "clients", G_TYPE_INT, load.clients,
+            "busy", G_TYPE_DOUBLE, load.busy,
+            "bytes-per-second", G_TYPE_UINT64, load.bytes_per_second,
+            "cpu", G_TYPE_INT, impl->cpu, NULL));
+    gst_value_array_append_and_take_value (&threads, &value);
+  }
+  for (walk = priv->media_threads.head; walk; walk = walk->next) {
+    GValue value = G_VALUE_INIT;
+    GstRTSPThreadImpl *impl = walk->data;
+
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    gst_value_take_structure (&value,
+        gst_structure_new ("application/x-rtsp-media-thread-load",
+            "medias", G_TYPE_INT, g_atomic_int_get (&impl->reused), NULL));
+    gst_value_array_append_and_take_value (&media_threads, &value);
+  }
+  g_mutex_unlock (&priv->lock);
+
+  result = gst_structure_new_empty ("application/x-rtsp-thread-pool-stats");
+  gst_structure_take_value (result, "threads", &threads);
+  gst_structure_take_value (result, "media-threads", &media_threads);
+
+  return result;
+}
+
 /**
  * gst_rtsp_thread_pool_cleanup:
  *
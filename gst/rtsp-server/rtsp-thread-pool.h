@@ -87,6 +87,9 @@ gboolean          gst_rtsp_thread_reuse    (GstRTSPThread * thread);
 GST_RTSP_SERVER_API
 void              gst_rtsp_thread_stop     (GstRTSPThread * thread);
 
+GST_RTSP_SERVER_API
+void              gst_rtsp_thread_add_bytes_sent (GstRTSPThread * thread, gsize bytes);
+
 /**
  * gst_rtsp_thread_ref:
  * @thread: The thread to refcount
@@ -171,11 +174,27 @@ void                gst_rtsp_thread_pool_set_max_threads (GstRTSPThreadPool * po
 GST_RTSP_SERVER_API
 gint                gst_rtsp_thread_pool_get_max_threads (GstRTSPThreadPool * pool);
 
+GST_RTSP_SERVER_API
+void                gst_rtsp_thread_pool_set_max_media_threads (GstRTSPThreadPool * pool,
+                                                                gint max_media_threads);
+
+GST_RTSP_SERVER_API
+gint                gst_rtsp_thread_pool_get_max_media_threads (GstRTSPThreadPool * pool);
+
+GST_RTSP_SERVER_API
+gboolean            gst_rtsp_thread_pool_set_cpus        (GstRTSPThreadPool * pool, const gchar * cpus);
+
+GST_RTSP_SERVER_API
+gchar *             gst_rtsp_thread_pool_get_cpus        (GstRTSPThreadPool * pool);
+
 GST_RTSP_SERVER_API
 GstRTSPThread *     gst_rtsp_thread_pool_get_thread      (GstRTSPThreadPool *pool,
                                                           GstRTSPThreadType type,
                                                           GstRTSPContext *ctx);
 
+GST_RTSP_SERVER_API
+GstStructure *      gst_rtsp_thread_pool_get_stats       (GstRTSPThreadPool * pool);
+
 GST_RTSP_SERVER_API
 void                gst_rtsp_thread_pool_cleanup         (void);
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
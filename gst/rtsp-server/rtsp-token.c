@@ -43,15 +43,28 @@
 
 #include "rtsp-token.h"
 
+/* the well-known boolean fields of the grants of a token */
+#define GRANT_TRANSPORT_CLIENT_SETTINGS (1 << 0)
+
 typedef struct _GstRTSPTokenImpl
 {
   GstRTSPToken token;
 
   GstStructure *structure;
+
+  /* the well-known fields of the structure, taken from the structure when
+   * the token is built. Once the structure was handed out writable it can
+   * change at any time and the fields are read from it every time */
+  gint exposed;
+  GQuark role;
+  guint grants;
 } GstRTSPTokenImpl;
 
 #define GST_RTSP_TOKEN_STRUCTURE(t)  (((GstRTSPTokenImpl *)(t))->structure)
 
+static GQuark quark_media_factory_role;
+static GQuark quark_transport_client_settings;
+
 //GST_DEBUG_CATEGORY_STATIC (rtsp_token_debug);
 //#define GST_CAT_DEFAULT rtsp_token_debug
 
@@ -85,9 +98,61 @@ _gst_rtsp_token_copy (GstRTSPTokenImpl * token)
   return (GstRTSPToken *) copy;
 }
 
+/* @intern when a quark can be made for the role. Exposed tokens are read
+ * for every check and don't make quarks for the strings put in them, a role
+ * without quark is in no #GstRTSPPermissions */
+static void
+read_header (const GstStructure * structure, gboolean intern, GQuark * role,
+    guint * grants)
+{
+  const GValue *value;
+  const gchar *str;
+
+  value = gst_structure_id_get_value (structure, quark_media_factory_role);
+  if (value && G_VALUE_HOLDS_STRING (value) &&
+      (str = g_value_get_string (value)))
+    *role = intern ? g_quark_from_string (str) : g_quark_try_string (str);
+  else
+    *role = 0;
+
+  *grants = 0;
+  value = gst_structure_id_get_value (structure,
+      quark_transport_client_settings);
+  if (value && G_VALUE_HOLDS_BOOLEAN (value) && g_value_get_boolean (value))
+    *grants |= GRANT_TRANSPORT_CLIENT_SETTINGS;
+}
+
+/* only called while the token is writable, nobody else reads the header */
+static void
+update_header (GstRTSPTokenImpl * token)
+{
+  read_header (token->structure, TRUE, &token->role, &token->grants);
+}
+
+static inline void
+get_header (GstRTSPTokenImpl * token, GQuark * role, guint * grants)
+{
+  if (G_LIKELY (!g_atomic_int_get (&token->exposed))) {
+    *role = token->role;
+    *grants = token->grants;
+  } else {
+    read_header (token->structure, FALSE, role, grants);
+  }
+}
+
 static void
 gst_rtsp_token_init (GstRTSPTokenImpl * token, GstStructure * structure)
 {
+  static gsize once = 0;
+
+  if (g_once_init_enter (&once)) {
+    quark_media_factory_role =
+        g_quark_from_static_string (GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE);
+    quark_transport_client_settings =
+        g_quark_from_static_string (GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS);
+    g_once_init_leave (&once, 1);
+  }
+
   gst_mini_object_init (GST_MINI_OBJECT_CAST (token), 0,
       GST_TYPE_RTSP_TOKEN,
       (GstMiniObjectCopyFunction) _gst_rtsp_token_copy, NULL,
@@ -96,6 +161,7 @@ gst_rtsp_token_init (GstRTSPTokenImpl * token, GstStructure * structure)
   token->structure = structure;
   gst_structure_set_parent_refcount (token->structure,
       &token->token.mini_object.refcount);
+  update_header (token);
 }
 
 /**
@@ -164,6 +230,7 @@ gst_rtsp_token_new_valist (const gchar * firstfield, va_list var_args)
   token = gst_rtsp_token_new_empty ();
   s = GST_RTSP_TOKEN_STRUCTURE (token);
   gst_structure_set_valist (s, firstfield, var_args);
+  update_header ((GstRTSPTokenImpl *) token);
 
   return token;
 }
@@ -187,10 +254,12 @@ gst_rtsp_token_set_string (GstRTSPToken * token, const gchar * field,
   g_return_if_fail (token != NULL);
   g_return_if_fail (field != NULL);
   g_return_if_fail (string_value != NULL);
+  g_return_if_fail (gst_mini_object_is_writable (GST_MINI_OBJECT_CAST
+          (token)));
 
-  s = gst_rtsp_token_writable_structure (token);
-  if (s != NULL)
-    gst_structure_set (s, field, G_TYPE_STRING, string_value, NULL);
+  s = GST_RTSP_TOKEN_STRUCTURE (token);
+  gst_structure_set (s, field, G_TYPE_STRING, string_value, NULL);
+  update_header ((GstRTSPTokenImpl *) token);
 }
 
 /**
@@ -211,10 +280,12 @@ gst_rtsp_token_set_bool (GstRTSPToken * token, const gchar * field,
 
   g_return_if_fail (token != NULL);
   g_return_if_fail (field != NULL);
+  g_return_if_fail (gst_mini_object_is_writable (GST_MINI_OBJECT_CAST
+          (token)));
 
-  s = gst_rtsp_token_writable_structure (token);
-  if (s != NULL)
-    gst_structure_set (s, field, G_TYPE_BOOLEAN, bool_value, NULL);
+  s = GST_RTSP_TOKEN_STRUCTURE (token);
+  gst_structure_set (s, field, G_TYPE_BOOLEAN, bool_value, NULL);
+  update_header ((GstRTSPTokenImpl *) token);
 }
 
 /**
@@ -257,6 +328,10 @@ gst_rtsp_token_writable_structure (GstRTSPToken * token)
   g_return_val_if_fail (gst_mini_object_is_writable (GST_MINI_OBJECT_CAST
           (token)), NULL);
 
+  /* the structure can change from now on, read the well-known fields from
+   * it when they are used */
+  g_atomic_int_set (&((GstRTSPTokenImpl *) token)->exposed, TRUE);
+
   return GST_RTSP_TOKEN_STRUCTURE (token);
 }
 
@@ -289,14 +364,75 @@ gst_rtsp_token_get_string (GstRTSPToken * token, const gchar * field)
 gboolean
 gst_rtsp_token_is_allowed (GstRTSPToken * token, const gchar * field)
 {
-  gboolean result;
-
   g_return_val_if_fail (GST_IS_RTSP_TOKEN (token), FALSE);
   g_return_val_if_fail (field != NULL, FALSE);
 
-  if (!gst_structure_get_boolean (GST_RTSP_TOKEN_STRUCTURE (token), field,
-          &result))
-    result = FALSE;
+  /* a field without quark is not in the structure */
+  return gst_rtsp_token_is_allowed_id (token, g_quark_try_string (field));
+}
 
-  return result;
+/**
+ * gst_rtsp_token_is_allowed_id:
+ * @token: a #GstRTSPToken
+ * @field: the quark of a field name
+ *
+ * Check if @token has a boolean @field and if it is set to %TRUE, like
+ * gst_rtsp_token_is_allowed() but with a quark for @field. The well-known
+ * fields, like #GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS, are checked without
+ * searching the structure of @token.
+ *
+ * Returns: %TRUE if @token has a boolean field @field set to %TRUE.
+ *
+ * Since: 1.18
+ */
+gboolean
+gst_rtsp_token_is_allowed_id (GstRTSPToken * token, GQuark field)
+{
+  GstRTSPTokenImpl *impl = (GstRTSPTokenImpl *) token;
+  const GValue *value;
+  GQuark role;
+  guint grants;
+
+  g_return_val_if_fail (GST_IS_RTSP_TOKEN (token), FALSE);
+
+  if (field == 0)
+    return FALSE;
+
+  if (field == quark_transport_client_settings) {
+    get_header (impl, &role, &grants);
+    return (grants & GRANT_TRANSPORT_CLIENT_SETTINGS) != 0;
+  }
+
+  value = gst_structure_id_get_value (impl->structure, field);
+  if (value == NULL || !G_VALUE_HOLDS_BOOLEAN (value))
+    return FALSE;
+
+  return g_value_get_boolean (value);
+}
+
+/**
+ * gst_rtsp_token_get_role_id:
+ * @token: a #GstRTSPToken
+ *
+ * Get the quark of the #GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE string of @token,
+ * without searching the structure of @token.
+ *
+ * Returns: the quark of the media factory role of @token or 0 when @token
+ * has no role. No quark is made for the role of a token that was handed out
+ * writable, 0 is returned when there is none yet.
+ *
+ * Since: 1.18
+ */
+GQuark
+gst_rtsp_token_get_role_id (GstRTSPToken * token)
+{
+  GstRTSPTokenImpl *impl = (GstRTSPTokenImpl *) token;
+  GQuark role;
+  guint grants;
+
+  g_return_val_if_fail (GST_IS_RTSP_TOKEN (token), 0);
+
+  get_header (impl, &role, &grants);
+
+  return role;
 }
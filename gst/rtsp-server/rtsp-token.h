@@ -103,6 +103,11 @@ void                 gst_rtsp_token_set_bool           (GstRTSPToken * token,
 GST_RTSP_SERVER_API
 gboolean             gst_rtsp_token_is_allowed         (GstRTSPToken *token,
                                                         const gchar *field);
+GST_RTSP_SERVER_API
+gboolean             gst_rtsp_token_is_allowed_id      (GstRTSPToken *token,
+                                                        GQuark field);
+GST_RTSP_SERVER_API
+GQuark               gst_rtsp_token_get_role_id        (GstRTSPToken *token);
 
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstRTSPToken, gst_rtsp_token_unref)
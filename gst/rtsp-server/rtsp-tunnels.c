@@ -0,0 +1,402 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The tunnels of RTSP-over-HTTP clients that wait for the other half of
+ * their tunnel. A tunnel is a GET and a POST connection with the same
+ * tunnelid, the client of the first connection is pending until the client
+ * of the second one is merged into it.
+ *
+ * The tunnels are spread over shards by the hash of the tunnelid so that
+ * clients opening many tunnels at once don't all wait for the same lock.
+ * Tunnels that stay pending longer than the timeout are removed from all
+ * shards when a tunnel is added and their client is closed. The number of
+ * pending tunnels is limited.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "rtsp-tunnels.h"
+
+GST_DEBUG_CATEGORY_STATIC (rtsp_tunnels_debug);
+#define GST_CAT_DEFAULT rtsp_tunnels_debug
+
+#define N_SHARDS        16
+
+/* how often the expired tunnels are removed at most, or more often when the
+ * timeout is shorter */
+#define SWEEP_INTERVAL  (5 * G_USEC_PER_SEC)
+
+#define DEFAULT_MAX_PENDING     1024
+#define DEFAULT_TIMEOUT_MS      (120 * 1000)
+
+typedef struct
+{
+  GstRTSPClient *client;
+  gint64 added;
+} Tunnel;
+
+typedef struct
+{
+  GMutex lock;
+
+  GHashTable *tunnels;
+
+  guint64 merged;
+  guint64 expired;
+  guint64 rejected;
+} Shard;
+
+struct _GstRTSPTunnels
+{
+  gint refcount;
+
+  Shard shards[N_SHARDS];
+
+  /* one thread removes the expired tunnels of all shards at a time */
+  GMutex sweep_lock;
+  gint64 last_sweep;
+
+  /* atomic, -1 doesn't limit */
+  gint max_pending;
+  gint timeout_ms;
+  gint pending;
+};
+
+static void
+tunnel_free (Tunnel * tunnel)
+{
+  g_object_unref (tunnel->client);
+  g_slice_free (Tunnel, tunnel);
+}
+
+GstRTSPTunnels *
+gst_rtsp_tunnels_new (void)
+{
+  static gsize once = 0;
+  GstRTSPTunnels *tunnels;
+  guint i;
+
+  if (g_once_init_enter (&once)) {
+    GST_DEBUG_CATEGORY_INIT (rtsp_tunnels_debug, "rtsptunnels", 0,
+        "GstRTSPTunnels");
+    g_once_init_leave (&once, 1);
+  }
+
+  tunnels = g_slice_new0 (GstRTSPTunnels);
+  tunnels->refcount = 1;
+  for (i = 0; i < N_SHARDS; i++) {
+    Shard *shard = &tunnels->shards[i];
+
+    g_mutex_init (&shard->lock);
+    shard->tunnels = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) tunnel_free);
+  }
+  g_mutex_init (&tunnels->sweep_lock);
+  tunnels->max_pending = DEFAULT_MAX_PENDING;
+  tunnels->timeout_ms = DEFAULT_TIMEOUT_MS;
+
+  return tunnels;
+}
+
+GstRTSPTunnels *
+gst_rtsp_tunnels_ref (GstRTSPTunnels * tunnels)
+{
+  g_atomic_int_inc (&tunnels->refcount);
+
+  return tunnels;
+}
+
+void
+gst_rtsp_tunnels_unref (GstRTSPTunnels * tunnels)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&tunnels->refcount))
+    return;
+
+  for (i = 0; i < N_SHARDS; i++) {
+    g_hash_table_unref (tunnels->shards[i].tunnels);
+    g_mutex_clear (&tunnels->shards[i].lock);
+  }
+  g_mutex_clear (&tunnels->sweep_lock);
+  g_slice_free (GstRTSPTunnels, tunnels);
+}
+
+void
+gst_rtsp_tunnels_set_max_pending (GstRTSPTunnels * tunnels, gint max_pending)
+{
+  g_atomic_int_set (&tunnels->max_pending, max_pending);
+}
+
+gint
+gst_rtsp_tunnels_get_max_pending (GstRTSPTunnels * tunnels)
+{
+  return g_atomic_int_get (&tunnels->max_pending);
+}
+
+/* a @timeout of GST_CLOCK_TIME_NONE keeps the tunnels until they are merged
+ * or closed */
+void
+gst_rtsp_tunnels_set_timeout (GstRTSPTunnels * tunnels, GstClockTime timeout)
+{
+  gint timeout_ms;
+
+  if (GST_CLOCK_TIME_IS_VALID (timeout))
+    timeout_ms = MIN (GST_TIME_AS_MSECONDS (timeout), G_MAXINT);
+  else
+    timeout_ms = -1;
+
+  g_atomic_int_set (&tunnels->timeout_ms, timeout_ms);
+}
+
+GstClockTime
+gst_rtsp_tunnels_get_timeout (GstRTSPTunnels * tunnels)
+{
+  gint timeout_ms;
+
+  timeout_ms = g_atomic_int_get (&tunnels->timeout_ms);
+  if (timeout_ms < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  return timeout_ms * GST_MSECOND;
+}
+
+static Shard *
+get_shard (GstRTSPTunnels * tunnels, const gchar * tunnelid)
+{
+  return &tunnels->shards[g_str_hash (tunnelid) % N_SHARDS];
+}
+
+typedef struct
+{
+  gint64 limit;
+  GList *clients;
+} SweepData;
+
+static gboolean
+steal_expired (gchar * tunnelid, Tunnel * tunnel, SweepData * data)
+{
+  if (tunnel->added >= data->limit)
+    return FALSE;
+
+  data->clients = g_list_prepend (data->clients, tunnel->client);
+  g_free (tunnelid);
+  g_slice_free (Tunnel, tunnel);
+
+  return TRUE;
+}
+
+/* with the shard lock, prepends the clients of the tunnels of @shard that
+ * were added before @limit to @clients */
+static GList *
+sweep_shard (GstRTSPTunnels * tunnels, Shard * shard, gint64 limit,
+    GList * clients)
+{
+  SweepData data = { limit, clients };
+  guint expired;
+
+  expired = g_hash_table_foreach_steal (shard->tunnels,
+      (GHRFunc) steal_expired, &data);
+  if (expired > 0) {
+    GST_DEBUG ("removed %u expired tunnels", expired);
+    shard->expired += expired;
+    g_atomic_int_add (&tunnels->pending, -(gint) expired);
+  }
+
+  return data.clients;
+}
+
+static void
+close_expired (GList * clients)
+{
+  GList *walk;
+
+  for (walk = clients; walk; walk = g_list_next (walk)) {
+    GstRTSPClient *client = walk->data;
+
+    GST_DEBUG ("closing client %p of expired tunnel", client);
+    gst_rtsp_client_close (client);
+  }
+  g_list_free_full (clients, g_object_unref);
+}
+
+/* without shard lock, remove the expired tunnels of all shards and close
+ * their clients. Closing a client removes its tunnel so that must be done
+ * without the shard lock */
+static void
+sweep (GstRTSPTunnels * tunnels, gint64 now)
+{
+  GList *clients = NULL;
+  gint timeout_ms;
+  gint64 limit;
+  guint i;
+
+  timeout_ms = g_atomic_int_get (&tunnels->timeout_ms);
+  if (timeout_ms < 0)
+    return;
+
+  /* another thread is removing them already */
+  if (!g_mutex_trylock (&tunnels->sweep_lock))
+    return;
+  if (now - tunnels->last_sweep <
+      MIN (SWEEP_INTERVAL, (gint64) timeout_ms * 1000)) {
+    g_mutex_unlock (&tunnels->sweep_lock);
+    return;
+  }
+  tunnels->last_sweep = now;
+  g_mutex_unlock (&tunnels->sweep_lock);
+
+  limit = now - (gint64) timeout_ms * 1000;
+  for (i = 0; i < N_SHARDS; i++) {
+    Shard *shard = &tunnels->shards[i];
+
+    g_mutex_lock (&shard->lock);
+    clients = sweep_shard (tunnels, shard, limit, clients);
+    g_mutex_unlock (&shard->lock);
+  }
+
+  close_expired (clients);
+}
+
+/* with the shard lock, add @client as pending for @tunnelid */
+static gboolean
+add_tunnel (GstRTSPTunnels * tunnels, Shard * shard, const gchar * tunnelid,
+    GstRTSPClient * client, gint64 now)
+{
+  gint max_pending;
+  Tunnel *tunnel;
+
+  max_pending = g_atomic_int_get (&tunnels->max_pending);
+  if (g_atomic_int_add (&tunnels->pending, 1) >= max_pending &&
+      max_pending >= 0)
+    goto too_many;
+
+  tunnel = g_slice_new (Tunnel);
+  tunnel->client = g_object_ref (client);
+  tunnel->added = now;
+  g_hash_table_insert (shard->tunnels, g_strdup (tunnelid), tunnel);
+
+  return TRUE;
+
+  /* ERRORS */
+too_many:
+  {
+    GST_WARNING ("too many pending tunnels, refusing tunnel %s", tunnelid);
+    g_atomic_int_add (&tunnels->pending, -1);
+    shard->rejected++;
+    return FALSE;
+  }
+}
+
+/* add @client as pending for @tunnelid, fails when there is a pending
+ * tunnel with @tunnelid already or when there are too many pending tunnels */
+gboolean
+gst_rtsp_tunnels_add (GstRTSPTunnels * tunnels, const gchar * tunnelid,
+    GstRTSPClient * client)
+{
+  Shard *shard = get_shard (tunnels, tunnelid);
+  gboolean res;
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+  sweep (tunnels, now);
+
+  g_mutex_lock (&shard->lock);
+  if (g_hash_table_contains (shard->tunnels, tunnelid)) {
+    GST_WARNING ("tunnel %s exists already", tunnelid);
+    shard->rejected++;
+    res = FALSE;
+  } else {
+    res = add_tunnel (tunnels, shard, tunnelid, client, now);
+  }
+  g_mutex_unlock (&shard->lock);
+
+  return res;
+}
+
+/* take the pending client of @tunnelid in @other or, when there is none, add
+ * @client as pending. Fails when @client can't be added because there are
+ * too many pending tunnels */
+gboolean
+gst_rtsp_tunnels_pair (GstRTSPTunnels * tunnels, const gchar * tunnelid,
+    GstRTSPClient * client, GstRTSPClient ** other)
+{
+  Shard *shard = get_shard (tunnels, tunnelid);
+  gboolean res = TRUE;
+  Tunnel *tunnel;
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+  *other = NULL;
+  sweep (tunnels, now);
+
+  g_mutex_lock (&shard->lock);
+  if ((tunnel = g_hash_table_lookup (shard->tunnels, tunnelid))) {
+    *other = g_object_ref (tunnel->client);
+    g_hash_table_remove (shard->tunnels, tunnelid);
+    g_atomic_int_add (&tunnels->pending, -1);
+    shard->merged++;
+  } else {
+    res = add_tunnel (tunnels, shard, tunnelid, client, now);
+  }
+  g_mutex_unlock (&shard->lock);
+
+  return res;
+}
+
+/* remove the pending tunnel of @client, when it has one */
+void
+gst_rtsp_tunnels_remove (GstRTSPTunnels * tunnels, const gchar * tunnelid,
+    GstRTSPClient * client)
+{
+  Shard *shard = get_shard (tunnels, tunnelid);
+  Tunnel *tunnel;
+
+  g_mutex_lock (&shard->lock);
+  tunnel = g_hash_table_lookup (shard->tunnels, tunnelid);
+  if (tunnel && tunnel->client == client) {
+    g_hash_table_remove (shard->tunnels, tunnelid);
+    g_atomic_int_add (&tunnels->pending, -1);
+  }
+  g_mutex_unlock (&shard->lock);
+}
+
+GstStructure *
+gst_rtsp_tunnels_get_stats (GstRTSPTunnels * tunnels)
+{
+  guint64 merged = 0, expired = 0, rejected = 0;
+  guint i;
+
+  for (i = 0; i < N_SHARDS; i++) {
+    Shard *shard = &tunnels->shards[i];
+
+    g_mutex_lock (&shard->lock);
+    merged += shard->merged;
+    expired += shard->expired;
+    rejected += shard->rejected;
+    g_mutex_unlock (&shard->lock);
+  }
+
+  return gst_structure_new ("application/x-rtsp-tunnel-stats",
+      "pending", G_TYPE_INT, g_atomic_int_get (&tunnels->pending),
+      "merged", G_TYPE_UINT64, merged,
+      "expired", G_TYPE_UINT64, expired,
+      "rejected", G_TYPE_UINT64, rejected, NULL);
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTSP_TUNNELS_H__
+#define __GST_RTSP_TUNNELS_H__
+
+#include <gst/gst.h>
+
+#include "rtsp-client.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstRTSPTunnels GstRTSPTunnels;
+
+GstRTSPTunnels *       gst_rtsp_tunnels_new                   (void);
+
+GstRTSPTunnels *       gst_rtsp_tunnels_ref                   (GstRTSPTunnels * tunnels);
+
+void                   gst_rtsp_tunnels_unref                 (GstRTSPTunnels * tunnels);
+
+void                   gst_rtsp_tunnels_set_max_pending       (GstRTSPTunnels * tunnels,
+                                                               gint max_pending);
+
+gint                   gst_rtsp_tunnels_get_max_pending       (GstRTSPTunnels * tunnels);
+
+void                   gst_rtsp_tunnels_set_timeout           (GstRTSPTunnels * tunnels,
+                                                               GstClockTime timeout);
+
+GstClockTime           gst_rtsp_tunnels_get_timeout           (GstRTSPTunnels * tunnels);
+
+gboolean               gst_rtsp_tunnels_add                   (GstRTSPTunnels * tunnels,
+                                                               const gchar * tunnelid,
+                                                               GstRTSPClient * client);
+
+gboolean               gst_rtsp_tunnels_pair                  (GstRTSPTunnels * tunnels,
+                                                               const gchar * tunnelid,
+                                                               GstRTSPClient * client,
+                                                               GstRTSPClient ** other);
+
+void                   gst_rtsp_tunnels_remove                (GstRTSPTunnels * tunnels,
+                                                               const gchar * tunnelid,
+                                                               GstRTSPClient * client);
+
+GstStructure *         gst_rtsp_tunnels_get_stats             (GstRTSPTunnels * tunnels);
+
+G_END_DECLS
+
+#endif /* __GST_RTSP_TUNNELS_H__ */
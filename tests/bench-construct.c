@@ -0,0 +1,125 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the time it takes to make the media element of a factory by
+ * parsing the launch line every time, as was done before launch templates,
+ * and by using the factory, which makes the element from a template. */
+
+#include <gst/gst.h>
+
+#include <gst/rtsp-server/rtsp-server.h>
+
+#define DEFAULT_LAUNCH "( videotestsrc is-live=true ! video/x-raw,width=320 ! " \
+    "videoconvert ! queue ! rtpvrawpay pt=96 name=pay0 " \
+    "audiotestsrc is-live=true ! audioconvert ! queue ! rtpL16pay name=pay1 )"
+
+static gint iterations = 1000;
+static gchar *launch = NULL;
+
+static GOptionEntry entries[] = {
+  {"iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of elements to make (default: 1000)", "N"},
+  {"launch", 'l', 0, G_OPTION_ARG_STRING, &launch,
+      "Launch line to use", "LAUNCH"},
+  {NULL}
+};
+
+int
+main (int argc, char *argv[])
+{
+  GstRTSPMediaFactory *factory;
+  GOptionContext *optctx;
+  GError *error = NULL;
+  GstRTSPUrl *url;
+  GstRTSPMedia *media;
+  GstElement *element;
+  gint64 start, parse_time, template_time, construct_time;
+  gint i;
+
+  optctx = g_option_context_new ("- Benchmark media construction");
+  g_option_context_add_main_entries (optctx, entries, NULL);
+  g_option_context_add_group (optctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (optctx, &argc, &argv, &error)) {
+    g_printerr ("Error parsing options: %s\n", error->message);
+    g_option_context_free (optctx);
+    g_clear_error (&error);
+    return -1;
+  }
+  g_option_context_free (optctx);
+
+  if (launch == NULL)
+    launch = g_strdup (DEFAULT_LAUNCH);
+
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_launch (factory, launch);
+  gst_rtsp_url_parse ("rtsp://localhost:8554/test", &url);
+
+  /* before: parse the launch line for each element */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++) {
+    element = gst_parse_launch_full (launch, NULL, GST_PARSE_FLAG_PLACE_IN_BIN,
+        NULL);
+    if (element == NULL)
+      goto parse_failed;
+    gst_object_unref (element);
+  }
+  parse_time = g_get_monotonic_time () - start;
+
+  /* after: the factory makes the elements from its template */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++) {
+    element = gst_rtsp_media_factory_create_element (factory, url);
+    if (element == NULL)
+      goto parse_failed;
+    gst_object_unref (element);
+  }
+  template_time = g_get_monotonic_time () - start;
+
+  /* complete construct, including stream collection and configuration */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++) {
+    media = gst_rtsp_media_factory_construct (factory, url);
+    if (media == NULL)
+      goto parse_failed;
+    g_object_unref (media);
+  }
+  construct_time = g_get_monotonic_time () - start;
+
+  g_print ("launch: %s\n", launch);
+  g_print ("parse:     %8.1f us/element\n", (gdouble) parse_time / iterations);
+  g_print ("template:  %8.1f us/element\n",
+      (gdouble) template_time / iterations);
+  g_print ("construct: %8.1f us/media\n", (gdouble) construct_time / iterations);
+
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+  g_free (launch);
+
+  return 0;
+
+  /* ERRORS */
+parse_failed:
+  {
+    g_printerr ("failed to make element from %s\n", launch);
+    gst_rtsp_url_free (url);
+    g_object_unref (factory);
+    g_free (launch);
+    return -1;
+  }
+}
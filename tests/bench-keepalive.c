@@ -0,0 +1,118 @@
+/* GStreamer
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures how many keep-alive requests a client handles per second on one
+ * core, with the keep-alive fast path and with a signal handler connected,
+ * which makes the client handle the requests the full way. */
+
+#include <gst/gst.h>
+
+#include <gst/rtsp-server/rtsp-server.h>
+
+static gint iterations = 100000;
+
+static GOptionEntry entries[] = {
+  {"iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of requests to handle (default: 100000)", "N"},
+  {NULL}
+};
+
+static gboolean
+count_response (GstRTSPClient * client, GstRTSPMessage * message,
+    gboolean close, gpointer user_data)
+{
+  guint *responses = user_data;
+
+  (*responses)++;
+
+  return TRUE;
+}
+
+static GstRTSPStatusCode
+pre_request (GstRTSPClient * client, GstRTSPContext * ctx, gpointer user_data)
+{
+  return GST_RTSP_STS_OK;
+}
+
+static gdouble
+run (GstRTSPClient * client, GstRTSPMethod method)
+{
+  GstRTSPMessage request = { 0, };
+  gint64 start;
+  gchar *str;
+  gint i;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++) {
+    gst_rtsp_message_init_request (&request, method, "rtsp://localhost/test");
+    str = g_strdup_printf ("%d", i);
+    gst_rtsp_message_take_header (&request, GST_RTSP_HDR_CSEQ, str);
+    gst_rtsp_client_handle_message (client, &request);
+    gst_rtsp_message_unset (&request);
+  }
+
+  return (gdouble) iterations * G_USEC_PER_SEC / (g_get_monotonic_time () -
+      start);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GstRTSPClient *client;
+  GOptionContext *optctx;
+  GError *error = NULL;
+  guint responses = 0;
+  gdouble options, get_param, slow_options, slow_get_param;
+
+  optctx = g_option_context_new ("- Benchmark keep-alive requests");
+  g_option_context_add_main_entries (optctx, entries, NULL);
+  g_option_context_add_group (optctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (optctx, &argc, &argv, &error)) {
+    g_printerr ("Error parsing options: %s\n", error->message);
+    g_option_context_free (optctx);
+    g_clear_error (&error);
+    return -1;
+  }
+  g_option_context_free (optctx);
+
+  client = gst_rtsp_client_new ();
+  gst_rtsp_client_set_send_func (client, count_response, &responses, NULL);
+
+  /* fast path */
+  options = run (client, GST_RTSP_OPTIONS);
+  get_param = run (client, GST_RTSP_GET_PARAMETER);
+
+  /* full path */
+  g_signal_connect (client, "pre-options-request", (GCallback) pre_request,
+      NULL);
+  g_signal_connect (client, "pre-get-parameter-request",
+      (GCallback) pre_request, NULL);
+  slow_options = run (client, GST_RTSP_OPTIONS);
+  slow_get_param = run (client, GST_RTSP_GET_PARAMETER);
+
+  g_print ("responses:            %u\n", responses);
+  g_print ("OPTIONS:       %10.0f requests/s (full path %10.0f requests/s)\n",
+      options, slow_options);
+  g_print ("GET_PARAMETER: %10.0f requests/s (full path %10.0f requests/s)\n",
+      get_param, slow_get_param);
+
+  g_object_unref (client);
+
+  return 0;
+}
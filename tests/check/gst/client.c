@@ -19,6 +19,9 @@
 
 #include <gst/check/gstcheck.h>
 
+#include <glib/gstdio.h>
+#include <string.h>
+
 #include <rtsp-client.h>
 
 #define VIDEO_PIPELINE "videotestsrc ! " \
@@ -492,6 +495,131 @@ GST_START_TEST (test_options)
 
 GST_END_TEST;
 
+static gint n_parsed_urls;
+static gint n_reused_urls;
+
+/* a parsed url has no user here, tag it to recognize it when it is used
+ * again for a later request */
+static void
+tag_request_url (GstRTSPClient * client, GstRTSPContext * ctx,
+    gpointer user_data)
+{
+  fail_unless (ctx->uri != NULL);
+
+  if (ctx->uri->user == NULL) {
+    ctx->uri->user = g_strdup ("tagged");
+    n_parsed_urls++;
+  } else {
+    fail_unless_equals_string (ctx->uri->user, "tagged");
+    n_reused_urls++;
+  }
+}
+
+static void
+send_options (GstRTSPClient * client, const gchar * url)
+{
+  GstRTSPMessage request = { 0, };
+  gchar *str;
+
+  fail_unless (gst_rtsp_message_init_request (&request, GST_RTSP_OPTIONS,
+          url) == GST_RTSP_OK);
+  str = g_strdup_printf ("%d", cseq);
+  gst_rtsp_message_add_header (&request, GST_RTSP_HDR_CSEQ, str);
+  g_free (str);
+
+  fail_unless (gst_rtsp_client_handle_message (client,
+          &request) == GST_RTSP_OK);
+  gst_rtsp_message_unset (&request);
+}
+
+GST_START_TEST (test_options_repeated)
+{
+  GstRTSPClient *client;
+
+  client = gst_rtsp_client_new ();
+  gst_rtsp_client_set_send_func (client, test_option_response_200, NULL, NULL);
+  g_signal_connect (client, "options-request", G_CALLBACK (tag_request_url),
+      NULL);
+  n_parsed_urls = n_reused_urls = 0;
+
+  /* OPTIONS repeated like a keep-alive reuse the url and keep the same
+   * Public header */
+  send_options (client, "rtsp://localhost/test");
+  send_options (client, "rtsp://localhost/test");
+  send_options (client, "rtsp://localhost/test");
+  fail_unless_equals_int (n_parsed_urls, 1);
+  fail_unless_equals_int (n_reused_urls, 2);
+
+  /* another uri is parsed again */
+  send_options (client, "rtsp://localhost/other");
+  fail_unless_equals_int (n_parsed_urls, 2);
+  fail_unless_equals_int (n_reused_urls, 2);
+
+  g_object_unref (client);
+}
+
+GST_END_TEST;
+
+static void
+send_get_parameter (GstRTSPClient * client, const gchar * url,
+    const gchar * session)
+{
+  GstRTSPMessage request = { 0, };
+  gchar *str;
+
+  fail_unless (gst_rtsp_message_init_request (&request,
+          GST_RTSP_GET_PARAMETER, url) == GST_RTSP_OK);
+  str = g_strdup_printf ("%d", cseq);
+  gst_rtsp_message_add_header (&request, GST_RTSP_HDR_CSEQ, str);
+  g_free (str);
+  if (session)
+    gst_rtsp_message_add_header (&request, GST_RTSP_HDR_SESSION, session);
+
+  fail_unless (gst_rtsp_client_handle_message (client,
+          &request) == GST_RTSP_OK);
+  gst_rtsp_message_unset (&request);
+}
+
+static GstRTSPStatusCode
+pre_get_parameter_bad_request (GstRTSPClient * client, GstRTSPContext * ctx,
+    gpointer user_data)
+{
+  return GST_RTSP_STS_BAD_REQUEST;
+}
+
+GST_START_TEST (test_keepalive)
+{
+  GstRTSPClient *client;
+  GstRTSPSessionPool *session_pool;
+
+  client = gst_rtsp_client_new ();
+  session_pool = gst_rtsp_session_pool_new ();
+  gst_rtsp_client_set_session_pool (client, session_pool);
+
+  /* keep-alive without session */
+  gst_rtsp_client_set_send_func (client, test_response_200, NULL, NULL);
+  send_get_parameter (client, "rtsp://localhost/test", NULL);
+
+  /* unknown sessions are still refused */
+  gst_rtsp_client_set_send_func (client, test_response_454, NULL, NULL);
+  send_get_parameter (client, "rtsp://localhost/test", "unknown");
+
+  /* invalid urls are still refused */
+  gst_rtsp_client_set_send_func (client, test_response_400, NULL, NULL);
+  send_get_parameter (client, "http://localhost/test", NULL);
+
+  /* a connected handler is still called */
+  g_signal_connect (client, "pre-get-parameter-request",
+      (GCallback) pre_get_parameter_bad_request, NULL);
+  gst_rtsp_client_set_send_func (client, test_response_400, NULL, NULL);
+  send_get_parameter (client, "rtsp://localhost/test", NULL);
+
+  g_object_unref (session_pool);
+  g_object_unref (client);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_describe)
 {
   GstRTSPClient *client;
@@ -532,6 +660,514 @@ GST_START_TEST (test_describe)
 
 GST_END_TEST;
 
+static void
+send_describe (GstRTSPClient * client, const gchar * url)
+{
+  GstRTSPMessage request = { 0, };
+  gchar *str;
+
+  fail_unless (gst_rtsp_message_init_request (&request, GST_RTSP_DESCRIBE,
+          url) == GST_RTSP_OK);
+  str = g_strdup_printf ("%d", cseq);
+  gst_rtsp_message_add_header (&request, GST_RTSP_HDR_CSEQ, str);
+  g_free (str);
+
+  fail_unless (gst_rtsp_client_handle_message (client,
+          &request) == GST_RTSP_OK);
+  gst_rtsp_message_unset (&request);
+}
+
+GST_START_TEST (test_describe_same_url)
+{
+  GstRTSPClient *client;
+
+  client = setup_client (NULL);
+  g_signal_connect (client, "describe-request", G_CALLBACK (tag_request_url),
+      NULL);
+  n_parsed_urls = n_reused_urls = 0;
+
+  /* the url of the previous request is reused, also when it was sanitized */
+  gst_rtsp_client_set_send_func (client, test_response_200, NULL, NULL);
+  send_describe (client, "rtsp://localhost//test/");
+  send_describe (client, "rtsp://localhost//test/");
+  fail_unless_equals_int (n_parsed_urls, 1);
+  fail_unless_equals_int (n_reused_urls, 1);
+
+  /* a different uri string is parsed, even when it sanitizes the same */
+  send_describe (client, "rtsp://localhost/test");
+  fail_unless_equals_int (n_parsed_urls, 2);
+  fail_unless_equals_int (n_reused_urls, 1);
+
+  /* the url of a failed request replaces the previous one */
+  gst_rtsp_client_set_send_func (client, test_response_404, NULL, NULL);
+  send_describe (client, "rtsp://localhost/other");
+
+  gst_rtsp_client_set_send_func (client, test_response_200, NULL, NULL);
+  send_describe (client, "rtsp://localhost/test");
+  fail_unless_equals_int (n_parsed_urls, 3);
+  fail_unless_equals_int (n_reused_urls, 1);
+
+  teardown_client (client);
+}
+
+GST_END_TEST;
+
+static gboolean
+test_response_401 (GstRTSPClient * client, GstRTSPMessage * response,
+    gboolean close, gpointer user_data)
+{
+  GstRTSPStatusCode code;
+  const gchar *reason;
+  GstRTSPVersion version;
+
+  fail_unless (gst_rtsp_message_parse_response (response, &code, &reason,
+          &version)
+      == GST_RTSP_OK);
+  fail_unless (code == GST_RTSP_STS_UNAUTHORIZED);
+
+  return TRUE;
+}
+
+static void
+send_describe_auth (GstRTSPClient * client, const gchar * authorization)
+{
+  GstRTSPMessage request = { 0, };
+  gchar *str;
+
+  fail_unless (gst_rtsp_message_init_request (&request, GST_RTSP_DESCRIBE,
+          "rtsp://localhost/test") == GST_RTSP_OK);
+  str = g_strdup_printf ("%d", cseq);
+  gst_rtsp_message_add_header (&request, GST_RTSP_HDR_CSEQ, str);
+  g_free (str);
+  gst_rtsp_message_add_header (&request, GST_RTSP_HDR_AUTHORIZATION,
+      authorization);
+
+  fail_unless (gst_rtsp_client_handle_message (client,
+          &request) == GST_RTSP_OK);
+  gst_rtsp_message_unset (&request);
+}
+
+GST_START_TEST (test_describe_auth_cache)
+{
+  GstRTSPClient *client;
+  GstRTSPMountPoints *mount_points;
+  GstRTSPMediaFactory *factory;
+  GstRTSPPermissions *permissions;
+  GstRTSPAuth *auth;
+  GstRTSPToken *token;
+  gchar *basic, *str_auth;
+
+  client = setup_client (NULL);
+
+  mount_points = gst_rtsp_client_get_mount_points (client);
+  factory = gst_rtsp_mount_points_match (mount_points, "/test", NULL);
+  fail_unless (factory != NULL);
+  permissions = gst_rtsp_permissions_new ();
+  gst_rtsp_permissions_add_role (permissions, "user",
+      GST_RTSP_PERM_MEDIA_FACTORY_ACCESS, G_TYPE_BOOLEAN, TRUE,
+      GST_RTSP_PERM_MEDIA_FACTORY_CONSTRUCT, G_TYPE_BOOLEAN, TRUE, NULL);
+  gst_rtsp_media_factory_set_permissions (factory, permissions);
+  gst_rtsp_permissions_unref (permissions);
+  g_object_unref (factory);
+  g_object_unref (mount_points);
+
+  auth = gst_rtsp_auth_new ();
+  basic = gst_rtsp_auth_make_basic ("user", "password");
+  token = gst_rtsp_token_new (GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE, G_TYPE_STRING,
+      "user", NULL);
+  gst_rtsp_auth_add_basic (auth, basic, token);
+  gst_rtsp_token_unref (token);
+  gst_rtsp_client_set_auth (client, auth);
+
+  str_auth = g_strdup_printf ("Basic %s", basic);
+
+  /* the second request uses the token of the first */
+  gst_rtsp_client_set_send_func (client, test_response_200, NULL, NULL);
+  send_describe_auth (client, str_auth);
+  send_describe_auth (client, str_auth);
+
+  /* wrong credentials */
+  gst_rtsp_client_set_send_func (client, test_response_401, NULL, NULL);
+  send_describe_auth (client, "Basic d3Jvbmc6d3Jvbmc=");
+
+  /* removed credentials are not accepted anymore */
+  gst_rtsp_client_set_send_func (client, test_response_200, NULL, NULL);
+  send_describe_auth (client, str_auth);
+  gst_rtsp_auth_remove_basic (auth, basic);
+  gst_rtsp_client_set_send_func (client, test_response_401, NULL, NULL);
+  send_describe_auth (client, str_auth);
+
+  g_free (str_auth);
+  g_free (basic);
+  g_object_unref (auth);
+  teardown_client (client);
+}
+
+GST_END_TEST;
+
+/* a stand-in for an external credential directory, looks up the Basic
+ * credentials in a file of "<credentials> <role>" lines from a thread */
+typedef struct
+{
+  GstRTSPAuth parent;
+  gchar *path;
+  gint lookups;
+} TestFileAuth;
+
+typedef struct
+{
+  GstRTSPAuthClass parent_class;
+} TestFileAuthClass;
+
+typedef struct
+{
+  GstRTSPAuth *auth;
+  gchar *authorization;
+  GstRTSPAuthResultFunc func;
+  gpointer user_data;
+} TestFileLookup;
+
+GType test_file_auth_get_type (void);
+
+G_DEFINE_TYPE (TestFileAuth, test_file_auth, GST_TYPE_RTSP_AUTH);
+
+static gpointer
+test_file_auth_lookup (TestFileLookup * lookup)
+{
+  TestFileAuth *auth = (TestFileAuth *) lookup->auth;
+  GstRTSPToken *token = NULL;
+  gchar *contents, **lines, **line;
+
+  if (g_str_has_prefix (lookup->authorization, "Basic ") &&
+      g_file_get_contents (auth->path, &contents, NULL, NULL)) {
+    lines = g_strsplit (contents, "\n", -1);
+    for (line = lines; *line && token == NULL; line++) {
+      gchar **fields = g_strsplit (*line, " ", 2);
+
+      if (g_strv_length (fields) == 2 &&
+          g_str_equal (lookup->authorization + 6, fields[0]))
+        token = gst_rtsp_token_new (GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE,
+            G_TYPE_STRING, fields[1], NULL);
+      g_strfreev (fields);
+    }
+    g_strfreev (lines);
+    g_free (contents);
+  }
+
+  lookup->func (lookup->auth, token, lookup->user_data);
+
+  if (token)
+    gst_rtsp_token_unref (token);
+  g_object_unref (lookup->auth);
+  g_free (lookup->authorization);
+  g_free (lookup);
+
+  return NULL;
+}
+
+static void
+test_file_auth_authenticate_async (GstRTSPAuth * auth, GstRTSPContext * ctx,
+    GstRTSPAuthResultFunc func, gpointer user_data)
+{
+  TestFileLookup *lookup;
+  gchar *authorization;
+
+  fail_unless (gst_rtsp_message_get_header (ctx->request,
+          GST_RTSP_HDR_AUTHORIZATION, &authorization, 0) == GST_RTSP_OK);
+
+  lookup = g_new0 (TestFileLookup, 1);
+  lookup->auth = g_object_ref (auth);
+  lookup->authorization = g_strdup (authorization);
+  lookup->func = func;
+  lookup->user_data = user_data;
+
+  g_atomic_int_inc (&((TestFileAuth *) auth)->lookups);
+  g_thread_unref (g_thread_new ("lookup", (GThreadFunc) test_file_auth_lookup,
+          lookup));
+}
+
+static void
+test_file_auth_finalize (GObject * obj)
+{
+  g_free (((TestFileAuth *) obj)->path);
+
+  G_OBJECT_CLASS (test_file_auth_parent_class)->finalize (obj);
+}
+
+static void
+test_file_auth_class_init (TestFileAuthClass * klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = test_file_auth_finalize;
+  GST_RTSP_AUTH_CLASS (klass)->authenticate_async =
+      test_file_auth_authenticate_async;
+}
+
+static void
+test_file_auth_init (TestFileAuth * auth)
+{
+}
+
+static GstRTSPStatusCode expected_auth_code;
+static gint auth_responses;
+
+static gboolean
+test_response_auth (GstRTSPClient * client, GstRTSPMessage * response,
+    gboolean close, gpointer user_data)
+{
+  GstRTSPStatusCode code;
+  const gchar *reason;
+  GstRTSPVersion version;
+
+  fail_unless (gst_rtsp_message_parse_response (response, &code, &reason,
+          &version)
+      == GST_RTSP_OK);
+  fail_unless (code == expected_auth_code);
+  auth_responses++;
+
+  return TRUE;
+}
+
+/* the suspended requests are resumed from the default main context */
+static void
+wait_auth_responses (gint n_responses)
+{
+  while (auth_responses < n_responses)
+    g_main_context_iteration (NULL, TRUE);
+  fail_unless_equals_int (auth_responses, n_responses);
+}
+
+static GstRTSPClient *
+setup_auth_client (GstRTSPAuth * auth)
+{
+  GstRTSPClient *client;
+  GstRTSPMountPoints *mount_points;
+  GstRTSPMediaFactory *factory;
+  GstRTSPPermissions *permissions;
+
+  client = setup_client (NULL);
+
+  mount_points = gst_rtsp_client_get_mount_points (client);
+  factory = gst_rtsp_mount_points_match (mount_points, "/test", NULL);
+  fail_unless (factory != NULL);
+  permissions = gst_rtsp_permissions_new ();
+  gst_rtsp_permissions_add_role (permissions, "user",
+      GST_RTSP_PERM_MEDIA_FACTORY_ACCESS, G_TYPE_BOOLEAN, TRUE,
+      GST_RTSP_PERM_MEDIA_FACTORY_CONSTRUCT, G_TYPE_BOOLEAN, TRUE, NULL);
+  gst_rtsp_media_factory_set_permissions (factory, permissions);
+  gst_rtsp_permissions_unref (permissions);
+  g_object_unref (factory);
+  g_object_unref (mount_points);
+
+  gst_rtsp_client_set_auth (client, auth);
+  gst_rtsp_client_set_send_func (client, test_response_auth, NULL, NULL);
+
+  return client;
+}
+
+static gint pre_describe_requests;
+
+static GstRTSPStatusCode
+count_pre_describe_request (GstRTSPClient * client, GstRTSPContext * ctx,
+    gpointer user_data)
+{
+  pre_describe_requests++;
+
+  return GST_RTSP_STS_OK;
+}
+
+GST_START_TEST (test_describe_auth_async)
+{
+  GstRTSPClient *client, *client2;
+  TestFileAuth *auth;
+  GError *error = NULL;
+  gchar *basic, *contents, *str_auth;
+  gint fd;
+
+  auth = g_object_new (test_file_auth_get_type (), NULL);
+  fd = g_file_open_tmp ("rtsp-auth-XXXXXX", &auth->path, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+  basic = gst_rtsp_auth_make_basic ("user", "password");
+  contents = g_strdup_printf ("%s user\n", basic);
+  fail_unless (g_file_set_contents (auth->path, contents, -1, NULL));
+  str_auth = g_strdup_printf ("Basic %s", basic);
+
+  auth_responses = 0;
+  pre_describe_requests = 0;
+  client = setup_auth_client (GST_RTSP_AUTH (auth));
+  client2 = setup_auth_client (GST_RTSP_AUTH (auth));
+  g_signal_connect (client, "pre-describe-request",
+      G_CALLBACK (count_pre_describe_request), NULL);
+
+  /* the request is suspended until the credentials are looked up, before
+   * its pre-request signal. The signal is emitted once it is resumed */
+  expected_auth_code = GST_RTSP_STS_OK;
+  send_describe_auth (client, str_auth);
+  fail_unless_equals_int (auth_responses, 0);
+  fail_unless_equals_int (pre_describe_requests, 0);
+  wait_auth_responses (1);
+  fail_unless_equals_int (auth->lookups, 1);
+  fail_unless_equals_int (pre_describe_requests, 1);
+
+  /* the result is cached for the other clients */
+  send_describe_auth (client2, str_auth);
+  fail_unless_equals_int (auth_responses, 2);
+  fail_unless_equals_int (auth->lookups, 1);
+
+  /* rejected credentials are cached too */
+  expected_auth_code = GST_RTSP_STS_UNAUTHORIZED;
+  send_describe_auth (client, "Basic d3Jvbmc6d3Jvbmc=");
+  wait_auth_responses (3);
+  send_describe_auth (client2, "Basic d3Jvbmc6d3Jvbmc=");
+  fail_unless_equals_int (auth_responses, 4);
+  fail_unless_equals_int (auth->lookups, 2);
+
+  /* without cache, the requests that arrive during the lookup are queued and
+   * use the result of the client */
+  gst_rtsp_auth_set_lookup_cache (GST_RTSP_AUTH (auth), 0, 0, 0);
+  expected_auth_code = GST_RTSP_STS_OK;
+  send_describe_auth (client2, str_auth);
+  send_describe_auth (client2, str_auth);
+  fail_unless_equals_int (auth_responses, 4);
+  wait_auth_responses (6);
+  fail_unless_equals_int (auth->lookups, 3);
+
+  teardown_client (client2);
+  teardown_client (client);
+  g_unlink (auth->path);
+  g_free (contents);
+  g_free (str_auth);
+  g_free (basic);
+  g_object_unref (auth);
+}
+
+GST_END_TEST;
+
+static gchar *digest_nonce;
+
+static gboolean
+test_response_digest (GstRTSPClient * client, GstRTSPMessage * response,
+    gboolean close, gpointer user_data)
+{
+  GstRTSPStatusCode code;
+  const gchar *reason;
+  GstRTSPVersion version;
+  gchar *header, *start, *end;
+
+  fail_unless (gst_rtsp_message_parse_response (response, &code, &reason,
+          &version)
+      == GST_RTSP_OK);
+  fail_unless (code == expected_auth_code);
+  auth_responses++;
+
+  /* keep the nonce of the challenge */
+  if (code == GST_RTSP_STS_UNAUTHORIZED && digest_nonce == NULL) {
+    fail_unless (gst_rtsp_message_get_header (response,
+            GST_RTSP_HDR_WWW_AUTHENTICATE, &header, 0) == GST_RTSP_OK);
+    start = strstr (header, "nonce=\"");
+    fail_unless (start != NULL);
+    start += strlen ("nonce=\"");
+    end = strchr (start, '"');
+    fail_unless (end != NULL);
+    digest_nonce = g_strndup (start, end - start);
+  }
+
+  return TRUE;
+}
+
+static void
+send_describe_digest (GstRTSPClient * client, const gchar * nonce,
+    const gchar * pass, GstRTSPStatusCode code)
+{
+  gchar *response, *authorization;
+
+  response = gst_rtsp_generate_digest_auth_response (NULL, "DESCRIBE",
+      "GStreamer RTSP Server", "user", pass, "rtsp://localhost/test", nonce);
+  authorization = g_strdup_printf ("Digest username=\"user\", "
+      "realm=\"GStreamer RTSP Server\", nonce=\"%s\", "
+      "uri=\"rtsp://localhost/test\", response=\"%s\"", nonce, response);
+
+  expected_auth_code = code;
+  send_describe_auth (client, authorization);
+
+  g_free (authorization);
+  g_free (response);
+}
+
+static GstRTSPClient *
+setup_digest_client (GstRTSPAuth * auth)
+{
+  GstRTSPClient *client;
+  GstRTSPConnection *conn;
+
+  client = setup_auth_client (auth);
+  create_connection (&conn);
+  fail_unless (gst_rtsp_client_set_connection (client, conn));
+  gst_rtsp_client_set_send_func (client, test_response_digest, NULL, NULL);
+
+  return client;
+}
+
+GST_START_TEST (test_describe_auth_digest)
+{
+  GstRTSPClient *client, *client2, *client3;
+  GstRTSPAuth *auth;
+  GstRTSPToken *token;
+  gchar *nonce;
+
+  auth = gst_rtsp_auth_new ();
+  gst_rtsp_auth_set_supported_methods (auth, GST_RTSP_AUTH_DIGEST);
+  token = gst_rtsp_token_new (GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE, G_TYPE_STRING,
+      "user", NULL);
+  gst_rtsp_auth_add_digest (auth, "user", "password", token);
+  gst_rtsp_token_unref (token);
+
+  client = setup_digest_client (auth);
+  client2 = setup_digest_client (auth);
+  client3 = setup_digest_client (auth);
+
+  /* get a nonce */
+  expected_auth_code = GST_RTSP_STS_UNAUTHORIZED;
+  send_describe (client, "rtsp://localhost/test");
+  fail_unless (digest_nonce != NULL);
+
+  /* a nonce that was changed is refused */
+  nonce = g_strdup (digest_nonce);
+  nonce[strlen (nonce) - 1] = nonce[strlen (nonce) - 1] == '0' ? '1' : '0';
+  send_describe_digest (client, nonce, "password",
+      GST_RTSP_STS_UNAUTHORIZED);
+  g_free (nonce);
+
+  /* a wrong password doesn't use up the nonce */
+  send_describe_digest (client, digest_nonce, "wrong",
+      GST_RTSP_STS_UNAUTHORIZED);
+  send_describe_digest (client2, digest_nonce, "password", GST_RTSP_STS_OK);
+
+  /* the nonce was used by another client */
+  send_describe_digest (client, digest_nonce, "password",
+      GST_RTSP_STS_UNAUTHORIZED);
+
+  /* without replay check all clients can use it */
+  gst_rtsp_auth_set_digest_nonces (auth, 60 * GST_SECOND, 0);
+  send_describe_digest (client, digest_nonce, "password", GST_RTSP_STS_OK);
+
+  /* an expired nonce is only accepted from the clients that used it */
+  gst_rtsp_auth_set_digest_nonces (auth, 0, 16);
+  send_describe_digest (client3, digest_nonce, "password",
+      GST_RTSP_STS_UNAUTHORIZED);
+  send_describe_digest (client2, digest_nonce, "password", GST_RTSP_STS_OK);
+  send_describe_digest (client, digest_nonce, "password", GST_RTSP_STS_OK);
+
+  g_free (digest_nonce);
+  digest_nonce = NULL;
+  teardown_client (client3);
+  teardown_client (client2);
+  teardown_client (client);
+  g_object_unref (auth);
+}
+
+GST_END_TEST;
+
 static const gchar *expected_transport = NULL;
 
 static gboolean
@@ -2021,7 +2657,13 @@ rtspclient_suite (void)
   tcase_add_test (tc, test_require);
   tcase_add_test (tc, test_request);
   tcase_add_test (tc, test_options);
+  tcase_add_test (tc, test_options_repeated);
+  tcase_add_test (tc, test_keepalive);
   tcase_add_test (tc, test_describe);
+  tcase_add_test (tc, test_describe_same_url);
+  tcase_add_test (tc, test_describe_auth_cache);
+  tcase_add_test (tc, test_describe_auth_async);
+  tcase_add_test (tc, test_describe_auth_digest);
   tcase_add_test (tc, test_setup_tcp);
   tcase_add_test (tc, test_setup_tcp_two_streams_same_channels);
   tcase_add_test (tc, test_client_multicast_transport_404);
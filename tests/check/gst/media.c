@@ -427,6 +427,197 @@ GST_START_TEST (test_media_prepare)
 
 GST_END_TEST;
 
+GST_START_TEST (test_media_cached_sdp)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPMedia *media;
+  GstRTSPUrl *url;
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread;
+  GstSDPInfo info;
+  GstSDPMessage *sdp;
+  gchar *str, *cached;
+
+  pool = gst_rtsp_thread_pool_new ();
+
+  factory = gst_rtsp_media_factory_new ();
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc is-live=true ! rtpvrawpay pt=96 name=pay0 )");
+
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+
+  info.is_ipv6 = FALSE;
+  info.server_ip = "127.0.0.1";
+
+  /* nothing cached yet */
+  fail_unless (gst_rtsp_media_get_cached_sdp (media, &info, "1234") == NULL);
+
+  gst_sdp_message_new (&sdp);
+  gst_sdp_message_set_version (sdp, "0");
+  gst_sdp_message_set_origin (sdp, "-", "1234", "1", "IN", "IP4",
+      info.server_ip);
+  gst_sdp_message_set_session_name (sdp, "test");
+  fail_unless (gst_rtsp_media_setup_sdp (media, sdp, &info));
+  gst_rtsp_media_cache_sdp (media, &info, sdp);
+  str = gst_sdp_message_as_text (sdp);
+
+  /* same session id gives the same SDP */
+  cached = gst_rtsp_media_get_cached_sdp (media, &info, "1234");
+  fail_unless (cached != NULL);
+  fail_unless_equals_string (cached, str);
+  g_free (cached);
+
+  /* only the session id changes */
+  gst_sdp_message_set_origin (sdp, "-", "9876543210", "1", "IN", "IP4",
+      info.server_ip);
+  g_free (str);
+  str = gst_sdp_message_as_text (sdp);
+  cached = gst_rtsp_media_get_cached_sdp (media, &info, "9876543210");
+  fail_unless_equals_string (cached, str);
+  g_free (cached);
+  g_free (str);
+  gst_sdp_message_free (sdp);
+
+  /* other server ip and address family are not cached */
+  info.server_ip = "10.0.0.1";
+  fail_unless (gst_rtsp_media_get_cached_sdp (media, &info, "1234") == NULL);
+  info.is_ipv6 = TRUE;
+  info.server_ip = "127.0.0.1";
+  fail_unless (gst_rtsp_media_get_cached_sdp (media, &info, "1234") == NULL);
+
+  /* unprepare empties the cache */
+  info.is_ipv6 = FALSE;
+  fail_unless (gst_rtsp_media_unprepare (media));
+  fail_unless (gst_rtsp_media_get_cached_sdp (media, &info, "1234") == NULL);
+
+  g_object_unref (media);
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+
+  g_object_unref (pool);
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_media_linger)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPMedia *media;
+  GstRTSPUrl *url;
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread;
+  GstStructure *stats;
+  guint64 reused, expired;
+  gint i;
+
+  pool = gst_rtsp_thread_pool_new ();
+
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_shared (factory, TRUE);
+  gst_rtsp_media_factory_set_linger_time (factory, 100 * GST_MSECOND);
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  fail_unless_equals_uint64 (gst_rtsp_media_get_linger_time (media),
+      100 * GST_MSECOND);
+
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+
+  /* the last unprepare keeps the media prepared */
+  fail_unless (gst_rtsp_media_unprepare (media));
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_PREPARED);
+
+  /* preparing again reuses the pipeline */
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+  fail_unless (media_has_sdp (media));
+
+  /* now let the linger time expire */
+  fail_unless (gst_rtsp_media_unprepare (media));
+  for (i = 0; i < 100; i++) {
+    stats = gst_rtsp_media_factory_get_stats (factory);
+    fail_unless (gst_structure_get_uint64 (stats, "linger-reused", &reused));
+    fail_unless (gst_structure_get_uint64 (stats, "linger-expired",
+            &expired));
+    gst_structure_free (stats);
+    if (expired > 0)
+      break;
+    g_usleep (10 * G_USEC_PER_SEC / 1000);
+  }
+  fail_unless_equals_uint64 (reused, 1);
+  fail_unless_equals_uint64 (expired, 1);
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_UNPREPARED);
+
+  g_object_unref (media);
+
+  /* unpreparing a lingering media unprepares it immediately */
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+  fail_unless (gst_rtsp_media_unprepare (media));
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_PREPARED);
+  fail_unless (gst_rtsp_media_unprepare (media));
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_UNPREPARED);
+
+  g_object_unref (media);
+
+  /* the linger statistics also count medias that got a linger time after
+   * they were constructed */
+  gst_rtsp_media_factory_set_linger_time (factory, 0);
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  gst_rtsp_media_set_linger_time (media, 100 * GST_MSECOND);
+
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+  fail_unless (gst_rtsp_media_unprepare (media));
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+
+  stats = gst_rtsp_media_factory_get_stats (factory);
+  fail_unless (gst_structure_get_uint64 (stats, "linger-reused", &reused));
+  gst_structure_free (stats);
+  fail_unless_equals_uint64 (reused, 2);
+
+  fail_unless (gst_rtsp_media_unprepare (media));
+  fail_unless (gst_rtsp_media_unprepare (media));
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_UNPREPARED);
+
+  g_object_unref (media);
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+
+  g_object_unref (pool);
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
 enum _SyncState
 {
   SYNC_STATE_INIT,
@@ -855,6 +1046,8 @@ rtspmedia_suite (void)
   tcase_add_test (tc, test_media_seek_one_active_stream);
   tcase_add_test (tc, test_media);
   tcase_add_test (tc, test_media_prepare);
+  tcase_add_test (tc, test_media_cached_sdp);
+  tcase_add_test (tc, test_media_linger);
   tcase_add_test (tc, test_media_shared_race_test_unsuspend_vs_set_state_null);
   tcase_add_test (tc, test_media_reusable);
   tcase_add_test (tc, test_media_dyn_prepare);
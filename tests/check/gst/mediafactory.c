@@ -19,7 +19,10 @@
 
 #include <gst/check/gstcheck.h>
 
+#include <glib/gstdio.h>
+
 #include <rtsp-media-factory.h>
+#include <rtsp-media-factory-uri.h>
 
 GST_START_TEST (test_parse_error)
 {
@@ -65,6 +68,68 @@ GST_START_TEST (test_launch)
 
 GST_END_TEST;
 
+GST_START_TEST (test_launch_template)
+{
+  GstRTSPMediaFactory *factory;
+  GstElement *element, *pay, *src;
+  GstPad *srcpad, *peer;
+  GstRTSPUrl *url;
+  guint pt, i;
+  gint num_buffers;
+
+  factory = gst_rtsp_media_factory_new ();
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc name=src num-buffers = 5 ! rtpvrawpay pt=97 name=pay0 )");
+
+  /* the first element is parsed, the others are made from the template */
+  for (i = 0; i < 3; i++) {
+    element = gst_rtsp_media_factory_create_element (factory, url);
+    fail_unless (GST_IS_BIN (element));
+    fail_if (GST_IS_PIPELINE (element));
+
+    pay = gst_bin_get_by_name (GST_BIN (element), "pay0");
+    fail_unless (pay != NULL);
+    g_object_get (pay, "pt", &pt, NULL);
+    fail_unless_equals_int (pt, 97);
+
+    src = gst_bin_get_by_name (GST_BIN (element), "src");
+    fail_unless (src != NULL);
+    g_object_get (src, "num-buffers", &num_buffers, NULL);
+    fail_unless_equals_int (num_buffers, 5);
+    srcpad = gst_element_get_static_pad (src, "src");
+    peer = gst_pad_get_peer (srcpad);
+    fail_unless (peer != NULL);
+    fail_unless (GST_PAD_PARENT (peer) == pay);
+
+    gst_object_unref (peer);
+    gst_object_unref (srcpad);
+    gst_object_unref (src);
+    gst_object_unref (pay);
+    gst_object_unref (element);
+  }
+
+  /* changing the launch line makes a new template */
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=98 name=pay0 )");
+  for (i = 0; i < 2; i++) {
+    element = gst_rtsp_media_factory_create_element (factory, url);
+    pay = gst_bin_get_by_name (GST_BIN (element), "pay0");
+    fail_unless (pay != NULL);
+    g_object_get (pay, "pt", &pt, NULL);
+    fail_unless_equals_int (pt, 98);
+    gst_object_unref (pay);
+    gst_object_unref (element);
+  }
+
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_launch_construct)
 {
   GstRTSPMediaFactory *factory;
@@ -133,6 +198,184 @@ GST_START_TEST (test_shared)
 
 GST_END_TEST;
 
+static void
+media_constructed_cb (GstRTSPMediaFactory * factory, GstRTSPMedia * media,
+    gint * n_constructed)
+{
+  g_atomic_int_inc (n_constructed);
+  /* make the construction slow so that the other threads have to wait */
+  g_usleep (G_USEC_PER_SEC / 10);
+}
+
+static gpointer
+construct_thread_func (GstRTSPMediaFactory * factory)
+{
+  GstRTSPUrl *url;
+  GstRTSPMedia *media;
+
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+  media = gst_rtsp_media_factory_construct (factory, url);
+  gst_rtsp_url_free (url);
+
+  return media;
+}
+
+GST_START_TEST (test_shared_concurrent_construct)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPMedia *media[4];
+  GThread *threads[4];
+  gint n_constructed = 0;
+  gint i;
+
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_shared (factory, TRUE);
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+  g_signal_connect (factory, "media-constructed",
+      G_CALLBACK (media_constructed_cb), &n_constructed);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("construct",
+        (GThreadFunc) construct_thread_func, factory);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    media[i] = g_thread_join (threads[i]);
+
+  /* only one media was constructed and all threads got it */
+  fail_unless_equals_int (n_constructed, 1);
+  for (i = 0; i < G_N_ELEMENTS (media); i++) {
+    fail_unless (GST_IS_RTSP_MEDIA (media[i]));
+    fail_unless (media[i] == media[0]);
+  }
+  for (i = 0; i < G_N_ELEMENTS (media); i++)
+    g_object_unref (media[i]);
+
+  g_object_unref (factory);
+}
+
+GST_END_TEST;
+
+static void
+media_configure_shared_cb (GstRTSPMediaFactory * factory,
+    GstRTSPMedia * media, gpointer user_data)
+{
+  gst_rtsp_media_set_shared (media, TRUE);
+}
+
+/* a media that is made shared by a media-configure handler is also
+ * constructed only once */
+GST_START_TEST (test_configure_shared_concurrent_construct)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPMedia *media[4];
+  GThread *threads[4];
+  gint n_constructed = 0;
+  gint i;
+
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+  g_signal_connect (factory, "media-constructed",
+      G_CALLBACK (media_constructed_cb), &n_constructed);
+  g_signal_connect (factory, "media-configure",
+      G_CALLBACK (media_configure_shared_cb), NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("construct",
+        (GThreadFunc) construct_thread_func, factory);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    media[i] = g_thread_join (threads[i]);
+
+  fail_unless_equals_int (n_constructed, 1);
+  for (i = 0; i < G_N_ELEMENTS (media); i++) {
+    fail_unless (GST_IS_RTSP_MEDIA (media[i]));
+    fail_unless (media[i] == media[0]);
+  }
+  for (i = 0; i < G_N_ELEMENTS (media); i++)
+    g_object_unref (media[i]);
+
+  g_object_unref (factory);
+}
+
+GST_END_TEST;
+
+static GMutex parallel_lock;
+static GCond parallel_cond;
+static gint parallel_active;
+
+static void
+media_constructed_parallel_cb (GstRTSPMediaFactory * factory,
+    GstRTSPMedia * media, gboolean * parallel)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+  /* wait until the construction for the other key is running too */
+  g_mutex_lock (&parallel_lock);
+  parallel_active++;
+  g_cond_broadcast (&parallel_cond);
+  while (parallel_active < 2) {
+    if (!g_cond_wait_until (&parallel_cond, &parallel_lock, end_time))
+      break;
+  }
+  if (parallel_active >= 2)
+    *parallel = TRUE;
+  g_mutex_unlock (&parallel_lock);
+}
+
+static GstRTSPMediaFactory *parallel_factory;
+
+static gpointer
+construct_url_thread_func (const gchar * uri)
+{
+  GstRTSPUrl *url;
+  GstRTSPMedia *media;
+
+  fail_unless (gst_rtsp_url_parse (uri, &url) == GST_RTSP_OK);
+  media = gst_rtsp_media_factory_construct (parallel_factory, url);
+  gst_rtsp_url_free (url);
+
+  return media;
+}
+
+/* the medias of different urls of a shared factory are constructed in
+ * parallel */
+GST_START_TEST (test_shared_construct_different_keys)
+{
+  GstRTSPMedia *media[2];
+  GThread *threads[2];
+  gboolean parallel = FALSE;
+  gint i;
+
+  parallel_factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_shared (parallel_factory, TRUE);
+  gst_rtsp_media_factory_set_launch (parallel_factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+  g_signal_connect (parallel_factory, "media-constructed",
+      G_CALLBACK (media_constructed_parallel_cb), &parallel);
+
+  threads[0] = g_thread_new ("construct",
+      (GThreadFunc) construct_url_thread_func,
+      (gpointer) "rtsp://localhost:8554/test1");
+  threads[1] = g_thread_new ("construct",
+      (GThreadFunc) construct_url_thread_func,
+      (gpointer) "rtsp://localhost:8554/test2");
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    media[i] = g_thread_join (threads[i]);
+
+  fail_unless (parallel);
+  fail_unless (GST_IS_RTSP_MEDIA (media[0]));
+  fail_unless (GST_IS_RTSP_MEDIA (media[1]));
+  fail_unless (media[0] != media[1]);
+  for (i = 0; i < G_N_ELEMENTS (media); i++)
+    g_object_unref (media[i]);
+
+  g_object_unref (parallel_factory);
+  parallel_factory = NULL;
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_addresspool)
 {
   GstRTSPMediaFactory *factory;
@@ -314,6 +557,41 @@ GST_START_TEST (test_reset)
 
 GST_END_TEST;
 
+GST_START_TEST (test_gop_cache)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPMedia *media;
+  GstRTSPUrl *url;
+  GstRTSPStream *stream;
+  gboolean enabled;
+
+  factory = gst_rtsp_media_factory_new ();
+  fail_if (gst_rtsp_media_factory_get_gop_cache (factory));
+  g_object_set (factory, "gop-cache", TRUE, NULL);
+  fail_unless (gst_rtsp_media_factory_get_gop_cache (factory));
+  gst_rtsp_url_parse ("rtsp://localhost:8554/test", &url);
+
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  g_object_get (media, "gop-cache", &enabled, NULL);
+  fail_unless (enabled);
+  stream = gst_rtsp_media_get_stream (media, 0);
+  fail_unless (gst_rtsp_stream_get_gop_cache (stream));
+
+  gst_rtsp_media_set_gop_cache (media, FALSE);
+  fail_if (gst_rtsp_media_get_gop_cache (media));
+  fail_if (gst_rtsp_stream_get_gop_cache (stream));
+  g_object_unref (media);
+
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_mcast_ttl)
 {
   GstRTSPMediaFactory *factory;
@@ -420,6 +698,414 @@ GST_START_TEST (test_allow_bind_mcast)
 
 GST_END_TEST;
 
+static guint
+get_warm_pool_level (GstRTSPMediaFactory * factory)
+{
+  GstStructure *stats;
+  guint level;
+
+  stats = gst_rtsp_media_factory_get_stats (factory);
+  fail_unless (gst_structure_get_uint (stats, "warm-pool-level", &level));
+  gst_structure_free (stats);
+
+  return level;
+}
+
+GST_START_TEST (test_warm_pool)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPThreadPool *pool;
+  GstRTSPMedia *media;
+  GstStructure *stats;
+  GstRTSPUrl *url;
+  guint64 hits, misses;
+  gint i;
+
+  factory = gst_rtsp_media_factory_new ();
+  fail_unless (gst_rtsp_media_factory_get_warm_pool_size (factory) == 0);
+  gst_rtsp_media_factory_set_warm_pool_size (factory, 1);
+  fail_unless (gst_rtsp_media_factory_get_warm_pool_size (factory) == 1);
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+
+  pool = gst_rtsp_thread_pool_new ();
+  fail_unless (gst_rtsp_media_factory_get_thread_pool (factory) == NULL);
+  gst_rtsp_media_factory_set_thread_pool (factory, pool);
+
+  /* the first media is not in the pool yet */
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_UNPREPARED);
+  g_object_unref (media);
+
+  /* wait for the pool to be filled */
+  for (i = 0; i < 100 && get_warm_pool_level (factory) == 0; i++)
+    g_usleep (G_USEC_PER_SEC / 20);
+  fail_unless_equals_int (get_warm_pool_level (factory), 1);
+
+  /* the next media is taken from the pool and is prepared */
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  fail_unless (gst_rtsp_media_get_status (media) ==
+      GST_RTSP_MEDIA_STATUS_PREPARED);
+  fail_unless (gst_rtsp_media_unprepare (media));
+  g_object_unref (media);
+
+  stats = gst_rtsp_media_factory_get_stats (factory);
+  fail_unless (gst_structure_get_uint64 (stats, "warm-pool-hits", &hits));
+  fail_unless (gst_structure_get_uint64 (stats, "warm-pool-misses", &misses));
+  fail_unless (hits == 1);
+  fail_unless (misses == 1);
+  gst_structure_free (stats);
+
+  /* wait for the refill and release it again */
+  for (i = 0; i < 100 && get_warm_pool_level (factory) == 0; i++)
+    g_usleep (G_USEC_PER_SEC / 20);
+  gst_rtsp_media_factory_set_warm_pool_size (factory, 0);
+  fail_unless_equals_int (get_warm_pool_level (factory), 0);
+
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+  g_object_unref (pool);
+
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
+static void
+media_constructed_count_cb (GstRTSPMediaFactory * factory,
+    GstRTSPMedia * media, gint * n_constructed)
+{
+  g_atomic_int_inc (n_constructed);
+}
+
+static void
+media_configure_record_cb (GstRTSPMediaFactory * factory,
+    GstRTSPMedia * media, gpointer user_data)
+{
+  gst_rtsp_media_set_transport_mode (media, GST_RTSP_TRANSPORT_MODE_RECORD);
+}
+
+/* medias that can't be kept in the warm pool are not made for it */
+GST_START_TEST (test_warm_pool_unpoolable)
+{
+  GstRTSPMediaFactory *factory;
+  GstRTSPThreadPool *pool;
+  GstRTSPMedia *media;
+  GstRTSPUrl *url;
+  gint n_constructed = 0;
+  gint i;
+
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+  pool = gst_rtsp_thread_pool_new ();
+
+  /* the pool of a shared factory is never filled */
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_shared (factory, TRUE);
+  gst_rtsp_media_factory_set_warm_pool_size (factory, 1);
+  gst_rtsp_media_factory_set_thread_pool (factory, pool);
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+  g_signal_connect (factory, "media-constructed",
+      G_CALLBACK (media_constructed_count_cb), &n_constructed);
+
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  g_object_unref (media);
+  g_usleep (G_USEC_PER_SEC / 5);
+  fail_unless_equals_int (g_atomic_int_get (&n_constructed), 1);
+  fail_unless_equals_int (get_warm_pool_level (factory), 0);
+  g_object_unref (factory);
+
+  /* a media that a configure handler makes unpoolable stops the filling */
+  n_constructed = 0;
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_warm_pool_size (factory, 1);
+  gst_rtsp_media_factory_set_thread_pool (factory, pool);
+  gst_rtsp_media_factory_set_launch (factory,
+      "( videotestsrc ! rtpvrawpay pt=96 name=pay0 )");
+  g_signal_connect (factory, "media-constructed",
+      G_CALLBACK (media_constructed_count_cb), &n_constructed);
+  g_signal_connect (factory, "media-configure",
+      G_CALLBACK (media_configure_record_cb), NULL);
+
+  media = gst_rtsp_media_factory_construct (factory, url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  g_object_unref (media);
+
+  /* one media is made for the pool and dropped */
+  for (i = 0; i < 100 && g_atomic_int_get (&n_constructed) < 2; i++)
+    g_usleep (G_USEC_PER_SEC / 20);
+  fail_unless_equals_int (g_atomic_int_get (&n_constructed), 2);
+
+  for (i = 0; i < 2; i++) {
+    media = gst_rtsp_media_factory_construct (factory, url);
+    fail_unless (GST_IS_RTSP_MEDIA (media));
+    g_object_unref (media);
+  }
+  g_usleep (G_USEC_PER_SEC / 5);
+  fail_unless_equals_int (g_atomic_int_get (&n_constructed), 4);
+  g_object_unref (factory);
+
+  gst_rtsp_url_free (url);
+  g_object_unref (pool);
+
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
+static gchar *
+find_packet_cache (const gchar * dirname)
+{
+  const gchar *name;
+  gchar *result = NULL;
+  GDir *dir;
+
+  dir = g_dir_open (dirname, 0, NULL);
+  fail_unless (dir != NULL);
+  while ((name = g_dir_read_name (dir)) && result == NULL) {
+    if (g_str_has_suffix (name, ".rtpcache"))
+      result = g_build_filename (dirname, name, NULL);
+  }
+  g_dir_close (dir);
+
+  return result;
+}
+
+/* write the output of the elements in @launch to @filename */
+static void
+make_test_file (const gchar * launch, const gchar * filename)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  gchar *desc;
+
+  desc = g_strdup_printf ("%s ! filesink location=\"%s\"", launch, filename);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+/* wait until the only packet cache in @cache_dir is another one than @old */
+static gchar *
+wait_packet_cache (const gchar * cache_dir, const gchar * old)
+{
+  gchar *cache = NULL;
+  gint i;
+
+  for (i = 0; i < 100; i++) {
+    if (g_file_test (cache_dir, G_FILE_TEST_IS_DIR))
+      cache = find_packet_cache (cache_dir);
+    if (cache && g_strcmp0 (cache, old) &&
+        (old == NULL || !g_file_test (old, G_FILE_TEST_EXISTS)))
+      break;
+    g_free (cache);
+    cache = NULL;
+    g_usleep (G_USEC_PER_SEC / 20);
+  }
+  fail_unless (cache != NULL);
+
+  return cache;
+}
+
+/* check that the next element of @factory is made from @name */
+static void
+check_factory_element (GstRTSPMediaFactoryURI * factory,
+    const GstRTSPUrl * url, const gchar * name)
+{
+  GstElement *element, *pay;
+
+  element = gst_rtsp_media_factory_create_element (GST_RTSP_MEDIA_FACTORY
+      (factory), url);
+  fail_unless (element != NULL);
+  pay = gst_bin_get_by_name (GST_BIN (element), name);
+  fail_unless (pay != NULL);
+  gst_object_unref (pay);
+  gst_object_unref (element);
+}
+
+GST_START_TEST (test_uri_packet_cache)
+{
+  GstRTSPMediaFactoryURI *factory;
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread;
+  GstRTSPMedia *media;
+  GstRTSPUrl *url;
+  gchar *dir, *cache_dir, *filename, *uri, *cache, *old;
+
+  dir = g_dir_make_tmp ("rtsp-cache-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  cache_dir = g_build_filename (dir, "cache", NULL);
+  filename = g_build_filename (dir, "test.wav", NULL);
+
+  /* make a small file to serve */
+  make_test_file ("audiotestsrc num-buffers=20 ! wavenc", filename);
+
+  factory = gst_rtsp_media_factory_uri_new ();
+  uri = gst_filename_to_uri (filename, NULL);
+  gst_rtsp_media_factory_uri_set_uri (factory, uri);
+  fail_unless (gst_rtsp_media_factory_uri_get_cache_dir (factory) == NULL);
+  gst_rtsp_media_factory_uri_set_cache_dir (factory, cache_dir);
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+
+  /* the first element demuxes the file and starts indexing it */
+  check_factory_element (factory, url, "dynpay0");
+  cache = wait_packet_cache (cache_dir, NULL);
+
+  /* the next one replays the packets */
+  check_factory_element (factory, url, "pay0");
+
+  pool = gst_rtsp_thread_pool_new ();
+  media = gst_rtsp_media_factory_construct (GST_RTSP_MEDIA_FACTORY (factory),
+      url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  fail_unless (gst_rtsp_media_n_streams (media) == 1);
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+  fail_unless (gst_rtsp_media_seekable (media) > 0);
+  fail_unless (gst_rtsp_media_unprepare (media));
+  g_object_unref (media);
+  g_object_unref (pool);
+
+  /* a changed file is indexed again and replaces the old cache */
+  make_test_file ("audiotestsrc num-buffers=30 ! wavenc", filename);
+  check_factory_element (factory, url, "dynpay0");
+  old = cache;
+  cache = wait_packet_cache (cache_dir, old);
+  fail_if (g_file_test (old, G_FILE_TEST_EXISTS));
+  g_free (old);
+  check_factory_element (factory, url, "pay0");
+
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+
+  g_unlink (cache);
+  g_rmdir (cache_dir);
+  g_unlink (filename);
+  g_rmdir (dir);
+  g_free (cache);
+  g_free (uri);
+  g_free (filename);
+  g_free (cache_dir);
+  g_free (dir);
+
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_uri_packet_cache_ts)
+{
+  const gchar *elements[] = { "x264enc", "h264parse", "mpegtsmux",
+    "tsdemux", "rtph264pay"
+  };
+  GstRTSPMediaFactoryURI *factory;
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread;
+  GstRTSPMedia *media;
+  GstRTSPStream *stream;
+  GstRTSPTransport *transport;
+  GstRTSPTimeRange *range;
+  GstRTSPUrl *url;
+  gchar *dir, *cache_dir, *filename, *uri, *cache, *str;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (elements); i++) {
+    GstElementFactory *element_factory;
+
+    if (!(element_factory = gst_element_factory_find (elements[i]))) {
+      GST_INFO ("skipping test, %s is missing", elements[i]);
+      return;
+    }
+    gst_object_unref (element_factory);
+  }
+
+  dir = g_dir_make_tmp ("rtsp-cache-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  cache_dir = g_build_filename (dir, "cache", NULL);
+  filename = g_build_filename (dir, "test.ts", NULL);
+
+  /* a video with reordered frames, its packets don't have increasing
+   * timestamps */
+  make_test_file ("videotestsrc num-buffers=60 ! "
+      "video/x-raw,width=64,height=64,framerate=30/1 ! "
+      "x264enc bframes=2 key-int-max=15 ! h264parse ! mpegtsmux", filename);
+
+  factory = gst_rtsp_media_factory_uri_new ();
+  uri = gst_filename_to_uri (filename, NULL);
+  gst_rtsp_media_factory_uri_set_uri (factory, uri);
+  gst_rtsp_media_factory_uri_set_cache_dir (factory, cache_dir);
+  fail_unless (gst_rtsp_url_parse ("rtsp://localhost:8554/test",
+          &url) == GST_RTSP_OK);
+
+  check_factory_element (factory, url, "dynpay0");
+  cache = wait_packet_cache (cache_dir, NULL);
+  check_factory_element (factory, url, "pay0");
+
+  pool = gst_rtsp_thread_pool_new ();
+  media = gst_rtsp_media_factory_construct (GST_RTSP_MEDIA_FACTORY (factory),
+      url);
+  fail_unless (GST_IS_RTSP_MEDIA (media));
+  fail_unless (gst_rtsp_media_n_streams (media) == 1);
+  stream = gst_rtsp_media_get_stream (media, 0);
+  thread = gst_rtsp_thread_pool_get_thread (pool,
+      GST_RTSP_THREAD_TYPE_MEDIA, NULL);
+  fail_unless (gst_rtsp_media_prepare (media, thread));
+
+  fail_unless (gst_rtsp_transport_new (&transport) == GST_RTSP_OK);
+  transport->lower_transport = GST_RTSP_LOWER_TRANS_TCP;
+  fail_unless (gst_rtsp_stream_complete_stream (stream, transport));
+  fail_unless (gst_rtsp_transport_free (transport) == GST_RTSP_OK);
+
+  /* the seek starts at the keyframe before the position */
+  fail_unless (gst_rtsp_range_parse ("npt=1.2-", &range) == GST_RTSP_OK);
+  fail_unless (gst_rtsp_media_seek (media, range));
+  gst_rtsp_range_free (range);
+  str = gst_rtsp_media_get_range_string (media, FALSE, GST_RTSP_RANGE_NPT);
+  fail_unless (gst_rtsp_range_parse (str, &range) == GST_RTSP_OK);
+  fail_unless (range->min.type == GST_RTSP_TIME_SECONDS);
+  fail_unless (range->min.seconds > 0.0 && range->min.seconds <= 1.2);
+  gst_rtsp_range_free (range);
+  g_free (str);
+
+  fail_unless (gst_rtsp_media_unprepare (media));
+  g_object_unref (media);
+  g_object_unref (pool);
+
+  gst_rtsp_url_free (url);
+  g_object_unref (factory);
+
+  g_unlink (cache);
+  g_rmdir (cache_dir);
+  g_unlink (filename);
+  g_rmdir (dir);
+  g_free (cache);
+  g_free (uri);
+  g_free (filename);
+  g_free (cache_dir);
+  g_free (dir);
+
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
 static Suite *
 rtspmediafactory_suite (void)
 {
@@ -430,13 +1116,22 @@ rtspmediafactory_suite (void)
   tcase_set_timeout (tc, 20);
   tcase_add_test (tc, test_parse_error);
   tcase_add_test (tc, test_launch);
+  tcase_add_test (tc, test_launch_template);
   tcase_add_test (tc, test_launch_construct);
   tcase_add_test (tc, test_shared);
+  tcase_add_test (tc, test_shared_concurrent_construct);
+  tcase_add_test (tc, test_configure_shared_concurrent_construct);
+  tcase_add_test (tc, test_shared_construct_different_keys);
   tcase_add_test (tc, test_addresspool);
   tcase_add_test (tc, test_permissions);
   tcase_add_test (tc, test_reset);
+  tcase_add_test (tc, test_gop_cache);
   tcase_add_test (tc, test_mcast_ttl);
   tcase_add_test (tc, test_allow_bind_mcast);
+  tcase_add_test (tc, test_warm_pool);
+  tcase_add_test (tc, test_warm_pool_unpoolable);
+  tcase_add_test (tc, test_uri_packet_cache);
+  tcase_add_test (tc, test_uri_packet_cache_ts);
 
   return s;
 }
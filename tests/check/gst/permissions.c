@@ -124,6 +124,52 @@ GST_START_TEST (test_permissions)
 
 GST_END_TEST;
 
+GST_START_TEST (test_permissions_id)
+{
+  GstRTSPPermissions *perms;
+  gchar *name;
+  gint i;
+
+  perms = gst_rtsp_permissions_new ();
+  gst_rtsp_permissions_add_role (perms, "user",
+      "permission1", G_TYPE_BOOLEAN, TRUE,
+      "permission2", G_TYPE_STRING, "yes", NULL);
+  fail_unless (gst_rtsp_permissions_is_allowed_id (perms,
+          g_quark_from_string ("user"), g_quark_from_string ("permission1")));
+  /* only booleans allow something */
+  fail_if (gst_rtsp_permissions_is_allowed_id (perms,
+          g_quark_from_string ("user"), g_quark_from_string ("permission2")));
+  fail_if (gst_rtsp_permissions_is_allowed_id (perms, 0,
+          g_quark_from_string ("permission1")));
+  fail_if (gst_rtsp_permissions_is_allowed_id (perms,
+          g_quark_from_string ("user"), 0));
+
+  /* more permissions than fit in a bitmask */
+  for (i = 0; i < 100; i++) {
+    name = g_strdup_printf ("many%d", i);
+    gst_rtsp_permissions_add_permission_for_role (perms, "admin", name,
+        i % 2 == 0);
+    g_free (name);
+  }
+  for (i = 0; i < 100; i++) {
+    name = g_strdup_printf ("many%d", i);
+    fail_unless_equals_int (gst_rtsp_permissions_is_allowed (perms, "admin",
+            name), i % 2 == 0);
+    fail_if (gst_rtsp_permissions_is_allowed (perms, "user", name));
+    g_free (name);
+  }
+  fail_unless (gst_rtsp_permissions_is_allowed (perms, "user", "permission1"));
+
+  /* and back to a bitmask */
+  gst_rtsp_permissions_remove_role (perms, "admin");
+  fail_if (gst_rtsp_permissions_is_allowed (perms, "admin", "many0"));
+  fail_unless (gst_rtsp_permissions_is_allowed (perms, "user", "permission1"));
+
+  gst_rtsp_permissions_unref (perms);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtsppermissions_suite (void)
 {
@@ -133,6 +179,7 @@ rtsppermissions_suite (void)
   suite_add_tcase (s, tc);
   tcase_set_timeout (tc, 20);
   tcase_add_test (tc, test_permissions);
+  tcase_add_test (tc, test_permissions_id);
 
   return s;
 }
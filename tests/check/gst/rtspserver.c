@@ -709,6 +709,394 @@ GST_START_TEST (test_describe)
 
 GST_END_TEST;
 
+GST_START_TEST (test_describe_multiple_acceptors)
+{
+  GstRTSPThreadPool *pool;
+  gint i;
+
+  pool = gst_rtsp_server_get_thread_pool (server);
+  gst_rtsp_thread_pool_set_max_threads (pool, 2);
+  g_object_unref (pool);
+
+  gst_rtsp_server_set_n_acceptors (server, 3);
+  fail_unless_equals_int (gst_rtsp_server_get_n_acceptors (server), 3);
+
+  start_server (FALSE);
+
+  /* the connections are spread over the acceptors, all of them work */
+  for (i = 0; i < 6; i++) {
+    GstRTSPConnection *conn;
+    GstSDPMessage *sdp_message;
+
+    conn = connect_to_server (test_port, TEST_MOUNT_POINT);
+    sdp_message = do_describe (conn, TEST_MOUNT_POINT);
+    fail_unless (gst_sdp_message_medias_len (sdp_message) == 2);
+    gst_sdp_message_free (sdp_message);
+    gst_rtsp_connection_free (conn);
+  }
+
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_max_connections)
+{
+  GstRTSPConnection *conn1, *conn2;
+  GstSDPMessage *sdp_message;
+  GstRTSPMessage *request;
+  GstStructure *stats;
+  guint64 accepted, rejected;
+  gint connections;
+
+  gst_rtsp_server_set_max_connections (server, 1);
+  fail_unless_equals_int (gst_rtsp_server_get_max_connections (server), 1);
+
+  start_server (FALSE);
+
+  conn1 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  sdp_message = do_describe (conn1, TEST_MOUNT_POINT);
+  fail_unless (gst_sdp_message_medias_len (sdp_message) == 2);
+  gst_sdp_message_free (sdp_message);
+
+  /* the second connection is closed without an answer */
+  conn2 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  request = create_request (conn2, GST_RTSP_OPTIONS, NULL);
+  fail_unless (send_request (conn2, request));
+  gst_rtsp_message_free (request);
+  iterate ();
+  fail_unless (read_response (conn2) == NULL);
+
+  stats = gst_rtsp_server_get_admission_stats (server);
+  fail_unless (gst_structure_get_int (stats, "connections", &connections));
+  fail_unless_equals_int (connections, 1);
+  fail_unless (gst_structure_get_uint64 (stats, "accepted", &accepted));
+  fail_unless_equals_int (accepted, 1);
+  fail_unless (gst_structure_get_uint64 (stats, "rejected-connections",
+          &rejected));
+  fail_unless_equals_int (rejected, 1);
+  gst_structure_free (stats);
+
+  gst_rtsp_connection_free (conn2);
+  gst_rtsp_connection_free (conn1);
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_connection_rate)
+{
+  GstRTSPConnection *conn1, *conn2, *conn3;
+  GstRTSPMessage *request;
+  GstStructure *stats;
+  guint64 accepted, rejected;
+  gdouble rate;
+  guint burst;
+
+  /* two connections at once, then one every 100 seconds */
+  gst_rtsp_server_set_connection_rate (server, 0.01, 2);
+  gst_rtsp_server_get_connection_rate (server, &rate, &burst);
+  fail_unless (rate == 0.01);
+  fail_unless_equals_int (burst, 2);
+
+  start_server (FALSE);
+
+  conn1 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  fail_unless (do_simple_request (conn1, GST_RTSP_OPTIONS,
+          NULL) == GST_RTSP_STS_OK);
+  conn2 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  fail_unless (do_simple_request (conn2, GST_RTSP_OPTIONS,
+          NULL) == GST_RTSP_STS_OK);
+
+  /* the third connection from the same address is over the rate */
+  conn3 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  request = create_request (conn3, GST_RTSP_OPTIONS, NULL);
+  fail_unless (send_request (conn3, request));
+  gst_rtsp_message_free (request);
+  iterate ();
+  fail_unless (read_response (conn3) == NULL);
+
+  stats = gst_rtsp_server_get_admission_stats (server);
+  fail_unless (gst_structure_get_uint64 (stats, "accepted", &accepted));
+  fail_unless_equals_int (accepted, 2);
+  fail_unless (gst_structure_get_uint64 (stats, "rejected-rate", &rejected));
+  fail_unless_equals_int (rejected, 1);
+  gst_structure_free (stats);
+
+  gst_rtsp_connection_free (conn3);
+  gst_rtsp_connection_free (conn2);
+  gst_rtsp_connection_free (conn1);
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_max_pending_connections)
+{
+  GstRTSPConnection *conn1, *conn2, *conn3;
+  GstRTSPMessage *request;
+  GstStructure *stats;
+  guint64 accepted, rejected;
+  gint pending;
+
+  gst_rtsp_server_set_max_pending_connections (server, 1);
+  fail_unless_equals_int (gst_rtsp_server_get_max_pending_connections
+      (server), 1);
+
+  start_server (FALSE);
+
+  /* the first connection doesn't send a request yet */
+  conn1 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  iterate ();
+
+  stats = gst_rtsp_server_get_admission_stats (server);
+  fail_unless (gst_structure_get_int (stats, "pending", &pending));
+  fail_unless_equals_int (pending, 1);
+  gst_structure_free (stats);
+
+  /* so the second one is refused */
+  conn2 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  request = create_request (conn2, GST_RTSP_OPTIONS, NULL);
+  fail_unless (send_request (conn2, request));
+  gst_rtsp_message_free (request);
+  iterate ();
+  fail_unless (read_response (conn2) == NULL);
+
+  /* once the first connection completed a request, new ones are admitted */
+  fail_unless (do_simple_request (conn1, GST_RTSP_OPTIONS,
+          NULL) == GST_RTSP_STS_OK);
+  conn3 = connect_to_server (test_port, TEST_MOUNT_POINT);
+  fail_unless (do_simple_request (conn3, GST_RTSP_OPTIONS,
+          NULL) == GST_RTSP_STS_OK);
+
+  stats = gst_rtsp_server_get_admission_stats (server);
+  fail_unless (gst_structure_get_int (stats, "pending", &pending));
+  fail_unless_equals_int (pending, 0);
+  fail_unless (gst_structure_get_uint64 (stats, "accepted", &accepted));
+  fail_unless_equals_int (accepted, 2);
+  fail_unless (gst_structure_get_uint64 (stats, "rejected-pending",
+          &rejected));
+  fail_unless_equals_int (rejected, 1);
+  gst_structure_free (stats);
+
+  gst_rtsp_connection_free (conn3);
+  gst_rtsp_connection_free (conn2);
+  gst_rtsp_connection_free (conn1);
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
+static gint tunnel_connected;
+
+static gpointer
+connect_tunnel (GstRTSPConnection * conn)
+{
+  GstRTSPResult res;
+
+  res = gst_rtsp_connection_connect (conn, NULL);
+  g_atomic_int_set (&tunnel_connected, 1);
+
+  return GINT_TO_POINTER (res);
+}
+
+/* connect an RTSP-over-HTTP tunnel, the connections are accepted from the
+ * main context while the tunnel connects */
+static GstRTSPResult
+connect_tunnel_to_server (gint port, GstRTSPConnection ** conn)
+{
+  GThread *thread;
+  gchar *address;
+  gchar *uri_string;
+  GstRTSPUrl *url = NULL;
+
+  address = gst_rtsp_server_get_address (server);
+  uri_string = g_strdup_printf ("rtsp://%s:%d%s", address, port,
+      TEST_MOUNT_POINT);
+  g_free (address);
+  fail_unless (gst_rtsp_url_parse (uri_string, &url) == GST_RTSP_OK);
+  g_free (uri_string);
+
+  fail_unless (gst_rtsp_connection_create (url, conn) == GST_RTSP_OK);
+  gst_rtsp_url_free (url);
+  gst_rtsp_connection_set_tunneled (*conn, TRUE);
+
+  g_atomic_int_set (&tunnel_connected, 0);
+  thread = g_thread_new ("tunnel", (GThreadFunc) connect_tunnel, *conn);
+  while (!g_atomic_int_get (&tunnel_connected)) {
+    iterate ();
+    g_usleep (1000);
+  }
+
+  return GPOINTER_TO_INT (g_thread_join (thread));
+}
+
+/* the tunnels are paired on the threads of the clients */
+static void
+wait_tunnel_stat (const gchar * field, guint64 value)
+{
+  GstStructure *stats;
+  guint64 current = 0;
+  gint i;
+
+  for (i = 0; i < 5000; i++) {
+    stats = gst_rtsp_server_get_tunnel_stats (server);
+    fail_unless (gst_structure_get_uint64 (stats, field, &current));
+    gst_structure_free (stats);
+    if (current == value)
+      break;
+    iterate ();
+    g_usleep (1000);
+  }
+  fail_unless_equals_uint64 (current, value);
+}
+
+GST_START_TEST (test_tunnel)
+{
+  GstRTSPConnection *conn1, *conn2;
+  GstSDPMessage *sdp_message;
+  GstStructure *stats;
+  gint pending;
+
+  gst_rtsp_server_set_tunnel_timeout (server, 10 * GST_SECOND);
+  fail_unless_equals_uint64 (gst_rtsp_server_get_tunnel_timeout (server),
+      10 * GST_SECOND);
+
+  start_server (FALSE);
+
+  /* the GET and POST connections of the tunnel are merged */
+  fail_unless (connect_tunnel_to_server (test_port, &conn1) == GST_RTSP_OK);
+  wait_tunnel_stat ("merged", 1);
+  sdp_message = do_describe (conn1, TEST_MOUNT_POINT);
+  fail_unless (gst_sdp_message_medias_len (sdp_message) == 2);
+  gst_sdp_message_free (sdp_message);
+
+  /* no tunnel can wait for its other half */
+  gst_rtsp_server_set_max_pending_tunnels (server, 0);
+  fail_unless_equals_int (gst_rtsp_server_get_max_pending_tunnels (server), 0);
+  fail_if (connect_tunnel_to_server (test_port, &conn2) == GST_RTSP_OK);
+  wait_tunnel_stat ("rejected", 1);
+
+  stats = gst_rtsp_server_get_tunnel_stats (server);
+  fail_unless (gst_structure_get_int (stats, "pending", &pending));
+  fail_unless_equals_int (pending, 0);
+  gst_structure_free (stats);
+
+  gst_rtsp_connection_free (conn2);
+  gst_rtsp_connection_free (conn1);
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
+static void
+wait_tunnels_pending (gint value)
+{
+  GstStructure *stats;
+  gint current = -1;
+  gint i;
+
+  for (i = 0; i < 5000; i++) {
+    stats = gst_rtsp_server_get_tunnel_stats (server);
+    fail_unless (gst_structure_get_int (stats, "pending", &current));
+    gst_structure_free (stats);
+    if (current == value)
+      break;
+    iterate ();
+    g_usleep (1000);
+  }
+  fail_unless_equals_int (current, value);
+}
+
+/* open only the GET connection of an RTSP-over-HTTP tunnel */
+static GSocketConnection *
+open_tunnel_get (gint port, const gchar * tunnelid)
+{
+  GSocketClient *socket_client;
+  GSocketConnection *connection;
+  GOutputStream *output;
+  GError *error = NULL;
+  gchar *address, *request;
+
+  address = gst_rtsp_server_get_address (server);
+  socket_client = g_socket_client_new ();
+  connection = g_socket_client_connect_to_host (socket_client, address, port,
+      NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (socket_client);
+  g_free (address);
+
+  request = g_strdup_printf ("GET %s HTTP/1.0\r\n"
+      "x-sessioncookie: %s\r\n"
+      "Accept: application/x-rtsp-tunnelled\r\n"
+      "Pragma: no-cache\r\n"
+      "Cache-Control: no-cache\r\n\r\n", TEST_MOUNT_POINT, tunnelid);
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  fail_unless (g_output_stream_write_all (output, request, strlen (request),
+          NULL, NULL, &error));
+  g_assert_no_error (error);
+  g_free (request);
+
+  return connection;
+}
+
+/* read the responses of the server until it closes @connection */
+static void
+wait_tunnel_closed (GSocketConnection * connection)
+{
+  GSocket *socket;
+  GError *error = NULL;
+  gchar buffer[1024];
+  gssize res = -1;
+  gint i;
+
+  socket = g_socket_connection_get_socket (connection);
+  g_socket_set_blocking (socket, FALSE);
+
+  for (i = 0; i < 5000 && res != 0; i++) {
+    res = g_socket_receive (socket, buffer, sizeof (buffer), NULL, &error);
+    if (res < 0) {
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+      g_clear_error (&error);
+      iterate ();
+      g_usleep (1000);
+    }
+  }
+  fail_unless (res == 0);
+}
+
+GST_START_TEST (test_tunnel_expired)
+{
+  GSocketConnection *connection1, *connection2;
+
+  gst_rtsp_server_set_tunnel_timeout (server, 100 * GST_MSECOND);
+
+  start_server (FALSE);
+
+  /* half a tunnel waits for its other half */
+  connection1 = open_tunnel_get (test_port, "tunnel1");
+  wait_tunnels_pending (1);
+
+  /* it expires, the next tunnel removes it and closes its client */
+  g_usleep (200 * 1000);
+  connection2 = open_tunnel_get (test_port, "tunnel2");
+  wait_tunnel_stat ("expired", 1);
+  wait_tunnels_pending (1);
+  wait_tunnel_closed (connection1);
+
+  g_object_unref (connection2);
+  g_object_unref (connection1);
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_describe_record_media)
 {
   GstRTSPConnection *conn;
@@ -1390,6 +1778,115 @@ enum
   UNBLOCK
 };
 
+static void
+client_connected_async_prepare_cb (GstRTSPServer * server,
+    GstRTSPClient * client, gpointer user_data)
+{
+  g_object_set (client, "async-prepare", TRUE, NULL);
+}
+
+static GstPadProbeReturn
+payloader_block_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  gint *block_state = user_data;
+
+  g_mutex_lock (&check_mutex);
+  if (*block_state == BLOCK_ME) {
+    *block_state = BLOCKED;
+    g_cond_broadcast (&check_cond);
+  }
+  while (*block_state != UNBLOCK)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* keep the media from prerolling until the test unblocks it */
+static void
+media_configure_block_preroll (GstRTSPMediaFactory * factory,
+    GstRTSPMedia * media, gpointer user_data)
+{
+  GstElement *element, *pay;
+  GstPad *pad;
+
+  element = gst_rtsp_media_get_element (media);
+  pay = gst_bin_get_by_name (GST_BIN (element), "pay0");
+  pad = gst_element_get_static_pad (pay, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      payloader_block_probe, user_data, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (pay);
+  gst_object_unref (element);
+}
+
+GST_START_TEST (test_play_async_prepare)
+{
+  GstRTSPConnection *conn;
+  GstRTSPMountPoints *mounts;
+  GstRTSPMediaFactory *factory;
+  gint block_state = BLOCK_ME;
+  GstRTSPMessage *request;
+  GstRTSPMessage *response;
+  GstRTSPStatusCode code;
+  GstRTSPThreadPool *pool;
+
+  /* all clients share one thread, a client that waits for a preparation
+   * must not keep the others from being served */
+  pool = gst_rtsp_server_get_thread_pool (server);
+  gst_rtsp_thread_pool_set_max_threads (pool, 1);
+  g_object_unref (pool);
+
+  mounts = gst_rtsp_server_get_mount_points (server);
+  fail_unless (mounts != NULL);
+  factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_launch (factory,
+      "( " VIDEO_PIPELINE "  " AUDIO_PIPELINE " )");
+  g_signal_connect (factory, "media-configure",
+      G_CALLBACK (media_configure_block_preroll), &block_state);
+  gst_rtsp_mount_points_add_factory (mounts, TEST_MOUNT_POINT "2", factory);
+  g_object_unref (mounts);
+
+  g_signal_connect (server, "client-connected",
+      G_CALLBACK (client_connected_async_prepare_cb), NULL);
+
+  start_server (FALSE);
+
+  conn = connect_to_server (test_port, TEST_MOUNT_POINT "2");
+  iterate ();
+
+  /* the describe waits for the preparation of the media */
+  request = create_request (conn, GST_RTSP_DESCRIBE, NULL);
+  fail_unless (send_request (conn, request));
+  gst_rtsp_message_free (request);
+
+  g_mutex_lock (&check_mutex);
+  while (block_state != BLOCKED)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  /* another client is served by the same thread in the meantime */
+  do_test_play (NULL);
+
+  /* now let the media preroll */
+  g_mutex_lock (&check_mutex);
+  block_state = UNBLOCK;
+  g_cond_broadcast (&check_cond);
+  g_mutex_unlock (&check_mutex);
+
+  response = read_response (conn);
+  gst_rtsp_message_parse_response (response, &code, NULL, NULL);
+  fail_unless (code == GST_RTSP_STS_OK);
+  gst_rtsp_message_free (response);
+
+  gst_rtsp_connection_free (conn);
+  stop_server ();
+  iterate ();
+}
+
+GST_END_TEST;
+
 
 static void
 media_constructed_block (GstRTSPMediaFactory * factory,
@@ -2617,6 +3114,12 @@ rtspserver_suite (void)
   tcase_add_test (tc, test_describe);
   tcase_add_test (tc, test_describe_non_existing_mount_point);
   tcase_add_test (tc, test_describe_record_media);
+  tcase_add_test (tc, test_describe_multiple_acceptors);
+  tcase_add_test (tc, test_max_connections);
+  tcase_add_test (tc, test_connection_rate);
+  tcase_add_test (tc, test_max_pending_connections);
+  tcase_add_test (tc, test_tunnel);
+  tcase_add_test (tc, test_tunnel_expired);
   tcase_add_test (tc, test_setup_udp);
   tcase_add_test (tc, test_setup_tcp);
   tcase_add_test (tc, test_setup_udp_mcast);
@@ -2628,6 +3131,7 @@ rtspserver_suite (void)
   tcase_add_test (tc, test_play_without_session);
   tcase_add_test (tc, test_bind_already_in_use);
   tcase_add_test (tc, test_play_multithreaded);
+  tcase_add_test (tc, test_play_async_prepare);
   tcase_add_test (tc, test_play_multithreaded_block_in_describe);
   tcase_add_test (tc, test_play_multithreaded_timeout_client);
   tcase_add_test (tc, test_play_multithreaded_timeout_session);
@@ -18,6 +18,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/rtp/gstrtpbuffer.h>
 
 #include <rtsp-stream.h>
 #include <rtsp-address-pool.h>
@@ -486,6 +487,547 @@ GST_START_TEST (test_tcp_transport)
 
 GST_END_TEST;
 
+static GstBuffer *
+make_rtp_packet (guint16 seq, guint32 rtptime, GstClockTime pts,
+    gboolean delta_unit)
+{
+  GstBuffer *buffer;
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  buffer = gst_rtp_buffer_new_allocate (10, 0, 0);
+  fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp));
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_ssrc (&rtp, 0x12345678);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, rtptime);
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_BUFFER_PTS (buffer) = pts;
+  if (delta_unit)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buffer;
+}
+
+static guint16
+get_rtp_seq (GstBuffer * buffer)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint16 seq;
+
+  fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp));
+  seq = gst_rtp_buffer_get_seq (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return seq;
+}
+
+static GMutex gop_lock;
+static GCond gop_cond;
+static GArray *gop_seqs;
+
+/* the seqnums of the RTP packets sent to the transports */
+static void
+gop_add_seq (GstBuffer * buffer)
+{
+  guint16 seq = get_rtp_seq (buffer);
+
+  g_mutex_lock (&gop_lock);
+  if (gop_seqs == NULL)
+    gop_seqs = g_array_new (FALSE, FALSE, sizeof (guint16));
+  g_array_append_val (gop_seqs, seq);
+  g_cond_signal (&gop_cond);
+  g_mutex_unlock (&gop_lock);
+}
+
+static void
+gop_clear_seqs (void)
+{
+  g_mutex_lock (&gop_lock);
+  if (gop_seqs) {
+    g_array_unref (gop_seqs);
+    gop_seqs = NULL;
+  }
+  g_mutex_unlock (&gop_lock);
+}
+
+static gboolean
+gop_send_rtp (GstBuffer * buffer, guint8 channel, gpointer user_data)
+{
+  if (channel == 0)
+    gop_add_seq (buffer);
+  gst_rtsp_stream_transport_message_sent (user_data);
+  return TRUE;
+}
+
+static gboolean
+gop_send_rtp_list (GstBufferList * buffer_list, guint8 channel,
+    gpointer user_data)
+{
+  guint i;
+
+  if (channel == 0) {
+    for (i = 0; i < gst_buffer_list_length (buffer_list); i++)
+      gop_add_seq (gst_buffer_list_get (buffer_list, i));
+  }
+  gst_rtsp_stream_transport_message_sent (user_data);
+  return TRUE;
+}
+
+static GstRTSPStreamTransport *
+new_tcp_transport (GstRTSPStream * stream)
+{
+  GstRTSPTransport *transport;
+  GstRTSPStreamTransport *trans;
+
+  fail_unless (gst_rtsp_transport_new (&transport) == GST_RTSP_OK);
+  transport->lower_transport = GST_RTSP_LOWER_TRANS_TCP;
+  transport->destination = g_strdup ("127.0.0.1");
+  transport->interleaved.min = 0;
+  transport->interleaved.max = 1;
+  trans = gst_rtsp_stream_transport_new (stream, transport);
+  gst_rtsp_stream_transport_set_callbacks (trans, gop_send_rtp, gop_send_rtp,
+      trans, NULL);
+  gst_rtsp_stream_transport_set_list_callbacks (trans, gop_send_rtp_list,
+      gop_send_rtp_list, trans, NULL);
+
+  return trans;
+}
+
+GST_START_TEST (test_gop_cache)
+{
+  GstPad *srcpad;
+  GstElement *pay;
+  GstRTSPStream *stream;
+  GstBin *bin;
+  GstElement *rtpbin;
+  GstRTSPStreamTransport *trans;
+  GstSegment segment;
+  GstRTSPUrl *url;
+  gchar *rtpinfo;
+  guint i;
+
+  srcpad = gst_pad_new ("testsrcpad", GST_PAD_SRC);
+  fail_unless (srcpad != NULL);
+  gst_pad_set_active (srcpad, TRUE);
+  pay = gst_element_factory_make ("rtpgstpay", "testpayloader");
+  fail_unless (pay != NULL);
+  stream = gst_rtsp_stream_new (0, pay, srcpad);
+  fail_unless (stream != NULL);
+  gst_object_unref (pay);
+  rtpbin = gst_element_factory_make ("rtpbin", "testrtpbin");
+  fail_unless (rtpbin != NULL);
+  bin = GST_BIN (gst_bin_new ("testbin"));
+  fail_unless (bin != NULL);
+  fail_unless (gst_bin_add (bin, rtpbin));
+
+  fail_if (gst_rtsp_stream_get_gop_cache (stream));
+  gst_rtsp_stream_set_gop_cache (stream, TRUE);
+  fail_unless (gst_rtsp_stream_get_gop_cache (stream));
+  gst_rtsp_stream_set_rate_control (stream, FALSE);
+  gst_rtsp_stream_set_protocols (stream, GST_RTSP_LOWER_TRANS_TCP);
+  fail_unless (gst_rtsp_stream_join_bin (stream, bin, rtpbin,
+          GST_STATE_PLAYING));
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_caps (gst_caps_from_string ("application/x-rtp, "
+                  "media=video, clock-rate=90000, encoding-name=X-GST, "
+                  "payload=96, ssrc=(uint)305419896"))));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&segment)));
+
+  /* a GOP of a keyframe in two packets and two delta frames, then the
+   * keyframe of the next GOP */
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (100, 0, 0,
+              FALSE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (101, 0, 0,
+              FALSE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (102, 3000,
+              GST_SECOND / 30, TRUE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (103, 6000,
+              2 * GST_SECOND / 30, TRUE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (104, 9000,
+              3 * GST_SECOND / 30, FALSE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (105, 9000,
+              3 * GST_SECOND / 30, FALSE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (106, 12000,
+              4 * GST_SECOND / 30, TRUE)) == GST_FLOW_OK);
+
+  /* the RTP-Info of a transport that is not streaming yet starts from the
+   * keyframe */
+  trans = new_tcp_transport (stream);
+  fail_unless (gst_rtsp_url_parse ("rtsp://127.0.0.1:8554/test/stream=0",
+          &url) == GST_RTSP_OK);
+  gst_rtsp_stream_transport_set_url (trans, url);
+  gst_rtsp_url_free (url);
+  rtpinfo = gst_rtsp_stream_transport_get_rtpinfo (trans,
+      3 * GST_SECOND / 30);
+  fail_unless_equals_string (rtpinfo,
+      "url=rtsp://127.0.0.1:8554/test/stream=0;seq=104;rtptime=9000");
+  g_free (rtpinfo);
+
+  /* the transport is sent the GOP, then the packets of the stream without
+   * a gap, also when they are cached while the GOP is sent. A packet that
+   * was cached and still queued when the transport was added is not sent
+   * again */
+  fail_unless (gst_rtsp_stream_add_transport (stream, trans));
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (107, 15000,
+              5 * GST_SECOND / 30, TRUE)) == GST_FLOW_OK);
+
+  g_mutex_lock (&gop_lock);
+  while (gop_seqs == NULL ||
+      g_array_index (gop_seqs, guint16, gop_seqs->len - 1) != 107)
+    g_cond_wait (&gop_cond, &gop_lock);
+  fail_unless_equals_int (g_array_index (gop_seqs, guint16, 0), 104);
+  for (i = 1; i < gop_seqs->len; i++) {
+    guint16 prev = g_array_index (gop_seqs, guint16, i - 1);
+    guint16 seq = g_array_index (gop_seqs, guint16, i);
+
+    fail_unless_equals_int (seq, (guint16) (prev + 1));
+  }
+  g_mutex_unlock (&gop_lock);
+
+  fail_unless (gst_rtsp_stream_remove_transport (stream, trans));
+  g_object_unref (trans);
+  gop_clear_seqs ();
+
+  gst_rtsp_stream_set_gop_cache (stream, FALSE);
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_rtsp_stream_leave_bin (stream, bin, rtpbin));
+  gst_object_unref (bin);
+  gst_object_unref (srcpad);
+  gst_object_unref (stream);
+}
+
+GST_END_TEST;
+
+static guint key_unit_requests;
+
+static gboolean
+key_unit_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (gst_event_has_name (event, "GstForceKeyUnit"))
+    key_unit_requests++;
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+GST_START_TEST (test_key_unit_on_join)
+{
+  GstPad *srcpad;
+  GstElement *pay;
+  GstRTSPStream *stream;
+  GstBin *bin;
+  GstElement *rtpbin;
+  GstRTSPStreamTransport *trans[3];
+  GstSegment segment;
+  GstStructure *stats;
+  guint value;
+  gint i;
+
+  srcpad = gst_pad_new ("testsrcpad", GST_PAD_SRC);
+  fail_unless (srcpad != NULL);
+  gst_pad_set_event_function (srcpad, key_unit_event);
+  gst_pad_set_active (srcpad, TRUE);
+  pay = gst_element_factory_make ("rtpgstpay", "testpayloader");
+  fail_unless (pay != NULL);
+  stream = gst_rtsp_stream_new (0, pay, srcpad);
+  fail_unless (stream != NULL);
+  gst_object_unref (pay);
+  rtpbin = gst_element_factory_make ("rtpbin", "testrtpbin");
+  fail_unless (rtpbin != NULL);
+  bin = GST_BIN (gst_bin_new ("testbin"));
+  fail_unless (bin != NULL);
+  fail_unless (gst_bin_add (bin, rtpbin));
+
+  fail_unless_equals_uint64 (gst_rtsp_stream_get_key_unit_interval (stream),
+      0);
+  gst_rtsp_stream_set_key_unit_interval (stream, 10 * GST_SECOND);
+  fail_unless_equals_uint64 (gst_rtsp_stream_get_key_unit_interval (stream),
+      10 * GST_SECOND);
+  gst_rtsp_stream_set_rate_control (stream, FALSE);
+  gst_rtsp_stream_set_protocols (stream, GST_RTSP_LOWER_TRANS_TCP);
+  fail_unless (gst_rtsp_stream_join_bin (stream, bin, rtpbin,
+          GST_STATE_PLAYING));
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_caps (gst_caps_from_string ("application/x-rtp, "
+                  "media=video, clock-rate=90000, encoding-name=X-GST, "
+                  "payload=96, ssrc=(uint)305419896"))));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&segment)));
+
+  /* the first client starts the stream, the second one requests a keyframe
+   * and the third one joins within the interval and shares the request */
+  for (i = 0; i < 3; i++) {
+    trans[i] = new_tcp_transport (stream);
+    fail_unless (gst_rtsp_stream_add_transport (stream, trans[i]));
+  }
+  fail_unless_equals_int (key_unit_requests, 1);
+
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (100, 0, 0,
+              TRUE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (101, 3000,
+              GST_SECOND / 30, FALSE)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (102, 6000,
+              2 * GST_SECOND / 30, FALSE)) == GST_FLOW_OK);
+
+  stats = gst_rtsp_stream_get_key_unit_stats (stream);
+  fail_unless (gst_structure_get_uint (stats, "requested", &value));
+  fail_unless_equals_int (value, 1);
+  fail_unless (gst_structure_get_uint (stats, "coalesced", &value));
+  fail_unless_equals_int (value, 1);
+  fail_unless (gst_structure_get_uint (stats, "honoured", &value));
+  fail_unless_equals_int (value, 1);
+  gst_structure_free (stats);
+
+  for (i = 0; i < 3; i++) {
+    fail_unless (gst_rtsp_stream_remove_transport (stream, trans[i]));
+    g_object_unref (trans[i]);
+  }
+  gop_clear_seqs ();
+
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_rtsp_stream_leave_bin (stream, bin, rtpbin));
+  gst_object_unref (bin);
+  gst_object_unref (srcpad);
+  gst_object_unref (stream);
+}
+
+GST_END_TEST;
+
+/* every audio packet is a keyframe, no keyframe is requested */
+GST_START_TEST (test_key_unit_audio)
+{
+  GstPad *srcpad;
+  GstElement *pay;
+  GstRTSPStream *stream;
+  GstBin *bin;
+  GstElement *rtpbin;
+  GstRTSPStreamTransport *trans[2];
+  GstSegment segment;
+  GstStructure *stats;
+  guint value;
+  gint i;
+
+  srcpad = gst_pad_new ("testsrcpad", GST_PAD_SRC);
+  fail_unless (srcpad != NULL);
+  gst_pad_set_event_function (srcpad, key_unit_event);
+  gst_pad_set_active (srcpad, TRUE);
+  pay = gst_element_factory_make ("rtpgstpay", "testpayloader");
+  fail_unless (pay != NULL);
+  stream = gst_rtsp_stream_new (0, pay, srcpad);
+  fail_unless (stream != NULL);
+  gst_object_unref (pay);
+  rtpbin = gst_element_factory_make ("rtpbin", "testrtpbin");
+  fail_unless (rtpbin != NULL);
+  bin = GST_BIN (gst_bin_new ("testbin"));
+  fail_unless (bin != NULL);
+  fail_unless (gst_bin_add (bin, rtpbin));
+
+  gst_rtsp_stream_set_key_unit_interval (stream, 10 * GST_SECOND);
+  gst_rtsp_stream_set_rate_control (stream, FALSE);
+  gst_rtsp_stream_set_protocols (stream, GST_RTSP_LOWER_TRANS_TCP);
+  fail_unless (gst_rtsp_stream_join_bin (stream, bin, rtpbin,
+          GST_STATE_PLAYING));
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_caps (gst_caps_from_string ("application/x-rtp, "
+                  "media=audio, clock-rate=48000, encoding-name=X-GST, "
+                  "payload=96, ssrc=(uint)305419896"))));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&segment)));
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (100, 0, 0,
+              FALSE)) == GST_FLOW_OK);
+
+  key_unit_requests = 0;
+  for (i = 0; i < 2; i++) {
+    trans[i] = new_tcp_transport (stream);
+    fail_unless (gst_rtsp_stream_add_transport (stream, trans[i]));
+  }
+  fail_unless (gst_pad_push (srcpad, make_rtp_packet (101, 960,
+              GST_SECOND / 50, FALSE)) == GST_FLOW_OK);
+  fail_unless_equals_int (key_unit_requests, 0);
+
+  stats = gst_rtsp_stream_get_key_unit_stats (stream);
+  fail_unless (gst_structure_get_uint (stats, "requested", &value));
+  fail_unless_equals_int (value, 0);
+  fail_unless (gst_structure_get_uint (stats, "honoured", &value));
+  fail_unless_equals_int (value, 0);
+  gst_structure_free (stats);
+
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_rtsp_stream_remove_transport (stream, trans[i]));
+    g_object_unref (trans[i]);
+  }
+  gop_clear_seqs ();
+
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_rtsp_stream_leave_bin (stream, bin, rtpbin));
+  gst_object_unref (bin);
+  gst_object_unref (srcpad);
+  gst_object_unref (stream);
+}
+
+GST_END_TEST;
+
+static GMutex batch_lock;
+static GCond batch_cond;
+static GstBuffer *batch_first;
+static GstBufferList *batch_list;
+
+static gboolean
+batch_send_rtp (GstBuffer * buffer, guint8 channel, gpointer user_data)
+{
+  /* keep the message outstanding so that the next packets queue up */
+  g_mutex_lock (&batch_lock);
+  fail_unless (batch_first == NULL);
+  batch_first = gst_buffer_ref (buffer);
+  g_mutex_unlock (&batch_lock);
+  return TRUE;
+}
+
+static gboolean
+batch_send_rtp_list (GstBufferList * buffer_list, guint8 channel,
+    gpointer user_data)
+{
+  g_mutex_lock (&batch_lock);
+  fail_unless (batch_list == NULL);
+  batch_list = gst_buffer_list_ref (buffer_list);
+  g_cond_signal (&batch_cond);
+  g_mutex_unlock (&batch_lock);
+  return TRUE;
+}
+
+static gboolean
+batch_send_rtcp (GstBuffer * buffer, guint8 channel, gpointer user_data)
+{
+  gst_rtsp_stream_transport_message_sent (user_data);
+  return TRUE;
+}
+
+static gboolean
+batch_send_rtcp_list (GstBufferList * buffer_list, guint8 channel,
+    gpointer user_data)
+{
+  gst_rtsp_stream_transport_message_sent (user_data);
+  return TRUE;
+}
+
+/* the packets that queue up while a message is outstanding are sent
+ * together in one list */
+GST_START_TEST (test_tcp_batching)
+{
+  GstPad *srcpad;
+  GstElement *pay;
+  GstRTSPStream *stream;
+  GstBin *bin;
+  GstElement *rtpbin;
+  GstRTSPTransport *transport;
+  GstRTSPStreamTransport *trans;
+  GstSegment segment;
+  guint i;
+
+  srcpad = gst_pad_new ("testsrcpad", GST_PAD_SRC);
+  fail_unless (srcpad != NULL);
+  gst_pad_set_active (srcpad, TRUE);
+  pay = gst_element_factory_make ("rtpgstpay", "testpayloader");
+  fail_unless (pay != NULL);
+  stream = gst_rtsp_stream_new (0, pay, srcpad);
+  fail_unless (stream != NULL);
+  gst_object_unref (pay);
+  rtpbin = gst_element_factory_make ("rtpbin", "testrtpbin");
+  fail_unless (rtpbin != NULL);
+  bin = GST_BIN (gst_bin_new ("testbin"));
+  fail_unless (bin != NULL);
+  fail_unless (gst_bin_add (bin, rtpbin));
+
+  gst_rtsp_stream_set_rate_control (stream, FALSE);
+  gst_rtsp_stream_set_protocols (stream, GST_RTSP_LOWER_TRANS_TCP);
+  fail_unless (gst_rtsp_stream_join_bin (stream, bin, rtpbin,
+          GST_STATE_PLAYING));
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_caps (gst_caps_from_string ("application/x-rtp, "
+                  "media=video, clock-rate=90000, encoding-name=X-GST, "
+                  "payload=96, ssrc=(uint)305419896"))));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&segment)));
+
+  fail_unless (gst_rtsp_transport_new (&transport) == GST_RTSP_OK);
+  transport->lower_transport = GST_RTSP_LOWER_TRANS_TCP;
+  transport->destination = g_strdup ("127.0.0.1");
+  transport->interleaved.min = 0;
+  transport->interleaved.max = 1;
+  trans = gst_rtsp_stream_transport_new (stream, transport);
+  gst_rtsp_stream_transport_set_callbacks (trans, batch_send_rtp,
+      batch_send_rtcp, trans, NULL);
+  gst_rtsp_stream_transport_set_list_callbacks (trans, batch_send_rtp_list,
+      batch_send_rtcp_list, trans, NULL);
+  fail_unless (gst_rtsp_stream_add_transport (stream, trans));
+
+  /* the first packet is sent on its own, the others wait in the appsink */
+  for (i = 0; i < 4; i++)
+    fail_unless (gst_pad_push (srcpad, make_rtp_packet (100 + i, 3000 * i,
+                i * GST_SECOND / 30, i > 0)) == GST_FLOW_OK);
+
+  g_mutex_lock (&batch_lock);
+  fail_unless (batch_first != NULL);
+  fail_unless_equals_int (get_rtp_seq (batch_first), 100);
+  fail_unless (batch_list == NULL);
+  g_mutex_unlock (&batch_lock);
+
+  /* when the first message is sent the queued packets go out together */
+  gst_rtsp_stream_transport_message_sent (trans);
+
+  g_mutex_lock (&batch_lock);
+  while (batch_list == NULL)
+    g_cond_wait (&batch_cond, &batch_lock);
+  fail_unless_equals_int (gst_buffer_list_length (batch_list), 3);
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (get_rtp_seq (gst_buffer_list_get (batch_list, i)),
+        101 + i);
+  g_mutex_unlock (&batch_lock);
+
+  gst_rtsp_stream_transport_message_sent (trans);
+
+  fail_unless (gst_rtsp_stream_remove_transport (stream, trans));
+  g_object_unref (trans);
+  gst_buffer_unref (batch_first);
+  batch_first = NULL;
+  gst_buffer_list_unref (batch_list);
+  batch_list = NULL;
+
+  fail_unless (gst_element_set_state (GST_ELEMENT (bin),
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_rtsp_stream_leave_bin (stream, bin, rtpbin));
+  gst_object_unref (bin);
+  gst_object_unref (srcpad);
+  gst_object_unref (stream);
+}
+
+GST_END_TEST;
+
 static void
 check_multicast_client_address (const gchar * destination, guint port,
     const gchar * expected_addr_str, gboolean expected_res)
@@ -590,6 +1132,10 @@ rtspstream_suite (void)
   tcase_add_test (tc, test_allocate_udp_ports_multicast);
   tcase_add_test (tc, test_allocate_udp_ports_client_settings);
   tcase_add_test (tc, test_tcp_transport);
+  tcase_add_test (tc, test_tcp_batching);
+  tcase_add_test (tc, test_gop_cache);
+  tcase_add_test (tc, test_key_unit_on_join);
+  tcase_add_test (tc, test_key_unit_audio);
   tcase_add_test (tc, test_multicast_client_address);
   tcase_add_test (tc, test_multicast_client_address_invalid);
 
@@ -215,6 +215,165 @@ GST_START_TEST (test_pool_thread_copy)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pool_least_loaded)
+{
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread1, *thread2, *thread3, *thread4;
+  GstStructure *stats;
+  const GValue *threads, *value;
+  const GstStructure *load;
+  gint clients;
+  guint i;
+
+  pool = gst_rtsp_thread_pool_new ();
+  gst_rtsp_thread_pool_set_max_threads (pool, 2);
+
+  thread1 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  thread2 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  fail_unless (thread1 != thread2);
+
+  /* the next clients go to the thread with the fewest clients */
+  thread3 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  thread4 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  fail_unless (thread3 == thread1 || thread3 == thread2);
+  fail_unless (thread4 != thread3);
+
+  gst_rtsp_thread_add_bytes_sent (thread1, 1000);
+
+  stats = gst_rtsp_thread_pool_get_stats (pool);
+  fail_unless (gst_structure_has_name (stats,
+          "application/x-rtsp-thread-pool-stats"));
+  threads = gst_structure_get_value (stats, "threads");
+  fail_unless_equals_int (gst_value_array_get_size (threads), 2);
+  for (i = 0; i < 2; i++) {
+    value = gst_value_array_get_value (threads, i);
+    load = gst_value_get_structure (value);
+    fail_unless (gst_structure_get_int (load, "clients", &clients));
+    fail_unless_equals_int (clients, 2);
+    fail_unless (gst_structure_has_field_typed (load, "busy", G_TYPE_DOUBLE));
+    fail_unless (gst_structure_has_field_typed (load, "bytes-per-second",
+            G_TYPE_UINT64));
+  }
+  gst_structure_free (stats);
+
+  gst_rtsp_thread_stop (thread1);
+  gst_rtsp_thread_stop (thread2);
+  gst_rtsp_thread_stop (thread3);
+  gst_rtsp_thread_stop (thread4);
+  g_object_unref (pool);
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pool_max_media_threads)
+{
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread1, *thread2, *thread3;
+  GstStructure *stats;
+  const GValue *threads;
+  const GstStructure *load;
+  gint max_media_threads, medias;
+
+  pool = gst_rtsp_thread_pool_new ();
+  fail_unless_equals_int (gst_rtsp_thread_pool_get_max_media_threads (pool),
+      -1);
+
+  g_object_set (pool, "max-media-threads", 2, NULL);
+  g_object_get (pool, "max-media-threads", &max_media_threads, NULL);
+  fail_unless_equals_int (max_media_threads, 2);
+
+  thread1 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_MEDIA,
+      NULL);
+  thread2 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_MEDIA,
+      NULL);
+  fail_unless (thread1 != thread2);
+
+  /* the third media shares a thread */
+  thread3 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_MEDIA,
+      NULL);
+  fail_unless (thread3 == thread1 || thread3 == thread2);
+
+  stats = gst_rtsp_thread_pool_get_stats (pool);
+  threads = gst_structure_get_value (stats, "media-threads");
+  fail_unless_equals_int (gst_value_array_get_size (threads), 2);
+  load = gst_value_get_structure (gst_value_array_get_value (threads, 0));
+  fail_unless (gst_structure_get_int (load, "medias", &medias));
+  fail_unless_equals_int (medias, thread3 == thread1 ? 2 : 1);
+  gst_structure_free (stats);
+
+  gst_rtsp_thread_stop (thread1);
+  gst_rtsp_thread_stop (thread2);
+  gst_rtsp_thread_stop (thread3);
+  g_object_unref (pool);
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pool_cpus)
+{
+  GstRTSPThreadPool *pool;
+  GstRTSPThread *thread1, *thread2, *thread3, *media;
+  GstStructure *stats;
+  const GValue *threads;
+  const GstStructure *load;
+  gchar *cpus;
+  gint cpu;
+
+  pool = gst_rtsp_thread_pool_new ();
+  gst_rtsp_thread_pool_set_max_threads (pool, -1);
+
+  fail_unless (gst_rtsp_thread_pool_get_cpus (pool) == NULL);
+  fail_if (gst_rtsp_thread_pool_set_cpus (pool, "foo"));
+  fail_if (gst_rtsp_thread_pool_set_cpus (pool, "3-1"));
+  fail_if (gst_rtsp_thread_pool_set_cpus (pool, ""));
+  fail_unless (gst_rtsp_thread_pool_get_cpus (pool) == NULL);
+
+  fail_unless (gst_rtsp_thread_pool_set_cpus (pool, "0"));
+  g_object_get (pool, "cpus", &cpus, NULL);
+  fail_unless_equals_string (cpus, "0");
+  g_free (cpus);
+
+  /* one client thread per CPU, even without a maximum */
+  thread1 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  thread2 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  fail_unless (thread1 == thread2);
+
+  media = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_MEDIA,
+      NULL);
+  fail_unless (media != NULL);
+
+  stats = gst_rtsp_thread_pool_get_stats (pool);
+  threads = gst_structure_get_value (stats, "threads");
+  fail_unless_equals_int (gst_value_array_get_size (threads), 1);
+  load = gst_value_get_structure (gst_value_array_get_value (threads, 0));
+  fail_unless (gst_structure_get_int (load, "cpu", &cpu));
+  fail_unless_equals_int (cpu, 0);
+  gst_structure_free (stats);
+
+  /* without CPUs the threads are not pinned */
+  fail_unless (gst_rtsp_thread_pool_set_cpus (pool, NULL));
+  thread3 = gst_rtsp_thread_pool_get_thread (pool, GST_RTSP_THREAD_TYPE_CLIENT,
+      NULL);
+  fail_unless (thread3 != thread1);
+
+  gst_rtsp_thread_stop (thread1);
+  gst_rtsp_thread_stop (thread2);
+  gst_rtsp_thread_stop (thread3);
+  gst_rtsp_thread_stop (media);
+  g_object_unref (pool);
+  gst_rtsp_thread_pool_cleanup ();
+}
+
+GST_END_TEST;
+
 static Suite *
 rtspthreadpool_suite (void)
 {
@@ -229,6 +388,9 @@ rtspthreadpool_suite (void)
   tcase_add_test (tc, test_pool_max_threads);
   tcase_add_test (tc, test_pool_max_threads_property);
   tcase_add_test (tc, test_pool_thread_copy);
+  tcase_add_test (tc, test_pool_least_loaded);
+  tcase_add_test (tc, test_pool_cpus);
+  tcase_add_test (tc, test_pool_max_media_threads);
 
   return s;
 }
@@ -94,6 +94,65 @@ GST_START_TEST (test_token)
 
 GST_END_TEST;
 
+GST_START_TEST (test_token_well_known_fields)
+{
+  GstRTSPToken *token, *copy;
+  GstStructure *str;
+
+  token = gst_rtsp_token_new_empty ();
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (token), 0);
+  fail_if (gst_rtsp_token_is_allowed_id (token,
+          g_quark_from_string (GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS)));
+  gst_rtsp_token_unref (token);
+
+  token = gst_rtsp_token_new (GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE, G_TYPE_STRING,
+      "user", GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS, G_TYPE_BOOLEAN, TRUE,
+      "permission1", G_TYPE_BOOLEAN, TRUE, NULL);
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (token),
+      g_quark_from_string ("user"));
+  fail_unless (gst_rtsp_token_is_allowed (token,
+          GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS));
+  fail_unless (gst_rtsp_token_is_allowed_id (token,
+          g_quark_from_string ("permission1")));
+  fail_if (gst_rtsp_token_is_allowed_id (token, 0));
+
+  copy = GST_RTSP_TOKEN (gst_mini_object_copy (GST_MINI_OBJECT (token)));
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (copy),
+      g_quark_from_string ("user"));
+  fail_unless (gst_rtsp_token_is_allowed (copy,
+          GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS));
+  gst_rtsp_token_unref (copy);
+
+  /* changes of the structure are seen */
+  gst_rtsp_token_set_string (token, GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE,
+      "admin");
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (token),
+      g_quark_from_string ("admin"));
+  str = gst_rtsp_token_writable_structure (token);
+  gst_structure_set (str, GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS,
+      G_TYPE_BOOLEAN, FALSE, NULL);
+  gst_structure_remove_field (str, GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE);
+  fail_if (gst_rtsp_token_is_allowed (token,
+          GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS));
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (token), 0);
+
+  /* also when the fields are read before the structure is changed */
+  str = gst_rtsp_token_writable_structure (token);
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (token), 0);
+  gst_structure_set (str, GST_RTSP_TOKEN_MEDIA_FACTORY_ROLE, G_TYPE_STRING,
+      "user", NULL);
+  fail_unless_equals_int (gst_rtsp_token_get_role_id (token),
+      g_quark_from_string ("user"));
+  gst_structure_set (str, GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS,
+      G_TYPE_BOOLEAN, TRUE, NULL);
+  fail_unless (gst_rtsp_token_is_allowed (token,
+          GST_RTSP_TOKEN_TRANSPORT_CLIENT_SETTINGS));
+
+  gst_rtsp_token_unref (token);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtsptoken_suite (void)
 {
@@ -103,6 +162,7 @@ rtsptoken_suite (void)
   suite_add_tcase (s, tc);
   tcase_set_timeout (tc, 20);
   tcase_add_test (tc, test_token);
+  tcase_add_test (tc, test_token_well_known_fields);
 
   return s;
 }